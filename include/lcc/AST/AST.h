@@ -11,11 +11,14 @@
  ***********************************/
 #ifndef LCC_SYNTAX_H
 #define LCC_SYNTAX_H
+#include "lcc/AST/ASTContext.h"
 #include "lcc/Basic/Box.h"
 #include "lcc/Basic/Util.h"
-#include "lcc/Lexer/Token.h"
+#include "lcc/Basic/SourceLocation.h"
+#include <algorithm>
 #include <memory>
 #include <optional>
+#include <span>
 #include <string>
 #include <string_view>
 #include <variant>
@@ -39,16 +42,7 @@ class UnaryExprSizeOf;
 
 class TypeName;
 class CastExpr;
-class MultiExpr;
-class AdditiveExpr;
-class ShiftExpr;
-class RelationalExpr;
-class EqualExpr;
-class BitAndExpr;
-class BitXorExpr;
-class BitOrExpr;
-class LogAndExpr;
-class LogOrExpr;
+class BinaryExpr;
 class CondExpr;
 using ConstantExpr = CondExpr;
 class AssignExpr;
@@ -74,7 +68,6 @@ class FunctionDefinition;
 class Declaration;
 class DeclSpec;
 class SpecifierQualifiers;
-class StorageClsSpec;
 class TypeQualifier;
 class TypeSpec;
 class EnumSpecifier;
@@ -106,18 +99,20 @@ using TypeNameBox = box<TypeName>;
 using InitializerListBox = box<InitializerList>;
 using AbstractDeclaratorBox = box<AbstractDeclarator>;
 
+/// not polymorphic, a node is only ever owned through its exact type by box,
+/// std::variant or ASTVector, so no node pays for a vptr
 class Node {
 private:
-  TokIter beginTokLoc_;
+  /// the first token of the node, the tokens are gone once parsing is done
+  SourceLocation beginLoc_;
 
 public:
-  Node(TokIter beginTokLoc) : beginTokLoc_(beginTokLoc) {}
-  virtual ~Node() = default;
+  Node(SourceLocation beginLoc) : beginLoc_(beginLoc) {}
   Node(const Node &) = delete;
   Node &operator=(const Node &) = delete;
   Node(Node &&) = default;
   Node &operator=(Node &&) = default;
-  TokIter getBeginLoc() const { return beginTokLoc_; }
+  SourceLocation getBeginLoc() const { return beginLoc_; }
 };
 
 /*
@@ -129,7 +124,7 @@ private:
   std::string_view ident_;
 
 public:
-  PrimaryExprIdent(TokIter begin, std::string_view identifier)
+  PrimaryExprIdent(SourceLocation begin, std::string_view identifier)
       : Node(begin), ident_(identifier) {}
   [[nodiscard]] std::string_view getIdentifier() const { return ident_; }
 };
@@ -140,14 +135,15 @@ public:
  */
 class PrimaryExprConstant final : public Node {
 public:
+  /// a string literal is copied into the ASTContext
   using Variant = std::variant<int32_t, uint32_t, int64_t, uint64_t, float,
-                               double, std::string>;
+                               double, std::string_view>;
 
 private:
   Variant value_;
 
 public:
-  PrimaryExprConstant(TokIter begin, Variant &&value)
+  PrimaryExprConstant(SourceLocation begin, Variant &&value)
       : Node(begin), value_(value) {}
   [[nodiscard]] const Variant &getValue() const { return value_; }
 };
@@ -161,7 +157,7 @@ private:
   ExprBox expr_;
 
 public:
-  PrimaryExprParentheses(TokIter begin, ExprBox expr)
+  PrimaryExprParentheses(SourceLocation begin, ExprBox expr)
       : Node(begin), expr_(MV_(expr)) {}
   [[nodiscard]] const Expr &getExpr() const { return *expr_; }
 };
@@ -204,7 +200,7 @@ private:
   ExprBox expr_;
 
 public:
-  PostFixExprSubscript(TokIter begin, PostFixExpr &&postFixExpr, ExprBox expr)
+  PostFixExprSubscript(SourceLocation begin, PostFixExpr &&postFixExpr, ExprBox expr)
       : Node(begin), postFixExpr_(MV_(postFixExpr)), expr_(MV_(expr)) {}
   [[nodiscard]] const PostFixExpr &getPostFixExpr() const {
     return postFixExpr_;
@@ -223,17 +219,17 @@ public:
 class PostFixExprFuncCall final : public Node {
 private:
   PostFixExpr postFixExpr_;
-  std::vector<AssignExprBox> params_;
+  ASTVector<AssignExprBox> params_;
 
 public:
-  PostFixExprFuncCall(TokIter begin, PostFixExpr &&postFixExpr,
-                      std::vector<AssignExprBox> &&params)
+  PostFixExprFuncCall(SourceLocation begin, PostFixExpr &&postFixExpr,
+                      ASTVector<AssignExprBox> &&params)
       : Node(begin), postFixExpr_(MV_(postFixExpr)), params_(MV_(params)) {}
 
   [[nodiscard]] const PostFixExpr &getPostFixExpr() const {
     return postFixExpr_;
   }
-  [[nodiscard]] const std::vector<AssignExprBox> &
+  [[nodiscard]] const ASTVector<AssignExprBox> &
   getOptionalAssignExpressions() const {
     return params_;
   }
@@ -249,7 +245,7 @@ private:
   std::string_view identifier_;
 
 public:
-  PostFixExprDot(TokIter begin, PostFixExpr &&postFixExpr,
+  PostFixExprDot(SourceLocation begin, PostFixExpr &&postFixExpr,
                  std::string_view identifier)
       : Node(begin), postFixExpr_(MV_(postFixExpr)), identifier_(identifier) {}
 
@@ -269,7 +265,7 @@ private:
   std::string_view identifier_;
 
 public:
-  PostFixExprArrow(TokIter begin, PostFixExpr &&postFixExpr,
+  PostFixExprArrow(SourceLocation begin, PostFixExpr &&postFixExpr,
                    std::string_view identifier)
       : Node(begin), postFixExpr_(MV_(postFixExpr)), identifier_(identifier) {}
   [[nodiscard]] const PostFixExpr &getPostFixExpr() const {
@@ -287,7 +283,7 @@ private:
   PostFixExpr postFixExpr_;
 
 public:
-  PostFixExprIncrement(TokIter begin, PostFixExpr &&postFixExpr)
+  PostFixExprIncrement(SourceLocation begin, PostFixExpr &&postFixExpr)
       : Node(begin), postFixExpr_(MV_(postFixExpr)) {}
   [[nodiscard]] const PostFixExpr &getPostFixExpr() const {
     return postFixExpr_;
@@ -303,7 +299,7 @@ private:
   PostFixExpr postFixExpr_;
 
 public:
-  PostFixExprDecrement(TokIter begin, PostFixExpr &&postFixExpr)
+  PostFixExprDecrement(SourceLocation begin, PostFixExpr &&postFixExpr)
       : Node(begin), postFixExpr_(MV_(postFixExpr)) {}
   [[nodiscard]] const PostFixExpr &getPostFixExpr() const {
     return postFixExpr_;
@@ -321,7 +317,7 @@ private:
   InitializerListBox initializerList_;
 
 public:
-  PostFixExprTypeInitializer(TokIter begin, TypeNameBox typeName,
+  PostFixExprTypeInitializer(SourceLocation begin, TypeNameBox typeName,
                              InitializerListBox initializerList)
       : Node(begin), typeName_(MV_(typeName)),
         initializerList_(MV_(initializerList)) {}
@@ -375,10 +371,11 @@ private:
   Variant value_;
 
 public:
-  UnaryExprUnaryOperator(TokIter begin, Op anOperator, Variant &&value)
+  UnaryExprUnaryOperator(SourceLocation begin, Op anOperator, Variant &&value)
       : Node(begin), operator_(anOperator), value_(MV_(value)) {}
 
   [[nodiscard]] Op getOperator() const { return operator_; }
+  [[nodiscard]] const Variant &getVariant() const { return value_; }
   [[nodiscard]] const CastExpr *getCastExpr() const {
     if (std::holds_alternative<CastExprBox>(value_)) {
       return std::get<CastExprBox>(value_).get();
@@ -397,7 +394,7 @@ class UnaryExprSizeOf final : public Node {
   Variant value_;
 
 public:
-  UnaryExprSizeOf(TokIter begin, Variant &&variant)
+  UnaryExprSizeOf(SourceLocation begin, Variant &&variant)
       : Node(begin), value_(MV_(variant)) {}
 
   [[nodiscard]] const Variant &getVariant() const { return value_; }
@@ -409,10 +406,13 @@ public:
  *  struct-or-union-specifier
  *  enum-specifier
  *  typedef-name
+ *
+ * the primitive ones are kept as bits of their DeclSpec, a TypeSpec is only
+ * made for the others
  */
 class TypeSpec final : public Node {
 public:
-  enum PrimTypeKind {
+  enum PrimTypeKind : uint16_t {
     Void = 1 << 0,
     Char = 1 << 1,
     Short = 1 << 2,
@@ -427,13 +427,13 @@ public:
   using TypedefName = std::string_view;
 
 private:
-  using Variant = std::variant<PrimTypeKind, box<StructOrUnionSpec>,
-                               box<EnumSpecifier>, TypedefName>;
+  using Variant = std::variant<box<StructOrUnionSpec>, box<EnumSpecifier>,
+                               TypedefName>;
 
   Variant variant_;
 
 public:
-  TypeSpec(TokIter begin, Variant &&variant)
+  TypeSpec(SourceLocation begin, Variant &&variant)
       : Node(begin), variant_(MV_(variant)) {}
 
   [[nodiscard]] const Variant &getVariant() const { return variant_; }
@@ -447,93 +447,104 @@ public:
  */
 class TypeQualifier final : public Node {
 public:
-  enum Qualifier { Const, Restrict, Volatile };
+  enum Qualifier : uint8_t { Const, Restrict, Volatile };
 
 private:
   Qualifier mQualifier;
 
 public:
-  TypeQualifier(TokIter begin, Qualifier qualifier)
+  TypeQualifier(SourceLocation begin, Qualifier qualifier)
       : Node(begin), mQualifier(qualifier) {}
   [[nodiscard]] Qualifier getQualifier() const { return mQualifier; }
 };
 
 /**
- * function-specifier:
- *      inline
- */
-class FunctionSpecifier final : public Node {
-public:
-  FunctionSpecifier(TokIter begin) : Node(begin) {}
-};
+ * declaration-specifiers:
+        storage-class-specifier declaration-specifiers{opt}
+        type-specifier declaration-specifiers{opt}
+        type-qualifier declaration-specifiers{opt}
+        function-specifier declaration-specifiers{opt}
 
-/**
  * storage-class-specifier:
  *      typedef
  *      extern
  *      static
  *      auto
  *      register
- */
-class StorageClsSpec final : public Node {
-public:
-  enum Specifiers { Typedef, Extern, Static, Auto, Register };
-
-private:
-  Specifiers mSpecifier;
 
-public:
-  StorageClsSpec(TokIter begin, Specifiers specifier)
-      : Node(begin), mSpecifier(specifier) {}
-  [[nodiscard]] Specifiers getSpecifier() const { return mSpecifier; }
-};
-
-/**
- * declaration-specifiers:
-        storage-class-specifier declaration-specifiers{opt}
-        type-specifier declaration-specifiers{opt}
-        type-qualifier declaration-specifiers{opt}
-        function-specifier declaration-specifiers{opt}
+ * function-specifier:
+ *      inline
+ *
+ * every specifier but a struct, union, enum or typedef name is a bit, a
+ * declaration makes no allocation for its specifiers
  */
 class DeclSpec final : public Node {
-private:
-  std::vector<StorageClsSpec> storageClassSpecifiers_;
-  std::vector<TypeSpec> typeSpecifiers_;
-  std::vector<TypeQualifier> typeQualifiers_;
-  std::vector<FunctionSpecifier> functionSpecifiers_;
-
 public:
-  DeclSpec(TokIter begin) : Node(begin) {}
-  void addStorageClassSpecifiers(StorageClsSpec &&specifier) {
-    storageClassSpecifiers_.push_back(MV_(specifier));
-  }
-  void addTypeSpec(TypeSpec &&specifier) {
-    typeSpecifiers_.push_back(MV_(specifier));
+  enum StorageClass : uint8_t { Typedef, Extern, Static, Auto, Register };
+
+private:
+  /// the struct, union, enum or typedef name, C allows only one of them
+  std::optional<TypeSpec> mTypeSpec;
+  /// TypeSpec::PrimTypeKind bits, long is the only one that may come twice
+  uint16_t mPrimTypes{0};
+  uint8_t mNumLongs{0};
+  /// 1 << StorageClass
+  uint8_t mStorageClasses{0};
+  /// 1 << TypeQualifier::Qualifier
+  uint8_t mQualifiers{0};
+  bool mInline{false};
+
+public:
+  DeclSpec(SourceLocation begin) : Node(begin) {}
+
+  /// false when the specifier was already given
+  bool addStorageClass(StorageClass storageClass) {
+    if (hasStorageClass(storageClass)) {
+      return false;
+    }
+    mStorageClasses |= 1u << storageClass;
+    return true;
+  }
+  bool addPrimType(TypeSpec::PrimTypeKind kind) {
+    if (kind == TypeSpec::Long && mNumLongs < 2) {
+      ++mNumLongs;
+    } else if (mPrimTypes & kind) {
+      return false;
+    }
+    mPrimTypes |= kind;
+    return true;
   }
-  void addTypeQualifiers(TypeQualifier &&qualifier) {
-    typeQualifiers_.push_back(MV_(qualifier));
+  bool addTypeSpec(TypeSpec &&specifier) {
+    if (mTypeSpec) {
+      return false;
+    }
+    mTypeSpec.emplace(MV_(specifier));
+    return true;
   }
-  void addFunctionSpecifier(FunctionSpecifier &&specifier) {
-    functionSpecifiers_.push_back(MV_(specifier));
+  /// a repeated qualifier is the same as a single one
+  void addQualifier(TypeQualifier::Qualifier qualifier) {
+    mQualifiers |= 1u << qualifier;
   }
+  void setInline() { mInline = true; }
 
-  [[nodiscard]] const std::vector<StorageClsSpec> &
-  getStorageClassSpecifiers() const {
-    return storageClassSpecifiers_;
-  }
-  [[nodiscard]] const std::vector<TypeSpec> &getTypeSpecs() const {
-    return typeSpecifiers_;
+  [[nodiscard]] bool hasStorageClass(StorageClass storageClass) const {
+    return mStorageClasses & (1u << storageClass);
   }
-  [[nodiscard]] const std::vector<TypeQualifier> &getTypeQualifiers() const {
-    return typeQualifiers_;
+  [[nodiscard]] bool hasStorageClass() const { return mStorageClasses; }
+  [[nodiscard]] uint8_t getStorageClasses() const { return mStorageClasses; }
+  [[nodiscard]] uint16_t getPrimTypes() const { return mPrimTypes; }
+  [[nodiscard]] unsigned getNumLongs() const { return mNumLongs; }
+  [[nodiscard]] const TypeSpec *getTypeSpec() const {
+    return mTypeSpec ? &*mTypeSpec : nullptr;
   }
-  [[nodiscard]] const std::vector<FunctionSpecifier> &
-  getFunctionSpecifier() const {
-    return functionSpecifiers_;
+  [[nodiscard]] bool hasTypeSpec() const { return mPrimTypes || mTypeSpec; }
+  [[nodiscard]] bool hasQualifier(TypeQualifier::Qualifier qualifier) const {
+    return mQualifiers & (1u << qualifier);
   }
+  [[nodiscard]] uint8_t getQualifiers() const { return mQualifiers; }
+  [[nodiscard]] bool isInline() const { return mInline; }
   [[nodiscard]] bool isEmpty() const {
-    return storageClassSpecifiers_.empty() && typeSpecifiers_.empty() &&
-           typeQualifiers_.empty() && functionSpecifiers_.empty();
+    return !mStorageClasses && !hasTypeSpec() && !mQualifiers && !mInline;
   }
 };
 
@@ -554,7 +565,7 @@ private:
 
 public:
   TypeName(
-      TokIter begin, DeclSpec specifierQualifiers,
+      SourceLocation begin, DeclSpec specifierQualifiers,
       std::optional<AbstractDeclaratorBox> abstractDeclarator = {std::nullopt})
       : Node(begin), mSpecifierQualifiers(MV_(specifierQualifiers)),
         mAbstractDeclarator(MV_(abstractDeclarator)) {}
@@ -576,241 +587,118 @@ public:
  */
 class CastExpr final : public Node {
 public:
-  using TypeNameCast = std::pair<TypeName, CastExprBox>;
+  using TypeNameCast = std::pair<TypeNameBox, CastExprBox>;
   using Variant = std::variant<UnaryExpr, TypeNameCast>;
 
 public:
   Variant variant_;
 
 public:
-  CastExpr(TokIter begin, Variant &&unaryOrCast)
+  CastExpr(SourceLocation begin, Variant &&unaryOrCast)
       : Node(begin), variant_(MV_(unaryOrCast)) {}
   [[nodiscard]] const Variant &getVariant() const { return variant_; }
 };
 
 /**
- * multiplicative-expression:
- *  cast-expression
- *  multiplicative-expression * cast-expression
- *  multiplicative-expression / cast-expression
- *  multiplicative-expression % cast-expression
- */
-class MultiExpr final : public Node {
-public:
-  enum Op { Multiply, Divide, Modulo };
-
-private:
-  CastExpr castExpr_;
-  std::vector<std::pair<Op, CastExpr>> optionalCastExps_;
-
-public:
-  explicit MultiExpr(TokIter begin, CastExpr &&castExpr,
-                     std::vector<std::pair<Op, CastExpr>> &&optionalCastExps)
-      : Node(begin), castExpr_(MV_(castExpr)),
-        optionalCastExps_(MV_(optionalCastExps)) {}
-  [[nodiscard]] const CastExpr &getCastExpr() const { return castExpr_; }
-  [[nodiscard]] const std::vector<std::pair<Op, CastExpr>> &
-  getOptionalCastExps() const {
-    return optionalCastExps_;
-  }
-};
-
-/**
- * additive-expression:
- * multiplicative-expression
- * additive-expression + multiplicative-expression
- * additive-expression - multiplicative-expression
+ * the operand of a binary operator, a cast-expression or the result of a
+ * binary operator of higher precedence. Both are boxed, a BinaryExpr is two
+ * pointers and an operator however big the cast-expression is
  */
-class AdditiveExpr final : public Node {
-public:
-  enum Op { Plus, Minus };
-
-private:
-  MultiExpr multiExpr_;
-  std::vector<std::pair<Op, MultiExpr>> optionalMultiExps_;
-
-public:
-  AdditiveExpr(TokIter begin, MultiExpr &&multiExpr,
-               std::vector<std::pair<Op, MultiExpr>> &&optionalMultiExps)
-      : Node(begin), multiExpr_(MV_(multiExpr)),
-        optionalMultiExps_(MV_(optionalMultiExps)) {}
-  [[nodiscard]] const MultiExpr &getMultiExpr() const { return multiExpr_; }
-  [[nodiscard]] const std::vector<std::pair<Op, MultiExpr>> &
-  getOptionalMultiExps() const {
-    return optionalMultiExps_;
-  }
-};
+using BinaryOperand = std::variant<box<CastExpr>, box<BinaryExpr>>;
 
 /**
- * shift-expression:
- *      additive-expression
- *      shift-expression << additive-expression
- *      shift-expression >> additive-expression
- */
-class ShiftExpr final : public Node {
-public:
-  enum Op { Right, Left };
-
-private:
-  AdditiveExpr additiveExpr_;
-  std::vector<std::pair<Op, AdditiveExpr>> optionalAdditiveExps_;
-
-public:
-  ShiftExpr(TokIter begin, AdditiveExpr &&additiveExpr,
-            std::vector<std::pair<Op, AdditiveExpr>> &&optionalAdditiveExps)
-      : Node(begin), additiveExpr_(MV_(additiveExpr)),
-        optionalAdditiveExps_(MV_(optionalAdditiveExps)) {}
-  [[nodiscard]] const AdditiveExpr &getAdditiveExpr() const {
-    return additiveExpr_;
-  }
-  [[nodiscard]] const std::vector<std::pair<Op, AdditiveExpr>> &
-  getOptAdditiveExps() const {
-    return optionalAdditiveExps_;
-  }
-};
-
-/**
- * relational-expression:
- *      shift-expression
- *      relational-expression < shift-expression
- *      relational-expression > shift-expression
- *      relational-expression <= shift-expression
- *      relational-expression >= shift-expression
- */
-class RelationalExpr final : public Node {
-public:
-  enum Op { LessThan, LessThanOrEqual, GreaterThan, GreaterThanOrEqual };
-
-private:
-  ShiftExpr shiftExpr_;
-  std::vector<std::pair<Op, ShiftExpr>> optionalShiftExps_;
-
-public:
-  RelationalExpr(TokIter begin, ShiftExpr &&shiftExpr,
-                 std::vector<std::pair<Op, ShiftExpr>> &&optionalShiftExps)
-      : Node(begin), shiftExpr_(MV_(shiftExpr)),
-        optionalShiftExps_(MV_(optionalShiftExps)) {}
-  [[nodiscard]] const ShiftExpr &getShiftExpr() const { return shiftExpr_; }
-  [[nodiscard]] const std::vector<std::pair<Op, ShiftExpr>> &
-  getOptionalShiftExpressions() const {
-    return optionalShiftExps_;
-  }
-};
-
-/**
- * equality-expression:
- *      relational-expression
- *      equality-expression == relational-expression
- *      equality-expression != relational-expression
- */
-class EqualExpr final : public Node {
-public:
-  enum Op { Equal, NotEqual };
-
-private:
-  RelationalExpr relationalExpr_;
-  std::vector<std::pair<Op, RelationalExpr>> optionalRelationalExps_;
-
-public:
-  EqualExpr(TokIter begin, RelationalExpr &&relationalExpr,
-            std::vector<std::pair<Op, RelationalExpr>> &&optionalRelationalExps)
-      : Node(begin), relationalExpr_(MV_(relationalExpr)),
-        optionalRelationalExps_(MV_(optionalRelationalExps)) {}
-  [[nodiscard]] const RelationalExpr &getRelationalExpr() const {
-    return relationalExpr_;
-  }
-
-  [[nodiscard]] const std::vector<std::pair<Op, RelationalExpr>> &
-  getOptionalRelationalExpr() const {
-    return optionalRelationalExps_;
-  }
-};
-
-/**
- * AND-expression:
- *      equality-expression
- *      AND-expression & equality-expression
- */
-class BitAndExpr final : public Node {
-private:
-  std::vector<EqualExpr> equalExps_;
-
-public:
-  BitAndExpr(TokIter begin, std::vector<EqualExpr> &&equalExps)
-      : Node(begin), equalExps_(MV_(equalExps)) {}
-  [[nodiscard]] const std::vector<EqualExpr> &getEqualExpr() const {
-    return equalExps_;
-  }
-};
-
-/**
- * exclusive-OR-expression:
- *      AND-expression
- *      exclusive-OR-expression ^ AND-expression
- */
-class BitXorExpr final : public Node {
-private:
-  std::vector<BitAndExpr> bitAndExps_;
-
-public:
-  BitXorExpr(TokIter begin, std::vector<BitAndExpr> &&bitAndExps)
-      : Node(begin), bitAndExps_(MV_(bitAndExps)) {}
-  [[nodiscard]] const std::vector<BitAndExpr> &getBitAndExprs() const {
-    return bitAndExps_;
-  }
-};
-
-/**
- * inclusive-OR-expression:
- *      exclusive-OR-expression
- *      inclusive-OR-expression | exclusive-OR-expression
+ * multiplicative-expression, additive-expression, shift-expression,
+ * relational-expression, equality-expression, AND-expression,
+ * exclusive-OR-expression, inclusive-OR-expression, logical-AND-expression
+ * and logical-OR-expression:
+ *      cast-expression
+ *      binary-expression binary-operator binary-expression
+ *
+ * One node for each operator, not one for each level of the grammar that an
+ * operand passes through: a cast-expression stands on its own. The operators
+ * are left associative, the left operand of `a - b - c` is `a - b`.
  */
-class BitOrExpr final : public Node {
-private:
-  std::vector<BitXorExpr> bitXorExps_;
-
+class BinaryExpr final : public Node {
 public:
-  BitOrExpr(TokIter begin, std::vector<BitXorExpr> &&bitXorExps)
-      : Node(begin), bitXorExps_(MV_(bitXorExps)) {}
+  /// from the tightest binding to the loosest
+  enum class Op : uint8_t {
+    Multiply,
+    Divide,
+    Modulo,
+    Plus,
+    Minus,
+    LeftShift,
+    RightShift,
+    LessThan,
+    LessThanOrEqual,
+    GreaterThan,
+    GreaterThanOrEqual,
+    Equal,
+    NotEqual,
+    BitAnd,
+    BitXor,
+    BitOr,
+    LogicalAnd,
+    LogicalOr
+  };
 
-  [[nodiscard]] const std::vector<BitXorExpr> &getBitXorExprs() const {
-    return bitXorExps_;
+  /// the level of the grammar of `op`, logical-OR-expression is 0 and
+  /// multiplicative-expression is NumPrecedences - 1
+  static constexpr unsigned NumPrecedences = 10;
+  static constexpr unsigned getPrecedence(Op op) {
+    switch (op) {
+    case Op::Multiply:
+    case Op::Divide:
+    case Op::Modulo:
+      return 9;
+    case Op::Plus:
+    case Op::Minus:
+      return 8;
+    case Op::LeftShift:
+    case Op::RightShift:
+      return 7;
+    case Op::LessThan:
+    case Op::LessThanOrEqual:
+    case Op::GreaterThan:
+    case Op::GreaterThanOrEqual:
+      return 6;
+    case Op::Equal:
+    case Op::NotEqual:
+      return 5;
+    case Op::BitAnd:
+      return 4;
+    case Op::BitXor:
+      return 3;
+    case Op::BitOr:
+      return 2;
+    case Op::LogicalAnd:
+      return 1;
+    case Op::LogicalOr:
+      return 0;
+    }
+    return 0;
   }
-};
 
-/**
- * logical-AND-expression:
- *      inclusive-OR-expression
- *      logical-AND-expression && inclusive-OR-expression
- */
-class LogAndExpr final : public Node {
 private:
-  std::vector<BitOrExpr> bitOrExps_;
+  Op op_;
+  BinaryOperand lhs_;
+  BinaryOperand rhs_;
 
 public:
-  LogAndExpr(TokIter begin, std::vector<BitOrExpr> &&bitOrExps)
-      : Node(begin), bitOrExps_(MV_(bitOrExps)) {}
-  [[nodiscard]] const std::vector<BitOrExpr> &getBitOrExprs() const {
-    return bitOrExps_;
-  }
+  BinaryExpr(SourceLocation begin, Op op, BinaryOperand &&lhs, BinaryOperand &&rhs)
+      : Node(begin), op_(op), lhs_(MV_(lhs)), rhs_(MV_(rhs)) {}
+  [[nodiscard]] Op getOperator() const { return op_; }
+  [[nodiscard]] unsigned getPrecedence() const { return getPrecedence(op_); }
+  [[nodiscard]] const BinaryOperand &getLhs() const { return lhs_; }
+  [[nodiscard]] const BinaryOperand &getRhs() const { return rhs_; }
 };
 
-/**
- * logical-OR-expression:
- *      logical-AND-expression
- *      logical-OR-expression || logical-AND-expression
- */
-class LogOrExpr final : public Node {
-private:
-  std::vector<LogAndExpr> logAndExps_;
-
-public:
-  LogOrExpr(TokIter begin, std::vector<LogAndExpr> &&logAndExps)
-      : Node(begin), logAndExps_(MV_(logAndExps)) {}
-  [[nodiscard]] const std::vector<LogAndExpr> &getLogAndExprs() const {
-    return logAndExps_;
+inline SourceLocation getBeginLoc(const BinaryOperand &operand) {
+  if (auto *castExpr = std::get_if<box<CastExpr>>(&operand)) {
+    return (*castExpr)->getBeginLoc();
   }
-};
+  return std::get<box<BinaryExpr>>(operand)->getBeginLoc();
+}
 
 /**
  * conditional-expression:
@@ -819,19 +707,19 @@ public:
  */
 class CondExpr final : public Node {
 private:
-  LogOrExpr logOrExpr_;
+  BinaryOperand logOrExpr_;
   std::optional<box<Expr>> optionalExpr_;
   std::optional<box<CondExpr>> optionalCondExpr_;
 
 public:
   explicit CondExpr(
-      TokIter begin, LogOrExpr &&logOrExpr,
+      SourceLocation begin, BinaryOperand &&logOrExpr,
       std::optional<box<Expr>> &&optionalExpr = {std::nullopt},
       std::optional<box<CondExpr>> &&optionalCondExpr = {std::nullopt})
       : Node(begin), logOrExpr_(MV_(logOrExpr)),
         optionalExpr_(MV_(optionalExpr)),
         optionalCondExpr_(MV_(optionalCondExpr)) {}
-  [[nodiscard]] const LogOrExpr &getLogicalOrExpression() const {
+  [[nodiscard]] const BinaryOperand &getLogicalOrExpression() const {
     return logOrExpr_;
   }
   [[nodiscard]] const Expr *getOptionalExpression() const {
@@ -881,16 +769,16 @@ public:
 
 private:
   CondExpr condExpr_;
-  std::vector<std::pair<AssignOp, CondExpr>> optionalConditionExpr_;
+  ASTVector<std::pair<AssignOp, CondExpr>> optionalConditionExpr_;
 
 public:
-  AssignExpr(TokIter begin, CondExpr &&conditionalExpression,
-             std::vector<std::pair<AssignOp, CondExpr>> &&optionalConditionExpr)
+  AssignExpr(SourceLocation begin, CondExpr &&conditionalExpression,
+             ASTVector<std::pair<AssignOp, CondExpr>> &&optionalConditionExpr)
       : Node(begin), condExpr_(MV_(conditionalExpression)),
         optionalConditionExpr_(MV_(optionalConditionExpr)) {}
 
   [[nodiscard]] const CondExpr &getConditionalExpr() const { return condExpr_; }
-  [[nodiscard]] const std::vector<std::pair<AssignOp, CondExpr>> &
+  [[nodiscard]] const ASTVector<std::pair<AssignOp, CondExpr>> &
   getOptionalConditionalExpr() const {
     return optionalConditionExpr_;
   }
@@ -903,13 +791,13 @@ public:
  */
 class Expr final : public Node {
 private:
-  std::vector<AssignExpr> assignExpressions_;
+  ASTVector<AssignExpr> assignExpressions_;
 
 public:
-  Expr(TokIter begin, std::vector<AssignExpr> &&assignExpressions)
+  Expr(SourceLocation begin, ASTVector<AssignExpr> &&assignExpressions)
       : Node(begin), assignExpressions_(MV_(assignExpressions)) {}
 
-  const std::vector<AssignExpr> &getAssignExpressions() const {
+  const ASTVector<AssignExpr> &getAssignExpressions() const {
     return assignExpressions_;
   }
 };
@@ -929,7 +817,7 @@ private:
   std::optional<ExprBox> optionalExpr_;
 
 public:
-  ExprStmt(TokIter begin,
+  ExprStmt(SourceLocation begin,
            std::optional<ExprBox> &&optionalExpr = {std::nullopt})
       : Node(begin), optionalExpr_(MV_(optionalExpr)) {}
   [[nodiscard]] const Expr *getOptionalExpression() const {
@@ -957,7 +845,7 @@ private:
   std::optional<Stmt> optionalElseStmt_;
 
 public:
-  IfStmt(TokIter begin, Expr &&expr, Stmt &&thenStmt,
+  IfStmt(SourceLocation begin, Expr &&expr, Stmt &&thenStmt,
          std::optional<Stmt> &&optionalElseStmt = {std::nullopt})
       : Node(begin), expr_(MV_(expr)), thenStmt_(MV_(thenStmt)),
         optionalElseStmt_(MV_(optionalElseStmt)) {}
@@ -984,7 +872,7 @@ private:
   Stmt stmt_;
 
 public:
-  SwitchStmt(TokIter begin, Expr &&expression, Stmt &&statement)
+  SwitchStmt(SourceLocation begin, Expr &&expression, Stmt &&statement)
       : Node(begin), expr_(MV_(expression)), stmt_(MV_(statement)) {}
 
   [[nodiscard]] const Expr &getExpression() const { return expr_; }
@@ -1001,7 +889,7 @@ private:
   Stmt stmt_;
 
 public:
-  DefaultStmt(TokIter begin, Stmt &&statement)
+  DefaultStmt(SourceLocation begin, Stmt &&statement)
       : Node(begin), stmt_(MV_(statement)) {}
   [[nodiscard]] const Stmt &getStatement() const { return stmt_; }
 };
@@ -1016,7 +904,7 @@ private:
   Stmt stmt_;
 
 public:
-  CaseStmt(TokIter begin, ConstantExpr &&constantExpr, Stmt &&stmt)
+  CaseStmt(SourceLocation begin, ConstantExpr &&constantExpr, Stmt &&stmt)
       : Node(begin), constantExpr_(MV_(constantExpr)), stmt_(MV_(stmt)) {}
 
   [[nodiscard]] const ConstantExpr &getConstantExpr() const {
@@ -1034,7 +922,7 @@ private:
   std::string_view mIdentifier;
 
 public:
-  LabelStmt(TokIter begin, std::string_view identifier)
+  LabelStmt(SourceLocation begin, std::string_view identifier)
       : Node(begin), mIdentifier(identifier) {}
   [[nodiscard]] std::string_view getIdentifier() const { return mIdentifier; }
 };
@@ -1048,7 +936,7 @@ private:
   std::string_view mIdentifier;
 
 public:
-  GotoStmt(TokIter begin, std::string_view identifier)
+  GotoStmt(SourceLocation begin, std::string_view identifier)
       : Node(begin), mIdentifier(identifier) {}
   [[nodiscard]] std::string_view getIdentifier() const { return mIdentifier; }
 };
@@ -1063,7 +951,7 @@ private:
   Expr expr_;
 
 public:
-  DoWhileStmt(TokIter begin, Stmt &&stmt, Expr &&expr)
+  DoWhileStmt(SourceLocation begin, Stmt &&stmt, Expr &&expr)
       : Node(begin), stmt_(MV_(stmt)), expr_(MV_(expr)) {}
   [[nodiscard]] const Stmt &getStatement() const { return stmt_; }
   [[nodiscard]] const Expr &getExpression() const { return expr_; }
@@ -1079,7 +967,7 @@ private:
   Stmt stmt_;
 
 public:
-  WhileStmt(TokIter begin, Expr &&expr, Stmt &&stmt)
+  WhileStmt(SourceLocation begin, Expr &&expr, Stmt &&stmt)
       : Node(begin), expr_(MV_(expr)), stmt_(MV_(stmt)) {}
   [[nodiscard]] const Expr &getExpression() const { return expr_; }
   [[nodiscard]] const Stmt &getStatement() const { return stmt_; }
@@ -1098,7 +986,7 @@ private:
   Stmt stmt_;
 
 public:
-  ForStmt(TokIter begin, Stmt stmt,
+  ForStmt(SourceLocation begin, Stmt stmt,
           std::variant<box<Declaration>, std::optional<Expr>> &&initial,
           std::optional<Expr> &&controlExpr = {std::nullopt},
           std::optional<Expr> &&postExpr = {std::nullopt})
@@ -1130,7 +1018,7 @@ public:
  */
 class BreakStmt final : public Node {
 public:
-  BreakStmt(TokIter begin) : Node(begin) {}
+  BreakStmt(SourceLocation begin) : Node(begin) {}
 };
 
 /**
@@ -1139,7 +1027,7 @@ public:
  */
 class ContinueStmt final : public Node {
 public:
-  ContinueStmt(TokIter begin) : Node(begin) {}
+  ContinueStmt(SourceLocation begin) : Node(begin) {}
 };
 
 /**
@@ -1151,7 +1039,7 @@ private:
   std::optional<Expr> optionalExpr_;
 
 public:
-  ReturnStmt(TokIter begin, std::optional<Expr> &&optionalExpr = {std::nullopt})
+  ReturnStmt(SourceLocation begin, std::optional<Expr> &&optionalExpr = {std::nullopt})
       : Node(begin), optionalExpr_(MV_(optionalExpr)) {}
   [[nodiscard]] const Expr *getExpression() const {
     if (optionalExpr_) {
@@ -1161,18 +1049,63 @@ public:
   }
 };
 
+/**
+ * the bytes of a resource included by #embed, C23 6.10.4. It stands for the
+ * comma separated integer constants of all the bytes, but is kept as one
+ * node so that a big resource costs no per element token or node. The bytes
+ * are a view of the buffer of the file manager, not a copy.
+ */
+class EmbedData final : public Node {
+private:
+  std::string_view bytes_;
+
+public:
+  EmbedData(SourceLocation begin, std::string_view bytes)
+      : Node(begin), bytes_(bytes) {}
+  [[nodiscard]] std::string_view getBytes() const { return bytes_; }
+};
+
+/**
+ * a run of plain numeric or character constants in an initializer list, the
+ * rows of a generated table. It stands for the comma separated constants as
+ * EmbedData does, the values are kept in one array of their common type
+ * rather than an Initializer and an expression chain each. A constant may be
+ * negated.
+ */
+class ConstantArray final : public Node {
+public:
+  /// the alternatives of PrimaryExprConstant without the string literal
+  using Variant =
+      std::variant<std::span<const int32_t>, std::span<const uint32_t>,
+                   std::span<const int64_t>, std::span<const uint64_t>,
+                   std::span<const float>, std::span<const double>>;
+
+private:
+  Variant values_;
+
+public:
+  ConstantArray(SourceLocation begin, Variant values)
+      : Node(begin), values_(values) {}
+  [[nodiscard]] const Variant &getValues() const { return values_; }
+  [[nodiscard]] size_t size() const {
+    return std::visit([](auto values) { return values.size(); }, values_);
+  }
+};
+
 /**
  * initializer:
  *  assignment-expression
  *  { initializer-list }
  *  { initializer-list , }
+ *  embed-data
  */
 class Initializer final : public Node {
-  using Variant = std::variant<AssignExpr, box<InitializerList>>;
+  using Variant = std::variant<AssignExpr, box<InitializerList>, EmbedData,
+                               ConstantArray>;
   Variant variant_;
 
 public:
-  Initializer(TokIter begin, Variant &&variant)
+  Initializer(SourceLocation begin, Variant &&variant)
       : Node(begin), variant_(MV_(variant)) {}
 
   [[nodiscard]] const Variant &getVariant() const { return variant_; }
@@ -1202,19 +1135,19 @@ class InitializerList final : public Node {
 public:
   using Identifier = std::string_view;
   using Designator = std::variant<ConstantExpr, Identifier>;
-  using DesignatorList = std::vector<Designator>;
+  using DesignatorList = ASTVector<Designator>;
   using Designation = DesignatorList;
   using InitializerPair = std::pair<std::optional<Designation>, Initializer>;
 
 private:
-  std::vector<InitializerPair> initializerPairs_;
+  ASTVector<InitializerPair> initializerPairs_;
 
 public:
-  InitializerList(TokIter begin,
-                  std::vector<InitializerPair> &&initializerPairs)
+  InitializerList(SourceLocation begin,
+                  ASTVector<InitializerPair> &&initializerPairs)
       : Node(begin), initializerPairs_(MV_(initializerPairs)) {}
 
-  const std::vector<InitializerPair> &getInitializerList() const {
+  const ASTVector<InitializerPair> &getInitializerList() const {
     return initializerPairs_;
   }
 };
@@ -1234,24 +1167,24 @@ public:
 class Declaration final : public Node {
 public:
   struct InitDeclarator {
-    TokIter beginLoc_;
+    SourceLocation beginLoc_;
     box<Declarator> declarator_;
     std::optional<Initializer> optionalInitializer_;
   };
 
 private:
   DeclSpec declarationSpecifiers_;
-  std::vector<InitDeclarator> initDeclarators_;
+  ASTVector<InitDeclarator> initDeclarators_;
 
 public:
-  Declaration(TokIter begin, DeclSpec &&declarationSpecifiers,
-              std::vector<InitDeclarator> &&initDeclarators)
+  Declaration(SourceLocation begin, DeclSpec &&declarationSpecifiers,
+              ASTVector<InitDeclarator> &&initDeclarators)
       : Node(begin), declarationSpecifiers_(MV_(declarationSpecifiers)),
         initDeclarators_(MV_(initDeclarators)) {}
   [[nodiscard]] const DeclSpec &getDeclarationSpecifiers() const {
     return declarationSpecifiers_;
   }
-  [[nodiscard]] const std::vector<InitDeclarator> &getInitDeclarators() const {
+  [[nodiscard]] const ASTVector<InitDeclarator> &getInitDeclarators() const {
     return initDeclarators_;
   }
 };
@@ -1270,12 +1203,12 @@ using BlockItem = std::variant<Stmt, Declaration>;
  */
 class BlockStmt final : public Node {
 private:
-  std::vector<BlockItem> blockItems_;
+  ASTVector<BlockItem> blockItems_;
 
 public:
-  BlockStmt(TokIter begin, std::vector<BlockItem> &&blockItems)
+  BlockStmt(SourceLocation begin, ASTVector<BlockItem> &&blockItems)
       : Node(begin), blockItems_(MV_(blockItems)) {}
-  [[nodiscard]] const std::vector<BlockItem> &getBlockItems() const {
+  [[nodiscard]] const ASTVector<BlockItem> &getBlockItems() const {
     return blockItems_;
   }
 };
@@ -1318,13 +1251,13 @@ using DirectDeclarator =
  *  type-qualifier-list{opt} pointer
  */
 class Pointer final : public Node {
-  std::vector<TypeQualifier> typeQualifiers_;
+  ASTVector<TypeQualifier> typeQualifiers_;
 
 public:
-  Pointer(TokIter begin, std::vector<TypeQualifier> &&typeQualifiers)
+  Pointer(SourceLocation begin, ASTVector<TypeQualifier> &&typeQualifiers)
       : Node(begin), typeQualifiers_(MV_(typeQualifiers)) {}
 
-  [[nodiscard]] const std::vector<TypeQualifier> &getTypeQualifiers() const {
+  [[nodiscard]] const ASTVector<TypeQualifier> &getTypeQualifiers() const {
     return typeQualifiers_;
   }
 };
@@ -1335,17 +1268,17 @@ public:
  *  pointer{opt} direct-abstract-declarator
  */
 class AbstractDeclarator final : public Node {
-  std::vector<Pointer> pointers_;
+  ASTVector<Pointer> pointers_;
   std::optional<DirectAbstractDeclarator> directAbstractDeclarator_;
 
 public:
-  AbstractDeclarator(TokIter begin, std::vector<Pointer> &&pointers,
+  AbstractDeclarator(SourceLocation begin, ASTVector<Pointer> &&pointers,
                      std::optional<DirectAbstractDeclarator>
                          &&directAbstractDeclarator = {std::nullopt})
       : Node(begin), pointers_(MV_(pointers)),
         directAbstractDeclarator_(MV_(directAbstractDeclarator)) {}
 
-  [[nodiscard]] const std::vector<Pointer> &getPointers() const {
+  [[nodiscard]] const ASTVector<Pointer> &getPointers() const {
     return pointers_;
   }
 
@@ -1361,24 +1294,66 @@ public:
 /**
  * declarator:
  *  pointer{opt} direct-declarator
+ *
+ * the name, the function declarator and the shape are found once, when the
+ * declarator is made, from those of the declarator it nests
  */
 class Declarator final : public Node {
-  std::vector<Pointer> pointers_;
+public:
+  /// what a declarator makes of the type of its specifiers, read from the
+  /// name outwards: `*a[3]` is {Array, Pointer}, an array of pointers
+  enum class Derivation : uint8_t { Pointer = 1, Array, Function };
+  /// the derivations past it are counted but not kept
+  static constexpr unsigned MaxDerivations = 32;
+
+private:
+  /// saturates at UINT8_MAX
+  uint8_t mNumDerivations{0};
+  ASTVector<Pointer> pointers_;
   DirectDeclarator directDeclarator_;
+  std::string_view mName;
+  const DirectDeclaratorParamTypeList *mFuncDeclarator{nullptr};
+  /// two bits for each derivation, the first in the low bits
+  uint64_t mDerivations{0};
+
+  void setDerivation(unsigned index, Derivation derivation) {
+    if (index < MaxDerivations) {
+      mDerivations |= uint64_t(derivation) << (index * 2);
+    }
+  }
+  /// the direct-declarator a suffix applies to, and the suffix
+  static const DirectDeclarator *getInner(const DirectDeclarator &direct,
+                                          Derivation &derivation);
 
 public:
-  Declarator(TokIter begin, std::vector<Pointer> &&pointers,
-             DirectDeclarator &&directDeclarator)
-      : Node(begin), pointers_(MV_(pointers)),
-        directDeclarator_(MV_(directDeclarator)) {}
+  Declarator(SourceLocation begin, ASTVector<Pointer> &&pointers,
+             DirectDeclarator &&directDeclarator);
 
-  [[nodiscard]] const std::vector<Pointer> &getPointers() const {
+  [[nodiscard]] const ASTVector<Pointer> &getPointers() const {
     return pointers_;
   }
 
   [[nodiscard]] const DirectDeclarator &getDirectDeclarator() const {
     return directDeclarator_;
   }
+
+  [[nodiscard]] std::string_view getName() const { return mName; }
+  /// the innermost function declarator, the one whose parameters belong to
+  /// the declared name: `(*f(int))(char)` gives `f(int)`. It is set for a
+  /// pointer to function as well, `(*fp)(int)` gives `(*fp)(int)`, check
+  /// isFunction() before taking the parameters as those of a function
+  [[nodiscard]] const DirectDeclaratorParamTypeList *getFuncDeclarator() const {
+    return mFuncDeclarator;
+  }
+  [[nodiscard]] unsigned getNumDerivations() const { return mNumDerivations; }
+  /// `index` < min(getNumDerivations(), MaxDerivations)
+  [[nodiscard]] Derivation getDerivation(unsigned index) const {
+    assert(index < MaxDerivations && index < mNumDerivations);
+    return Derivation(mDerivations >> (index * 2) & 3);
+  }
+  [[nodiscard]] bool isFunction() const {
+    return mNumDerivations && getDerivation(0) == Derivation::Function;
+  }
 };
 
 /**
@@ -1393,7 +1368,7 @@ public:
   Variant declaratorKind_;
 
 public:
-  ParameterDeclaration(TokIter begin, DeclSpec &&declSpec,
+  ParameterDeclaration(SourceLocation begin, DeclSpec &&declSpec,
                        Variant &&variant = {std::nullopt})
       : Node(begin), declSpec_(MV_(declSpec)), declaratorKind_(MV_(variant)) {}
   [[nodiscard]] const DeclSpec &getDeclSpec() const { return declSpec_; }
@@ -1406,13 +1381,13 @@ public:
  */
 class ParamList final : public Node {
 private:
-  std::vector<ParameterDeclaration> parameterList_;
+  ASTVector<ParameterDeclaration> parameterList_;
 
 public:
-  ParamList(TokIter begin, std::vector<ParameterDeclaration> &&parameterList)
+  ParamList(SourceLocation begin, ASTVector<ParameterDeclaration> &&parameterList)
       : Node(begin), parameterList_(MV_(parameterList)) {}
 
-  [[nodiscard]] const std::vector<ParameterDeclaration> &
+  [[nodiscard]] const ASTVector<ParameterDeclaration> &
   getParameterDeclarations() const {
     return parameterList_;
   }
@@ -1428,7 +1403,7 @@ class ParamTypeList final : public Node {
   bool hasEllipse_;
 
 public:
-  ParamTypeList(TokIter begin, ParamList &&parameterList, bool hasEllipse)
+  ParamTypeList(SourceLocation begin, ParamList &&parameterList, bool hasEllipse)
       : Node(begin), parameterList_(MV_(parameterList)),
         hasEllipse_(hasEllipse) {}
 
@@ -1447,7 +1422,7 @@ class DirectAbstractDeclaratorParentheses final : public Node {
   AbstractDeclarator abstractDeclarator_;
 
 public:
-  DirectAbstractDeclaratorParentheses(TokIter begin,
+  DirectAbstractDeclaratorParentheses(SourceLocation begin,
                                       AbstractDeclarator &&abstractDeclarator)
       : Node(begin), abstractDeclarator_(MV_(abstractDeclarator)) {}
 
@@ -1467,15 +1442,15 @@ public:
  */
 class DirectAbstractDeclaratorAssignExpr final : public Node {
   std::optional<DirectAbstractDeclarator> optionalDirectAbstractDeclarator_;
-  std::vector<TypeQualifier> typeQualifiers_;
+  ASTVector<TypeQualifier> typeQualifiers_;
   std::optional<AssignExpr> optionalAssignExpr_;
   bool hasStatic_{false};
 
 public:
   DirectAbstractDeclaratorAssignExpr(
-      TokIter begin,
+      SourceLocation begin,
       std::optional<DirectAbstractDeclarator> &&directAbstractDeclarator,
-      std::vector<TypeQualifier> &&typeQualifiers,
+      ASTVector<TypeQualifier> &&typeQualifiers,
       std::optional<AssignExpr> &&assignExpr, bool hasStatic)
       : Node(begin),
         optionalDirectAbstractDeclarator_(MV_(directAbstractDeclarator)),
@@ -1490,7 +1465,7 @@ public:
     return nullptr;
   }
 
-  [[nodiscard]] const std::vector<TypeQualifier> &getTypeQualifiers() const {
+  [[nodiscard]] const ASTVector<TypeQualifier> &getTypeQualifiers() const {
     return typeQualifiers_;
   }
 
@@ -1510,7 +1485,7 @@ class DirectAbstractDeclaratorAsterisk final : public Node {
 
 public:
   DirectAbstractDeclaratorAsterisk(
-      TokIter begin,
+      SourceLocation begin,
       std::optional<DirectAbstractDeclarator> &&directAbstractDeclarator)
       : Node(begin),
         optionalDirectAbstractDeclarator_(MV_(directAbstractDeclarator)) {}
@@ -1534,7 +1509,7 @@ class DirectAbstractDeclaratorParamTypeList final : public Node {
 
 public:
   DirectAbstractDeclaratorParamTypeList(
-      TokIter begin,
+      SourceLocation begin,
       std::optional<DirectAbstractDeclarator> &&directAbstractDeclarator,
       std::optional<ParamTypeList> &&paramTypeList)
       : Node(begin),
@@ -1565,7 +1540,7 @@ class DirectDeclaratorIdent final : public Node {
   std::string_view mIdent;
 
 public:
-  DirectDeclaratorIdent(TokIter begin, std::string_view ident)
+  DirectDeclaratorIdent(SourceLocation begin, std::string_view ident)
       : Node(begin), mIdent(ident) {}
 
   [[nodiscard]] const std::string_view &getIdent() const { return mIdent; }
@@ -1579,7 +1554,7 @@ class DirectDeclaratorParentheses final : public Node {
   Declarator declarator_;
 
 public:
-  DirectDeclaratorParentheses(TokIter begin, Declarator &&declarator)
+  DirectDeclaratorParentheses(SourceLocation begin, Declarator &&declarator)
       : Node(begin), declarator_(MV_(declarator)) {}
 
   [[nodiscard]] const Declarator &getDeclarator() const { return declarator_; }
@@ -1594,7 +1569,7 @@ class DirectDeclaratorParamTypeList final : public Node {
   ParamTypeList paramTypeList_;
 
 public:
-  DirectDeclaratorParamTypeList(TokIter begin,
+  DirectDeclaratorParamTypeList(SourceLocation begin,
                                 DirectDeclarator &&directDeclarator,
                                 ParamTypeList &&paramTypeList)
       : Node(begin), directDeclarator_(MV_(directDeclarator)),
@@ -1618,13 +1593,13 @@ public:
 class DirectDeclaratorAssignExpr final : public Node {
   DirectDeclarator directDeclarator_;
   std::optional<AssignExpr> optionalAssignExpr_;
-  std::vector<TypeQualifier> typeQualifierList_;
+  ASTVector<TypeQualifier> typeQualifierList_;
   bool hasStatic_{false};
 
 public:
   DirectDeclaratorAssignExpr(
-      TokIter begin, DirectDeclarator &&directDeclarator,
-      std::vector<TypeQualifier> &&typeQualifierList,
+      SourceLocation begin, DirectDeclarator &&directDeclarator,
+      ASTVector<TypeQualifier> &&typeQualifierList,
       std::optional<AssignExpr> &&assignExpr = {std::nullopt},
       bool hasStatic = false)
       : Node(begin), directDeclarator_(MV_(directDeclarator)),
@@ -1635,7 +1610,7 @@ public:
     return directDeclarator_;
   }
 
-  [[nodiscard]] const std::vector<TypeQualifier> &getTypeQualifierList() const {
+  [[nodiscard]] const ASTVector<TypeQualifier> &getTypeQualifierList() const {
     return typeQualifierList_;
   }
 
@@ -1655,11 +1630,11 @@ public:
  */
 class DirectDeclaratorAsterisk final : public Node {
   DirectDeclarator directDeclarator_;
-  std::vector<TypeQualifier> typeQualifierList_;
+  ASTVector<TypeQualifier> typeQualifierList_;
 
 public:
-  DirectDeclaratorAsterisk(TokIter begin, DirectDeclarator &&directDeclarator,
-                           std::vector<TypeQualifier> &&typeQualifierList)
+  DirectDeclaratorAsterisk(SourceLocation begin, DirectDeclarator &&directDeclarator,
+                           ASTVector<TypeQualifier> &&typeQualifierList)
       : Node(begin), directDeclarator_(MV_(directDeclarator)),
         typeQualifierList_(MV_(typeQualifierList)) {}
 
@@ -1667,11 +1642,74 @@ public:
     return directDeclarator_;
   }
 
-  [[nodiscard]] const std::vector<TypeQualifier> &getTypeQualifierList() const {
+  [[nodiscard]] const ASTVector<TypeQualifier> &getTypeQualifierList() const {
     return typeQualifierList_;
   }
 };
 
+inline const DirectDeclarator *
+Declarator::getInner(const DirectDeclarator &direct, Derivation &derivation) {
+  if (const auto *function =
+          std::get_if<box<DirectDeclaratorParamTypeList>>(&direct)) {
+    derivation = Derivation::Function;
+    return &(*function)->getDirectDeclarator();
+  }
+  derivation = Derivation::Array;
+  if (const auto *array =
+          std::get_if<box<DirectDeclaratorAssignExpr>>(&direct)) {
+    return &(*array)->getDirectDeclarator();
+  }
+  if (const auto *vla = std::get_if<box<DirectDeclaratorAsterisk>>(&direct)) {
+    return &(*vla)->getDirectDeclarator();
+  }
+  /// an identifier or ( declarator ), the bottom of the chain
+  return nullptr;
+}
+
+inline Declarator::Declarator(SourceLocation begin,
+                              ASTVector<Pointer> &&pointers,
+                              DirectDeclarator &&directDeclarator)
+    : Node(begin), pointers_(MV_(pointers)),
+      directDeclarator_(MV_(directDeclarator)) {
+  /// the suffixes of this level are nested outermost first, they apply
+  /// innermost first
+  unsigned numSuffixes = 0, numNested = 0;
+  Derivation derivation;
+  const DirectDeclarator *bottom = &directDeclarator_;
+  for (const auto *inner = getInner(*bottom, derivation); inner;
+       inner = getInner(*bottom, derivation)) {
+    if (derivation == Derivation::Function) {
+      mFuncDeclarator =
+          std::get<box<DirectDeclaratorParamTypeList>>(*bottom).get();
+    }
+    bottom = inner;
+    ++numSuffixes;
+  }
+  if (const auto *ident = std::get_if<box<DirectDeclaratorIdent>>(bottom)) {
+    mName = (*ident)->getIdent();
+  } else {
+    const auto &nested =
+        std::get<box<DirectDeclaratorParentheses>>(*bottom)->getDeclarator();
+    mName = nested.mName;
+    if (nested.mFuncDeclarator) {
+      mFuncDeclarator = nested.mFuncDeclarator;
+    }
+    numNested = nested.mNumDerivations;
+    mDerivations = nested.mDerivations;
+  }
+  unsigned index = numNested + numSuffixes;
+  const DirectDeclarator *outer = &directDeclarator_;
+  while (const auto *inner = getInner(*outer, derivation)) {
+    setDerivation(--index, derivation);
+    outer = inner;
+  }
+  index = numNested + numSuffixes;
+  for (size_t i = 0; i < pointers_.size(); ++i) {
+    setDerivation(index++, Derivation::Pointer);
+  }
+  mNumDerivations = std::min<unsigned>(index, UINT8_MAX);
+}
+
 /**
  * struct-or-union-specifier:
  *  struct-or-union identifier{opt} { struct-declaration-list }
@@ -1695,24 +1733,24 @@ public:
 class StructOrUnionSpec final : public Node {
 public:
   struct StructDeclarator {
-    TokIter beginLoc_;
+    SourceLocation beginLoc_;
     std::optional<Declarator> optionalDeclarator_;
     std::optional<ConstantExpr> optionalBitfield_;
   };
   struct StructDeclaration {
-    TokIter beginLoc_;
+    SourceLocation beginLoc_;
     DeclSpec specifierQualifiers_;
-    std::vector<StructDeclarator> structDeclarators_;
+    ASTVector<StructDeclarator> structDeclarators_;
   };
 
 private:
   std::string_view name_;
   bool isUnion_;
-  std::vector<StructDeclaration> structDeclarations_;
+  ASTVector<StructDeclaration> structDeclarations_;
 
 public:
-  StructOrUnionSpec(TokIter begin, bool isUnion, std::string_view identifier,
-                    std::vector<StructDeclaration> &&structDeclarations)
+  StructOrUnionSpec(SourceLocation begin, bool isUnion, std::string_view identifier,
+                    ASTVector<StructDeclaration> &&structDeclarations)
       : Node(begin), name_(identifier), isUnion_(isUnion),
         structDeclarations_(MV_(structDeclarations)) {}
 
@@ -1720,7 +1758,7 @@ public:
 
   [[nodiscard]] std::string_view getTag() const { return name_; }
 
-  [[nodiscard]] const std::vector<StructDeclaration> &
+  [[nodiscard]] const ASTVector<StructDeclaration> &
   getStructDeclarations() const {
     return structDeclarations_;
   }
@@ -1746,22 +1784,22 @@ public:
 class EnumSpecifier final : public Node {
 public:
   struct Enumerator {
-    TokIter beginLoc_;
+    SourceLocation beginLoc_;
     std::string_view name_;
     std::optional<ConstantExpr> optionalConstantExpr_{std::nullopt};
   };
 
 private:
   std::string_view tagName_;
-  std::vector<Enumerator> enumerators_;
+  ASTVector<Enumerator> enumerators_;
 
 public:
-  EnumSpecifier(TokIter begin, std::string_view tagName,
-                std::vector<Enumerator> &&enumerators)
+  EnumSpecifier(SourceLocation begin, std::string_view tagName,
+                ASTVector<Enumerator> &&enumerators)
       : Node(begin), tagName_(tagName), enumerators_(MV_(enumerators)) {}
 
   [[nodiscard]] std::string_view getName() const { return tagName_; }
-  [[nodiscard]] const std::vector<Enumerator> &getEnumerators() const {
+  [[nodiscard]] const ASTVector<Enumerator> &getEnumerators() const {
     return enumerators_;
   }
 };
@@ -1776,7 +1814,7 @@ class FunctionDefinition final : public Node {
   BlockStmt compoundStmt_;
 
 public:
-  FunctionDefinition(TokIter begin, DeclSpec &&declarationSpecifiers,
+  FunctionDefinition(SourceLocation begin, DeclSpec &&declarationSpecifiers,
                      Declarator &&declarator, BlockStmt &&compoundStmt)
       : Node(begin), declarationSpecifiers_(MV_(declarationSpecifiers)),
         declarator_(MV_(declarator)), compoundStmt_(MV_(compoundStmt)) {}
@@ -1790,6 +1828,10 @@ public:
   [[nodiscard]] const BlockStmt &getCompoundStatement() const {
     return compoundStmt_;
   }
+  /// for a body the parser left for later
+  void setCompoundStatement(BlockStmt &&compoundStmt) {
+    compoundStmt_ = MV_(compoundStmt);
+  }
 };
 
 /**
@@ -1805,17 +1847,43 @@ using ExternalDeclaration = std::variant<Declaration, FunctionDefinition>;
  *  translation-unit external-declaration
  */
 class TranslationUnit final {
-  std::vector<ExternalDeclaration> mGlobals;
-
-public:
-  explicit TranslationUnit(TokIter begin,
-                           std::vector<ExternalDeclaration> &&globals) noexcept
-      : mGlobals(MV_(globals)) {}
-
-  [[nodiscard]] const std::vector<ExternalDeclaration> &getGlobals() const {
-    return mGlobals;
-  }
-};
+  /// owns every node of the tree, the globals included
+  std::unique_ptr<ASTContext> mContext;
+  ASTVector<ExternalDeclaration> *mGlobals;
+
+public:
+  TranslationUnit(std::unique_ptr<ASTContext> context,
+                  ASTVector<ExternalDeclaration> &&globals) noexcept
+      : mContext(MV_(context)),
+        mGlobals(mContext->New<ASTVector<ExternalDeclaration>>(MV_(globals))) {
+  }
+
+  [[nodiscard]] const ASTVector<ExternalDeclaration> &getGlobals() const {
+    return *mGlobals;
+  }
+  [[nodiscard]] const ASTContext &getContext() const { return *mContext; }
+};
+
+/// the sizes on 64 bit hosts, a node growing past them costs memory for every
+/// one of its kind in the tree, bump them only on purpose
+static_assert(sizeof(Node) == sizeof(SourceLocation),
+              "a node keeps nothing but its location");
+static_assert(sizeof(void *) != 8 || sizeof(DeclSpec) <= 56);
+static_assert(sizeof(void *) != 8 || sizeof(TypeSpec) <= 32);
+static_assert(sizeof(void *) != 8 || sizeof(TypeName) <= 80);
+static_assert(sizeof(void *) != 8 || sizeof(Declaration) <= 96);
+static_assert(sizeof(void *) != 8 || sizeof(Declarator) <= 88);
+static_assert(sizeof(void *) != 8 || sizeof(PrimaryExprIdent) <= 24);
+static_assert(sizeof(void *) != 8 || sizeof(PrimaryExprConstant) <= 32);
+static_assert(sizeof(void *) != 8 || sizeof(ConstantArray) <= 32);
+static_assert(sizeof(void *) != 8 || sizeof(PostFixExpr) <= 48);
+static_assert(sizeof(void *) != 8 || sizeof(CastExpr) <= 72);
+static_assert(sizeof(void *) != 8 || sizeof(BinaryExpr) <= 40);
+static_assert(sizeof(void *) != 8 || sizeof(CondExpr) <= 56);
+static_assert(sizeof(void *) != 8 || sizeof(AssignExpr) <= 96);
+static_assert(sizeof(void *) != 8 || sizeof(Expr) <= 40);
+static_assert(sizeof(void *) != 8 || sizeof(Stmt) <= 16);
+static_assert(sizeof(void *) != 8 || sizeof(BlockStmt) <= 40);
 } // namespace lcc::Syntax
 
 #endif // LCC_SYNTAX_H
@@ -0,0 +1,164 @@
+/***********************************
+ * File:     ASTContext.h
+ *
+ * Author:   caipeng
+ *
+ * Email:    iiicp@outlook.com
+ *
+ * Date:     2023/6/17
+ *
+ * Sign:     enjoy life
+ ***********************************/
+
+#ifndef LCC_ASTCONTEXT_H
+#define LCC_ASTCONTEXT_H
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/raw_ostream.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace lcc {
+
+/// The memory of the syntax tree of one translation unit. Nodes, the
+/// buffers of their vectors and the string literals are bump allocated from
+/// slabs, nothing is freed or destroyed on its own: the slabs are released in
+/// one go with the context, at the end of the translation unit.
+///
+/// The parser makes its context current for the thread while it runs, `box`
+/// and ASTVector pick the current context up when they are created, so the
+/// node constructors don't have to pass it around.
+class ASTContext {
+private:
+  struct Slab {
+    char *Begin;
+    size_t Size;
+    /// mapped for huge pages, else from malloc
+    bool Mapped;
+  };
+
+  char *mCur{nullptr};
+  char *mEnd{nullptr};
+  llvm::SmallVector<Slab, 8> mSlabs;
+  bool mHugePages;
+  size_t mNumAllocations{0};
+  size_t mBytesAllocated{0};
+  /// the containers of the adopted nodes still refer to them
+  std::vector<std::unique_ptr<ASTContext>> mAdopted;
+
+  static inline thread_local ASTContext *sCurrent = nullptr;
+
+public:
+  /// with `hugePages` the slabs are 2MB aligned and advised as transparent
+  /// huge pages, which saves TLB misses on a large tree, where the system
+  /// supports it
+  explicit ASTContext(bool hugePages = false) : mHugePages(hugePages) {}
+  ~ASTContext();
+  ASTContext(const ASTContext &) = delete;
+  ASTContext &operator=(const ASTContext &) = delete;
+
+  /// the context of the tree being built on this thread, or null
+  static ASTContext *getCurrent() { return sCurrent; }
+
+  /// makes a context current for a scope
+  class CurrentScope {
+    ASTContext *mPrev;
+
+  public:
+    explicit CurrentScope(ASTContext &context) : mPrev(sCurrent) {
+      sCurrent = &context;
+    }
+    ~CurrentScope() { sCurrent = mPrev; }
+    CurrentScope(const CurrentScope &) = delete;
+    CurrentScope &operator=(const CurrentScope &) = delete;
+  };
+
+  void *Allocate(size_t size, size_t alignment) {
+    ++mNumAllocations;
+    mBytesAllocated += size;
+    auto cur = reinterpret_cast<uintptr_t>(mCur);
+    uintptr_t aligned = (cur + alignment - 1) & ~uintptr_t(alignment - 1);
+    if (mCur && aligned + size <= reinterpret_cast<uintptr_t>(mEnd)) {
+      mCur = reinterpret_cast<char *>(aligned + size);
+      return reinterpret_cast<void *>(aligned);
+    }
+    return AllocateSlow(size, alignment);
+  }
+
+  /// never destroyed, `T` may only own memory of this context
+  template <typename T, typename... Args> T *New(Args &&...args) {
+    return new (Allocate(sizeof(T), alignof(T)))
+        T(std::forward<Args>(args)...);
+  }
+
+  std::string_view CopyString(std::string_view str) {
+    if (str.empty()) {
+      return {};
+    }
+    auto *data = static_cast<char *>(Allocate(str.size(), 1));
+    std::memcpy(data, str.data(), str.size());
+    return {data, str.size()};
+  }
+
+  /// keeps a context another thread built nodes in alive as long as this
+  /// one, its slabs count as this one's
+  void Adopt(std::unique_ptr<ASTContext> other);
+
+  [[nodiscard]] size_t getNumAllocations() const { return mNumAllocations; }
+  [[nodiscard]] size_t getBytesAllocated() const { return mBytesAllocated; }
+  [[nodiscard]] size_t getBytesReserved() const;
+  [[nodiscard]] size_t getNumSlabs() const { return mSlabs.size(); }
+  void PrintStats(llvm::raw_ostream &os) const;
+
+private:
+  void *AllocateSlow(size_t size, size_t alignment);
+  Slab NewSlab(size_t minSize);
+};
+
+/// An allocator for the containers inside the nodes, from the context which
+/// is current when the container is created, or from the heap when there is
+/// none. Deallocating from a context does nothing.
+template <typename T> class ASTAllocator {
+private:
+  template <typename U> friend class ASTAllocator;
+  ASTContext *mContext;
+
+public:
+  using value_type = T;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+
+  ASTAllocator() : mContext(ASTContext::getCurrent()) {}
+  template <typename U>
+  ASTAllocator(const ASTAllocator<U> &other) : mContext(other.mContext) {}
+
+  T *allocate(size_t n) {
+    if (mContext) {
+      return static_cast<T *>(mContext->Allocate(n * sizeof(T), alignof(T)));
+    }
+    return static_cast<T *>(::operator new(n * sizeof(T)));
+  }
+  void deallocate(T *ptr, size_t) {
+    if (!mContext) {
+      ::operator delete(ptr);
+    }
+  }
+
+  template <typename U> bool operator==(const ASTAllocator<U> &other) const {
+    return mContext == other.mContext;
+  }
+  template <typename U> bool operator!=(const ASTAllocator<U> &other) const {
+    return mContext != other.mContext;
+  }
+};
+
+template <typename T> using ASTVector = std::vector<T, ASTAllocator<T>>;
+} // namespace lcc
+
+#endif // LCC_ASTCONTEXT_H
@@ -0,0 +1,329 @@
+/***********************************
+ * File:     ASTVisitor.h
+ *
+ * Author:   caipeng
+ *
+ * Email:    iiicp@outlook.com
+ *
+ * Date:     2023/6/18
+ *
+ * Sign:     enjoy life
+ ***********************************/
+
+#ifndef LCC_ASTVISITOR_H
+#define LCC_ASTVISITOR_H
+
+#include "lcc/AST/AST.h"
+#include "lcc/Basic/Match.h"
+#include "llvm/ADT/SmallVector.h"
+#include <algorithm>
+#include <type_traits>
+
+namespace lcc::Syntax {
+
+/// A walk over the syntax tree for the passes which need one, after clang's
+/// RecursiveASTVisitor. `Derived` hides the hooks of the node classes it
+/// cares about, for a node class X:
+///
+///   bool VisitX(const X &)      before the children of the node, false
+///                               leaves them out
+///   void PostVisitX(const X &)  after the children
+///
+/// The hooks are bound at compile time, one which is not hidden costs
+/// nothing. The children are visited in source order. The nodes still to
+/// visit are kept on a work stack of the visitor rather than on the C stack,
+/// a tree thousands of levels deep, as generated code makes, is walked in
+/// constant stack.
+template <typename Derived> class ASTVisitor {
+public:
+#define AST_NODE(Name)                                                         \
+  bool Visit##Name(const Name &) { return true; }                              \
+  void PostVisit##Name(const Name &) {}
+#include "lcc/AST/ASTNodes.def"
+
+  void Traverse(const TranslationUnit &unit) {
+    size_t base = Enter();
+    Push(unit.getGlobals());
+    std::reverse(mStack.begin() + base, mStack.end());
+    Run(base);
+  }
+  /// `node` and all below it, a node class or any of the variants, boxes
+  /// and vectors of them. A hook may start a walk of its own.
+  template <typename T> void Traverse(const T &node) {
+    size_t base = Enter();
+    Push(node);
+    std::reverse(mStack.begin() + base, mStack.end());
+    Run(base);
+  }
+
+  /// ends the walk once the current hook returns
+  void Stop() { mStopped = true; }
+  [[nodiscard]] bool isStopped() const { return mStopped; }
+
+private:
+  enum class Kind : uint8_t {
+#define AST_NODE(Name) Name,
+#include "lcc/AST/ASTNodes.def"
+  };
+  struct WorkItem {
+    const void *Node;
+    Kind NodeKind;
+    /// the post-order hook of Node, below its children on the stack
+    bool Post;
+  };
+
+  llvm::SmallVector<WorkItem, 32> mStack;
+  bool mStopped{false};
+
+  Derived &derived() { return *static_cast<Derived *>(this); }
+
+  size_t Enter() {
+    if (mStack.empty()) {
+      mStopped = false;
+    }
+    return mStack.size();
+  }
+
+  void Run(size_t base) {
+    while (mStack.size() > base && !mStopped) {
+      Step(mStack.pop_back_val());
+    }
+    mStack.truncate(std::min(mStack.size(), base));
+  }
+
+  void Step(WorkItem item) {
+    switch (item.NodeKind) {
+#define AST_NODE(Name)                                                         \
+  case Kind::Name: {                                                           \
+    const auto &node = *static_cast<const Name *>(item.Node);                  \
+    if (item.Post) {                                                           \
+      derived().PostVisit##Name(node);                                         \
+    } else if (derived().Visit##Name(node)) {                                  \
+      if constexpr (!std::is_same_v<decltype(&Derived::PostVisit##Name),       \
+                                    void (ASTVisitor::*)(const Name &)>) {     \
+        mStack.push_back({item.Node, Kind::Name, true});                       \
+      }                                                                        \
+      size_t first = mStack.size();                                            \
+      PushChildren(node);                                                      \
+      std::reverse(mStack.begin() + first, mStack.end());                      \
+    }                                                                          \
+    break;                                                                     \
+  }
+#include "lcc/AST/ASTNodes.def"
+    }
+  }
+
+#define AST_NODE(Name)                                                         \
+  void Push(const Name &node) { mStack.push_back({&node, Kind::Name, false}); }
+#include "lcc/AST/ASTNodes.def"
+
+  template <typename T> void Push(const box<T> &node) { Push(*node); }
+  template <typename T> void Push(const T *node) {
+    if (node) {
+      Push(*node);
+    }
+  }
+  template <typename T> void Push(const std::optional<T> &node) {
+    if (node) {
+      Push(*node);
+    }
+  }
+  template <typename... Ts> void Push(const std::variant<Ts...> &node) {
+    lcc::visit([this](const auto &alt) { Push(alt); }, node);
+  }
+  template <typename T> void Push(const ASTVector<T> &nodes) {
+    for (const auto &node : nodes) {
+      Push(node);
+    }
+  }
+  template <typename T, typename U> void Push(const std::pair<T, U> &pair) {
+    Push(pair.first);
+    Push(pair.second);
+  }
+  /// the names and operators kept beside the nodes
+  void Push(std::string_view) {}
+  void Push(AssignExpr::AssignOp) {}
+  void Push(const Declaration::InitDeclarator &initDeclarator) {
+    Push(initDeclarator.declarator_);
+    Push(initDeclarator.optionalInitializer_);
+  }
+  void Push(const StructOrUnionSpec::StructDeclaration &declaration) {
+    Push(declaration.specifierQualifiers_);
+    Push(declaration.structDeclarators_);
+  }
+  void Push(const StructOrUnionSpec::StructDeclarator &declarator) {
+    Push(declarator.optionalDeclarator_);
+    Push(declarator.optionalBitfield_);
+  }
+  void Push(const EnumSpecifier::Enumerator &enumerator) {
+    Push(enumerator.optionalConstantExpr_);
+  }
+
+  void PushChildren(const PrimaryExprIdent &) {}
+  void PushChildren(const PrimaryExprConstant &) {}
+  void PushChildren(const PrimaryExprParentheses &node) {
+    Push(node.getExpr());
+  }
+  void PushChildren(const PostFixExprSubscript &node) {
+    Push(node.getPostFixExpr());
+    Push(node.getExpr());
+  }
+  void PushChildren(const PostFixExprFuncCall &node) {
+    Push(node.getPostFixExpr());
+    Push(node.getOptionalAssignExpressions());
+  }
+  void PushChildren(const PostFixExprDot &node) {
+    Push(node.getPostFixExpr());
+  }
+  void PushChildren(const PostFixExprArrow &node) {
+    Push(node.getPostFixExpr());
+  }
+  void PushChildren(const PostFixExprIncrement &node) {
+    Push(node.getPostFixExpr());
+  }
+  void PushChildren(const PostFixExprDecrement &node) {
+    Push(node.getPostFixExpr());
+  }
+  void PushChildren(const PostFixExprTypeInitializer &node) {
+    Push(node.getTypeName());
+    Push(node.getInitializerList());
+  }
+  void PushChildren(const UnaryExprUnaryOperator &node) {
+    Push(node.getVariant());
+  }
+  void PushChildren(const UnaryExprSizeOf &node) { Push(node.getVariant()); }
+  void PushChildren(const TypeSpec &node) { Push(node.getVariant()); }
+  void PushChildren(const TypeQualifier &) {}
+  void PushChildren(const DeclSpec &node) { Push(node.getTypeSpec()); }
+  void PushChildren(const TypeName &node) {
+    Push(node.getSpecifierQualifiers());
+    Push(node.getAbstractDeclarator());
+  }
+  void PushChildren(const CastExpr &node) { Push(node.getVariant()); }
+  void PushChildren(const BinaryExpr &node) {
+    Push(node.getLhs());
+    Push(node.getRhs());
+  }
+  void PushChildren(const CondExpr &node) {
+    Push(node.getLogicalOrExpression());
+    Push(node.getOptionalExpression());
+    Push(node.getOptionalConditionalExpression());
+  }
+  void PushChildren(const AssignExpr &node) {
+    Push(node.getConditionalExpr());
+    Push(node.getOptionalConditionalExpr());
+  }
+  void PushChildren(const Expr &node) { Push(node.getAssignExpressions()); }
+  void PushChildren(const ExprStmt &node) {
+    Push(node.getOptionalExpression());
+  }
+  void PushChildren(const IfStmt &node) {
+    Push(node.getExpression());
+    Push(node.getThenStmt());
+    Push(node.getElseStmt());
+  }
+  void PushChildren(const SwitchStmt &node) {
+    Push(node.getExpression());
+    Push(node.getStatement());
+  }
+  void PushChildren(const DefaultStmt &node) { Push(node.getStatement()); }
+  void PushChildren(const CaseStmt &node) {
+    Push(node.getConstantExpr());
+    Push(node.getStatement());
+  }
+  void PushChildren(const LabelStmt &) {}
+  void PushChildren(const GotoStmt &) {}
+  void PushChildren(const DoWhileStmt &node) {
+    Push(node.getStatement());
+    Push(node.getExpression());
+  }
+  void PushChildren(const WhileStmt &node) {
+    Push(node.getExpression());
+    Push(node.getStatement());
+  }
+  void PushChildren(const ForStmt &node) {
+    Push(node.getInitial());
+    Push(node.getControlling());
+    Push(node.getPost());
+    Push(node.getStatement());
+  }
+  void PushChildren(const BreakStmt &) {}
+  void PushChildren(const ContinueStmt &) {}
+  void PushChildren(const ReturnStmt &node) { Push(node.getExpression()); }
+  void PushChildren(const EmbedData &) {}
+  void PushChildren(const ConstantArray &) {}
+  void PushChildren(const Initializer &node) { Push(node.getVariant()); }
+  void PushChildren(const InitializerList &node) {
+    Push(node.getInitializerList());
+  }
+  void PushChildren(const Declaration &node) {
+    Push(node.getDeclarationSpecifiers());
+    Push(node.getInitDeclarators());
+  }
+  void PushChildren(const BlockStmt &node) { Push(node.getBlockItems()); }
+  void PushChildren(const Pointer &node) { Push(node.getTypeQualifiers()); }
+  void PushChildren(const AbstractDeclarator &node) {
+    Push(node.getPointers());
+    Push(node.getDirectAbstractDeclarator());
+  }
+  void PushChildren(const Declarator &node) {
+    Push(node.getPointers());
+    Push(node.getDirectDeclarator());
+  }
+  void PushChildren(const ParameterDeclaration &node) {
+    Push(node.getDeclSpec());
+    Push(node.declaratorKind_);
+  }
+  void PushChildren(const ParamList &node) {
+    Push(node.getParameterDeclarations());
+  }
+  void PushChildren(const ParamTypeList &node) {
+    Push(node.getParameterList());
+  }
+  void PushChildren(const DirectAbstractDeclaratorParentheses &node) {
+    Push(node.getAbstractDeclarator());
+  }
+  void PushChildren(const DirectAbstractDeclaratorAssignExpr &node) {
+    Push(node.getDirectAbstractDeclarator());
+    Push(node.getTypeQualifiers());
+    Push(node.getAssignmentExpression());
+  }
+  void PushChildren(const DirectAbstractDeclaratorAsterisk &node) {
+    Push(node.getDirectAbstractDeclarator());
+  }
+  void PushChildren(const DirectAbstractDeclaratorParamTypeList &node) {
+    Push(node.getDirectAbstractDeclarator());
+    Push(node.getParameterTypeList());
+  }
+  void PushChildren(const DirectDeclaratorIdent &) {}
+  void PushChildren(const DirectDeclaratorParentheses &node) {
+    Push(node.getDeclarator());
+  }
+  void PushChildren(const DirectDeclaratorParamTypeList &node) {
+    Push(node.getDirectDeclarator());
+    Push(node.getParamTypeList());
+  }
+  void PushChildren(const DirectDeclaratorAssignExpr &node) {
+    Push(node.getDirectDeclarator());
+    Push(node.getTypeQualifierList());
+    Push(node.getAssignmentExpression());
+  }
+  void PushChildren(const DirectDeclaratorAsterisk &node) {
+    Push(node.getDirectDeclarator());
+    Push(node.getTypeQualifierList());
+  }
+  void PushChildren(const StructOrUnionSpec &node) {
+    Push(node.getStructDeclarations());
+  }
+  void PushChildren(const EnumSpecifier &node) {
+    Push(node.getEnumerators());
+  }
+  void PushChildren(const FunctionDefinition &node) {
+    Push(node.getDeclarationSpecifiers());
+    Push(node.getDeclarator());
+    Push(node.getCompoundStatement());
+  }
+};
+} // namespace lcc::Syntax
+
+#endif // LCC_ASTVISITOR_H
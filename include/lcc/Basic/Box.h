@@ -12,36 +12,59 @@
 #ifndef LCC_BOX_H
 #define LCC_BOX_H
 
-#include <memory>
+#include "lcc/AST/ASTContext.h"
+#include <cstdint>
+#include <utility>
 namespace lcc {
 
+/// An owning pointer to a node, created from the node it holds. A box made
+/// while an ASTContext is current puts the node in the context, which frees
+/// it with the rest of the tree; the low bit of the pointer remembers that the
+/// box must not delete it.
 template <typename T> class box {
-  std::unique_ptr<T> impl_;
+  uintptr_t impl_;
+  static constexpr uintptr_t InContext = 1;
+
+  T *ptr() const { return reinterpret_cast<T *>(impl_ & ~InContext); }
+  void destroy() {
+    if (impl_ && !(impl_ & InContext)) {
+      delete ptr();
+    }
+  }
 
 public:
   // Automatic construction from a `T`, not a `T*`
-  box(T &&obj) : impl_(new T(std::move(obj))) {}
+  box(T &&obj) {
+    static_assert(alignof(T) > 1, "the low bit of the pointer is a flag");
+    if (ASTContext *context = ASTContext::getCurrent()) {
+      impl_ = reinterpret_cast<uintptr_t>(context->New<T>(std::move(obj))) |
+              InContext;
+    } else {
+      impl_ = reinterpret_cast<uintptr_t>(new T(std::move(obj)));
+    }
+  }
 
-  box(box &&other) : impl_(std::move(other.impl_)) {}
+  box(box &&other) : impl_(std::exchange(other.impl_, 0)) {}
 
   box &operator=(box &&other) {
-    if (this != &other)
-      impl_ = std::move(other.impl_);
+    if (this != &other) {
+      destroy();
+      impl_ = std::exchange(other.impl_, 0);
+    }
     return *this;
   }
 
-  // unique_ptr destroys `T` for us.
-  ~box() = default;
+  ~box() { destroy(); }
 
   // Access propagates const ness.
-  T &operator*() { return *impl_; }
-  const T &operator*() const { return *impl_; }
+  T &operator*() { return *ptr(); }
+  const T &operator*() const { return *ptr(); }
 
-  T *operator->() { return impl_.get(); }
-  const T *operator->() const { return impl_.get(); }
+  T *operator->() { return ptr(); }
+  const T *operator->() const { return ptr(); }
 
-  T *get() { return impl_.get(); }
-  const T *get() const { return impl_.get(); }
+  T *get() { return ptr(); }
+  const T *get() const { return ptr(); }
 };
 } // namespace lcc
 
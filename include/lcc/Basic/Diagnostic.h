@@ -10,6 +10,7 @@
 
 #ifndef LCC_DIAGNOSTIC_H
 #define LCC_DIAGNOSTIC_H
+#include "lcc/Basic/SourceLocation.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/SMLoc.h"
 #include "llvm/Support/FormatVariadic.h"
@@ -33,11 +34,25 @@ class DiagnosticEngine {
   llvm::SourceMgr &mSrcMgr;
   llvm::raw_ostream &mOstream;
   unsigned NumErrors;
+  SourceLocationTable mLocations;
 public:
   DiagnosticEngine(llvm::SourceMgr &SrcMgr, llvm::raw_ostream &ostream)
-    :mSrcMgr(SrcMgr), mOstream(ostream), NumErrors(0) {}
+    :mSrcMgr(SrcMgr), mOstream(ostream), NumErrors(0), mLocations(SrcMgr) {}
 
   unsigned numErrors() { return NumErrors; }
+  [[nodiscard]] llvm::SourceMgr &getSourceMgr() const { return mSrcMgr; }
+  [[nodiscard]] llvm::raw_ostream &getOstream() const { return mOstream; }
+  /// the locations of the syntax tree in the buffers of the source manager
+  [[nodiscard]] const SourceLocationTable &getLocations() const {
+    return mLocations;
+  }
+
+  /// the messages another engine buffered, when it reported for this one
+  /// from another thread
+  void TakeReported(llvm::StringRef text, unsigned numErrors) {
+    mOstream << text;
+    NumErrors += numErrors;
+  }
 
   template <typename... Args>
   void report(llvm::SMLoc Loc, unsigned DiagID, Args &&... arguments) {
@@ -47,6 +62,11 @@ public:
     NumErrors += (Kind == llvm::SourceMgr::DK_Error);
   }
 
+  template <typename... Args>
+  void report(SourceLocation Loc, unsigned DiagID, Args &&... arguments) {
+    report(mLocations.getSMLoc(Loc), DiagID, std::forward<Args>(arguments)...);
+  }
+
   void report(llvm::StringRef fileName, int line) {
     auto pos = fileName.find_last_of("/");
     if (pos == std::string::npos) {
@@ -54,9 +74,9 @@ public:
     }
     if (pos != std::string::npos) {
       auto shortFilename = fileName.substr(pos + 1);
-      llvm::errs() << "[" << shortFilename << ":" << line << "]:";
+      mOstream << "[" << shortFilename << ":" << line << "]:";
     } else {
-      llvm::errs() << "[" << fileName << ":" << line << "]:";
+      mOstream << "[" << fileName << ":" << line << "]:";
     }
   }
 };
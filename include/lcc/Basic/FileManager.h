@@ -0,0 +1,96 @@
+/***********************************
+ * File:     FileManager.h
+ *
+ * Author:   caipeng
+ *
+ * Email:    iiicp@outlook.com
+ *
+ * Date:     2023/6/13
+ *
+ * Sign:     enjoy life
+ ***********************************/
+
+#ifndef LCC_FILEMANAGER_H
+#define LCC_FILEMANAGER_H
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/ErrorOr.h"
+#include "llvm/Support/FileSystem/UniqueID.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+
+namespace lcc {
+
+/// One file on disk, identified by its device and inode. The content is read
+/// (mapped when the file is large enough) the first time somebody asks for
+/// it, and is never written afterwards, so every translation unit of the
+/// process lexes the same bytes.
+class FileEntry {
+private:
+  std::string mName;
+  llvm::sys::fs::UniqueID mUniqueID;
+  mutable std::once_flag mLoadOnce;
+  mutable std::unique_ptr<llvm::MemoryBuffer> mRawBuffer;
+  /// built by the first getBuffer(), a file only ever #embed'ed never pays
+  /// for it
+  mutable std::once_flag mNormalizeOnce;
+  /// only when the source text has to be normalized, else mRawBuffer is used
+  mutable std::unique_ptr<llvm::MemoryBuffer> mBuffer;
+  mutable std::error_code mLoadError;
+
+public:
+  FileEntry(llvm::StringRef name, llvm::sys::fs::UniqueID id)
+      : mName(name), mUniqueID(id) {}
+  FileEntry(const FileEntry &) = delete;
+  FileEntry &operator=(const FileEntry &) = delete;
+
+  /// the path the file was first looked up by
+  [[nodiscard]] llvm::StringRef getName() const { return mName; }
+  [[nodiscard]] llvm::sys::fs::UniqueID getUniqueID() const {
+    return mUniqueID;
+  }
+
+  /// the content without UTF-8 BOM and with "\r\n" turned into "\n", it is
+  /// safe to call from several threads at once
+  llvm::ErrorOr<const llvm::MemoryBuffer *> getBuffer() const;
+  /// the bytes as they are on disk, for #embed
+  llvm::ErrorOr<const llvm::MemoryBuffer *> getRawBuffer() const;
+
+private:
+  void Load() const;
+  void Normalize() const;
+};
+
+/// Process wide cache of the files read by the compiler. A path is stat'ed at
+/// most once, failures included, and the content of a file is loaded at most
+/// once however many translation units include it. Entries live as long as
+/// the manager, so the buffers can be registered in the llvm::SourceMgr of
+/// every translation unit without copying.
+class FileManager {
+private:
+  mutable std::mutex mMutex;
+  llvm::DenseMap<llvm::sys::fs::UniqueID, std::unique_ptr<FileEntry>>
+      mUniqueFiles;
+  /// every path looked up so far, an error for a path which is not a file
+  llvm::StringMap<llvm::ErrorOr<FileEntry *>> mSeenPaths;
+  unsigned mNumStatCalls{0};
+
+public:
+  FileManager() = default;
+  FileManager(const FileManager &) = delete;
+  FileManager &operator=(const FileManager &) = delete;
+
+  /// the regular file at `path`, two paths of the same file give the same entry
+  llvm::ErrorOr<const FileEntry *> getFile(llvm::StringRef path);
+
+  [[nodiscard]] unsigned getNumUniqueFiles() const;
+  [[nodiscard]] unsigned getNumStatCalls() const;
+};
+} // namespace lcc
+
+#endif // LCC_FILEMANAGER_H
@@ -0,0 +1,122 @@
+/***********************************
+ * File:     IntegerValue.h
+ *
+ * Author:   caipeng
+ *
+ * Email:    iiicp@outlook.com
+ *
+ * Date:     2023/6/16
+ *
+ * Sign:     enjoy life
+ ***********************************/
+
+#ifndef LCC_INTEGERVALUE_H
+#define LCC_INTEGERVALUE_H
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace lcc {
+
+/// An integer constant together with its C type. The types are those of an
+/// LP64 target: char 8, short 16, int 32, long and long long 64 bits wide, so
+/// a type is told apart by its width and signedness alone. The value is kept
+/// extended to 64 bits as its type says, which makes every operation a couple
+/// of machine instructions and never allocates.
+class IntegerValue {
+public:
+  enum class BinaryOp : uint8_t {
+    Mul,
+    Div,
+    Rem,
+    Add,
+    Sub,
+    Shl,
+    Shr,
+    Less,
+    Greater,
+    LessEqual,
+    GreaterEqual,
+    Equal,
+    NotEqual,
+    BitAnd,
+    BitXor,
+    BitOr
+  };
+  /// what went wrong in an operation, the result is the wrapped around value
+  /// in every case so that the caller may go on after a warning
+  enum class Status : uint8_t { Ok, Overflow, DivisionByZero, ShiftOutOfRange };
+
+private:
+  uint64_t mValue{0};
+  uint8_t mWidth{32};
+  bool mUnsigned{false};
+
+public:
+  constexpr IntegerValue() = default;
+  /// `value` is truncated to the type
+  constexpr IntegerValue(uint64_t value, unsigned width, bool isUnsigned)
+      : mValue(Extend(value, width, isUnsigned)), mWidth(width),
+        mUnsigned(isUnsigned) {}
+
+  static constexpr IntegerValue getInt(int64_t value) {
+    return {static_cast<uint64_t>(value), 32, false};
+  }
+  /// the result of the relational, equality and logical operators
+  static constexpr IntegerValue getBool(bool value) { return getInt(value); }
+
+  [[nodiscard]] constexpr unsigned getWidth() const { return mWidth; }
+  [[nodiscard]] constexpr bool isUnsigned() const { return mUnsigned; }
+  [[nodiscard]] constexpr uint64_t getZExtValue() const { return mValue; }
+  [[nodiscard]] constexpr int64_t getSExtValue() const {
+    return static_cast<int64_t>(mValue);
+  }
+  [[nodiscard]] constexpr bool isTrue() const { return mValue != 0; }
+  [[nodiscard]] constexpr bool isNegative() const {
+    return !mUnsigned && getSExtValue() < 0;
+  }
+
+  /// C99 6.3.1.3, a conversion to another integer type wraps around
+  [[nodiscard]] constexpr IntegerValue convertTo(unsigned width,
+                                                 bool isUnsigned) const {
+    return {mValue, width, isUnsigned};
+  }
+  /// C99 6.3.1.1p2, every type narrower than int fits in int
+  [[nodiscard]] constexpr IntegerValue promote() const {
+    return mWidth < 32 ? convertTo(32, false) : *this;
+  }
+
+  /// C99 6.5.5 to 6.5.12, the operands go through the usual arithmetic
+  /// conversions of 6.3.1.8 first, except for the shifts which only promote
+  static Status Apply(BinaryOp op, IntegerValue lhs, IntegerValue rhs,
+                      IntegerValue &result);
+  /// C99 6.5.3.3
+  Status Negate(IntegerValue &result) const;
+  [[nodiscard]] IntegerValue BitNot() const;
+  [[nodiscard]] IntegerValue LogicalNot() const { return getBool(!isTrue()); }
+
+  /// C99 6.4.4.1, the value and type of an integer constant: the first type of
+  /// the list of its base and suffix the value fits in. A decimal constant too
+  /// large for long long is taken as unsigned long long, as other compilers
+  /// do. Returns nullopt on a bad digit or suffix and when the value doesn't
+  /// fit in 64 bits.
+  static std::optional<IntegerValue> ParseLiteral(std::string_view spelling);
+
+private:
+  static constexpr uint64_t Extend(uint64_t value, unsigned width,
+                                   bool isUnsigned) {
+    if (width >= 64) {
+      return value;
+    }
+    uint64_t mask = (uint64_t(1) << width) - 1;
+    value &= mask;
+    if (!isUnsigned && (value >> (width - 1)) & 1) {
+      value |= ~mask;
+    }
+    return value;
+  }
+};
+} // namespace lcc
+
+#endif // LCC_INTEGERVALUE_H
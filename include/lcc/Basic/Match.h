@@ -13,6 +13,7 @@
 #define LCC_MATCH_H
 #include "lcc/Basic/Util.h"
 #include <cassert>
+#include <utility>
 #include <variant>
 namespace lcc {
 template <class... Ts> struct overload : Ts... {
@@ -34,230 +35,85 @@ template <typename G> struct YComb {
 
 template <typename G> YComb(G) -> YComb<G>;
 
+/// the call of `callable` with alternative `i` of `variant`
 template <size_t i, typename Callable, typename Variant>
-constexpr decltype(auto)
-visit_imp(Callable &&callable, Variant &&variant,
-          std::enable_if_t<i == 0 || (i > 8)> * = nullptr) {
-  if (variant.index() == i) {
-    return std::forward<Callable>(callable)(
-        std::get<i>(std::forward<Variant>(variant)));
-  }
-  if constexpr (i > 0) {
-    return visit_imp<i - 1>(std::forward<Callable>(callable),
-                            std::forward<Variant>(variant));
-  } else {
-    LCC_UNREACHABLE;
-  }
-}
-
-template <size_t i, typename Callable, typename Variant>
-constexpr decltype(auto) visit_imp(Callable &&callable, Variant &&variant,
-                                   std::enable_if_t<i == 1> * = nullptr) {
-  switch (variant.index()) {
-  case 0:
-    return std::forward<Callable>(callable)(
-        std::get<0>(std::forward<Variant>(variant)));
-  case 1:
-    return std::forward<Callable>(callable)(
-        std::get<1>(std::forward<Variant>(variant)));
-  default:
-    LCC_UNREACHABLE;
-  }
+constexpr decltype(auto) visit_alt(Callable &&callable, Variant &&variant) {
+  return std::forward<Callable>(callable)(
+      std::get<i>(std::forward<Variant>(variant)));
 }
 
-template <size_t i, typename Callable, typename Variant>
-constexpr decltype(auto) visit_imp(Callable &&callable, Variant &&variant,
-                                   std::enable_if_t<i == 2> * = nullptr) {
-  switch (variant.index()) {
-  case 0:
-    return std::forward<Callable>(callable)(
-        std::get<0>(std::forward<Variant>(variant)));
-  case 1:
-    return std::forward<Callable>(callable)(
-        std::get<1>(std::forward<Variant>(variant)));
-  case 2:
-    return std::forward<Callable>(callable)(
-        std::get<2>(std::forward<Variant>(variant)));
-  default:
-    LCC_UNREACHABLE;
-  }
-}
-
-template <size_t i, typename Callable, typename Variant>
-constexpr decltype(auto) visit_imp(Callable &&callable, Variant &&variant,
-                                   std::enable_if_t<i == 3> * = nullptr) {
-  switch (variant.index()) {
-  case 0:
-    return std::forward<Callable>(callable)(
-        std::get<0>(std::forward<Variant>(variant)));
-  case 1:
-    return std::forward<Callable>(callable)(
-        std::get<1>(std::forward<Variant>(variant)));
-  case 2:
-    return std::forward<Callable>(callable)(
-        std::get<2>(std::forward<Variant>(variant)));
-  case 3:
-    return std::forward<Callable>(callable)(
-        std::get<3>(std::forward<Variant>(variant)));
-  default:
-    LCC_UNREACHABLE;
-  }
-}
-
-template <size_t i, typename Callable, typename Variant>
-constexpr decltype(auto) visit_imp(Callable &&callable, Variant &&variant,
-                                   std::enable_if_t<i == 4> * = nullptr) {
-  switch (variant.index()) {
-  case 0:
-    return std::forward<Callable>(callable)(
-        std::get<0>(std::forward<Variant>(variant)));
-  case 1:
-    return std::forward<Callable>(callable)(
-        std::get<1>(std::forward<Variant>(variant)));
-  case 2:
-    return std::forward<Callable>(callable)(
-        std::get<2>(std::forward<Variant>(variant)));
-  case 3:
-    return std::forward<Callable>(callable)(
-        std::get<3>(std::forward<Variant>(variant)));
-  case 4:
-    return std::forward<Callable>(callable)(
-        std::get<4>(std::forward<Variant>(variant)));
-  default:
-    LCC_UNREACHABLE;
-  }
-}
+/// one entry per alternative, a single indirect call whatever the number of
+/// alternatives
+template <typename Callable, typename Variant, typename Indices>
+struct visit_table_imp;
+template <typename Callable, typename Variant, size_t... is>
+struct visit_table_imp<Callable, Variant, std::index_sequence<is...>> {
+  using Result = decltype(visit_alt<0>(std::declval<Callable>(),
+                                       std::declval<Variant>()));
+  static constexpr Result (*table[])(Callable &&, Variant &&) = {
+      &visit_alt<is, Callable, Variant>...};
+};
 
-template <size_t i, typename Callable, typename Variant>
-constexpr decltype(auto) visit_imp(Callable &&callable, Variant &&variant,
-                                   std::enable_if_t<i == 5> * = nullptr) {
-  switch (variant.index()) {
-  case 0:
-    return std::forward<Callable>(callable)(
-        std::get<0>(std::forward<Variant>(variant)));
-  case 1:
-    return std::forward<Callable>(callable)(
-        std::get<1>(std::forward<Variant>(variant)));
-  case 2:
-    return std::forward<Callable>(callable)(
-        std::get<2>(std::forward<Variant>(variant)));
-  case 3:
-    return std::forward<Callable>(callable)(
-        std::get<3>(std::forward<Variant>(variant)));
-  case 4:
-    return std::forward<Callable>(callable)(
-        std::get<4>(std::forward<Variant>(variant)));
-  case 5:
-    return std::forward<Callable>(callable)(
-        std::get<5>(std::forward<Variant>(variant)));
-  default:
-    LCC_UNREACHABLE;
-  }
+template <typename Callable, typename Variant>
+constexpr decltype(auto) visit_table(Callable &&callable, Variant &&variant) {
+  using Table = visit_table_imp<
+      Callable, Variant,
+      std::make_index_sequence<std::variant_size_v<std::decay_t<Variant>>>>;
+  return Table::table[variant.index()](std::forward<Callable>(callable),
+                                       std::forward<Variant>(variant));
 }
 
-template <size_t i, typename Callable, typename Variant>
-constexpr decltype(auto) visit_imp(Callable &&callable, Variant &&variant,
-                                   std::enable_if_t<i == 6> * = nullptr) {
-  switch (variant.index()) {
-  case 0:
-    return std::forward<Callable>(callable)(
-        std::get<0>(std::forward<Variant>(variant)));
-  case 1:
-    return std::forward<Callable>(callable)(
-        std::get<1>(std::forward<Variant>(variant)));
-  case 2:
-    return std::forward<Callable>(callable)(
-        std::get<2>(std::forward<Variant>(variant)));
-  case 3:
-    return std::forward<Callable>(callable)(
-        std::get<3>(std::forward<Variant>(variant)));
-  case 4:
-    return std::forward<Callable>(callable)(
-        std::get<4>(std::forward<Variant>(variant)));
-  case 5:
-    return std::forward<Callable>(callable)(
-        std::get<5>(std::forward<Variant>(variant)));
-  case 6:
-    return std::forward<Callable>(callable)(
-        std::get<6>(std::forward<Variant>(variant)));
-  default:
-    LCC_UNREACHABLE;
-  }
-}
+/// the most alternatives visit_switch takes
+inline constexpr size_t visit_switch_max = 16;
 
-template <size_t i, typename Callable, typename Variant>
-constexpr decltype(auto) visit_imp(Callable &&callable, Variant &&variant,
-                                   std::enable_if_t<i == 7> * = nullptr) {
-  switch (variant.index()) {
-  case 0:
-    return std::forward<Callable>(callable)(
-        std::get<0>(std::forward<Variant>(variant)));
-  case 1:
-    return std::forward<Callable>(callable)(
-        std::get<1>(std::forward<Variant>(variant)));
-  case 2:
-    return std::forward<Callable>(callable)(
-        std::get<2>(std::forward<Variant>(variant)));
-  case 3:
-    return std::forward<Callable>(callable)(
-        std::get<3>(std::forward<Variant>(variant)));
-  case 4:
-    return std::forward<Callable>(callable)(
-        std::get<4>(std::forward<Variant>(variant)));
-  case 5:
-    return std::forward<Callable>(callable)(
-        std::get<5>(std::forward<Variant>(variant)));
-  case 6:
-    return std::forward<Callable>(callable)(
-        std::get<6>(std::forward<Variant>(variant)));
-  case 7:
-    return std::forward<Callable>(callable)(
-        std::get<7>(std::forward<Variant>(variant)));
-  default:
-    LCC_UNREACHABLE;
-  }
-}
+#define LCC_VISIT_CASE(i)                                                      \
+  case i:                                                                      \
+    if constexpr (i < size) {                                                  \
+      return visit_alt<i>(std::forward<Callable>(callable),                    \
+                          std::forward<Variant>(variant));                     \
+    } else {                                                                   \
+      LCC_UNREACHABLE;                                                         \
+    }
 
-template <size_t i, typename Callable, typename Variant>
-constexpr decltype(auto) visit_imp(Callable &&callable, Variant &&variant,
-                                   std::enable_if_t<i == 8> * = nullptr) {
+/// a switch the compiler lowers to a jump table and where it can inline the
+/// matchers, the cases past the last alternative are discarded
+template <typename Callable, typename Variant>
+constexpr decltype(auto) visit_switch(Callable &&callable, Variant &&variant) {
+  constexpr size_t size = std::variant_size_v<std::decay_t<Variant>>;
+  static_assert(size <= visit_switch_max);
   switch (variant.index()) {
-  case 0:
-    return std::forward<Callable>(callable)(
-        std::get<0>(std::forward<Variant>(variant)));
-  case 1:
-    return std::forward<Callable>(callable)(
-        std::get<1>(std::forward<Variant>(variant)));
-  case 2:
-    return std::forward<Callable>(callable)(
-        std::get<2>(std::forward<Variant>(variant)));
-  case 3:
-    return std::forward<Callable>(callable)(
-        std::get<3>(std::forward<Variant>(variant)));
-  case 4:
-    return std::forward<Callable>(callable)(
-        std::get<4>(std::forward<Variant>(variant)));
-  case 5:
-    return std::forward<Callable>(callable)(
-        std::get<5>(std::forward<Variant>(variant)));
-  case 6:
-    return std::forward<Callable>(callable)(
-        std::get<6>(std::forward<Variant>(variant)));
-  case 7:
-    return std::forward<Callable>(callable)(
-        std::get<7>(std::forward<Variant>(variant)));
-  case 8:
-    return std::forward<Callable>(callable)(
-        std::get<8>(std::forward<Variant>(variant)));
+    LCC_VISIT_CASE(0)
+    LCC_VISIT_CASE(1)
+    LCC_VISIT_CASE(2)
+    LCC_VISIT_CASE(3)
+    LCC_VISIT_CASE(4)
+    LCC_VISIT_CASE(5)
+    LCC_VISIT_CASE(6)
+    LCC_VISIT_CASE(7)
+    LCC_VISIT_CASE(8)
+    LCC_VISIT_CASE(9)
+    LCC_VISIT_CASE(10)
+    LCC_VISIT_CASE(11)
+    LCC_VISIT_CASE(12)
+    LCC_VISIT_CASE(13)
+    LCC_VISIT_CASE(14)
+    LCC_VISIT_CASE(15)
   default:
     LCC_UNREACHABLE;
   }
 }
+#undef LCC_VISIT_CASE
 
 template <typename Callable, typename Variant>
 constexpr decltype(auto) visit(Callable &&callable, Variant &&variant) {
-  return visit_imp<std::variant_size_v<std::decay_t<Variant>> - 1>(
-      std::forward<Callable>(callable), std::forward<Variant>(variant));
+  if constexpr (std::variant_size_v<std::decay_t<Variant>> <=
+                visit_switch_max) {
+    return visit_switch(std::forward<Callable>(callable),
+                        std::forward<Variant>(variant));
+  } else {
+    return visit_table(std::forward<Callable>(callable),
+                       std::forward<Variant>(variant));
+  }
 }
 
 template <typename Variant, typename... Matchers>
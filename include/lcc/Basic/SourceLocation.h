@@ -0,0 +1,90 @@
+/***********************************
+ * File:     SourceLocation.h
+ *
+ * Author:   caipeng
+ *
+ * Email:    iiicp@outlook.com
+ *
+ * Date:     2023/6/18
+ *
+ * Sign:     enjoy life
+ ***********************************/
+
+#ifndef LCC_SOURCELOCATION_H
+#define LCC_SOURCELOCATION_H
+
+#include "llvm/Support/SMLoc.h"
+#include "llvm/Support/SourceMgr.h"
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace lcc {
+
+/// A position in the source of a translation unit in 32 bits, what the syntax
+/// tree keeps of the tokens it was parsed from. The buffers of the SourceMgr
+/// are laid out one after the other in a single offset space, buffer 1 from
+/// 1, each taking its size plus one for its end, so a location is the base of
+/// its buffer plus the offset in it. 0 is the invalid location, as is any
+/// position past 4GB of source.
+class SourceLocation {
+private:
+  uint32_t mID{0};
+
+public:
+  SourceLocation() = default;
+
+  /// `offset` into the buffer starting at `fileBase`, see getFileBase
+  static SourceLocation getFileLoc(uint64_t fileBase, uint64_t offset) {
+    SourceLocation loc;
+    if (fileBase && fileBase + offset <= UINT32_MAX) {
+      loc.mID = fileBase + offset;
+    }
+    return loc;
+  }
+  static SourceLocation getFromRawEncoding(uint32_t id) {
+    SourceLocation loc;
+    loc.mID = id;
+    return loc;
+  }
+
+  [[nodiscard]] uint32_t getRawEncoding() const { return mID; }
+  [[nodiscard]] bool isValid() const { return mID != 0; }
+
+  bool operator==(SourceLocation other) const { return mID == other.mID; }
+  bool operator!=(SourceLocation other) const { return mID != other.mID; }
+};
+
+/// The base of each buffer of a SourceMgr in the offset space of
+/// SourceLocation, the prefix sums of the buffer sizes. The buffers of a
+/// SourceMgr are only ever added, the table takes in the ones added since
+/// the last lookup, so a lookup is a binary search however many buffers there
+/// are. A table which is up to date, see Update, can be read from several
+/// threads as long as no buffer is added.
+class SourceLocationTable {
+private:
+  const llvm::SourceMgr &mSrcMgr;
+  /// the base of buffer i + 1 at i, then the end of the last buffer
+  mutable std::vector<uint64_t> mBases{1};
+
+public:
+  explicit SourceLocationTable(const llvm::SourceMgr &srcMgr)
+      : mSrcMgr(srcMgr) {}
+  SourceLocationTable(const SourceLocationTable &) = delete;
+  SourceLocationTable &operator=(const SourceLocationTable &) = delete;
+
+  [[nodiscard]] const llvm::SourceMgr &getSourceMgr() const { return mSrcMgr; }
+  /// takes in the buffers added to the source manager
+  void Update() const;
+
+  /// the base of buffer `fileID`, 0 when it doesn't fit the offset space
+  [[nodiscard]] uint64_t getFileBase(unsigned fileID) const;
+  /// the buffer id and the offset in it, {0, 0} when the location is invalid
+  /// or not in a buffer of the source manager
+  [[nodiscard]] std::pair<unsigned, uint32_t>
+  getDecomposedLoc(SourceLocation loc) const;
+  [[nodiscard]] llvm::SMLoc getSMLoc(SourceLocation loc) const;
+};
+} // namespace lcc
+
+#endif // LCC_SOURCELOCATION_H
@@ -37,16 +37,48 @@ private:
   llvm::SourceMgr &Mgr;
   DiagnosticEngine &Diag;
   std::string mSourceCode;
+  unsigned mBufferID{0};
   const char *P{nullptr};
   const char *Ep{nullptr};
+  /// Sp meaning start p
+  const char *Sp{nullptr};
+  std::string mStrBuilder;
+  char mIncludeDelimiter{' '};
+  /// 0: nothing, 1: after '#', 2: after '# include' or '# embed'
+  unsigned mIncludeState{0};
+  bool mLeadingSpace{false};
 
 public:
   explicit Lexer(llvm::SourceMgr &mgr, DiagnosticEngine &diag,
                  std::string &&sourceCode,
                  std::string_view sourcePath = "<stdin>");
+  /// lex a buffer owned by somebody else, e.g. lcc::FileManager. The buffer
+  /// must outlive the lexer and the tokens, it is never copied
+  Lexer(llvm::SourceMgr &mgr, DiagnosticEngine &diag,
+        const llvm::MemoryBuffer &buffer);
+  /// lex the next pp token, std::nullopt at the end of buffer
+  std::optional<Token> Lex();
+  /// fast path for the groups skipped by a false #if: moves to the '#' of the
+  /// next directive without building tokens. Only comments, literals and line
+  /// splices are looked at, so the skipped text needn't be valid C. Returns
+  /// false at the end of buffer. `atLineStart` is false when a directive name
+  /// has just been read and the rest of its line must be skipped first
+  bool SkipToNextDirective(bool atLineStart);
   std::vector<Token> tokenize();
   std::vector<Token> toCTokens(std::vector<Token> &&ppTokens);
 
+  [[nodiscard]] unsigned getBufferID() const { return mBufferID; }
+  /// where the next token is looked for
+  [[nodiscard]] const char *getPosition() const { return P; }
+  [[nodiscard]] std::string_view getBufferName() const {
+    return Mgr.getMemoryBuffer(mBufferID)->getBufferIdentifier();
+  }
+
+  /// the kind of the single pp token spelled by `spelling`, used by the
+  /// preprocessor to classify the result of '##'. tok::unknown if the spelling
+  /// is not exactly one identifier, pp number or punctuator
+  static tok::TokenKind GetTokenKindOfSpelling(std::string_view spelling);
+
 private:
   void RegularSourceCode();
   static bool IsLetter(char ch);
@@ -60,7 +92,8 @@ private:
                                          char nextChar, char nnChar);
 
   Token::ValueType ParseNumber(const Token &ppToken);
-  std::vector<char> ParseCharacters(const Token &ppToken, bool handleCharMode);
+  size_t DecodeCharacters(const Token &ppToken, bool handleCharMode,
+                          char *out);
   std::uint32_t ParseEscapeChar(const char *p, char escape);
   static bool IsJudgeNumber(const std::string &preCharacters, char curChar);
 };
@@ -15,6 +15,7 @@
 #include <cassert>
 #include <cstdint>
 #include <string>
+#include <string_view>
 #include <variant>
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/SMLoc.h"
@@ -22,12 +23,18 @@
 namespace lcc{
 class Token {
 private:
+  /// std::string_view is for bytes which outlive the tokens, the resource of
+  /// #embed in the buffer of the file manager
   using TokenValue =
-      std::variant<std::monostate, int32_t, uint32_t, int64_t, uint64_t, float, double, std::string>;
+      std::variant<std::monostate, int32_t, uint32_t, int64_t, uint64_t, float, double, std::string,
+                   std::string_view>;
   TokenValue mValue;
   tok::TokenKind mTokenKind;
   const char *mOffsetPtr{nullptr};
   uint32_t mLength;
+  bool mLeadingSpace{false};
+  /// buffer id in mSrcMgr, 0 for a token which is not spelled in a buffer
+  unsigned mFileID{0};
   llvm::SourceMgr &mSrcMgr;
 public:
   using ValueType = TokenValue;
@@ -39,8 +46,13 @@ public:
   [[nodiscard]] llvm::StringRef getRepresentation() const {
       if (std::holds_alternative<std::string>(mValue)) {
         return std::get<std::string>(mValue);
+      } else if (const auto *view = std::get_if<std::string_view>(&mValue)) {
+        return {view->data(), view->size()};
       }else {
-        auto *mem = mSrcMgr.getMemoryBuffer(mSrcMgr.getMainFileID());
+        /// the token may come from an included file, so slice the buffer
+        /// which contains the token instead of main file
+        unsigned id = mFileID ? mFileID : mSrcMgr.FindBufferContainingLoc(getSMLoc());
+        auto *mem = mSrcMgr.getMemoryBuffer(id ? id : mSrcMgr.getMainFileID());
         uint32_t offset = mOffsetPtr - mem->getBufferStart();
         return mem->getBuffer().substr(offset, mLength);
       }
@@ -48,7 +60,8 @@ public:
 
   [[nodiscard]] std::pair<unsigned, unsigned> getLineAndColumn() const {
     assert(mOffsetPtr);
-    return mSrcMgr.getLineAndColumn(llvm::SMLoc::getFromPointer(mOffsetPtr));
+    return mSrcMgr.getLineAndColumn(llvm::SMLoc::getFromPointer(mOffsetPtr),
+                                    mFileID);
   }
 
   [[nodiscard]] tok::TokenKind getTokenKind() const {
@@ -74,6 +87,27 @@ public:
   [[nodiscard]] llvm::SMLoc getSMLoc() const {
     return llvm::SMLoc::getFromPointer(getOffset());
   }
+
+  [[nodiscard]] uint32_t getLength() const {
+    return mLength;
+  }
+
+  /// whitespace or a comment precedes this token on its line
+  [[nodiscard]] bool hasLeadingSpace() const {
+    return mLeadingSpace;
+  }
+
+  void setLeadingSpace(bool leadingSpace) {
+    mLeadingSpace = leadingSpace;
+  }
+
+  [[nodiscard]] unsigned getFileID() const {
+    return mFileID;
+  }
+
+  void setFileID(unsigned fileID) {
+    mFileID = fileID;
+  }
 };
 using TokIter = std::vector<Token>::const_iterator;
 } // namespace lcc::lexer
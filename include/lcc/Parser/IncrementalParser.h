@@ -0,0 +1,118 @@
+/***********************************
+ * File:     IncrementalParser.h
+ *
+ * Author:   caipeng
+ *
+ * Email:    iiicp@outlook.com
+ *
+ * Date:     2023/6/18
+ *
+ * Sign:     enjoy life
+ ***********************************/
+
+#ifndef LCC_INCREMENTALPARSER_H
+#define LCC_INCREMENTALPARSER_H
+
+#include "lcc/AST/AST.h"
+#include "lcc/Basic/Diagnostic.h"
+#include "lcc/Parser/Parser.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace lcc {
+
+/// The parse of a source kept up to date with the edits made to it, for an
+/// editor or a language server. The text is taken as C after preprocessing,
+/// as the parser sees it.
+///
+/// Each top-level declaration remembers the range of the text it was parsed
+/// from and the names it declares at file scope. An edit re-lexes and
+/// re-parses the declarations whose range it touches, together with the text
+/// between them and their neighbours, after the names the declarations before
+/// them declare; the rest of the tree is kept as it is. The reparsed range
+/// starts before the declarations with a parse error just before it, and
+/// grows when its last declaration has an error or doesn't end, its braces
+/// don't balance, it has a lexical error such as an open comment, or it
+/// changes whether a name is a typedef name for the declarations after it.
+///
+/// A reparsed range is lexed from a buffer of its own in a source manager of
+/// its own, with a context of its own; the locations of the nodes of a
+/// declaration are turned into offsets in the current text by getOffset. The
+/// diagnostics are reported to the engine as text, so a chunk is freed with
+/// its buffer once no declaration is parsed from it, and an edit costs the
+/// same however long the session has run.
+class IncrementalParser {
+private:
+  /// the buffer and the nodes of one reparsed range
+  struct Chunk {
+    llvm::SourceMgr Mgr;
+    SourceLocationTable Locations{Mgr};
+    const llvm::MemoryBuffer *Buffer{nullptr};
+    unsigned BufferID{0};
+    std::unique_ptr<ASTContext> Context;
+  };
+  struct Entry {
+    /// the range of the declaration in mText, from its first token to the
+    /// end of its last
+    size_t Begin;
+    size_t End;
+    /// where the buffer of the chunk starts in mText
+    size_t Base;
+    std::shared_ptr<Chunk> Source;
+    const Syntax::ExternalDeclaration *Decl;
+    /// the names declared at file scope, whether they are typedef names
+    llvm::SmallVector<std::pair<std::string_view, bool>, 2> Names;
+    /// the bindings of mFileScope before those of the declaration
+    unsigned FirstBinding{0};
+    /// parsed without an error up to its ; or }, the parse of one with an
+    /// error may have stopped at what follows it
+    bool Clean{true};
+  };
+
+  DiagnosticEngine &Diag;
+  std::string mText;
+  std::string mName;
+  std::vector<Entry> mEntries;
+  /// the names of the file scope of all the declarations in order
+  Parser::Scope mFileScope;
+  /// the spellings of the names of mFileScope and the entries, a binding
+  /// outlives the chunk it was parsed from when the names stay the same
+  llvm::StringSet<> mNames;
+
+  void Reparse(size_t first, size_t last);
+  /// `afterDecl` when the range follows a declaration
+  std::vector<Entry> ParseRange(size_t begin, size_t end, bool afterDecl,
+                                unsigned scopeSize, bool &complete,
+                                std::string &messages, unsigned &numErrors);
+
+public:
+  /// parses `text` whole, `name` is the buffer name of the diagnostics
+  IncrementalParser(DiagnosticEngine &diag, std::string text,
+                    std::string name = "<stdin>");
+
+  /// replaces `length` bytes of the text at `offset` with `text` and reparses
+  /// what the edit touches. False leaves all as it was when the range is not
+  /// in the text
+  bool Edit(size_t offset, size_t length, std::string_view text);
+
+  [[nodiscard]] const std::string &getText() const { return mText; }
+  [[nodiscard]] size_t getNumDecls() const { return mEntries.size(); }
+  [[nodiscard]] const Syntax::ExternalDeclaration &getDecl(size_t index) const {
+    return *mEntries[index].Decl;
+  }
+  /// the range of declaration `index` in the text
+  [[nodiscard]] std::pair<size_t, size_t> getDeclRange(size_t index) const {
+    return {mEntries[index].Begin, mEntries[index].End};
+  }
+  /// the offset in the text of `loc`, the location of a node of declaration
+  /// `index`, std::string::npos when it is not
+  [[nodiscard]] size_t getOffset(size_t index, SourceLocation loc) const;
+};
+} // namespace lcc
+
+#endif // LCC_INCREMENTALPARSER_H
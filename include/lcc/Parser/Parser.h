@@ -13,50 +13,169 @@
 #include "lcc/AST/AST.h"
 #include "lcc/Basic/Diagnostic.h"
 #include "lcc/Lexer/Token.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
 #include <bitset>
 #include <map>
 #include <optional>
 #include <set>
 #include <string>
-#include <unordered_map>
 #include <vector>
 namespace lcc {
+class IncrementalParser;
+class PCHReader;
 using TokenBitSet = std::bitset<tok::TokenKind::NUM_TOKENS>;
 class Parser {
+  friend class IncrementalParser;
+
 private:
   const std::vector<Token>& mTokens;
   TokIter mTokCursor;
   TokIter mTokEnd;
   bool mIsCheckTypedefType{true};
   DiagnosticEngine &Diag;
+  /// of Diag, shared with the parsers of the function bodies
+  const SourceLocationTable &mLocations;
+  /// of the translation unit being parsed
+  ASTContext *mContext{nullptr};
+  bool mHugePageArena{false};
+  /// the threads for the function bodies, 0 parses them in place
+  unsigned mBodyThreads{0};
+  /// the buffer of the token Loc located last, the tokens of a file come in
+  /// runs
+  unsigned mLocFileID{0};
+  uint64_t mLocFileBase{0};
+  const char *mLocBufferStart{nullptr};
 private:
+  /// The names of the ordinary identifiers in scope, for telling typedef
+  /// names apart. One hash table holds the innermost binding of each name,
+  /// a binding remembers the one it shadows, and popScope puts those back,
+  /// so a lookup costs one probe however deep the blocks nest.
   class Scope {
   private:
-    struct Symbol {
-      std::string_view identifier;
-      bool isTypedef{false};
+    static constexpr unsigned NoBinding = ~0u;
+    struct Binding {
+      std::string_view Name;
+      /// the binding of the name in an enclosing scope, or NoBinding
+      unsigned Shadowed;
+      unsigned Depth;
+      bool IsTypedef;
     };
-    std::vector<std::unordered_map<std::string_view, Symbol>> mCurrentScope;
+    /// in order of declaration, which is also the order of the scopes
+    std::vector<Binding> mBindings;
+    llvm::DenseMap<llvm::StringRef, unsigned> mInnermost;
+    /// the start of each open block scope in mBindings
+    std::vector<unsigned> mScopeBegins;
+    /// bumped whenever some name starts or stops being a typedef name
+    uint32_t mGeneration{1};
+    /// for a function body parsed on its own, the scope of the file it is
+    /// in, as much of it as was declared before the body
+    const Scope *mFileScope{nullptr};
+    unsigned mFileScopeSize{0};
+    /// the declarations made at file scope, with those of names already bound
+    std::vector<std::pair<std::string_view, bool>> *mFileScopeLog{nullptr};
+    /// the file scope of the -include-pch prefix, declared before any binding
+    /// of this scope
+    const PCHReader *mExternal{nullptr};
+
+    [[nodiscard]] const Binding *lookup(std::string_view name) const;
+    /// whether the name is a typedef name where this scope doesn't bind it
+    [[nodiscard]] bool isTypedefOutside(std::string_view name) const;
+    void bind(std::string_view name, bool isTypedef);
   public:
-    Scope() {
-      mCurrentScope.emplace_back();
-    }
-    void addTypedef(std::string_view name);
+    [[nodiscard]] uint32_t getGeneration() const { return mGeneration; }
+    void addTypedef(std::string_view name) { bind(name, true); }
     bool isTypedefInScope(std::string_view name) const;
     bool checkIsTypedefInCurrentScope(std::string_view name) const;
-    void addToScope(std::string_view name);
+    void addToScope(std::string_view name) { bind(name, false); }
     void pushScope();
     void popScope();
+    /// the number of bindings of the file scope so far
+    [[nodiscard]] unsigned getFileScopeSize() const {
+      return mScopeBegins.empty() ? mBindings.size() : mScopeBegins.front();
+    }
+    /// makes the first `size` bindings of `fileScope` the file scope of
+    /// this one, which has to be empty
+    void setFileScope(const Scope &fileScope, unsigned size);
+
+    /// the file scope kept by IncrementalParser across edits
+    [[nodiscard]] unsigned getNumBindings() const { return mBindings.size(); }
+    /// appends each declaration at file scope to `log`, the name and whether
+    /// it is a typedef, also one of a name the file scope already binds
+    void setFileScopeLog(std::vector<std::pair<std::string_view, bool>> *log) {
+      mFileScopeLog = log;
+    }
+    /// whether the name is a typedef name by the first `size` bindings of
+    /// the file scope, nullopt when none of them binds it
+    [[nodiscard]] std::optional<bool> isTypedefAt(std::string_view name,
+                                                  unsigned size) const;
+    /// drops the file scope bindings past the first `size`
+    void truncate(unsigned size);
+    void setExternal(const PCHReader *pch) { mExternal = pch; }
+    /// the name and whether it is a typedef name of each binding of the file
+    /// scope, in the order of declaration
+    [[nodiscard]] std::vector<std::pair<std::string_view, bool>>
+    getFileScopeBindings() const;
   };
   Scope mScope;
   TokenBitSet FirstDeclaration, FirstExpression, FirstStatement;
   TokenBitSet FirstStructDeclaration, FirstExternalDeclaration;
+
+  /// the kinds of the IsFirstIn* checks: the token kinds, and an identifier
+  /// which names a typedef as a kind of its own
+  static constexpr size_t TypedefName = tok::NUM_TOKENS;
+  using AnnotatedBitSet = std::bitset<tok::NUM_TOKENS + 1>;
+  AnnotatedBitSet AnnotatedFirstDeclSpec, AnnotatedFirstSpecQual;
+  AnnotatedBitSet AnnotatedFirstExpr, AnnotatedFirstStmt;
+  AnnotatedBitSet AnnotatedFirstBlockItem;
+  /// for each identifier token, the scope generation its typedef check was
+  /// made in shifted left by one, and the answer in the low bit; 0 until the
+  /// first check
+  mutable std::vector<uint32_t> mTypedefAnnotations;
+  /// mTypedefAnnotations, or those of the parser of the whole file for the
+  /// parser of a function body
+  uint32_t *mAnnotations;
+
+  /// the body of a function definition left for later, from the { to one
+  /// past the }, with the parameter names and the file scope size at its
+  /// start
+  struct DelayedBody {
+    static constexpr size_t NoDecl = ~size_t(0);
+    size_t DeclIndex;
+    TokIter Begin;
+    TokIter End;
+    unsigned FileScopeSize;
+    llvm::SmallVector<std::string_view, 4> ParameterNames;
+  };
+  std::vector<DelayedBody> mDelayedBodies;
+
+  /// the parser of function bodies of `parent` on another thread
+  Parser(const Parser &parent, DiagnosticEngine &diag);
 public:
   explicit Parser(const std::vector<Token> & tokens, DiagnosticEngine &diag);
   Syntax::TranslationUnit ParseTranslationUnit();
-  
+  /// back the ASTContext with huge pages
+  void UseHugePageArena() { mHugePageArena = true; }
+  /// leave the function bodies for later and parse them on up to `threads`
+  /// threads once the file scope is done
+  void UseDelayedBodies(unsigned threads) { mBodyThreads = threads; }
+  /// -include-pch, the tokens start after the prefix and the names it
+  /// declares at file scope are looked up in the pch
+  void UsePCH(const PCHReader &pch) { mScope.setExternal(&pch); }
+  /// for -emit-pch, after ParseTranslationUnit, the names refer to the tokens
+  [[nodiscard]] std::vector<std::pair<std::string_view, bool>>
+  GetFileScopeBindings() const {
+    return mScope.getFileScopeBindings();
+  }
+
 private:
   std::optional<Syntax::ExternalDeclaration> ParseExternalDeclaration();
+  /// one past the } matching the { at the cursor, nullopt when there is none
+  [[nodiscard]] std::optional<TokIter> FindBodyEnd() const;
+  void ParseDelayedBodies(ASTVector<Syntax::ExternalDeclaration> &decls);
+  std::optional<Syntax::BlockStmt> ParseDelayedBody(const Parser &parent,
+                                                    const DelayedBody &body);
   std::optional<Syntax::Declaration> ParseDeclarationSuffix(
       Syntax::DeclSpec &&declSpec,
       std::optional<Syntax::Declarator> &&alreadyParsedDeclarator = {});
@@ -84,6 +203,10 @@ private:
   std::optional<Syntax::EnumSpecifier::Enumerator> ParseEnumerator();
   std::optional<Syntax::Initializer> ParseInitializer();
   std::optional<Syntax::InitializerList> ParseInitializerList();
+  /// the shortest run of constants ParseConstantArray packs, a short list
+  /// keeps its expressions
+  static constexpr size_t MinConstantRun = 16;
+  std::optional<Syntax::ConstantArray> ParseConstantArray();
 
   std::optional<Syntax::BlockStmt> ParseBlockStmt();
   std::optional<Syntax::BlockItem> ParseBlockItem();
@@ -104,31 +227,38 @@ private:
   std::optional<Syntax::Expr> ParseExpr();
   std::optional<Syntax::AssignExpr> ParseAssignExpr();
   std::optional<Syntax::CondExpr> ParseConditionalExpr();
-  std::optional<Syntax::LogOrExpr> ParseLogOrExpr();
-  std::optional<Syntax::LogAndExpr> ParseLogAndExpr();
-  std::optional<Syntax::BitOrExpr> ParseBitOrExpr();
-  std::optional<Syntax::BitXorExpr> ParseBitXorExpr();
-  std::optional<Syntax::BitAndExpr> ParseBitAndExpr();
-  std::optional<Syntax::EqualExpr> ParseEqualExpr();
-  std::optional<Syntax::RelationalExpr> ParseRelationalExpr();
-  std::optional<Syntax::ShiftExpr> ParseShiftExpr();
-  std::optional<Syntax::AdditiveExpr> ParseAdditiveExpr();
-  std::optional<Syntax::MultiExpr> ParseMultiExpr();
+  std::optional<Syntax::BinaryOperand> ParseBinaryExpr(unsigned minPrecedence);
   std::optional<Syntax::CastExpr> ParseCastExpr();
   std::optional<Syntax::UnaryExpr> ParseUnaryExpr();
   std::optional<Syntax::PostFixExpr> ParsePostFixExpr();
   void ParsePostFixExprSuffix(TokIter beginTokLoc,
                               Syntax::PostFixExpr &postFixExpr);
+  /// ( type-name ) { initializer-list }, from the {, with its suffixes
+  std::optional<Syntax::PostFixExpr>
+  ParseCompoundLiteral(TokIter beginTokLoc,
+                       std::optional<Syntax::TypeName> &&typeName);
 
   std::optional<Syntax::TypeName> ParseTypeName();
+  /// what the tree keeps of a token, it is freed after parsing
+  SourceLocation Loc(TokIter tok);
+  /// the spelling of a name, copied into the context for the same reason
+  std::string_view Spelling(TokIter tok);
+  /// where a diagnostic about `tok` goes, the end of the last token when it
+  /// is past the end of the input
+  [[nodiscard]] llvm::SMLoc DiagLoc(TokIter tok) const;
   bool IsAssignOp(tok::TokenKind type);
   bool Expect(tok::TokenKind tokenType);
   bool ConsumeAny();
+  /// the kind of the current token, eof past the last one
+  [[nodiscard]] tok::TokenKind CurKind() const;
   bool Peek(tok::TokenKind tokenType);
   bool PeekN(int n, tok::TokenKind tokenType);
   bool IsUnaryOp(tok::TokenKind tokenType);
   bool IsPostFixExpr(tok::TokenKind tokenType);
   bool IsCurrentIn(TokenBitSet tokenSet);
+  /// the kind of the token `lookahead` past the current one, classifying an
+  /// identifier once for each change of the scopes
+  [[nodiscard]] size_t GetAnnotatedKind(unsigned lookahead = 0) const;
 
   bool IsFirstInExternalDeclaration() const;
   bool IsFirstInFunctionDefinition() const;
@@ -159,7 +289,9 @@ private:
   bool IsFirstInShiftExpr() const;
   bool IsFirstInAdditiveExpr() const;
   bool IsFirstInMultiExpr() const;
-  bool IsFirstInTypeName() const;
+  /// with a lookahead of 1 after a (, tells ( type-name ) from
+  /// ( expression ) without consuming anything
+  bool IsFirstInTypeName(unsigned lookahead = 0) const;
   bool IsFirstInCastExpr() const;
   bool IsFirstInUnaryExpr() const;
   bool IsFirstInPostFixExpr() const;
@@ -178,12 +310,15 @@ private:
     static_assert((std::is_same_v<std::decay_t<Args>, tok::TokenKind> && ...));
     return (TokenBitSet() | ... | TokenBitSet().set(tokenKinds, true));
   }
+  static AnnotatedBitSet Annotate(TokenBitSet tokenSet) {
+    AnnotatedBitSet result;
+    for (size_t kind = 0; kind < tok::NUM_TOKENS; ++kind) {
+      result[kind] = tokenSet[kind];
+    }
+    return result;
+  }
 
   void SkipTo(TokenBitSet recoveryToken, unsigned DiagID);
-
-  std::string_view GetDeclaratorName(const Syntax::Declarator &declarator);
-  const Syntax::DirectDeclaratorParamTypeList *
-  GetFuncDeclarator(const Syntax::Declarator &declarator);
 };
 }
 #endif // LCC_PARSER_H
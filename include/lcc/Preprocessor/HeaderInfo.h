@@ -0,0 +1,86 @@
+/***********************************
+ * File:     HeaderInfo.h
+ *
+ * Author:   caipeng
+ *
+ * Email:    iiicp@outlook.com
+ *
+ * Date:     2023/6/12
+ *
+ * Sign:     enjoy life
+ ***********************************/
+
+#ifndef LCC_HEADERINFO_H
+#define LCC_HEADERINFO_H
+
+#include "lcc/Preprocessor/MacroInfo.h"
+
+namespace lcc {
+
+/// what the preprocessor knows about a file after it has been included once,
+/// the table is keyed by the file identity, not by the spelled path
+struct HeaderFileInfo {
+  bool IsPragmaOnce{false};
+  bool IsEntered{false};
+  /// the X of `#ifndef X ... #endif` wrapping the whole file
+  IdentifierInfo *ControllingMacro{nullptr};
+
+  /// a later #include of the file would produce no tokens
+  [[nodiscard]] bool canSkip() const {
+    if (IsPragmaOnce && IsEntered) {
+      return true;
+    }
+    return ControllingMacro && ControllingMacro->Macro;
+  }
+};
+
+/// Watches the directives and tokens of one file to find out whether the whole
+/// file is wrapped in an include guard:
+///
+///   #ifndef X        (or #if !defined X, #if !defined(X))
+///   ...
+///   #endif
+///
+/// Only comments and whitespace may appear outside the guard, and the guard
+/// conditional may not have #else or #elif.
+class MultipleIncludeOpt {
+  enum class State { Start, InGuard, AfterGuard, Invalid };
+  State mState{State::Start};
+  IdentifierInfo *mMacro{nullptr};
+
+public:
+  /// the first thing of the file is the #ifndef of a guard candidate
+  [[nodiscard]] bool isAtStart() const { return mState == State::Start; }
+
+  void EnterGuard(IdentifierInfo *macro) {
+    if (mState != State::Start) {
+      mState = State::Invalid;
+      return;
+    }
+    mState = State::InGuard;
+    mMacro = macro;
+  }
+
+  /// the outermost conditional is closed by #endif
+  void ExitTopLevelConditional() {
+    if (mState == State::InGuard) {
+      mState = State::AfterGuard;
+    }
+  }
+
+  /// a token or a directive, only allowed inside the guard
+  void ReadTokenOrDirective() {
+    if (mState != State::InGuard) {
+      mState = State::Invalid;
+    }
+  }
+
+  void Invalidate() { mState = State::Invalid; }
+
+  [[nodiscard]] IdentifierInfo *GetControllingMacroAtEndOfFile() const {
+    return mState == State::AfterGuard ? mMacro : nullptr;
+  }
+};
+} // namespace lcc
+
+#endif // LCC_HEADERINFO_H
@@ -0,0 +1,120 @@
+/***********************************
+ * File:     MacroInfo.h
+ *
+ * Author:   caipeng
+ *
+ * Email:    iiicp@outlook.com
+ *
+ * Date:     2023/6/10
+ *
+ * Sign:     enjoy life
+ ***********************************/
+
+#ifndef LCC_MACROINFO_H
+#define LCC_MACROINFO_H
+
+#include "lcc/Basic/TokenKinds.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/STLExtras.h"
+#include <cstdint>
+#include <string_view>
+
+namespace lcc {
+class MacroInfo;
+
+/// Prosser's hide set: the macros a token must not be expanded by any more.
+/// Sets are immutable lists sorted by the macro address and interned by the
+/// preprocessor, so adding a macro or intersecting two sets never copies more
+/// than the (usually tiny) nesting depth of the expansion.
+struct HideSet {
+  const MacroInfo *Macro;
+  const HideSet *Next;
+};
+
+/// one entry of the identifier table, the spelling is owned by the table
+struct IdentifierInfo {
+  std::string_view Name;
+  MacroInfo *Macro{nullptr};
+};
+
+/// compact pp token used inside the preprocessor. The spelling never owns
+/// memory: it refers to the source buffer, the identifier table, the static
+/// punctuator spelling or the preprocessor arena, so copying a token is a
+/// plain memcpy and macro bodies can live in the arena as flat arrays.
+///
+/// string literal and char constant spell their content without the quotes,
+/// the same as lcc::Token::getRepresentation()
+struct PPToken {
+  PPToken() : FileID(0), LeadingSpace(false) {}
+
+  tok::TokenKind Kind{tok::unknown};
+  /// 1-based parameter index when the token is a parameter of a macro body
+  uint16_t ArgNo{0};
+  /// buffer id of Loc in the source manager, 0 for a synthesized token
+  uint32_t FileID : 31;
+  uint32_t LeadingSpace : 1;
+  const char *Loc{nullptr};
+  std::string_view Spelling;
+  /// only for identifiers
+  IdentifierInfo *Ident{nullptr};
+  const HideSet *HS{nullptr};
+};
+
+class MacroInfo {
+public:
+  enum class BuiltinKind : uint8_t { None, File, Line };
+
+private:
+  IdentifierInfo *mName;
+  const char *mDefLoc;
+  llvm::ArrayRef<IdentifierInfo *> mParams;
+  llvm::ArrayRef<PPToken> mBody;
+  bool mFunctionLike;
+  bool mVariadic;
+  bool mHasPaste;
+  BuiltinKind mBuiltin;
+
+public:
+  MacroInfo(IdentifierInfo *name, const char *defLoc,
+            llvm::ArrayRef<IdentifierInfo *> params,
+            llvm::ArrayRef<PPToken> body, bool functionLike, bool variadic,
+            BuiltinKind builtin = BuiltinKind::None)
+      : mName(name), mDefLoc(defLoc), mParams(params), mBody(body),
+        mFunctionLike(functionLike), mVariadic(variadic),
+        mHasPaste(llvm::any_of(
+            body, [](const PPToken &t) { return t.Kind == tok::pp_hashhash; })),
+        mBuiltin(builtin) {}
+
+  [[nodiscard]] IdentifierInfo *getName() const { return mName; }
+  [[nodiscard]] const char *getDefLoc() const { return mDefLoc; }
+  [[nodiscard]] llvm::ArrayRef<IdentifierInfo *> getParams() const {
+    return mParams;
+  }
+  [[nodiscard]] unsigned getNumParams() const { return mParams.size(); }
+  [[nodiscard]] llvm::ArrayRef<PPToken> getBody() const { return mBody; }
+  [[nodiscard]] bool isFunctionLike() const { return mFunctionLike; }
+  [[nodiscard]] bool isVariadic() const { return mVariadic; }
+  /// the body contains '##', an object like macro can't be pushed as it is
+  [[nodiscard]] bool hasPaste() const { return mHasPaste; }
+  [[nodiscard]] BuiltinKind getBuiltinKind() const { return mBuiltin; }
+
+  /// C99 6.10.3p2, a redefinition must be identical
+  [[nodiscard]] bool isIdenticalTo(const MacroInfo &other) const {
+    if (mFunctionLike != other.mFunctionLike ||
+        mVariadic != other.mVariadic || mParams != other.mParams ||
+        mBody.size() != other.mBody.size() || mBuiltin != other.mBuiltin) {
+      return false;
+    }
+    for (size_t i = 0; i < mBody.size(); ++i) {
+      const PPToken &lhs = mBody[i], &rhs = other.mBody[i];
+      if (lhs.Kind != rhs.Kind || lhs.Spelling != rhs.Spelling ||
+          (i != 0 && lhs.LeadingSpace != rhs.LeadingSpace)) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+} // namespace lcc
+
+#endif // LCC_MACROINFO_H
@@ -0,0 +1,35 @@
+/***********************************
+ * File:     PPCallbacks.h
+ *
+ * Author:   caipeng
+ *
+ * Email:    iiicp@outlook.com
+ *
+ * Date:     2023/6/15
+ *
+ * Sign:     enjoy life
+ ***********************************/
+
+#ifndef LCC_PPCALLBACKS_H
+#define LCC_PPCALLBACKS_H
+
+namespace lcc {
+
+/// Told by the preprocessor about what it does while it runs, e.g. the -E
+/// printer follows the include stack through it instead of guessing it from
+/// the tokens, a file may produce no token at all
+class PPCallbacks {
+public:
+  enum FileChangeReason { EnterFile, ExitFile };
+
+  virtual ~PPCallbacks() = default;
+
+  /// an #include has been entered or a file has been left. `fileID` is the
+  /// buffer on top of the include stack afterwards and `loc` where lexing
+  /// goes on in it
+  virtual void FileChanged(unsigned fileID, const char *loc,
+                           FileChangeReason reason) {}
+};
+} // namespace lcc
+
+#endif // LCC_PPCALLBACKS_H
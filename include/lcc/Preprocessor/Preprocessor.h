@@ -0,0 +1,258 @@
+/***********************************
+ * File:     Preprocessor.h
+ *
+ * Author:   caipeng
+ *
+ * Email:    iiicp@outlook.com
+ *
+ * Date:     2023/6/10
+ *
+ * Sign:     enjoy life
+ ***********************************/
+
+#ifndef LCC_PREPROCESSOR_H
+#define LCC_PREPROCESSOR_H
+
+#include "lcc/Basic/Diagnostic.h"
+#include "lcc/Basic/FileManager.h"
+#include "lcc/Lexer/Lexer.h"
+#include "lcc/Lexer/Token.h"
+#include "lcc/Preprocessor/HeaderInfo.h"
+#include "lcc/Preprocessor/MacroInfo.h"
+#include "lcc/Preprocessor/PPCallbacks.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/FileSystem/UniqueID.h"
+#include "llvm/Support/StringSaver.h"
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace lcc {
+class PCHReader;
+
+/// The preprocessor sits between Lexer::Lex and Lexer::toCTokens. It pulls pp
+/// tokens from the lexer of the file on top of the include stack, executes the
+/// directives and hands out macro expanded tokens one at a time.
+///
+/// Macro bodies are stored once as flat PPToken arrays in the arena. An object
+/// like macro is expanded by pushing a context which points into its body,
+/// only function like macros build a new token list for the substituted
+/// arguments. Recursion is stopped by hide sets (Prosser's algorithm), so the
+/// expansion engine never rescans tokens it has already produced.
+class Preprocessor {
+public:
+  struct IncludedFile {
+    const FileEntry *File;
+    bool IsSystem;
+  };
+
+private:
+  struct ConditionalInfo {
+    const char *IfLoc;
+    /// one of the groups has been taken, the others are skipped
+    bool WasTaken;
+    bool SeenElse;
+  };
+
+  struct FileContext {
+    Lexer *Lex;
+    std::string Dir;
+    /// std::nullopt for buffers which are not a file, e.g. the predefines
+    std::optional<llvm::sys::fs::UniqueID> ID;
+    std::vector<ConditionalInfo> Conds;
+    MultipleIncludeOpt MIOpt;
+    bool AtLineStart{true};
+    /// found in a system include dir, or included by such a file
+    bool IsSystem{false};
+  };
+
+  /// the parameters of #embed and __has_embed, C23 6.10.4.2
+  struct EmbedParams {
+    std::optional<uint64_t> Limit;
+    std::vector<PPToken> Prefix;
+    std::vector<PPToken> Suffix;
+    std::vector<PPToken> IfEmpty;
+  };
+
+  struct MacroContext {
+    llvm::ArrayRef<PPToken> Tokens;
+    size_t Pos{0};
+    /// substituted tokens of a function like macro, Tokens refers to it
+    std::vector<PPToken> Storage;
+    /// added to the hide set of every token read from this context
+    const HideSet *HS{nullptr};
+    /// the first token takes the leading space of the macro name
+    std::optional<bool> FirstLeadingSpace;
+    /// a macro argument or a directive line being expanded on its own, reading
+    /// stops here instead of falling through to the enclosing tokens
+    bool IsBarrier{false};
+  };
+
+  llvm::SourceMgr &mSrcMgr;
+  DiagnosticEngine &Diag;
+  FileManager &mFileMgr;
+
+  llvm::BumpPtrAllocator mArena;
+  llvm::StringSaver mSaver{mArena};
+  llvm::StringMap<IdentifierInfo, llvm::BumpPtrAllocator> mIdentifiers;
+  llvm::DenseMap<std::pair<const MacroInfo *, const HideSet *>,
+                 const HideSet *>
+      mHideSets;
+
+  llvm::DenseMap<llvm::sys::fs::UniqueID, HeaderFileInfo> mHeaderInfos;
+  std::vector<std::string> mIncludeDirs;
+  std::vector<std::string> mSystemIncludeDirs;
+  std::string mPredefines;
+  std::vector<std::unique_ptr<Lexer>> mOwnedLexers;
+  std::vector<FileContext> mFiles;
+  std::vector<MacroContext> mContexts;
+  std::vector<PPToken> mPushback;
+  std::vector<IncludedFile> mIncludedFiles;
+  llvm::SmallPtrSet<const FileEntry *, 32> mIncludedFileSet;
+  /// location of the outermost macro name being expanded, for __LINE__
+  const char *mExpansionLoc{nullptr};
+  /// the same, but left alone by the directives, -E prints the tokens of an
+  /// expansion on the line of the macro name
+  const char *mExpansionStartLoc{nullptr};
+  unsigned mExpansionStartFileID{0};
+  unsigned mNumSkippedIncludes{0};
+  /// -include-pch, the macros of the prefix are read on first use
+  const PCHReader *mPCH{nullptr};
+  /// the text of the pch in the source manager, the macro tokens point into it
+  unsigned mPCHFileID{0};
+  PPCallbacks *mCallbacks{nullptr};
+
+public:
+  /// the file manager may be shared by the preprocessors of several
+  /// translation units, headers are then read once for all of them
+  Preprocessor(llvm::SourceMgr &mgr, DiagnosticEngine &diag,
+               FileManager &fileMgr);
+  Preprocessor(const Preprocessor &) = delete;
+  Preprocessor &operator=(const Preprocessor &) = delete;
+
+  /// -I dir, or -isystem dir when `isSystem`. The -I dirs are searched first
+  void AddIncludeDir(std::string_view dir, bool isSystem = false);
+  /// -D name or -D name=value
+  void AddMacroDefinition(std::string_view definition);
+  /// -U name
+  void AddMacroUndef(std::string_view name);
+  /// -include-pch, before EnterMainFile. A macro of the prefix is loaded from
+  /// the pch the first time its name is seen, the pch must outlive the
+  /// preprocessor
+  void UsePCH(const PCHReader &pch);
+  /// not owned, nullptr for none. PrintPreprocessedOutput installs its own
+  /// while it runs
+  void setCallbacks(PPCallbacks *callbacks) { mCallbacks = callbacks; }
+
+  /// the lexer of the main file must outlive the preprocessor
+  void EnterMainFile(Lexer &lexer);
+
+  /// the next fully expanded token, std::nullopt at the end of main file
+  std::optional<Token> Lex();
+  /// run Lex until the end of main file
+  std::vector<Token> Preprocess();
+  /// -E, an alternative to Preprocess. The tokens are written to `os` as they
+  /// are spelled, with the line markers and the spacing needed to read them
+  /// back the same
+  void PrintPreprocessedOutput(llvm::raw_ostream &os);
+  /// dependency scanning, an alternative to Preprocess. Only the directive
+  /// lines are lexed and executed, so #include, #if and #define work as usual
+  /// but no token of the text between them is built
+  void ScanDependencies();
+
+  [[nodiscard]] const MacroInfo *getMacroInfo(std::string_view name) const;
+  /// the macros defined now, sorted by name, for -emit-pch
+  [[nodiscard]] std::vector<const MacroInfo *> getDefinedMacros() const;
+  /// the number of #include skipped by the include guard or #pragma once
+  [[nodiscard]] unsigned getNumSkippedIncludes() const {
+    return mNumSkippedIncludes;
+  }
+  /// every file entered by #include, once, in the order of the first #include
+  [[nodiscard]] llvm::ArrayRef<IncludedFile> getIncludedFiles() const {
+    return mIncludedFiles;
+  }
+
+private:
+  IdentifierInfo *GetIdentifierInfo(std::string_view name);
+  void LoadMacroFromPCH(IdentifierInfo *ident);
+  PPToken ToPPToken(const Token &token);
+  Token ToToken(const PPToken &token);
+  std::string GetFullSpelling(const PPToken &token) const;
+
+  void EnterFile(Lexer &lexer,
+                 std::optional<llvm::sys::fs::UniqueID> id = std::nullopt,
+                 bool isSystem = false);
+  /// the end of the file on top of the include stack
+  void ExitFile();
+  void DefineBuiltinMacro(std::string_view name, MacroInfo::BuiltinKind kind);
+
+  /// tokens before macro expansion, directives are executed here
+  std::optional<PPToken> LexRaw();
+  std::optional<PPToken> LexFromFile();
+  std::optional<PPToken> LexExpanded();
+
+  /// directives
+  void HandleDirective(const PPToken &hash);
+  std::vector<PPToken> ReadDirectiveLine();
+  void SkipLine();
+  void HandleDefine(const PPToken &directive);
+  void HandleUndef(const PPToken &directive);
+  void HandleInclude(const PPToken &directive);
+  void HandleEmbed(const PPToken &directive);
+  void HandleIf(const PPToken &directive);
+  void HandleIfdef(const PPToken &directive, bool isIfndef);
+  void HandleElse(const PPToken &directive, bool isElif);
+  void HandleEndif(const PPToken &directive);
+  void HandleDiagnosticDirective(const PPToken &directive, bool isError);
+  void HandlePragma(const PPToken &directive);
+  /// skip the group after a false condition, stops after the #elif, #else or
+  /// #endif that ends the conditional or turns it active
+  void SkipExcludedBlock();
+  bool EvaluateCondition(const PPToken &directive,
+                         llvm::ArrayRef<PPToken> line);
+  bool EvaluateDirectiveExpression(llvm::ArrayRef<PPToken> tokens,
+                                   const char *loc);
+  std::optional<uint64_t> EvaluateDirectiveValue(llvm::ArrayRef<PPToken> tokens,
+                                                 const char *loc);
+  /// "file" or <file> at the front of `tokens`. Tokens which don't start with
+  /// a header name are macro expanded first, C99 6.10.2p4. What follows the
+  /// name is left in `rest`
+  bool ReadHeaderName(llvm::ArrayRef<PPToken> tokens, std::string &fileName,
+                      bool &isAngled, std::vector<PPToken> &rest);
+  void AddIncludedFile(const FileEntry *file, bool isSystem);
+  /// `report` is false for __has_embed, which evaluates to 0 instead
+  bool ParseEmbedParams(llvm::ArrayRef<PPToken> tokens, EmbedParams &params,
+                        bool report);
+  /// the bytes of the resource, std::nullopt when it doesn't exist
+  std::optional<std::string_view> LookupEmbed(std::string_view fileName,
+                                              bool isAngled,
+                                              const EmbedParams &params);
+  /// __has_embed( ... ) with the tokens between the parentheses
+  int EvaluateHasEmbed(llvm::ArrayRef<PPToken> tokens);
+  const FileEntry *LookupIncludeFile(std::string_view fileName, bool isAngled,
+                                     bool &isSystem) const;
+
+  /// macro expansion
+  bool EnterMacro(const PPToken &name, MacroInfo *macro);
+  std::vector<PPToken>
+  SubstituteArgs(const MacroInfo *macro,
+                 const std::vector<std::vector<PPToken>> &args,
+                 const HideSet *hs);
+  std::vector<PPToken> ExpandTokens(llvm::ArrayRef<PPToken> tokens);
+  PPToken Stringize(llvm::ArrayRef<PPToken> arg, const PPToken &hash);
+  std::optional<PPToken> Paste(const PPToken &lhs, const PPToken &rhs);
+
+  /// hide set
+  const HideSet *GetHideSet(const MacroInfo *macro, const HideSet *next);
+  const HideSet *HideSetAdd(const HideSet *hs, const MacroInfo *macro);
+  const HideSet *HideSetUnion(const HideSet *lhs, const HideSet *rhs);
+  const HideSet *HideSetIntersect(const HideSet *lhs, const HideSet *rhs);
+  static bool HideSetContains(const HideSet *hs, const MacroInfo *macro);
+};
+} // namespace lcc
+
+#endif // LCC_PREPROCESSOR_H
@@ -0,0 +1,80 @@
+/***********************************
+ * File:     ConstantEvaluator.h
+ *
+ * Author:   caipeng
+ *
+ * Email:    iiicp@outlook.com
+ *
+ * Date:     2023/6/16
+ *
+ * Sign:     enjoy life
+ ***********************************/
+
+#ifndef LCC_CONSTANTEVALUATOR_H
+#define LCC_CONSTANTEVALUATOR_H
+
+#include "lcc/AST/AST.h"
+#include "lcc/Basic/Diagnostic.h"
+#include "lcc/Basic/IntegerValue.h"
+#include "llvm/ADT/STLFunctionalExtras.h"
+#include <optional>
+#include <string_view>
+
+namespace lcc {
+
+/// C99 6.6p6, the integer constant expressions of case labels, enumerator
+/// values, bit-field widths and array bounds. The expression is walked where
+/// it is, nothing is allocated. The operands which are not evaluated, the
+/// other arm of `?:` and the right side of a short-circuited `&&` or `||`, are
+/// still checked to be constant but can't fail.
+class ConstantEvaluator {
+public:
+  /// the value of the enumeration constant `name`, nullopt when there is none
+  using EnumeratorLookup =
+      llvm::function_ref<std::optional<IntegerValue>(std::string_view name)>;
+
+private:
+  /// an arithmetic type spelled by type specifiers alone
+  struct ScalarType {
+    unsigned Size;
+    bool IsInteger;
+    bool IsUnsigned;
+    bool IsBool;
+  };
+
+  DiagnosticEngine &Diag;
+  EnumeratorLookup mLookup;
+  bool mHasError{false};
+
+public:
+  explicit ConstantEvaluator(DiagnosticEngine &diag,
+                             EnumeratorLookup lookup = {})
+      : Diag(diag), mLookup(lookup) {}
+
+  /// nullopt after an error was reported
+  std::optional<IntegerValue> Evaluate(const Syntax::ConstantExpr &expr);
+  /// an array bound is an assignment-expression in the grammar
+  std::optional<IntegerValue> Evaluate(const Syntax::AssignExpr &expr);
+
+private:
+  IntegerValue visit(const Syntax::CondExpr &expr, bool evaluate);
+  IntegerValue visit(const Syntax::BinaryOperand &expr, bool evaluate);
+  IntegerValue visit(const Syntax::BinaryExpr &expr, bool evaluate);
+  IntegerValue visit(const Syntax::CastExpr &expr, bool evaluate);
+  IntegerValue visit(const Syntax::UnaryExpr &expr, bool evaluate);
+  IntegerValue visit(const Syntax::PostFixExpr &expr, bool evaluate);
+  IntegerValue visit(const Syntax::PrimaryExpr &expr, bool evaluate);
+  IntegerValue visit(const Syntax::Expr &expr, bool evaluate);
+
+  IntegerValue Apply(IntegerValue::BinaryOp op, IntegerValue lhs,
+                     IntegerValue rhs, bool evaluate, SourceLocation loc);
+  void CheckStatus(IntegerValue::Status status, SourceLocation loc);
+  IntegerValue NotConstant(SourceLocation loc);
+
+  /// nullopt for a type-name with a declarator, a tag or a typedef name
+  static std::optional<ScalarType>
+  GetScalarType(const Syntax::TypeName &typeName);
+};
+} // namespace lcc
+
+#endif // LCC_CONSTANTEVALUATOR_H
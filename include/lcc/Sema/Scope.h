@@ -14,9 +14,11 @@
 
 #include "lcc/AST/SemaAST.h"
 #include "lcc/Sema/Type.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/ScopeExit.h"
+#include "llvm/ADT/StringRef.h"
 #include <string_view>
-#include <unordered_map>
+#include <vector>
 
 namespace lcc {
 
@@ -25,38 +27,117 @@ namespace lcc {
 /// 2.
 /// 可以通过id绑定到某一个类型上，这样可以和添加debug信息复用。就是为了添加debug信息
 ///    导致的复用
-
+///
+/// The names in scope during Sema, the ordinary identifiers and the tags of
+/// structs, unions and enums, which C keeps apart (C11 6.2.3). As in the
+/// Parser's scope, one hash table per namespace holds the innermost binding
+/// of each name and a binding remembers the one it shadows, so a lookup is
+/// one probe however deep the blocks nest and leaving a scope costs only the
+/// names it declared. A symbol found is valid until the next one is added or
+/// its scope is left.
 class Scope {
 public:
   using DeclarationSymbol =
       std::variant<SemaSyntax::Declaration *, SemaSyntax::FunctionDefinition *>;
+  using TagSymbol = const Type *;
 
 private:
-  struct Env {
-    std::vector<std::pair<std::string_view, DeclarationSymbol>>
-        declarationSymbols_;
+  template <typename T> class SymbolTable {
+  private:
+    static constexpr unsigned NoBinding = ~0u;
+    struct Binding {
+      std::string_view name_;
+      /// the binding of the name in an enclosing scope, or NoBinding
+      unsigned shadowed_;
+      unsigned depth_;
+      T symbol_;
+    };
+    /// in order of declaration, which is also the order of the scopes
+    std::vector<Binding> bindings_;
+    llvm::DenseMap<llvm::StringRef, unsigned> innermost_;
+    /// the start of each open scope in bindings_
+    std::vector<unsigned> scopeBegins_;
+
+  public:
+    const T *Find(std::string_view name) const {
+      auto iter = innermost_.find(llvm::StringRef(name.data(), name.size()));
+      return iter == innermost_.end() ? nullptr
+                                      : &bindings_[iter->second].symbol_;
+    }
+    const T *FindInCurrentScope(std::string_view name) const {
+      auto iter = innermost_.find(llvm::StringRef(name.data(), name.size()));
+      if (iter == innermost_.end() ||
+          bindings_[iter->second].depth_ != scopeBegins_.size()) {
+        return nullptr;
+      }
+      return &bindings_[iter->second].symbol_;
+    }
+    /// the binding of the name in the current scope when it has one already,
+    /// which stays, null when `symbol` is bound
+    const T *Add(std::string_view name, T symbol) {
+      auto [iter, inserted] = innermost_.try_emplace(
+          llvm::StringRef(name.data(), name.size()), bindings_.size());
+      unsigned shadowed = NoBinding;
+      if (!inserted) {
+        if (bindings_[iter->second].depth_ == scopeBegins_.size()) {
+          return &bindings_[iter->second].symbol_;
+        }
+        shadowed = iter->second;
+        iter->second = bindings_.size();
+      }
+      bindings_.push_back(
+          Binding{name, shadowed, unsigned(scopeBegins_.size()), symbol});
+      return nullptr;
+    }
+    void PushScope() { scopeBegins_.push_back(bindings_.size()); }
+    void PopScope() {
+      unsigned begin = scopeBegins_.back();
+      scopeBegins_.pop_back();
+      while (bindings_.size() > begin) {
+        const Binding &binding = bindings_.back();
+        llvm::StringRef key(binding.name_.data(), binding.name_.size());
+        if (binding.shadowed_ == NoBinding) {
+          innermost_.erase(key);
+        } else {
+          innermost_[key] = binding.shadowed_;
+        }
+        bindings_.pop_back();
+      }
+    }
   };
-  /// 记录当前的环境id
+
+  SymbolTable<DeclarationSymbol> declarationSymbols_;
+  SymbolTable<TagSymbol> tagSymbols_;
+  /// 记录当前的环境id, 0 is the file scope
   size_t currentEnvId_{0};
-  /// 默认添加一个全局的环境
-  std::vector<Env> scopes_ = {{}};
 
 public:
-  auto EnterScope() {
-    scopes_.push_back({});
+  /// opens a block scope, which is closed when the result goes away
+  [[nodiscard]] auto EnterScope() {
+    declarationSymbols_.PushScope();
+    tagSymbols_.PushScope();
     currentEnvId_++;
-    return llvm::make_scope_exit([&] {
-      scopes_.pop_back();
+    return llvm::make_scope_exit([this] {
+      declarationSymbols_.PopScope();
+      tagSymbols_.PopScope();
       currentEnvId_--;
     });
   }
+  [[nodiscard]] size_t getCurrentEnvId() const { return currentEnvId_; }
 
-  const DeclarationSymbol *FindDeclSymbol(std::string_view name) {
-    return FindDeclSymbol(name, currentEnvId_);
-  }
+  /// the innermost declaration of the ordinary identifier `name`
+  const DeclarationSymbol *FindDeclSymbol(std::string_view name) const;
+  const DeclarationSymbol *
+  FindDeclSymbolInCurrentScope(std::string_view name) const;
+  /// declares `name` in the current scope, the declaration it already has
+  /// there when it is a redeclaration, which is kept
+  const DeclarationSymbol *AddDeclSymbol(std::string_view name,
+                                         DeclarationSymbol symbol);
 
-private:
-  const DeclarationSymbol *FindDeclSymbol(std::string_view name, size_t envId);
+  /// the innermost struct, union or enum with the tag `name`
+  const TagSymbol *FindTagSymbol(std::string_view name) const;
+  const TagSymbol *FindTagSymbolInCurrentScope(std::string_view name) const;
+  const TagSymbol *AddTagSymbol(std::string_view name, TagSymbol symbol);
 };
 } // namespace lcc
 #endif // LCC_SCOPE_H
@@ -0,0 +1,158 @@
+/***********************************
+ * File:     ASTFile.h
+ *
+ * Author:   caipeng
+ *
+ * Email:    iiicp@outlook.com
+ *
+ * Date:     2023/6/18
+ *
+ * Sign:     enjoy life
+ ***********************************/
+
+#ifndef LCC_ASTFILE_H
+#define LCC_ASTFILE_H
+
+#include "lcc/AST/AST.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/raw_ostream.h"
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace lcc {
+
+/// the kinds of the records, the layout of each is in ASTNodeKinds.def
+enum class ASTNodeKind : uint16_t {
+#define AST_NODE(Name) Name,
+#include "lcc/Serialization/ASTNodeKinds.def"
+  NUM_KINDS
+};
+const char *getASTNodeKindName(ASTNodeKind kind);
+
+/// the payload of a PrimaryExprConstant, which alternative its value is, and
+/// of a ConstantArray, which its elements are
+enum class ASTConstantKind : uint16_t {
+  Int32,
+  UInt32,
+  Int64,
+  UInt64,
+  Float,
+  Double,
+  String
+};
+
+/// Binary AST file: the syntax tree of a translation unit, written by
+/// -emit-ast-file for tools which want lcc's parse without running the
+/// frontend. All integers are little endian uint32, the file is laid out so
+/// that it can be mapped and walked in place:
+///
+///   header      magic, format version, NUM_KINDS, section offsets
+///   nodes       a record of six words per node, the root first:
+///               {kind | payload << 16, file, offset, string or constant,
+///               first child, number of children}
+///   children    the node indices of the children of each node one after
+///               the other, NoNode for an absent optional child
+///   constants   the values of the numeric constants, two words each
+///   strings     the names, labels, string literals and file names, each
+///               spelled once however many nodes refer to it
+///   string table  {offset, length} of each string
+///   files       the string of the name of each file a node is located in
+///
+/// A node is located by the offset of its first token in its file. Nothing
+/// is decoded when the file is opened, a record is read when it is visited.
+class ASTWriter {
+public:
+  /// `srcMgr` holds the buffers the tokens of `unit` are spelled in
+  static void Emit(const Syntax::TranslationUnit &unit,
+                   const llvm::SourceMgr &srcMgr, llvm::raw_ostream &os);
+};
+
+class ASTReader;
+
+/// a node of a mapped AST file, a pointer and an index
+class ASTRecord {
+private:
+  const ASTReader *mReader{nullptr};
+  uint32_t mIndex{0};
+
+public:
+  ASTRecord() = default;
+  ASTRecord(const ASTReader *reader, uint32_t index)
+      : mReader(reader), mIndex(index) {}
+
+  /// false for an absent child
+  explicit operator bool() const { return mReader != nullptr; }
+  [[nodiscard]] uint32_t getIndex() const { return mIndex; }
+
+  [[nodiscard]] ASTNodeKind getKind() const;
+  [[nodiscard]] uint32_t getPayload() const;
+  /// the name of the file of the node, empty when it has none
+  [[nodiscard]] llvm::StringRef getFileName() const;
+  [[nodiscard]] uint32_t getOffset() const;
+  /// the name, label, member, typedef or string literal of the node
+  [[nodiscard]] std::optional<llvm::StringRef> getString() const;
+  /// the value of a numeric PrimaryExprConstant as it is stored in 64 bits,
+  /// the payload tells the type
+  [[nodiscard]] std::optional<uint64_t> getConstant() const;
+  /// the number of elements of a ConstantArray
+  [[nodiscard]] std::optional<uint32_t> getNumElements() const;
+  /// element `index` of a ConstantArray as getConstant stores it
+  [[nodiscard]] std::optional<uint64_t> getElement(uint32_t index) const;
+
+  [[nodiscard]] uint32_t getNumChildren() const;
+  /// an empty record for an absent child or a malformed file, one where the
+  /// child is not numbered after this node
+  [[nodiscard]] ASTRecord getChild(uint32_t index) const;
+
+private:
+  [[nodiscard]] std::optional<uint64_t> ReadConstant(uint64_t index) const;
+};
+
+/// Read side of the AST file, the file is mapped once and never written so a
+/// reader may be shared between threads.
+class ASTReader {
+private:
+  friend class ASTRecord;
+
+  std::string mFileName;
+  std::unique_ptr<llvm::MemoryBuffer> mBuffer;
+  const char *mNodes{nullptr};
+  uint32_t mNumNodes{0};
+  const char *mChildren{nullptr};
+  uint32_t mNumChildren{0};
+  const char *mConstants{nullptr};
+  uint32_t mNumConstants{0};
+  llvm::StringRef mStrings;
+  const char *mStringTable{nullptr};
+  uint32_t mNumStrings{0};
+  const char *mFiles{nullptr};
+  uint32_t mNumFiles{0};
+
+  ASTReader() = default;
+
+public:
+  /// fails when the file is not an AST file of this compiler
+  static llvm::Expected<std::unique_ptr<ASTReader>> Load(llvm::StringRef path);
+  /// the same for an AST file held in `buffer`, e.g. a section of a pch
+  static llvm::Expected<std::unique_ptr<ASTReader>>
+  Load(std::unique_ptr<llvm::MemoryBuffer> buffer);
+
+  [[nodiscard]] llvm::StringRef getFileName() const { return mFileName; }
+  [[nodiscard]] uint32_t getNumNodes() const { return mNumNodes; }
+  /// the TranslationUnit, empty when there is no node
+  [[nodiscard]] ASTRecord getRoot() const {
+    return mNumNodes ? ASTRecord(this, 0) : ASTRecord();
+  }
+
+private:
+  [[nodiscard]] const char *getRecord(uint32_t index) const;
+  [[nodiscard]] std::optional<llvm::StringRef> getString(uint32_t index) const;
+};
+} // namespace lcc
+
+#endif // LCC_ASTFILE_H
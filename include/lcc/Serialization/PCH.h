@@ -0,0 +1,158 @@
+/***********************************
+ * File:     PCH.h
+ *
+ * Author:   caipeng
+ *
+ * Email:    iiicp@outlook.com
+ *
+ * Date:     2023/6/14
+ *
+ * Sign:     enjoy life
+ ***********************************/
+
+#ifndef LCC_PCH_H
+#define LCC_PCH_H
+
+#include "lcc/Basic/TokenKinds.h"
+#include "lcc/Preprocessor/MacroInfo.h"
+#include "lcc/Serialization/ASTFile.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace lcc {
+
+/// Precompiled header: the state of the compiler after a header prefix,
+/// written by -emit-pch and read back by -include-pch. All integers are
+/// little endian uint32, the file is laid out so that it can be mapped and
+/// used in place:
+///
+///   header      magic, format version, NUM_TOKENS, section offsets
+///   text        every macro re-spelled as a `#define` line, the spellings and
+///               locations of the macro tokens point into it, so it is
+///               registered as a source buffer for the diagnostics
+///   strings     the names of the input files and of the file scope bindings
+///   inputs      the real paths of the files the prefix was built from, with
+///               size and mtime
+///   macros      open addressing hash table of the macros defined at the end
+///               of the prefix, a bucket is {hash, record offset}
+///   bindings    open addressing hash table of the names the prefix declares
+///               at file scope, and whether each is a typedef name
+///   ast         the syntax tree of the prefix as a binary AST file, see
+///               lcc/Serialization/ASTFile.h
+///
+/// Nothing is decoded when the file is opened, a macro or a binding is looked
+/// up in its table the first time the translation unit asks for the name. The
+/// parser of the translation unit starts after the prefix, its file scope
+/// falls back to the bindings, and the declarations of the prefix are read
+/// from the AST section instead of being parsed again.
+class PCHWriter {
+private:
+  struct MacroEntry {
+    /// the name is spelled in mText, which may still grow
+    uint32_t NameOffset;
+    uint32_t NameLength;
+    /// in words from the start of mMacroRecords
+    uint32_t RecordOffset;
+  };
+  struct Binding {
+    uint32_t NameOffset;
+    uint32_t NameLength;
+    bool IsTypedef;
+  };
+  struct InputFile {
+    uint32_t NameOffset;
+    uint32_t NameLength;
+    uint64_t Size;
+    uint64_t ModTime;
+  };
+  std::string mText;
+  std::string mStrings;
+  std::vector<uint32_t> mMacroRecords;
+  std::vector<MacroEntry> mMacros;
+  std::vector<Binding> mBindings;
+  std::string mAST;
+  std::vector<InputFile> mInputFiles;
+
+public:
+  /// a file the prefix depends on, the pch is stale once it changes
+  llvm::Error AddInputFile(llvm::StringRef path);
+  void AddMacro(const MacroInfo &macro);
+  /// a name the prefix declares at file scope, see Parser::GetFileScopeBindings
+  void AddFileScopeBinding(std::string_view name, bool isTypedef);
+  /// the syntax tree of the prefix, `srcMgr` holds the buffers it is spelled in
+  void AddAST(const Syntax::TranslationUnit &unit,
+              const llvm::SourceMgr &srcMgr);
+  void Emit(llvm::raw_ostream &os) const;
+
+private:
+  uint32_t AddString(std::string_view str);
+};
+
+/// a macro record of the pch, the spellings point into PCHReader::getText()
+struct PCHMacro {
+  struct Token {
+    tok::TokenKind Kind;
+    bool LeadingSpace;
+    uint16_t ArgNo;
+    /// offset of the token in the text
+    uint32_t Loc;
+    std::string_view Spelling;
+  };
+  std::string_view Name;
+  uint32_t DefLoc;
+  bool FunctionLike;
+  bool Variadic;
+  llvm::SmallVector<std::string_view, 4> Params;
+  llvm::SmallVector<Token, 8> Body;
+};
+
+/// Read side of the pch. The file is mapped once and is never written, so one
+/// reader can be shared by the translation units compiled in parallel.
+class PCHReader {
+private:
+  std::string mFileName;
+  std::unique_ptr<llvm::MemoryBuffer> mBuffer;
+  llvm::StringRef mText;
+  llvm::StringRef mStrings;
+  const char *mMacroTable{nullptr};
+  uint32_t mNumMacroBuckets{0};
+  const char *mBindingTable{nullptr};
+  uint32_t mNumBindingBuckets{0};
+  std::unique_ptr<ASTReader> mAST;
+  std::vector<std::string_view> mInputFiles;
+
+  PCHReader() = default;
+
+public:
+  /// fails when the file is not a pch of this compiler, when one of its tables
+  /// is malformed, or when one of the files the prefix was built from has
+  /// changed since
+  static llvm::Expected<std::unique_ptr<PCHReader>> Load(llvm::StringRef path);
+
+  [[nodiscard]] llvm::StringRef getFileName() const { return mFileName; }
+  /// the `#define` lines the macro tokens are spelled in
+  [[nodiscard]] llvm::StringRef getText() const { return mText; }
+  /// the prefix header first, then the files it included
+  [[nodiscard]] llvm::ArrayRef<std::string_view> getInputFiles() const {
+    return mInputFiles;
+  }
+
+  [[nodiscard]] std::optional<PCHMacro> LookupMacro(std::string_view name) const;
+  /// whether the prefix declares `name` at file scope as a typedef name,
+  /// std::nullopt when it doesn't declare it
+  [[nodiscard]] std::optional<bool> LookupBinding(std::string_view name) const;
+  /// the declarations of the prefix, walked in place
+  [[nodiscard]] const ASTReader &getAST() const { return *mAST; }
+};
+} // namespace lcc
+
+#endif // LCC_PCH_H
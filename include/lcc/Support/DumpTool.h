@@ -12,6 +12,7 @@
 #ifndef LCC_DUMPTOOL_H
 #define LCC_DUMPTOOL_H
 #include "lcc/AST/AST.h"
+#include "lcc/Lexer/Token.h"
 namespace lcc::dump {
 
 void dumpTokens(const std::vector<lcc::Token> &tokens);
@@ -25,10 +26,8 @@ void visit(const Syntax::Declarator &declarator);
 void visit(const Syntax::AbstractDeclarator &abstractDeclarator);
 void visit(const Syntax::InitializerList &initializerList);
 void visit(const Syntax::Initializer &initializer);
-void visit(const Syntax::StorageClsSpec &storageClassSpecifier);
 void visit(const Syntax::TypeQualifier &typeQualifier);
 void visit(const Syntax::TypeSpec &typeSpecifier);
-void visit(const Syntax::FunctionSpecifier &functionSpecifier);
 // void visit(const Syntax::SpecifierQualifiers &specifierQualifiers);
 void visit(const Syntax::Pointer &pointer);
 void visit(const Syntax::DirectDeclarator &directDeclarator);
@@ -57,16 +56,9 @@ void visit(const Syntax::Expr &expr);
 void visit(const Syntax::ConstantExpr &constantExpr);
 void visit(const Syntax::AssignExpr &assignExpr);
 void visit(const Syntax::CondExpr &conditionalExpr);
-void visit(const Syntax::LogOrExpr &logOrExpr);
-void visit(const Syntax::LogAndExpr &logAndExpr);
-void visit(const Syntax::BitOrExpr &bitOrExpr);
-void visit(const Syntax::BitXorExpr &bitXorExpr);
-void visit(const Syntax::BitAndExpr &bitAndExpr);
-void visit(const Syntax::EqualExpr &equalExpr);
-void visit(const Syntax::RelationalExpr &relationalExpr);
-void visit(const Syntax::ShiftExpr &shiftExpr);
-void visit(const Syntax::AdditiveExpr &additiveExpr);
-void visit(const Syntax::MultiExpr &multiExpr);
+/// the binary operators are dumped in the shape of the grammar, a node for
+/// each level from `precedence` down to the cast-expression
+void visit(const Syntax::BinaryOperand &operand, unsigned precedence);
 void visit(const Syntax::CastExpr &castExpr);
 void visit(const Syntax::UnaryExpr &unaryExpr);
 void visit(const Syntax::TypeName &typeName);
@@ -0,0 +1,109 @@
+/***********************************
+ * File:     ASTContext.cc
+ *
+ * Author:   caipeng
+ *
+ * Email:    iiicp@outlook.com
+ *
+ * Date:     2023/6/17
+ *
+ * Sign:     enjoy life
+ ***********************************/
+
+#include "lcc/AST/ASTContext.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/MathExtras.h"
+#include <algorithm>
+#include <cstdlib>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace lcc {
+
+/// the first slab, each new one is twice as large up to MaxSlabSize
+static constexpr size_t MinSlabSize = 64 * 1024;
+static constexpr size_t MaxSlabSize = 4 * 1024 * 1024;
+static constexpr size_t HugePageSize = 2 * 1024 * 1024;
+
+ASTContext::~ASTContext() {
+  for (const Slab &slab : mSlabs) {
+#ifdef __linux__
+    if (slab.Mapped) {
+      munmap(slab.Begin, slab.Size);
+      continue;
+    }
+#endif
+    std::free(slab.Begin);
+  }
+}
+
+ASTContext::Slab ASTContext::NewSlab(size_t minSize) {
+  size_t size = MinSlabSize << std::min<size_t>(mSlabs.size(), 6);
+  size = std::max(std::min(size, MaxSlabSize), minSize);
+#ifdef __linux__
+  if (mHugePages) {
+    /// over-map by a huge page and trim, so the slab starts on a boundary
+    size = llvm::alignTo(size, HugePageSize);
+    void *map = mmap(nullptr, size + HugePageSize, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (map != MAP_FAILED) {
+      auto begin = reinterpret_cast<uintptr_t>(map);
+      uintptr_t aligned = llvm::alignTo(begin, HugePageSize);
+      if (aligned != begin) {
+        munmap(map, aligned - begin);
+      }
+      munmap(reinterpret_cast<void *>(aligned + size),
+             begin + HugePageSize - aligned);
+      madvise(reinterpret_cast<void *>(aligned), size, MADV_HUGEPAGE);
+      return {reinterpret_cast<char *>(aligned), size, true};
+    }
+  }
+#endif
+  auto *begin = static_cast<char *>(std::malloc(size));
+  if (!begin) {
+    llvm::report_bad_alloc_error("out of memory in the AST arena");
+  }
+  return {begin, size, false};
+}
+
+void *ASTContext::AllocateSlow(size_t size, size_t alignment) {
+  Slab slab = NewSlab(size + alignment - 1);
+  mSlabs.push_back(slab);
+  auto begin = reinterpret_cast<uintptr_t>(slab.Begin);
+  uintptr_t aligned = (begin + alignment - 1) & ~uintptr_t(alignment - 1);
+  char *end = slab.Begin + slab.Size;
+  /// an allocation larger than the rest of the current slab is most likely
+  /// one of a kind, keep bumping the old slab when it has more room left
+  if (!mCur || end - reinterpret_cast<char *>(aligned + size) >= mEnd - mCur) {
+    mCur = reinterpret_cast<char *>(aligned + size);
+    mEnd = end;
+  }
+  return reinterpret_cast<void *>(aligned);
+}
+
+void ASTContext::Adopt(std::unique_ptr<ASTContext> other) {
+  mSlabs.append(other->mSlabs.begin(), other->mSlabs.end());
+  mNumAllocations += other->mNumAllocations;
+  mBytesAllocated += other->mBytesAllocated;
+  other->mSlabs.clear();
+  other->mCur = other->mEnd = nullptr;
+  other->mNumAllocations = other->mBytesAllocated = 0;
+  mAdopted.push_back(std::move(other));
+}
+
+size_t ASTContext::getBytesReserved() const {
+  size_t size = 0;
+  for (const Slab &slab : mSlabs) {
+    size += slab.Size;
+  }
+  return size;
+}
+
+void ASTContext::PrintStats(llvm::raw_ostream &os) const {
+  os << "AST arena: " << mNumAllocations << " allocations, "
+     << mBytesAllocated << " bytes allocated, " << getBytesReserved()
+     << " bytes reserved in " << mSlabs.size() << " slabs"
+     << (mHugePages ? " (huge pages)" : "") << "\n";
+}
+} // namespace lcc
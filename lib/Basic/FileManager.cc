@@ -0,0 +1,129 @@
+/***********************************
+ * File:     FileManager.cc
+ *
+ * Author:   caipeng
+ *
+ * Email:    iiicp@outlook.com
+ *
+ * Date:     2023/6/13
+ *
+ * Sign:     enjoy life
+ ***********************************/
+
+#include "lcc/Basic/FileManager.h"
+#include "llvm/Support/FileSystem.h"
+#include <cstring>
+
+namespace lcc {
+
+using namespace llvm;
+
+void FileEntry::Load() const {
+  std::call_once(mLoadOnce, [this] {
+    /// MemoryBuffer::getFile maps the file when it is big enough to pay off
+    auto buffer = MemoryBuffer::getFile(mName);
+    if (!buffer) {
+      mLoadError = buffer.getError();
+      return;
+    }
+    mRawBuffer = std::move(*buffer);
+  });
+}
+
+void FileEntry::Normalize() const {
+  std::call_once(mNormalizeOnce, [this] {
+    StringRef content = mRawBuffer->getBuffer();
+    bool hasBOM = content.startswith("\xef\xbb\xbf");
+    const char *cr = static_cast<const char *>(
+        std::memchr(content.data(), '\r', content.size()));
+    if (!hasBOM && !cr) {
+      return;
+    }
+    /// same as Lexer::RegularSourceCode, done once here instead of once per
+    /// translation unit
+    if (hasBOM) {
+      content = content.drop_front(3);
+    }
+    std::string normalized;
+    normalized.reserve(content.size());
+    /// copy the runs between the "\r\n"s, a lone '\r' is kept
+    const char *p = content.data(), *end = content.data() + content.size();
+    while ((cr = static_cast<const char *>(std::memchr(p, '\r', end - p)))) {
+      bool crlf = cr + 1 < end && cr[1] == '\n';
+      normalized.append(p, crlf ? cr : cr + 1);
+      p = cr + 1;
+    }
+    normalized.append(p, end);
+    mBuffer = MemoryBuffer::getMemBufferCopy(normalized, mName);
+  });
+}
+
+llvm::ErrorOr<const llvm::MemoryBuffer *> FileEntry::getBuffer() const {
+  Load();
+  if (!mRawBuffer) {
+    return mLoadError;
+  }
+  Normalize();
+  return mBuffer ? mBuffer.get() : mRawBuffer.get();
+}
+
+llvm::ErrorOr<const llvm::MemoryBuffer *> FileEntry::getRawBuffer() const {
+  Load();
+  if (!mRawBuffer) {
+    return mLoadError;
+  }
+  return mRawBuffer.get();
+}
+
+llvm::ErrorOr<const FileEntry *> FileManager::getFile(llvm::StringRef path) {
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto iter = mSeenPaths.find(path);
+    if (iter != mSeenPaths.end()) {
+      if (!iter->second) {
+        return iter->second.getError();
+      }
+      return *iter->second;
+    }
+  }
+
+  /// stat without holding the lock, another thread may race us on the same
+  /// path, the first one to come back wins
+  sys::fs::file_status status;
+  std::error_code ec = sys::fs::status(path, status);
+  if (!ec && !sys::fs::is_regular_file(status)) {
+    ec = sys::fs::is_directory(status)
+             ? std::make_error_code(std::errc::is_a_directory)
+             : std::make_error_code(std::errc::no_such_file_or_directory);
+  }
+
+  std::lock_guard<std::mutex> lock(mMutex);
+  ++mNumStatCalls;
+  if (ec) {
+    auto &entry = *mSeenPaths.try_emplace(path, ec).first;
+    if (!entry.second) {
+      return entry.second.getError();
+    }
+    return *entry.second;
+  }
+  auto &file = mUniqueFiles[status.getUniqueID()];
+  if (!file) {
+    file = std::make_unique<FileEntry>(path, status.getUniqueID());
+  }
+  auto &entry = *mSeenPaths.try_emplace(path, file.get()).first;
+  if (!entry.second) {
+    return entry.second.getError();
+  }
+  return *entry.second;
+}
+
+unsigned FileManager::getNumUniqueFiles() const {
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mUniqueFiles.size();
+}
+
+unsigned FileManager::getNumStatCalls() const {
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mNumStatCalls;
+}
+} // namespace lcc
@@ -0,0 +1,250 @@
+/***********************************
+ * File:     IntegerValue.cc
+ *
+ * Author:   caipeng
+ *
+ * Email:    iiicp@outlook.com
+ *
+ * Date:     2023/6/16
+ *
+ * Sign:     enjoy life
+ ***********************************/
+
+#include "lcc/Basic/IntegerValue.h"
+#include "llvm/Support/MathExtras.h"
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+namespace lcc {
+
+using Status = IntegerValue::Status;
+
+static Status ApplyShift(IntegerValue::BinaryOp op, IntegerValue lhs,
+                         IntegerValue rhs, IntegerValue &result) {
+  /// C99 6.5.7p3, the type of the result is that of the promoted left operand
+  unsigned width = lhs.getWidth();
+  bool isUnsigned = lhs.isUnsigned();
+  uint64_t count = rhs.getZExtValue();
+  bool outOfRange = rhs.isNegative() || count >= width;
+  if (op == IntegerValue::BinaryOp::Shl) {
+    if (outOfRange) {
+      result = IntegerValue(0, width, isUnsigned);
+      return Status::ShiftOutOfRange;
+    }
+    result = IntegerValue(lhs.getZExtValue() << count, width, isUnsigned);
+    /// C99 6.5.7p4, a signed E1 * 2^E2 has to be representable
+    if (!isUnsigned &&
+        (lhs.isNegative() || result.isNegative() ||
+         (result.getZExtValue() >> count) != lhs.getZExtValue())) {
+      return Status::Overflow;
+    }
+    return Status::Ok;
+  }
+  if (outOfRange) {
+    result = IntegerValue(lhs.isNegative() ? ~uint64_t(0) : 0, width,
+                          isUnsigned);
+    return Status::ShiftOutOfRange;
+  }
+  /// a negative value is shifted arithmetically, implementation-defined
+  result = isUnsigned
+               ? IntegerValue(lhs.getZExtValue() >> count, width, true)
+               : IntegerValue(static_cast<uint64_t>(lhs.getSExtValue() >>
+                                                    count),
+                              width, false);
+  return Status::Ok;
+}
+
+Status IntegerValue::Apply(BinaryOp op, IntegerValue lhs, IntegerValue rhs,
+                           IntegerValue &result) {
+  lhs = lhs.promote();
+  rhs = rhs.promote();
+  if (op == BinaryOp::Shl || op == BinaryOp::Shr) {
+    return ApplyShift(op, lhs, rhs, result);
+  }
+
+  /// C99 6.3.1.8, after promotion a wider type holds every value of a
+  /// narrower one, so the common type is the wider one, unsigned when the
+  /// widths are equal and one of them is
+  unsigned width = std::max(lhs.mWidth, rhs.mWidth);
+  bool isUnsigned = (lhs.mUnsigned && lhs.mWidth == width) ||
+                    (rhs.mUnsigned && rhs.mWidth == width);
+  lhs = lhs.convertTo(width, isUnsigned);
+  rhs = rhs.convertTo(width, isUnsigned);
+  uint64_t a = lhs.mValue, b = rhs.mValue;
+  int64_t sa = lhs.getSExtValue(), sb = rhs.getSExtValue();
+
+  /// a signed result is computed in 64 bits and then has to survive the
+  /// truncation to its type
+  auto checked = [&](bool overflow, int64_t value) {
+    result = IntegerValue(static_cast<uint64_t>(value), width, false);
+    return overflow || result.getSExtValue() != value ? Status::Overflow
+                                                      : Status::Ok;
+  };
+  auto compare = [&](auto pred) {
+    result = getBool(isUnsigned ? pred(a, b) : pred(sa, sb));
+    return Status::Ok;
+  };
+
+  switch (op) {
+  case BinaryOp::Mul: {
+    if (isUnsigned) {
+      result = IntegerValue(a * b, width, true);
+      return Status::Ok;
+    }
+    int64_t value;
+    bool overflow = llvm::MulOverflow(sa, sb, value);
+    return checked(overflow, value);
+  }
+  case BinaryOp::Add: {
+    if (isUnsigned) {
+      result = IntegerValue(a + b, width, true);
+      return Status::Ok;
+    }
+    int64_t value;
+    bool overflow = llvm::AddOverflow(sa, sb, value);
+    return checked(overflow, value);
+  }
+  case BinaryOp::Sub: {
+    if (isUnsigned) {
+      result = IntegerValue(a - b, width, true);
+      return Status::Ok;
+    }
+    int64_t value;
+    bool overflow = llvm::SubOverflow(sa, sb, value);
+    return checked(overflow, value);
+  }
+  case BinaryOp::Div:
+  case BinaryOp::Rem: {
+    bool isDiv = op == BinaryOp::Div;
+    if (b == 0) {
+      result = IntegerValue(0, width, isUnsigned);
+      return Status::DivisionByZero;
+    }
+    if (isUnsigned) {
+      result = IntegerValue(isDiv ? a / b : a % b, width, true);
+      return Status::Ok;
+    }
+    /// the minimum divided by -1 is the only quotient which doesn't fit,
+    /// and the only one the host can't compute either
+    if (sb == -1) {
+      result = IntegerValue(isDiv ? 0 - a : 0, width, false);
+      return isDiv && a != 0 && result.mValue == a ? Status::Overflow
+                                                   : Status::Ok;
+    }
+    return checked(false, isDiv ? sa / sb : sa % sb);
+  }
+  case BinaryOp::Less:
+    return compare(std::less<>());
+  case BinaryOp::Greater:
+    return compare(std::greater<>());
+  case BinaryOp::LessEqual:
+    return compare(std::less_equal<>());
+  case BinaryOp::GreaterEqual:
+    return compare(std::greater_equal<>());
+  case BinaryOp::Equal:
+    result = getBool(a == b);
+    return Status::Ok;
+  case BinaryOp::NotEqual:
+    result = getBool(a != b);
+    return Status::Ok;
+  case BinaryOp::BitAnd:
+    result = IntegerValue(a & b, width, isUnsigned);
+    return Status::Ok;
+  case BinaryOp::BitXor:
+    result = IntegerValue(a ^ b, width, isUnsigned);
+    return Status::Ok;
+  case BinaryOp::BitOr:
+    result = IntegerValue(a | b, width, isUnsigned);
+    return Status::Ok;
+  case BinaryOp::Shl:
+  case BinaryOp::Shr:
+    break;
+  }
+  return Status::Ok;
+}
+
+Status IntegerValue::Negate(IntegerValue &result) const {
+  IntegerValue value = promote();
+  result = IntegerValue(0 - value.mValue, value.mWidth, value.mUnsigned);
+  /// only zero and the minimum are their own negation
+  if (!value.mUnsigned && value.mValue != 0 && result.mValue == value.mValue) {
+    return Status::Overflow;
+  }
+  return Status::Ok;
+}
+
+IntegerValue IntegerValue::BitNot() const {
+  IntegerValue value = promote();
+  return {~value.mValue, value.mWidth, value.mUnsigned};
+}
+
+std::optional<IntegerValue>
+IntegerValue::ParseLiteral(std::string_view spelling) {
+  size_t pos = 0;
+  unsigned base = 10;
+  if (spelling.size() >= 2 && spelling[0] == '0' &&
+      (spelling[1] == 'x' || spelling[1] == 'X')) {
+    base = 16;
+    pos = 2;
+  } else if (!spelling.empty() && spelling[0] == '0') {
+    base = 8;
+  }
+
+  size_t digitsStart = pos;
+  uint64_t value = 0;
+  for (; pos < spelling.size(); ++pos) {
+    char c = spelling[pos];
+    unsigned digit;
+    if (c >= '0' && c <= '9') {
+      digit = c - '0';
+    } else if (base == 16 && (c | 32) >= 'a' && (c | 32) <= 'f') {
+      digit = (c | 32) - 'a' + 10;
+    } else {
+      break;
+    }
+    if (digit >= base) {
+      return std::nullopt;
+    }
+    if (value > (std::numeric_limits<uint64_t>::max() - digit) / base) {
+      return std::nullopt;
+    }
+    value = value * base + digit;
+  }
+  if (pos == digitsStart) {
+    return std::nullopt;
+  }
+
+  /// u, l, ll in either order and either case, but not lL
+  bool hasUnsigned = false;
+  unsigned numLongs = 0;
+  while (pos < spelling.size()) {
+    char c = spelling[pos];
+    if ((c == 'u' || c == 'U') && !hasUnsigned) {
+      hasUnsigned = true;
+      ++pos;
+    } else if ((c == 'l' || c == 'L') && numLongs == 0) {
+      numLongs = pos + 1 < spelling.size() && spelling[pos + 1] == c ? 2 : 1;
+      pos += numLongs;
+    } else {
+      return std::nullopt;
+    }
+  }
+
+  /// int, unsigned int, long, unsigned long, long long, unsigned long long,
+  /// where long long is no wider than long
+  for (unsigned width : {32u, 64u}) {
+    if (numLongs != 0 && width < 64) {
+      continue;
+    }
+    if (!hasUnsigned && value <= (uint64_t(1) << (width - 1)) - 1) {
+      return IntegerValue(value, width, false);
+    }
+    if ((hasUnsigned || base != 10) &&
+        (width == 64 || value <= (uint64_t(1) << width) - 1)) {
+      return IntegerValue(value, width, true);
+    }
+  }
+  return IntegerValue(value, 64, true);
+}
+} // namespace lcc
@@ -0,0 +1,68 @@
+/***********************************
+ * File:     SourceLocation.cc
+ *
+ * Author:   caipeng
+ *
+ * Email:    iiicp@outlook.com
+ *
+ * Date:     2023/6/18
+ *
+ * Sign:     enjoy life
+ ***********************************/
+
+#include "lcc/Basic/SourceLocation.h"
+#include <algorithm>
+
+namespace lcc {
+
+using namespace llvm;
+
+void SourceLocationTable::Update() const {
+  for (unsigned id = mBases.size(), e = mSrcMgr.getNumBuffers(); id <= e;
+       ++id) {
+    mBases.push_back(mBases.back() +
+                     mSrcMgr.getMemoryBuffer(id)->getBufferSize() + 1);
+  }
+}
+
+uint64_t SourceLocationTable::getFileBase(unsigned fileID) const {
+  if (!fileID || fileID > mSrcMgr.getNumBuffers()) {
+    return 0;
+  }
+  if (fileID >= mBases.size()) {
+    Update();
+  }
+  uint64_t base = mBases[fileID - 1];
+  if (base + mSrcMgr.getMemoryBuffer(fileID)->getBufferSize() > UINT32_MAX) {
+    return 0;
+  }
+  return base;
+}
+
+std::pair<unsigned, uint32_t>
+SourceLocationTable::getDecomposedLoc(SourceLocation loc) const {
+  if (!loc.isValid()) {
+    return {0, 0};
+  }
+  uint32_t raw = loc.getRawEncoding();
+  if (raw >= mBases.back()) {
+    Update();
+  }
+  /// the last buffer starting at or before the location
+  auto iter = std::upper_bound(mBases.begin(), mBases.end(), uint64_t(raw));
+  if (iter == mBases.begin() || iter == mBases.end()) {
+    return {0, 0};
+  }
+  unsigned index = iter - mBases.begin() - 1;
+  return {index + 1, uint32_t(raw - mBases[index])};
+}
+
+SMLoc SourceLocationTable::getSMLoc(SourceLocation loc) const {
+  auto [id, offset] = getDecomposedLoc(loc);
+  if (!id) {
+    return {};
+  }
+  return SMLoc::getFromPointer(
+      mSrcMgr.getMemoryBuffer(id)->getBufferStart() + offset);
+}
+} // namespace lcc
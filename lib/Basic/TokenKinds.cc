@@ -32,6 +32,9 @@ const char *tok::getPunctuatorSpelling(TokenKind Kind) {
   switch (Kind) {
 #define PUNCTUATOR(ID, SP) case ID: return SP;
 #include "lcc/Basic/TokenKinds.def"
+  case pp_hash: return "#";
+  case pp_hashhash: return "##";
+  case pp_backslash: return "\\";
   default: break;
   }
   return nullptr;
@@ -10,8 +10,11 @@
 
 #include "lcc/Lexer/Lexer.h"
 #include "lcc/Basic/Util.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
 #include <algorithm>
 #include <charconv> // std::from_chars
+#include <cstring>
 #include <limits>
 #include <set>
 
@@ -25,12 +28,24 @@ Lexer::Lexer(llvm::SourceMgr &mgr, DiagnosticEngine &diag,
 
   RegularSourceCode();
   auto memBuf = MemoryBuffer::getMemBuffer(mSourceCode, sourcePath);
-  Mgr.AddNewSourceBuffer(std::move(memBuf), SMLoc());
-  auto *m = Mgr.getMemoryBuffer(Mgr.getMainFileID());
-  P = m->getBufferStart();
+  mBufferID = Mgr.AddNewSourceBuffer(std::move(memBuf), SMLoc());
+  auto *m = Mgr.getMemoryBuffer(mBufferID);
+  P = Sp = m->getBufferStart();
   Ep = m->getBufferEnd();
 }
 
+Lexer::Lexer(llvm::SourceMgr &mgr, DiagnosticEngine &diag,
+             const llvm::MemoryBuffer &buffer)
+    : Mgr(mgr), Diag(diag) {
+  /// the buffer is shared with other translation units, register a view of
+  /// it instead of a copy
+  auto memBuf = MemoryBuffer::getMemBuffer(buffer.getMemBufferRef(),
+                                           /*RequiresNullTerminator=*/false);
+  mBufferID = Mgr.AddNewSourceBuffer(std::move(memBuf), SMLoc());
+  P = Sp = buffer.getBufferStart();
+  Ep = buffer.getBufferEnd();
+}
+
 /**
 整型
 10进制：123 123u 123l 123ul 123lu 123ull 123llu
@@ -132,6 +147,8 @@ Token::ValueType Lexer::ParseNumber(const Token &ppToken) {
         Diag,
         SMLoc::getFromPointer(ppToken.getOffset() + (suffixBegin - begin)),
         diag::err_lex_invalid_literal_suffix);
+    /// the value is that of the number without it
+    suffix = {};
   }
 
   if (!isFloat) {
@@ -440,22 +457,27 @@ tok::TokenKind Lexer::ParsePunctuation(const char *&offset, char curChar,
   }
   return type;
 }
-std::vector<Token> Lexer::tokenize() {
-
-  std::vector<Token> results;
-
-  /// Sp meaning start p
-  const char *Sp = P;
-  std::string strBuilder;
-  char includeDelimiter{' '};
+std::optional<Token> Lexer::Lex() {
+  std::optional<Token> result;
 
   auto InsertToken = [&](const char *sp, const char *p,
                          tok::TokenKind tokenKind, std::string value = {}) {
-        results.emplace_back(tokenKind, sp, p - sp, Mgr, std::move(value));
-    strBuilder.clear();
+    if (tokenKind == tok::pp_hash) {
+      mIncludeState = 1;
+    } else if (mIncludeState == 1 && tokenKind == tok::identifier &&
+               (value == "include" || value == "embed")) {
+      mIncludeState = 2;
+    } else {
+      mIncludeState = 0;
+    }
+    result.emplace(tokenKind, sp, p - sp, Mgr, std::move(value));
+    result->setLeadingSpace(mLeadingSpace);
+    result->setFileID(mBufferID);
+    mLeadingSpace = false;
+    mStrBuilder.clear();
   };
 
-  while (P < Ep) {
+  while (P < Ep && !result) {
     char curChar = (P < Ep ? P[0] : '\0');
     char nextChar = (P < Ep - 1) ? P[1] : '\0';
 
@@ -477,12 +499,9 @@ std::vector<Token> Lexer::tokenize() {
         break;
       }
       if (curChar == '"') {
-        if (results.size() >= 2 &&
-            results[results.size() - 2].getTokenKind() == tok::pp_hash &&
-            results[results.size() - 1].getTokenKind() == tok::identifier &&
-            results[results.size() - 1].getRepresentation() == "include") {
+        if (mIncludeState == 2) {
           state = State::AfterInclude;
-          includeDelimiter = '"';
+          mIncludeDelimiter = '"';
           Sp = P++;
         } else {
           state = State::StringLiteral;
@@ -490,16 +509,24 @@ std::vector<Token> Lexer::tokenize() {
         }
         break;
       }
+      /// line splicing
+      if (curChar == '\\' && nextChar == '\n') {
+        P += 2;
+        break;
+      }
       if (curChar == '\\') {
+        Sp = P;
         InsertToken(Sp, ++P, tok::pp_backslash);
         break;
       }
       /// \r\n meaning \n in windows
       if (curChar == '\r' && nextChar == '\n') {
+        Sp = P;
         InsertToken(Sp + 1, P += 2, tok::pp_newline);
         break;
       }
       if (curChar == '\n') {
+        Sp = P;
         InsertToken(Sp, ++P, tok::pp_newline);
         break;
       }
@@ -510,17 +537,15 @@ std::vector<Token> Lexer::tokenize() {
       }
       if (curChar == '/' && nextChar == '*') {
         state = State::BlockComment;
+        Sp = P;
         P += 2;
         break;
       }
       /// Line comments and block comments need to be processed first
       if (IsPunctuation(curChar)) {
-        if (curChar == '<' && results.size() >= 2 &&
-            results[results.size() - 2].getTokenKind() == tok::pp_hash &&
-            results[results.size() - 1].getTokenKind() == tok::identifier &&
-            results[results.size() - 1].getRepresentation() == "include") {
+        if (curChar == '<' && mIncludeState == 2) {
           state = State::AfterInclude;
-          includeDelimiter = '>';
+          mIncludeDelimiter = '>';
           Sp = P++;
         } else {
           state = State::Punctuator;
@@ -530,66 +555,67 @@ std::vector<Token> Lexer::tokenize() {
       }
       /// last process
       if (IsWhiteSpace(curChar)) {
+        mLeadingSpace = true;
         P++;
         break;
       }
-      DiagReport(Diag, SMLoc::getFromPointer(Sp), diag::err_lex_illegal_char);
+      DiagReport(Diag, SMLoc::getFromPointer(P), diag::err_lex_illegal_char);
       P++; /// skip this char
       break;
     }
     case State::CharacterLiteral: {
-      if (curChar == '\'' && strBuilder.empty()) {
+      if (curChar == '\'' && mStrBuilder.empty()) {
         state = State::Start;
-        InsertToken(Sp, P, tok::char_constant, strBuilder);
+        InsertToken(Sp, P, tok::char_constant, mStrBuilder);
         DiagReport(Diag, SMLoc::getFromPointer(Sp),
                    diag::err_lex_empty_char_literal);
-      } else if (curChar == '\'' && !strBuilder.ends_with('\\')) {
+      } else if (curChar == '\'' && !mStrBuilder.ends_with('\\')) {
         state = State::Start;
-        InsertToken(Sp, P, tok::char_constant, strBuilder);
+        InsertToken(Sp, P, tok::char_constant, mStrBuilder);
       } else {
-        strBuilder += curChar;
+        mStrBuilder += curChar;
       }
       P++;
       break;
     }
     case State::StringLiteral: {
       if (curChar == '"' &&
-          (strBuilder.empty() || !strBuilder.ends_with('\\'))) {
+          (mStrBuilder.empty() || !mStrBuilder.ends_with('\\'))) {
         state = State::Start;
-        InsertToken(Sp, P, tok::string_literal, strBuilder);
+        InsertToken(Sp, P, tok::string_literal, mStrBuilder);
       } else {
-        strBuilder += curChar;
+        mStrBuilder += curChar;
       }
       P++;
       break;
     }
     case State::Identifier: {
       if (IsLetter(curChar) || IsDigit(curChar)) {
-        strBuilder += curChar;
+        mStrBuilder += curChar;
         P++;
       } else {
         state = State::Start;
-        InsertToken(Sp, P, tok::identifier, strBuilder);
+        InsertToken(Sp, P, tok::identifier, mStrBuilder);
       }
       break;
     }
     case State::Number: {
       constexpr std::uint8_t toLower = 32;
-      if (strBuilder.empty()) {
-        strBuilder += curChar;
+      if (mStrBuilder.empty()) {
+        mStrBuilder += curChar;
         P++;
       } else {
         char lower_char = (curChar | toLower);
-        if (!IsJudgeNumber(strBuilder, lower_char) && (lower_char != 'e') &&
+        if (!IsJudgeNumber(mStrBuilder, lower_char) && (lower_char != 'e') &&
             (lower_char != 'p') && (lower_char != 'f') && (lower_char != 'u') &&
             (lower_char != 'l') && (lower_char != '.') &&
-            (((strBuilder.back() | toLower) != 'e' &&
-              (strBuilder.back() | toLower) != 'p') ||
+            (((mStrBuilder.back() | toLower) != 'e' &&
+              (mStrBuilder.back() | toLower) != 'p') ||
              (lower_char != '+' && lower_char != '-'))) {
-          InsertToken(Sp, P, tok::pp_number, strBuilder);
+          InsertToken(Sp, P, tok::pp_number, mStrBuilder);
           state = State::Start;
         } else {
-          strBuilder += curChar;
+          mStrBuilder += curChar;
           P++;
         }
         break;
@@ -607,6 +633,7 @@ std::vector<Token> Lexer::tokenize() {
     case State::LineComment: {
       if (curChar == '\n') {
         state = State::Start;
+        mLeadingSpace = true;
       } else {
         P++;
       }
@@ -615,6 +642,7 @@ std::vector<Token> Lexer::tokenize() {
     case State::BlockComment: {
       if (curChar == '*' && nextChar == '/') {
         state = State::Start;
+        mLeadingSpace = true;
         P += 2;
       } else {
         P++;
@@ -622,25 +650,36 @@ std::vector<Token> Lexer::tokenize() {
       break;
     }
     case State::AfterInclude: {
-      if (curChar != includeDelimiter && curChar != '\n') {
-        strBuilder += curChar;
+      if (curChar != mIncludeDelimiter && curChar != '\n') {
+        mStrBuilder += curChar;
         P++;
         break;
       }
       /// curChar is delimiter
       if (curChar != '\n') {
-        InsertToken(Sp, P++, tok::string_literal, strBuilder);
+        InsertToken(Sp, P++, tok::string_literal, mStrBuilder);
         state = State::Start;
         break;
       }
       DiagReport(Diag, SMLoc::getFromPointer(P),
                  diag::err_lex_illegal_newline_in_after_include);
+      mStrBuilder.clear();
+      state = State::Start;
+      break;
     }
     }
   }
-  results.shrink_to_fit();
 
-  if (state == State::CharacterLiteral) {
+  if (result || P < Ep) {
+    return result;
+  }
+
+  /// the end of buffer, flush the pending token
+  if (state == State::Identifier) {
+    InsertToken(Sp, P, tok::identifier, mStrBuilder);
+  } else if (state == State::Number) {
+    InsertToken(Sp, P, tok::pp_number, mStrBuilder);
+  } else if (state == State::CharacterLiteral) {
     DiagReport(Diag, SMLoc::getFromPointer(Sp), diag::err_lex_unclosed_char);
   } else if (state == State::StringLiteral) {
     DiagReport(Diag, SMLoc::getFromPointer(Sp), diag::err_lex_unclosed_string);
@@ -651,13 +690,156 @@ std::vector<Token> Lexer::tokenize() {
     DiagReport(Diag, SMLoc::getFromPointer(Sp),
                diag::err_lex_unclosed_after_include);
   }
+  state = State::Start;
+  return result;
+}
+
+bool Lexer::SkipToNextDirective(bool atLineStart) {
+  LCC_ASSERT(state == State::Start);
+  const char *p = P;
+  /// skip the line, or what is left of it. The only things which can hide a
+  /// newline are a block comment and a line splice, a quote only needs to be
+  /// matched so that a "/*" inside it isn't taken for a comment
+  auto skipLine = [&] {
+    while (p < Ep) {
+      const char *nl =
+          static_cast<const char *>(std::memchr(p, '\n', Ep - p));
+      const char *end = nl ? nl : Ep;
+      const char *special = p;
+      while (special < end && *special != '/' && *special != '"' &&
+             *special != '\'') {
+        ++special;
+      }
+      if (special == end) {
+        if (!nl) {
+          p = Ep;
+          return;
+        }
+        p = nl + 1;
+        /// a splice joins the next line to this one
+        if (nl > P && nl[-1] == '\\') {
+          continue;
+        }
+        return;
+      }
+      p = special + 1;
+      if (*special == '/') {
+        if (p < Ep && *p == '*') {
+          const char *close = p + 1;
+          while ((close = static_cast<const char *>(
+                      std::memchr(close, '*', Ep - close))) &&
+                 (close + 1 >= Ep || close[1] != '/')) {
+            ++close;
+          }
+          p = close ? close + 2 : Ep;
+        } else if (p < Ep && *p == '/') {
+          p = end;
+        }
+        continue;
+      }
+      /// string or char literal, ends at the newline when it isn't closed
+      char quote = *special;
+      while (p < end && *p != quote) {
+        /// a splice continues the literal on the next line
+        if (*p == '\\' && p + 1 == end && nl) {
+          p = nl + 1;
+          nl = static_cast<const char *>(std::memchr(p, '\n', Ep - p));
+          end = nl ? nl : Ep;
+          continue;
+        }
+        p += (*p == '\\' && p + 1 < end) ? 2 : 1;
+      }
+      if (p < end) {
+        ++p;
+      }
+    }
+  };
+
+  if (!atLineStart) {
+    skipLine();
+  }
+  while (p < Ep) {
+    /// whitespace and comments may come before the '#'
+    if (*p == ' ' || *p == '\t' || *p == '\f' || *p == '\v' || *p == '\r') {
+      ++p;
+      continue;
+    }
+    if (*p == '\n') {
+      ++p;
+      continue;
+    }
+    if (*p == '\\' && p + 1 < Ep && p[1] == '\n') {
+      p += 2;
+      continue;
+    }
+    if (*p == '/' && p + 1 < Ep && p[1] == '*') {
+      const char *close = p + 2;
+      while ((close = static_cast<const char *>(
+                  std::memchr(close, '*', Ep - close))) &&
+             (close + 1 >= Ep || close[1] != '/')) {
+        ++close;
+      }
+      p = close ? close + 2 : Ep;
+      continue;
+    }
+    if (*p == '#') {
+      break;
+    }
+    skipLine();
+  }
+  P = Sp = p;
+  mIncludeState = 0;
+  mLeadingSpace = false;
+  mStrBuilder.clear();
+  return P < Ep;
+}
 
+std::vector<Token> Lexer::tokenize() {
+  std::vector<Token> results;
+  while (auto token = Lex()) {
+    results.push_back(std::move(*token));
+  }
+  results.shrink_to_fit();
   return results;
 }
 
+tok::TokenKind Lexer::GetTokenKindOfSpelling(std::string_view spelling) {
+  if (spelling.empty()) {
+    return tok::unknown;
+  }
+  if (IsLetter(spelling[0])) {
+    bool isIdentifier = std::all_of(spelling.begin(), spelling.end(), [](char c) {
+      return IsLetter(c) || IsDigit(c);
+    });
+    return isIdentifier ? tok::identifier : tok::unknown;
+  }
+  if (IsDigit(spelling[0]) ||
+      (spelling[0] == '.' && spelling.size() > 1 && IsDigit(spelling[1]))) {
+    for (size_t i = 1; i < spelling.size(); ++i) {
+      char c = spelling[i];
+      char prev = spelling[i - 1] | 32;
+      if (IsLetter(c) || IsDigit(c) || c == '.' ||
+          ((c == '+' || c == '-') && (prev == 'e' || prev == 'p'))) {
+        continue;
+      }
+      return tok::unknown;
+    }
+    return tok::pp_number;
+  }
+  const char *p = spelling.data();
+  char nextChar = spelling.size() > 1 ? spelling[1] : '\0';
+  char nnChar = spelling.size() > 2 ? spelling[2] : '\0';
+  tok::TokenKind kind = ParsePunctuation(p, spelling[0], nextChar, nnChar);
+  if (p != spelling.data() + spelling.size()) {
+    return tok::unknown;
+  }
+  return kind;
+}
+
 std::vector<Token> Lexer::toCTokens(std::vector<Token> &&ppTokens) {
   std::vector<Token> results;
-  for (auto &iter : ppTokens) {
+  for (size_t i = 0; i < ppTokens.size(); ++i) {
+    auto &iter = ppTokens[i];
     switch (iter.getTokenKind()) {
     case tok::pp_hash:
     case tok::pp_hashhash:
@@ -667,6 +849,10 @@ std::vector<Token> Lexer::toCTokens(std::vector<Token> &&ppTokens) {
       break;
     case tok::pp_newline:
       break;
+    /// the bytes are passed on as they are
+    case tok::embed_data:
+      results.push_back(std::move(iter));
+      break;
     case tok::identifier: {
       iter.setTokenKind(tok::getKeywordTokenType(iter.getRepresentation()));
       results.push_back(iter);
@@ -679,23 +865,42 @@ std::vector<Token> Lexer::toCTokens(std::vector<Token> &&ppTokens) {
       results.push_back(iter);
       break;
     }
+    /// adjacent string literals are one, C11 5.1.1.2p6: the decoded size of
+    /// the run is measured first, then the pieces are decoded one after the
+    /// other into a buffer of that size
     case tok::string_literal: {
-      auto chars = ParseCharacters(iter, false);
-      std::string str(chars.begin(), chars.end());
-      iter.setTokenKind(tok::string_literal);
-      iter.setValue(str);
+      size_t size = 0, end = i;
+      for (size_t next = i; next < ppTokens.size(); ++next) {
+        auto kind = ppTokens[next].getTokenKind();
+        if (kind == tok::string_literal) {
+          size += DecodeCharacters(ppTokens[next], false, nullptr);
+          end = next;
+        } else if (kind != tok::pp_newline) {
+          break;
+        }
+      }
+      std::string str(size, '\0');
+      for (char *out = str.data(); i <= end; ++i) {
+        if (ppTokens[i].getTokenKind() == tok::string_literal) {
+          out += DecodeCharacters(ppTokens[i], false, out);
+        }
+      }
+      --i;
+      iter.setValue(std::move(str));
       results.push_back(iter);
       break;
     }
     case tok::char_constant: {
-      auto chars = ParseCharacters(iter, true);
+      llvm::SmallString<8> chars;
+      chars.resize(DecodeCharacters(iter, true, nullptr));
+      DecodeCharacters(iter, true, chars.data());
       iter.setTokenKind(tok::char_constant);
-      iter.setValue((int32_t)chars[0]);
+      iter.setValue((int32_t)(chars.empty() ? 0 : chars[0]));
       results.push_back(iter);
       break;
     }
     default:
-      iter.setValue(tok::getPunctuatorSpelling(iter.getTokenKind()));
+      iter.setValue(std::string(tok::getPunctuatorSpelling(iter.getTokenKind())));
       results.push_back(iter);
     }
   }
@@ -792,21 +997,30 @@ std::uint32_t Lexer::ParseEscapeChar(const char *p, char escape) {
   return 0;
 }
 
-std::vector<char> Lexer::ParseCharacters(const Token &ppToken,
-                                         bool handleCharMode) {
+/// the characters of the string or character literal `ppToken` with its
+/// escapes decoded into `out`, only their number when `out` is null. The
+/// diagnostics are reported by the pass which writes, a literal is measured
+/// first and then decoded without being reported twice
+size_t Lexer::DecodeCharacters(const Token &ppToken, bool handleCharMode,
+                               char *out) {
   const auto *sp = ppToken.getOffset();
+  bool report = out != nullptr;
 
   llvm::StringRef characters = ppToken.getRepresentation();
-  std::vector<char> result;
-  result.reserve(characters.size());
-  size_t offset = 0, resultStart = 0;
+  size_t offset = 0, size = 0;
+  auto put = [&](char ch) {
+    if (out) {
+      out[size] = ch;
+    }
+    ++size;
+  };
   while (offset < characters.size()) {
     char ch = characters[offset];
     if (ch == '\n') {
-      if (handleCharMode) {
+      if (report && handleCharMode) {
         DiagReport(Diag, SMLoc::getFromPointer(sp + offset),
                    diag::err_lex_implicit_newline_in_char);
-      } else {
+      } else if (report) {
         DiagReport(Diag, SMLoc::getFromPointer(sp + offset),
                    diag::err_lex_implicit_newline_in_string);
       }
@@ -814,14 +1028,11 @@ std::vector<char> Lexer::ParseCharacters(const Token &ppToken,
       continue;
     }
     if (ch != '\\') {
-      result.push_back(ch);
-      resultStart++;
+      put(ch);
       offset++;
-      if (handleCharMode) {
-        if (resultStart > 1) {
-          DiagReport(Diag, SMLoc::getFromPointer(sp + offset),
-                     diag::warn_lex_multi_character);
-        }
+      if (handleCharMode && report && size > 1) {
+        DiagReport(Diag, SMLoc::getFromPointer(sp + offset),
+                   diag::warn_lex_multi_character);
       }
       continue;
     }
@@ -832,70 +1043,46 @@ std::vector<char> Lexer::ParseCharacters(const Token &ppToken,
     if (characters[offset + 1] == 'x') {
       offset += 2;
       size_t lastHex = offset;
-      while (lastHex < characters.size()) {
-        if (IsHexDigit(characters[lastHex])) {
-          lastHex++;
-          continue;
-        }
-        break;
+      uint32_t value = 0;
+      while (lastHex < characters.size() && IsHexDigit(characters[lastHex])) {
+        value = value * 16 + llvm::hexDigitValue(characters[lastHex]);
+        lastHex++;
       }
       if (offset == lastHex) {
-        DiagReport(Diag, SMLoc::getFromPointer(sp + offset),
-                   diag::err_lex_at_least_one_hexadecimal_digit_required);
-        result.resize(1);
-        result[0] = 'x';
-        return result;
-      }
-      std::string_view sv(characters.data() + offset, lastHex - offset);
-      auto value = std::strtol(sv.data(), nullptr, 16);
-      result.push_back((char)value);
-      resultStart++;
+        if (report) {
+          DiagReport(Diag, SMLoc::getFromPointer(sp + offset),
+                     diag::err_lex_at_least_one_hexadecimal_digit_required);
+          out[0] = 'x';
+        }
+        return 1;
+      }
+      put((char)value);
       offset = lastHex;
-      break;
     }
     /// '\0' is octal char
     else if (IsDigit(characters[offset + 1])) {
       offset++;
       size_t start = offset;
-      /// first octal char
-      if (offset < characters.size() && IsOctDigit(characters[offset])) {
-        offset++;
-      } else {
-        goto end;
-      }
-      /// second octal char
-      if (offset < characters.size() && IsOctDigit(characters[offset])) {
-        offset++;
-      } else {
-        goto end;
-      }
-      /// third octal char
-      if (offset < characters.size() && IsOctDigit(characters[offset])) {
+      while (offset < characters.size() && offset - start < 3 &&
+             IsOctDigit(characters[offset])) {
         offset++;
-      } else {
-        goto end;
       }
-    end:
       if (offset == start) {
-        DiagReport(Diag, SMLoc::getFromPointer(sp + offset),
-                   diag::err_lex_at_least_one_oct_digit_required);
-        result.resize(1);
-        result[0] = '0';
-        return result;
-      }
-      auto value = OctalToNum(characters.substr(start, offset - start));
-      result.push_back((char)value);
-      resultStart++;
-      break;
+        if (report) {
+          DiagReport(Diag, SMLoc::getFromPointer(sp + offset),
+                     diag::err_lex_at_least_one_oct_digit_required);
+          out[0] = '0';
+        }
+        return 1;
+      }
+      put((char)OctalToNum(characters.substr(start, offset - start)));
     } else {
-      auto character = ParseEscapeChar(sp + offset, characters[offset + 1]);
-      result.push_back((char)character);
-      resultStart++;
+      put(report ? (char)ParseEscapeChar(sp + offset, characters[offset + 1])
+                 : 0);
       offset += 2;
     }
   }
-  result.resize(resultStart);
-  return result;
+  return size;
 }
 
 bool Lexer::IsJudgeNumber(const std::string &preCharacters, char curChar) {
@@ -0,0 +1,281 @@
+/***********************************
+ * File:     IncrementalParser.cc
+ *
+ * Author:   caipeng
+ *
+ * Email:    iiicp@outlook.com
+ *
+ * Date:     2023/6/18
+ *
+ * Sign:     enjoy life
+ ***********************************/
+
+#include "lcc/Parser/IncrementalParser.h"
+#include "lcc/Lexer/Lexer.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+
+namespace lcc {
+using namespace Syntax;
+
+IncrementalParser::IncrementalParser(DiagnosticEngine &diag, std::string text,
+                                     std::string name)
+    : Diag(diag), mText(MV_(text)), mName(MV_(name)) {
+  Reparse(0, 0);
+}
+
+bool IncrementalParser::Edit(size_t offset, size_t length,
+                             std::string_view text) {
+  if (offset > mText.size() || length > mText.size() - offset) {
+    return false;
+  }
+  size_t editEnd = offset + length;
+  /// the declarations the edit touches, one ending where it begins or
+  /// beginning where it ends as well
+  auto first = std::partition_point(
+      mEntries.begin(), mEntries.end(),
+      [offset](const Entry &entry) { return entry.End < offset; });
+  auto last = std::partition_point(
+      first, mEntries.end(),
+      [editEnd](const Entry &entry) { return entry.Begin <= editEnd; });
+  /// and the one after, which has the names of what fails before it
+  if (first == last && last != mEntries.end()) {
+    ++last;
+  }
+  while (first != mEntries.begin() && !first[-1].Clean) {
+    --first;
+  }
+  mText.replace(offset, length, text);
+  /// the declarations after the edit move with the text
+  for (auto iter = last; iter != mEntries.end(); ++iter) {
+    iter->Begin = iter->Begin - length + text.size();
+    iter->End = iter->End - length + text.size();
+    iter->Base = iter->Base - length + text.size();
+  }
+  Reparse(first - mEntries.begin(), last - mEntries.begin());
+  return true;
+}
+
+/// parses the declarations [first, last) again with the text around them,
+/// from the end of the one before to the beginning of the one after
+void IncrementalParser::Reparse(size_t first, size_t last) {
+  unsigned scopeSize = first < mEntries.size() ? mEntries[first].FirstBinding
+                                               : mFileScope.getNumBindings();
+  /// the first binding of each name among the prefix of the file scope and
+  /// `entries`, whether it is a typedef name after them
+  auto typedefNames = [&](auto begin, auto end) {
+    llvm::StringMap<bool> names;
+    for (auto iter = begin; iter != end; ++iter) {
+      for (auto [name, isTypedef] : iter->Names) {
+        auto prefix = mFileScope.isTypedefAt(name, scopeSize);
+        names.try_emplace(name, prefix.value_or(isTypedef));
+      }
+    }
+    return names;
+  };
+
+  std::vector<Entry> entries;
+  std::string messages;
+  unsigned numErrors;
+  for (;;) {
+    size_t begin = first ? mEntries[first - 1].End : 0;
+    size_t end = last < mEntries.size() ? mEntries[last].Begin : mText.size();
+    bool complete;
+    messages.clear();
+    entries = ParseRange(begin, end, first != 0, scopeSize, complete,
+                         messages, numErrors);
+    if (last == mEntries.size()) {
+      break;
+    }
+    if (!complete) {
+      /// twice the declarations on each try
+      last = std::min(mEntries.size(), last + std::max<size_t>(1, last - first));
+      continue;
+    }
+    /// a name which becomes or stops being a typedef name changes the parse
+    /// of the declarations after it, one the range doesn't declare is what
+    /// they declare it as
+    auto before = typedefNames(mEntries.begin() + first,
+                               mEntries.begin() + last);
+    auto after = typedefNames(entries.begin(), entries.end());
+    auto later = [&](std::string_view name) {
+      for (auto iter = mEntries.begin() + last; iter != mEntries.end();
+           ++iter) {
+        for (auto [other, isTypedef] : iter->Names) {
+          if (other == name) {
+            return isTypedef;
+          }
+        }
+      }
+      return false;
+    };
+    auto changed = [&later](const llvm::StringMap<bool> &names,
+                            const llvm::StringMap<bool> &other) {
+      return llvm::any_of(names, [&](const auto &name) {
+        auto iter = other.find(name.getKey());
+        return name.getValue() != (iter != other.end()
+                                       ? iter->getValue()
+                                       : later(name.getKey()));
+      });
+    };
+    if (changed(before, after) || changed(after, before)) {
+      last = mEntries.size();
+      continue;
+    }
+    break;
+  }
+  Diag.TakeReported(messages, numErrors);
+
+  /// the file scope only changes when the names the range declares do
+  bool sameNames = std::equal(
+      mEntries.begin() + first, mEntries.begin() + last, entries.begin(),
+      entries.end(), [](const Entry &entry, const Entry &other) {
+        return entry.Names == other.Names;
+      });
+  mEntries.erase(mEntries.begin() + first, mEntries.begin() + last);
+  mEntries.insert(mEntries.begin() + first,
+                  std::make_move_iterator(entries.begin()),
+                  std::make_move_iterator(entries.end()));
+  if (sameNames) {
+    /// a name is bound by its first declaration
+    unsigned binding = scopeSize;
+    for (size_t i = first; i < first + entries.size(); ++i) {
+      mEntries[i].FirstBinding = binding;
+      for (auto [name, isTypedef] : mEntries[i].Names) {
+        binding += !mFileScope.isTypedefAt(name, binding).has_value();
+      }
+    }
+    return;
+  }
+  mFileScope.truncate(scopeSize);
+  for (size_t i = first; i < mEntries.size(); ++i) {
+    mEntries[i].FirstBinding = mFileScope.getNumBindings();
+    for (auto [name, isTypedef] : mEntries[i].Names) {
+      if (isTypedef) {
+        mFileScope.addTypedef(name);
+      } else {
+        mFileScope.addToScope(name);
+      }
+    }
+  }
+}
+
+std::vector<IncrementalParser::Entry>
+IncrementalParser::ParseRange(size_t begin, size_t end, bool afterDecl,
+                              unsigned scopeSize, bool &complete,
+                              std::string &messages, unsigned &numErrors) {
+  auto chunk = std::make_shared<Chunk>();
+  llvm::SourceMgr &mgr = chunk->Mgr;
+  chunk->Buffer = mgr.getMemoryBuffer(mgr.AddNewSourceBuffer(
+      llvm::MemoryBuffer::getMemBufferCopy(
+          llvm::StringRef(mText).slice(begin, end), mName),
+      llvm::SMLoc()));
+  chunk->Context = std::make_unique<ASTContext>();
+  /// the messages of a try are kept until it is the last
+  llvm::raw_string_ostream os(messages);
+  DiagnosticEngine diag(mgr, os);
+
+  Lexer lexer(mgr, diag, *chunk->Buffer);
+  chunk->BufferID = lexer.getBufferID();
+  auto tokens = lexer.toCTokens(lexer.tokenize());
+  /// a range the parse of the whole text would see more of: one which
+  /// leaves a comment or a literal open, doesn't balance its braces, or
+  /// whose last declaration has an error or doesn't end
+  complete = !diag.numErrors();
+  int depth = 0;
+  for (const auto &token : tokens) {
+    if (token.getTokenKind() == tok::l_brace) {
+      ++depth;
+    } else if (token.getTokenKind() == tok::r_brace && --depth < 0) {
+      complete = false;
+    }
+  }
+  complete = complete && depth == 0;
+
+  /// the parser looks at the token at the end after an error, the range
+  /// ends where the text may go on. It has no location, as the end of the
+  /// input has none
+  tokens.emplace_back(tok::eof, nullptr, 0, mgr);
+
+  ASTContext::CurrentScope currentScope(*chunk->Context);
+  Parser parser(tokens, diag);
+  parser.mContext = chunk->Context.get();
+  parser.mTokEnd = tokens.cend() - 1;
+  parser.mScope.setFileScope(mFileScope, scopeSize);
+  std::vector<std::pair<std::string_view, bool>> declared;
+  parser.mScope.setFileScopeLog(&declared);
+  const char *start = chunk->Buffer->getBufferStart();
+  std::vector<Entry> entries;
+  bool clean = true;
+  size_t numDeclared = 0;
+  /// what follows a declaration is skipped up to the next one
+  if (afterDecl) {
+    parser.SkipTo(parser.FirstExternalDeclaration,
+                  diag::err_parse_skip_to_first_external_declaration);
+  }
+  while (parser.mTokCursor != parser.mTokEnd) {
+    if (parser.Peek(tok::semi)) {
+      parser.ConsumeAny();
+      clean = true;
+      continue;
+    }
+    TokIter firstTok = parser.mTokCursor;
+    unsigned numErrors = diag.numErrors();
+    auto result = parser.ParseExternalDeclaration();
+    /// after an error a declaration may be made of no tokens at all
+    bool empty = parser.mTokCursor == firstTok;
+    TokIter lastTok = empty ? firstTok : parser.mTokCursor - 1;
+    clean = result && !empty && diag.numErrors() == numErrors &&
+            (lastTok->getTokenKind() == tok::semi ||
+             lastTok->getTokenKind() == tok::r_brace);
+    if (result) {
+      size_t entryBegin = begin + (firstTok->getOffset() - start);
+      Entry entry{entryBegin,
+                  empty ? entryBegin
+                        : begin + (lastTok->getOffset() + lastTok->getLength() -
+                                   start),
+                  begin,
+                  chunk,
+                  chunk->Context->New<ExternalDeclaration>(MV_(*result)),
+                  {},
+                  0,
+                  clean};
+      entries.push_back(MV_(entry));
+    }
+    /// the names of a declaration which fails stay declared, they go with
+    /// the declaration before, which is reparsed with it, or when it is the
+    /// first with the one after
+    if (!entries.empty() && numDeclared != declared.size()) {
+      Entry &entry = entries.back();
+      for (; numDeclared < declared.size(); ++numDeclared) {
+        auto [name, isTypedef] = declared[numDeclared];
+        entry.Names.emplace_back(mNames.insert(name).first->getKey(),
+                                 isTypedef);
+      }
+      entry.Clean = entry.Clean && result;
+    }
+    /// the tokens skipped after it are not a declaration
+    if (parser.mTokCursor != parser.mTokEnd &&
+        !parser.FirstExternalDeclaration[parser.mTokCursor->getTokenKind()]) {
+      clean = false;
+    }
+    parser.SkipTo(parser.FirstExternalDeclaration,
+                  diag::err_parse_skip_to_first_external_declaration);
+  }
+  complete = complete && clean &&
+             numDeclared == declared.size();
+  os.flush();
+  numErrors = diag.numErrors();
+  return entries;
+}
+
+size_t IncrementalParser::getOffset(size_t index, SourceLocation loc) const {
+  const Entry &entry = mEntries[index];
+  auto [id, offset] = entry.Source->Locations.getDecomposedLoc(loc);
+  if (!id || id != entry.Source->BufferID) {
+    return std::string::npos;
+  }
+  return entry.Base + offset;
+}
+} // namespace lcc
@@ -11,7 +11,10 @@
 #include "lcc/Parser/Parser.h"
 #include "lcc/Basic/Match.h"
 #include "lcc/Basic/Util.h"
+#include "lcc/Serialization/PCH.h"
+#include "llvm/Support/ThreadPool.h"
 #include <algorithm>
+#include <cassert>
 #include <iostream>
 #include <set>
 
@@ -20,7 +23,7 @@ using namespace Syntax;
 
 Parser::Parser(const std::vector<Token> & tokens, DiagnosticEngine &diag)
     : mTokens(tokens), mTokCursor(mTokens.cbegin()),
-      mTokEnd(mTokens.cend()), Diag(diag) {
+      mTokEnd(mTokens.cend()), Diag(diag), mLocations(diag.getLocations()) {
 
   FirstDeclaration = FormTokenKinds(tok::kw_auto, tok::kw_extern, tok::kw_static,
      tok::kw_register, tok::kw_typedef, tok::kw_const, tok::kw_restrict,
@@ -41,11 +44,46 @@ Parser::Parser(const std::vector<Token> & tokens, DiagnosticEngine &diag)
 
   FirstStructDeclaration = FirstDeclaration | FormTokenKinds(tok::semi);
   FirstExternalDeclaration = FirstDeclaration | FormTokenKinds(tok::semi);
-}
+
+  AnnotatedFirstSpecQual = Annotate(FormTokenKinds(tok::kw_void, tok::kw_char,
+     tok::kw_short, tok::kw_int, tok::kw_long, tok::kw_float, tok::kw__Bool,
+     tok::kw_double, tok::kw_signed, tok::kw_unsigned, tok::kw_enum,
+     tok::kw_struct, tok::kw_union, tok::kw_const, tok::kw_restrict,
+     tok::kw_volatile, tok::kw_inline));
+  AnnotatedFirstSpecQual.set(TypedefName);
+  AnnotatedFirstDeclSpec = AnnotatedFirstSpecQual | Annotate(FormTokenKinds(
+     tok::kw_typedef, tok::kw_extern, tok::kw_static, tok::kw_auto,
+     tok::kw_register));
+  /// a typedef name is an identifier still
+  AnnotatedFirstExpr = Annotate(FirstExpression);
+  AnnotatedFirstExpr.set(TypedefName);
+  AnnotatedFirstStmt = Annotate(FirstStatement) | AnnotatedFirstExpr;
+  AnnotatedFirstBlockItem = AnnotatedFirstDeclSpec | AnnotatedFirstStmt;
+  mTypedefAnnotations.resize(mTokens.size());
+  mAnnotations = mTypedefAnnotations.data();
+}
+
+Parser::Parser(const Parser &parent, DiagnosticEngine &diag)
+    : mTokens(parent.mTokens), mTokCursor(parent.mTokEnd),
+      mTokEnd(parent.mTokEnd), Diag(diag), mLocations(parent.mLocations),
+      mHugePageArena(parent.mHugePageArena),
+      FirstDeclaration(parent.FirstDeclaration),
+      FirstExpression(parent.FirstExpression),
+      FirstStatement(parent.FirstStatement),
+      FirstStructDeclaration(parent.FirstStructDeclaration),
+      FirstExternalDeclaration(parent.FirstExternalDeclaration),
+      AnnotatedFirstDeclSpec(parent.AnnotatedFirstDeclSpec),
+      AnnotatedFirstSpecQual(parent.AnnotatedFirstSpecQual),
+      AnnotatedFirstExpr(parent.AnnotatedFirstExpr),
+      AnnotatedFirstStmt(parent.AnnotatedFirstStmt),
+      AnnotatedFirstBlockItem(parent.AnnotatedFirstBlockItem),
+      mAnnotations(parent.mAnnotations) {}
 
 TranslationUnit Parser::ParseTranslationUnit() {
-  std::vector<ExternalDeclaration> decls;
-  auto begin = mTokCursor;
+  auto context = std::make_unique<ASTContext>(mHugePageArena);
+  ASTContext::CurrentScope currentScope(*context);
+  mContext = context.get();
+  ASTVector<ExternalDeclaration> decls;
   while (mTokCursor != mTokEnd) {
     /// ; is a external declaration
     if (Peek(tok::semi)) {
@@ -55,141 +93,152 @@ TranslationUnit Parser::ParseTranslationUnit() {
     auto result = ParseExternalDeclaration();
     if (result) {
       decls.push_back(std::move(*result));
+      if (!mDelayedBodies.empty() &&
+          mDelayedBodies.back().DeclIndex == DelayedBody::NoDecl) {
+        mDelayedBodies.back().DeclIndex = decls.size() - 1;
+      }
     }
     SkipTo(FirstExternalDeclaration, diag::err_parse_skip_to_first_external_declaration);
   }
-  return TranslationUnit(begin, MV_(decls));
+  if (!mDelayedBodies.empty()) {
+    ParseDelayedBodies(decls);
+  }
+  mContext = nullptr;
+  return TranslationUnit(MV_(context), MV_(decls));
 }
 
 DeclSpec Parser::ParseDeclarationSpecifiers() {
   auto begin = mTokCursor;
-  DeclSpec decSpec(begin);
+  DeclSpec decSpec(Loc(begin));
   bool seeTy = false;
+  /// a specifier given twice is dropped by the bit sets, report it
+  auto storageClass = [&](DeclSpec::StorageClass storageClass) {
+    if (!decSpec.addStorageClass(storageClass)) {
+      DiagReport(Diag, DiagLoc(mTokCursor),
+                 diag::err_parse_duplicate_decl_specifier,
+                 mTokCursor->getRepresentation());
+    }
+    ConsumeAny();
+  };
+  auto primType = [&](TypeSpec::PrimTypeKind kind) {
+    seeTy = true;
+    if (!decSpec.addPrimType(kind)) {
+      DiagReport(Diag, DiagLoc(mTokCursor),
+                 diag::err_parse_duplicate_decl_specifier,
+                 mTokCursor->getRepresentation());
+    }
+    ConsumeAny();
+  };
+  auto typeSpec = [&](TokIter specBegin, TypeSpec &&specifier) {
+    if (!decSpec.addTypeSpec(MV_(specifier))) {
+      DiagReport(Diag, DiagLoc(specBegin),
+                 diag::err_parse_duplicate_decl_specifier,
+                 specBegin->getRepresentation());
+    }
+  };
 next_specifier:
-  switch (mTokCursor->getTokenKind()) {
+  switch (CurKind()) {
   case tok::kw_auto: {
-    decSpec.addStorageClassSpecifiers(
-        StorageClsSpec(mTokCursor, StorageClsSpec::Auto));
-    ConsumeAny();
+    storageClass(DeclSpec::Auto);
     break;
   }
   case tok::kw_register: {
-    decSpec.addStorageClassSpecifiers(
-        StorageClsSpec(mTokCursor, StorageClsSpec::Register));
-    ConsumeAny();
+    storageClass(DeclSpec::Register);
     break;
   }
   case tok::kw_static: {
-    decSpec.addStorageClassSpecifiers(
-        StorageClsSpec(mTokCursor, StorageClsSpec::Static));
-    ConsumeAny();
+    storageClass(DeclSpec::Static);
     break;
   }
   case tok::kw_extern: {
-    decSpec.addStorageClassSpecifiers(
-        StorageClsSpec(mTokCursor, StorageClsSpec::Extern));
-    ConsumeAny();
+    storageClass(DeclSpec::Extern);
     break;
   }
   case tok::kw_typedef: {
-    decSpec.addStorageClassSpecifiers(
-        StorageClsSpec(mTokCursor, StorageClsSpec::Typedef));
-    ConsumeAny();
+    storageClass(DeclSpec::Typedef);
     break;
   }
   case tok::kw_volatile: {
-    decSpec.addTypeQualifiers(
-        TypeQualifier(mTokCursor, TypeQualifier::Volatile));
+    decSpec.addQualifier(TypeQualifier::Volatile);
     ConsumeAny();
     break;
   }
   case tok::kw_const: {
-    decSpec.addTypeQualifiers(TypeQualifier(mTokCursor, TypeQualifier::Const));
+    decSpec.addQualifier(TypeQualifier::Const);
     ConsumeAny();
     break;
   }
   case tok::kw_restrict: {
-    decSpec.addTypeQualifiers(
-        TypeQualifier(mTokCursor, TypeQualifier::Restrict));
+    decSpec.addQualifier(TypeQualifier::Restrict);
     ConsumeAny();
     break;
   }
-  case tok::kw_void: {
-    seeTy = true;
-    decSpec.addTypeSpec(TypeSpec(mTokCursor, TypeSpec::Void));
+  case tok::kw_inline: {
+    decSpec.setInline();
     ConsumeAny();
     break;
   }
+  case tok::kw_void: {
+    primType(TypeSpec::Void);
+    break;
+  }
   case tok::kw_char: {
-    seeTy = true;
-    decSpec.addTypeSpec(TypeSpec(mTokCursor, TypeSpec::Char));
-    ConsumeAny();
+    primType(TypeSpec::Char);
     break;
   }
   case tok::kw_short: {
-    seeTy = true;
-    decSpec.addTypeSpec(TypeSpec(mTokCursor, TypeSpec::Short));
-    ConsumeAny();
+    primType(TypeSpec::Short);
     break;
   }
   case tok::kw_int: {
-    seeTy = true;
-    decSpec.addTypeSpec(TypeSpec(mTokCursor, TypeSpec::Int));
-    ConsumeAny();
+    primType(TypeSpec::Int);
     break;
   }
   case tok::kw_long: {
-    seeTy = true;
-    decSpec.addTypeSpec(TypeSpec(mTokCursor, TypeSpec::Long));
-    ConsumeAny();
+    primType(TypeSpec::Long);
     break;
   }
   case tok::kw_float: {
-    seeTy = true;
-    decSpec.addTypeSpec(TypeSpec(mTokCursor, TypeSpec::Float));
-    ConsumeAny();
+    primType(TypeSpec::Float);
     break;
   }
   case tok::kw_double: {
-    seeTy = true;
-    decSpec.addTypeSpec(TypeSpec(mTokCursor, TypeSpec::Double));
-    ConsumeAny();
+    primType(TypeSpec::Double);
     break;
   }
   case tok::kw_signed: {
-    seeTy = true;
-    decSpec.addTypeSpec(TypeSpec(mTokCursor, TypeSpec::Signed));
-    ConsumeAny();
+    primType(TypeSpec::Signed);
     break;
   }
   case tok::kw_unsigned: {
-    seeTy = true;
-    decSpec.addTypeSpec(TypeSpec(mTokCursor, TypeSpec::Unsigned));
-    ConsumeAny();
+    primType(TypeSpec::Unsigned);
     break;
   }
   case tok::kw_union:
   case tok::kw_struct: {
+    auto specBegin = mTokCursor;
     auto expected = ParseStructOrUnionSpecifier();
     if (expected) {
-      decSpec.addTypeSpec(TypeSpec(mTokCursor, MV_(*expected)));
+      typeSpec(specBegin, TypeSpec(Loc(mTokCursor), MV_(*expected)));
     }
     seeTy = true;
     break;
   }
   case tok::kw_enum: {
+    auto specBegin = mTokCursor;
     auto expected = ParseEnumSpecifier();
     if (expected) {
-      decSpec.addTypeSpec(TypeSpec(mTokCursor, MV_(*expected)));
+      typeSpec(specBegin, TypeSpec(Loc(mTokCursor), MV_(*expected)));
     }
     seeTy = true;
     break;
   }
   case tok::identifier: {
-    auto name = mTokCursor->getRepresentation();
-    if (!seeTy && mScope.isTypedefInScope(name)) {
+    if (!seeTy && GetAnnotatedKind() == TypedefName) {
+      auto specBegin = mTokCursor;
+      auto name = Spelling(mTokCursor);
       ConsumeAny();
-      decSpec.addTypeSpec(TypeSpec(mTokCursor, name));
+      typeSpec(specBegin, TypeSpec(Loc(mTokCursor), name));
       seeTy = true;
       break;
     }
@@ -203,16 +252,11 @@ next_specifier:
 
 std::optional<Declaration> Parser::ParseDeclarationSuffix(
     DeclSpec &&declSpec, std::optional<Declarator> &&alreadyParsedDeclarator) {
-  bool hasTypedef =
-      std::any_of(declSpec.getStorageClassSpecifiers().begin(),
-                  declSpec.getStorageClassSpecifiers().end(),
-                  [](const StorageClsSpec &storage) {
-                    return storage.getSpecifier() == StorageClsSpec::Typedef;
-                  });
-  std::vector<Declaration::InitDeclarator> initDeclarators;
+  bool hasTypedef = declSpec.hasStorageClass(DeclSpec::Typedef);
+  ASTVector<Declaration::InitDeclarator> initDeclarators;
   if (alreadyParsedDeclarator) {
     if (!hasTypedef) {
-      auto name = GetDeclaratorName(*alreadyParsedDeclarator);
+      auto name = alreadyParsedDeclarator->getName();
       mScope.addToScope(name);
     }
     if (!Peek(tok::equal)) {
@@ -247,16 +291,16 @@ std::optional<Declaration> Parser::ParseDeclarationSuffix(
     auto begin = mTokCursor;
     auto declarator = ParseDeclarator();
     if (!hasTypedef && declarator) {
-      auto name = GetDeclaratorName(*declarator);
+      auto name = declarator->getName();
       mScope.addToScope(name);
     }
     if (!Peek(tok::equal) && declarator) {
-      initDeclarators.push_back({begin, MV_(*declarator), std::nullopt});
+      initDeclarators.push_back({Loc(begin), MV_(*declarator), std::nullopt});
     } else {
       Expect(tok::equal);
       auto initializer = ParseInitializer();
       if (initializer && declarator) {
-        initDeclarators.push_back({begin, MV_(*declarator), MV_(*initializer)});
+        initDeclarators.push_back({Loc(begin), MV_(*declarator), MV_(*initializer)});
       }
     }
   }while (Peek(tok::comma));
@@ -265,7 +309,7 @@ End:
   Expect(tok::semi);
   if (hasTypedef) {
     for (auto& iter : initDeclarators) {
-      auto name = GetDeclaratorName(*iter.declarator_);
+      auto name = iter.declarator_->getName();
       mScope.addTypedef(name);
     }
   }
@@ -277,32 +321,27 @@ std::optional<ExternalDeclaration> Parser::ParseExternalDeclaration() {
   auto begin = mTokCursor;
   auto declSpecs = ParseDeclarationSpecifiers();
   if (declSpecs.isEmpty()) {
-    DiagReport(Diag, mTokCursor->getSMLoc(), diag::err_parse_expect_storage_class_or_type_specifier_or_qualifier);
+    DiagReport(Diag, DiagLoc(mTokCursor), diag::err_parse_expect_storage_class_or_type_specifier_or_qualifier);
   }
   if (Peek(tok::semi)) {
     ConsumeAny();
-    return Declaration(begin, MV_(declSpecs), {});
+    return Declaration(Loc(begin), MV_(declSpecs), {});
   }
   auto declarator = ParseDeclarator();
   const DirectDeclaratorParamTypeList *parameters = nullptr;
   if (!declarator) {
     goto end;
   }
-  parameters = GetFuncDeclarator(*declarator);
+  parameters = declarator->getFuncDeclarator();
   if (!parameters) {
     goto end;
   }
-  if (declSpecs.getStorageClassSpecifiers().size() > 0 &&
-      std::any_of(declSpecs.getStorageClassSpecifiers().begin(),
-                  declSpecs.getStorageClassSpecifiers().end(),
-                  [](const StorageClsSpec &specifier) {
-                    return specifier.getSpecifier() == StorageClsSpec::Typedef;
-                  })) {
+  if (declSpecs.hasStorageClass(DeclSpec::Typedef)) {
     goto end;
   }
 
   if (Peek(tok::semi) && PeekN(1, tok::l_brace)) {
-    DiagReport(Diag, mTokCursor->getSMLoc(),
+    DiagReport(Diag, DiagLoc(mTokCursor),
                diag::err_parse_accidently_add_semi);
     goto end;
   }
@@ -313,6 +352,7 @@ std::optional<ExternalDeclaration> Parser::ParseExternalDeclaration() {
     /// function define
     /// func param and block stmt share a scope
     mScope.pushScope();
+    llvm::SmallVector<std::string_view, 4> parameterNames;
     auto &parameterDeclarations = parameters->getParamTypeList()
                                       .getParameterList()
                                       .getParameterDeclarations();
@@ -323,32 +363,43 @@ std::optional<ExternalDeclaration> Parser::ParseExternalDeclaration() {
       auto &parameterDeclarator = iter.declaratorKind_;
       auto isOnlyOneTypeSpecifier =
           [&parameterDeclarations](const DeclSpec &declSpec) {
-            return declSpec.getStorageClassSpecifiers().size() == 0 &&
-                   declSpec.getTypeQualifiers().size() == 0 &&
-                   declSpec.getFunctionSpecifier().size() == 0 &&
-                   declSpec.getTypeSpecs().size() == 1 &&
+            return !declSpec.hasStorageClass() &&
+                   !declSpec.getQualifiers() && !declSpec.isInline() &&
+                   !declSpec.getTypeSpec() &&
                    (parameterDeclarations.size() == 1);
           };
-      if (isOnlyOneTypeSpecifier(declSpecifiers)) {
-        auto *primitive = std::get_if<TypeSpec::PrimTypeKind>(
-            &declSpecifiers.getTypeSpecs()[0].getVariant());
-        if (primitive && *primitive == TypeSpec::PrimTypeKind::Void) {
-          break;
-        }
+      if (isOnlyOneTypeSpecifier(declSpecifiers) &&
+          declSpecifiers.getPrimTypes() == TypeSpec::Void) {
+        break;
       }
       if (std::holds_alternative<std::optional<AbstractDeclarator>>(
               parameterDeclarator)) {
-        DiagReport(Diag, declSpecifiers.getBeginLoc()->getSMLoc(), diag::err_parse_func_param_declaration_miss_name);
+        DiagReport(Diag, declSpecifiers.getBeginLoc(), diag::err_parse_func_param_declaration_miss_name);
         continue;
       }
       auto &decl = std::get<Declarator>(parameterDeclarator);
-      mScope.addToScope(GetDeclaratorName(decl));
+      parameterNames.push_back(decl.getName());
+      mScope.addToScope(parameterNames.back());
+    }
+    if (mBodyThreads) {
+      /// without a matching } the body is parsed here, for the recovery
+      if (auto bodyEnd = FindBodyEnd()) {
+        TokIter bodyBegin = mTokCursor;
+        mDelayedBodies.push_back(DelayedBody{
+            DelayedBody::NoDecl, bodyBegin, *bodyEnd,
+            mScope.getFileScopeSize(), MV_(parameterNames)});
+        mTokCursor = *bodyEnd;
+        mScope.popScope();
+        mScope.addToScope(declarator->getName());
+        return FunctionDefinition(Loc(begin), MV_(declSpecs), MV_(*declarator),
+                                  BlockStmt(Loc(bodyBegin), {}));
+      }
     }
     auto compoundStmt = ParseBlockStmt();
     mScope.popScope();
-    mScope.addToScope(GetDeclaratorName(*declarator));
+    mScope.addToScope(declarator->getName());
     if (compoundStmt) {
-      return FunctionDefinition(begin, MV_(declSpecs), MV_(*declarator),
+      return FunctionDefinition(Loc(begin), MV_(declSpecs), MV_(*declarator),
                                 MV_(*compoundStmt));
     }
     return std::nullopt;
@@ -358,17 +409,150 @@ end:
   return ParseDeclarationSuffix(MV_(declSpecs), MV_(declarator));
 }
 
+std::optional<TokIter> Parser::FindBodyEnd() const {
+  unsigned depth = 0;
+  for (TokIter iter = mTokCursor; iter != mTokEnd; ++iter) {
+    if (iter->getTokenKind() == tok::l_brace) {
+      ++depth;
+    } else if (iter->getTokenKind() == tok::r_brace && --depth == 0) {
+      return iter + 1;
+    }
+  }
+  return std::nullopt;
+}
+
+namespace {
+/// the messages of a function body parsed on another thread, colored as the
+/// stream they are replayed to would color them
+class BufferedMessages : public llvm::raw_string_ostream {
+  bool mColors;
+
+public:
+  BufferedMessages(std::string &str, const llvm::raw_ostream &target)
+      : llvm::raw_string_ostream(str), mColors(target.has_colors()) {
+    enable_colors(target.colors_enabled());
+  }
+  bool has_colors() const override { return mColors; }
+};
+} // namespace
+
+void Parser::ParseDelayedBodies(ASTVector<ExternalDeclaration> &decls) {
+  /// runs of consecutive bodies of about the same number of tokens, a few
+  /// for each thread so that one done early can take another. A run has a
+  /// context of its own and keeps its messages, they are replayed in the
+  /// order of the bodies afterwards.
+  struct Run {
+    size_t Begin;
+    size_t End;
+    std::unique_ptr<ASTContext> Context;
+    std::string Messages;
+    unsigned NumErrors{0};
+    std::vector<std::optional<BlockStmt>> Bodies;
+  };
+  size_t numTokens = 0;
+  for (const auto &body : mDelayedBodies) {
+    numTokens += body.End - body.Begin;
+  }
+  size_t runTokens = numTokens / (mBodyThreads * 4) + 1;
+  std::vector<Run> runs;
+  for (size_t i = 0; i < mDelayedBodies.size();) {
+    size_t begin = i, tokens = 0;
+    while (i < mDelayedBodies.size() && tokens < runTokens) {
+      tokens += mDelayedBodies[i].End - mDelayedBodies[i].Begin;
+      ++i;
+    }
+    runs.push_back(Run{begin, i, nullptr, {}, 0, {}});
+  }
+
+  /// the source manager computes the line offsets of a buffer when it first
+  /// needs them, which is not safe to happen on two threads at once, nor is
+  /// taking new buffers into the location table
+  mLocations.Update();
+  llvm::SourceMgr &srcMgr = Diag.getSourceMgr();
+  for (unsigned id = 1; id <= srcMgr.getNumBuffers(); ++id) {
+    srcMgr.getLineAndColumn(
+        llvm::SMLoc::getFromPointer(
+            srcMgr.getMemoryBuffer(id)->getBufferStart()),
+        id);
+  }
+
+  {
+    llvm::ThreadPool pool(llvm::hardware_concurrency(mBodyThreads));
+    for (auto &run : runs) {
+      pool.async([this, &run] {
+        run.Context = std::make_unique<ASTContext>(mHugePageArena);
+        ASTContext::CurrentScope currentScope(*run.Context);
+        BufferedMessages messages(run.Messages, Diag.getOstream());
+        DiagnosticEngine diag(Diag.getSourceMgr(), messages);
+        Parser parser(*this, diag);
+        parser.mContext = run.Context.get();
+        for (size_t i = run.Begin; i < run.End; ++i) {
+          run.Bodies.push_back(
+              parser.ParseDelayedBody(*this, mDelayedBodies[i]));
+        }
+        messages.flush();
+        run.NumErrors = diag.numErrors();
+      });
+    }
+    pool.wait();
+  }
+
+  /// a definition whose body fails is dropped, as it is when parsed in place
+  std::vector<bool> failed(decls.size());
+  for (auto &run : runs) {
+    Diag.TakeReported(run.Messages, run.NumErrors);
+    for (size_t i = run.Begin; i < run.End; ++i) {
+      auto &body = run.Bodies[i - run.Begin];
+      size_t index = mDelayedBodies[i].DeclIndex;
+      if (body) {
+        std::get<FunctionDefinition>(decls[index])
+            .setCompoundStatement(MV_(*body));
+      } else {
+        failed[index] = true;
+      }
+    }
+    mContext->Adopt(MV_(run.Context));
+  }
+  size_t kept = 0;
+  for (size_t i = 0; i < decls.size(); ++i) {
+    if (!failed[i]) {
+      if (kept != i) {
+        decls[kept] = MV_(decls[i]);
+      }
+      ++kept;
+    }
+  }
+  while (decls.size() > kept) {
+    decls.pop_back();
+  }
+  mDelayedBodies.clear();
+}
+
+std::optional<BlockStmt> Parser::ParseDelayedBody(const Parser &parent,
+                                                  const DelayedBody &body) {
+  mTokCursor = body.Begin;
+  mTokEnd = body.End;
+  mScope.setFileScope(parent.mScope, body.FileScopeSize);
+  mScope.pushScope();
+  for (auto name : body.ParameterNames) {
+    mScope.addToScope(name);
+  }
+  auto compoundStmt = ParseBlockStmt();
+  mScope.popScope();
+  return compoundStmt;
+}
+
 /// declaration: declaration-specifiers init-declarator-list{opt} ;
 std::optional<Declaration> Parser::ParseDeclaration() {
   auto begin = mTokCursor;
   auto declSpecs = ParseDeclarationSpecifiers();
   if (declSpecs.isEmpty()) {
-    DiagReport(Diag, mTokCursor->getSMLoc(),
+    DiagReport(Diag, DiagLoc(mTokCursor),
                diag::err_parse_expect_storage_class_or_type_specifier_or_qualifier);
   }
   if (Peek(tok::semi)) {
     ConsumeAny();
-    return Declaration(begin, MV_(declSpecs), {});
+    return Declaration(Loc(begin), MV_(declSpecs), {});
   }
   return ParseDeclarationSuffix(MV_(declSpecs));
 }
@@ -382,20 +566,20 @@ std::optional<StructOrUnionSpec> Parser::ParseStructOrUnionSpecifier() {
   ConsumeAny();
   std::string_view tagName;
   auto start = mTokCursor;
-  switch (mTokCursor->getTokenKind()) {
+  switch (CurKind()) {
   case tok::identifier: {
-    tagName = mTokCursor->getRepresentation();
+    tagName = Spelling(mTokCursor);
     ConsumeAny();
     if (Peek(tok::l_brace)) {
       goto lbrace;
     }
-    return StructOrUnionSpec(begin, isUnion, tagName, {});
+    return StructOrUnionSpec(Loc(begin), isUnion, tagName, {});
   }
   case tok::l_brace: {
   lbrace:
     ConsumeAny();
     mScope.pushScope();
-    std::vector<StructOrUnionSpec::StructDeclaration> structDeclarations;
+    ASTVector<StructOrUnionSpec::StructDeclaration> structDeclarations;
     while (IsCurrentIn(FirstStructDeclaration)) {
       auto decl = ParseStructDeclaration();
       if (decl) {
@@ -406,10 +590,10 @@ std::optional<StructOrUnionSpec> Parser::ParseStructOrUnionSpecifier() {
     }
     mScope.popScope();
     Expect(tok::r_brace);
-    return StructOrUnionSpec(begin, isUnion, tagName, MV_(structDeclarations));
+    return StructOrUnionSpec(Loc(begin), isUnion, tagName, MV_(structDeclarations));
   }
   default:
-    DiagReport(Diag, start->getSMLoc(), diag::err_parse_expect_n, "identifier or { after struct/union");
+    DiagReport(Diag, DiagLoc(start), diag::err_parse_expect_n, "identifier or { after struct/union");
     return std::nullopt;
   }
 }
@@ -425,16 +609,15 @@ Parser::ParseStructDeclaration() {
   }
 
   auto specs = ParseDeclarationSpecifiers();
-  if (specs.getStorageClassSpecifiers().size() > 0) {
-    DiagReport(Diag, begin->getSMLoc(),
+  if (specs.hasStorageClass()) {
+    DiagReport(Diag, DiagLoc(begin),
                diag::err_parse_struct_declaration_appear_storage_class);
   }
-  if (specs.getTypeSpecs().size() == 0 &&
-      specs.getTypeQualifiers().size() == 0) {
-    DiagReport(Diag, begin->getSMLoc(),
+  if (!specs.hasTypeSpec() && !specs.getQualifiers()) {
+    DiagReport(Diag, DiagLoc(begin),
                diag::err_parse_expect_type_specifier_or_qualifier);
   }
-  std::vector<StructOrUnionSpec::StructDeclarator> declarators;
+  ASTVector<StructOrUnionSpec::StructDeclarator> declarators;
   bool first = true;
   do {
     if (first) {
@@ -448,7 +631,7 @@ Parser::ParseStructDeclaration() {
     }
   } while (Peek(tok::comma));
   Expect(tok::semi);
-  return StructOrUnionSpec::StructDeclaration{begin, MV_(specs),
+  return StructOrUnionSpec::StructDeclaration{Loc(begin), MV_(specs),
                                               MV_(declarators)};
 }
 
@@ -459,14 +642,17 @@ Parser::ParseStructDeclarator() {
   auto declarator = ParseDeclarator();
   SetCheckTypedefType(true);
   if (declarator)
-    mScope.addToScope(GetDeclaratorName(*declarator));
+    mScope.addToScope(declarator->getName());
   if (Peek(tok::colon) && declarator) {
     ConsumeAny();
-    auto constant = ParseConditionalExpr();
-    return StructOrUnionSpec::StructDeclarator{begin, MV_(*declarator),
-                                               MV_(*constant)};
-  } else if (declarator){
-    return StructOrUnionSpec::StructDeclarator{begin, MV_(*declarator),
+    /// a missing width was reported, the field is kept without one
+    if (auto constant = ParseConditionalExpr()) {
+      return StructOrUnionSpec::StructDeclarator{
+          Loc(begin), MV_(*declarator), MV_(*constant)};
+    }
+  }
+  if (declarator) {
+    return StructOrUnionSpec::StructDeclarator{Loc(begin), MV_(*declarator),
                                                std::nullopt};
   }else {
     return std::nullopt;
@@ -475,7 +661,7 @@ Parser::ParseStructDeclarator() {
 
 /// declarator: pointer{opt} direct-declarator
 std::optional<Declarator> Parser::ParseDeclarator() {
-  std::vector<Pointer> pointers;
+  ASTVector<Pointer> pointers;
   auto begin = mTokCursor;
   while (Peek(tok::star)) {
     pointers.push_back(ParsePointer());
@@ -484,7 +670,7 @@ std::optional<Declarator> Parser::ParseDeclarator() {
   if (!directDeclarator) {
     return std::nullopt;
   }
-  return Declarator(begin, MV_(pointers), MV_(*directDeclarator));
+  return Declarator(Loc(begin), MV_(pointers), MV_(*directDeclarator));
 }
 
 /**
@@ -500,7 +686,7 @@ direct-declarator:
  */
 void Parser::ParseDirectDeclaratorSuffix(TokIter beginTokLoc, DirectDeclarator &directDeclarator) {
   while (Peek(tok::l_paren) || Peek(tok::l_square)) {
-    switch (mTokCursor->getTokenKind()) {
+    switch (CurKind()) {
     case tok::l_paren: {
       ConsumeAny();
       if (IsFirstInDeclarationSpecifier()) {
@@ -509,12 +695,12 @@ void Parser::ParseDirectDeclaratorSuffix(TokIter beginTokLoc, DirectDeclarator &
         SetCheckTypedefType(true);
         if (parameterTypeList) {
           directDeclarator = DirectDeclaratorParamTypeList(
-              beginTokLoc, MV_(directDeclarator), MV_(*parameterTypeList));
+              Loc(beginTokLoc), MV_(directDeclarator), MV_(*parameterTypeList));
         }
       }else {
         directDeclarator = DirectDeclaratorParamTypeList(
-            beginTokLoc, MV_(directDeclarator),
-            ParamTypeList(beginTokLoc, ParamList(beginTokLoc, {}), false));
+            Loc(beginTokLoc), MV_(directDeclarator),
+            ParamTypeList(Loc(beginTokLoc), ParamList(Loc(beginTokLoc), {}), false));
       }
       Expect(tok::r_paren);
       break;
@@ -523,23 +709,23 @@ void Parser::ParseDirectDeclaratorSuffix(TokIter beginTokLoc, DirectDeclarator &
       ConsumeAny();
       if (Peek(tok::kw_static)) {
         ConsumeAny();
-        std::vector<TypeQualifier> typeQualifiers;
+        ASTVector<TypeQualifier> typeQualifiers;
         while (Peek(tok::kw_const) || Peek(tok::kw_volatile)
                || Peek(tok::kw_restrict)) {
-          switch (mTokCursor->getTokenKind()) {
+          switch (CurKind()) {
           case tok::kw_const: {
             typeQualifiers.push_back(
-                TypeQualifier(mTokCursor, TypeQualifier::Const));
+                TypeQualifier(Loc(mTokCursor), TypeQualifier::Const));
             break;
           }
           case tok::kw_volatile: {
             typeQualifiers.push_back(
-                TypeQualifier(mTokCursor, TypeQualifier::Volatile));
+                TypeQualifier(Loc(mTokCursor), TypeQualifier::Volatile));
             break;
           }
           case tok::kw_restrict: {
             typeQualifiers.push_back(
-                TypeQualifier(mTokCursor, TypeQualifier::Restrict));
+                TypeQualifier(Loc(mTokCursor), TypeQualifier::Restrict));
             break;
           }
           default:
@@ -550,30 +736,30 @@ void Parser::ParseDirectDeclaratorSuffix(TokIter beginTokLoc, DirectDeclarator &
         auto assignment = ParseAssignExpr();
         if (assignment) {
           directDeclarator = DirectDeclaratorAssignExpr(
-              beginTokLoc, MV_(directDeclarator), MV_(typeQualifiers),
+              Loc(beginTokLoc), MV_(directDeclarator), MV_(typeQualifiers),
               MV_(*assignment), true);
         }
         Expect(tok::r_square);
         break;
       }
 
-      std::vector<TypeQualifier> typeQualifiers;
+      ASTVector<TypeQualifier> typeQualifiers;
       while (Peek(tok::kw_const) || Peek(tok::kw_volatile)
              || Peek(tok::kw_restrict)) {
-        switch (mTokCursor->getTokenKind()) {
+        switch (CurKind()) {
         case tok::kw_const: {
           typeQualifiers.push_back(
-              TypeQualifier(mTokCursor, TypeQualifier::Const));
+              TypeQualifier(Loc(mTokCursor), TypeQualifier::Const));
           break;
         }
         case tok::kw_volatile: {
           typeQualifiers.push_back(
-              TypeQualifier(mTokCursor, TypeQualifier::Volatile));
+              TypeQualifier(Loc(mTokCursor), TypeQualifier::Volatile));
           break;
         }
         case tok::kw_restrict: {
           typeQualifiers.push_back(
-              TypeQualifier(mTokCursor, TypeQualifier::Restrict));
+              TypeQualifier(Loc(mTokCursor), TypeQualifier::Restrict));
           break;
         }
         default:
@@ -586,26 +772,26 @@ void Parser::ParseDirectDeclaratorSuffix(TokIter beginTokLoc, DirectDeclarator &
         auto assignment = ParseAssignExpr();
         if (assignment) {
           directDeclarator = DirectDeclaratorAssignExpr(
-              beginTokLoc, MV_(directDeclarator), MV_(typeQualifiers),
+              Loc(beginTokLoc), MV_(directDeclarator), MV_(typeQualifiers),
               MV_(*assignment), true);
         }
         Expect(tok::r_square);
       }else if (Peek(tok::star)) {
         ConsumeAny();
         directDeclarator = DirectDeclaratorAsterisk(
-            beginTokLoc, MV_(directDeclarator), MV_(typeQualifiers));
+            Loc(beginTokLoc), MV_(directDeclarator), MV_(typeQualifiers));
         Expect(tok::r_square);
       }else if (IsFirstInAssignmentExpr()) {
         auto assignment = ParseAssignExpr();
         if (assignment) {
           directDeclarator = DirectDeclaratorAssignExpr(
-              beginTokLoc, MV_(directDeclarator), MV_(typeQualifiers),
+              Loc(beginTokLoc), MV_(directDeclarator), MV_(typeQualifiers),
               MV_(*assignment), false);
         }
         Expect(tok::r_square);
       }else {
         directDeclarator = DirectDeclaratorAssignExpr(
-            beginTokLoc, MV_(directDeclarator), MV_(typeQualifiers),
+            Loc(beginTokLoc), MV_(directDeclarator), MV_(typeQualifiers),
             std::nullopt, false);
         Expect(tok::r_square);
       }
@@ -632,23 +818,23 @@ std::optional<DirectDeclarator> Parser::ParseDirectDeclarator() {
   std::optional<DirectDeclarator> directDeclarator{std::nullopt};
   auto begin = mTokCursor;
   if (Peek(tok::identifier)) {
-    auto name = mTokCursor->getRepresentation();
+    auto name = Spelling(mTokCursor);
     if (IsCheckTypedefType()) {
       if (mScope.checkIsTypedefInCurrentScope(name)) {
-        DiagReport(Diag, begin->getSMLoc(), diag::err_parse_expect_n, "identifier, but get a typedef type");
+        DiagReport(Diag, DiagLoc(begin), diag::err_parse_expect_n, "identifier, but get a typedef type");
       }
     }
     ConsumeAny();
-    directDeclarator = DirectDeclaratorIdent(begin, name);
+    directDeclarator = DirectDeclaratorIdent(Loc(begin), name);
   }else if (Peek(tok::l_paren)) {
     ConsumeAny();
     auto declarator = ParseDeclarator();
     if (declarator) {
-      directDeclarator = DirectDeclaratorParentheses(begin, MV_(*declarator));
+      directDeclarator = DirectDeclaratorParentheses(Loc(begin), MV_(*declarator));
     }
     Expect(tok::r_paren);
   }else {
-    DiagReport(Diag, begin->getSMLoc(), diag::err_parse_expect_n, "identifier or (");
+    DiagReport(Diag, DiagLoc(begin), diag::err_parse_expect_n, "identifier or (");
     return std::nullopt;
   }
 
@@ -671,7 +857,7 @@ std::optional<ParamTypeList> Parser::ParseParameterTypeList() {
     hasEllipse = true;
   }
   if (parameterList) {
-    return ParamTypeList(begin, MV_(*parameterList), hasEllipse);
+    return ParamTypeList(Loc(begin), MV_(*parameterList), hasEllipse);
   }
   return std::nullopt;
 }
@@ -682,7 +868,7 @@ parameter-list:
     parameter-list , parameter-declaration
  */
 std::optional<ParamList> Parser::ParseParameterList() {
-  std::vector<ParameterDeclaration> paramDecls;
+  ASTVector<ParameterDeclaration> paramDecls;
   auto begin = mTokCursor;
   auto declaration = ParseParameterDeclaration();
   if (declaration) {
@@ -696,7 +882,7 @@ std::optional<ParamList> Parser::ParseParameterList() {
       paramDecls.push_back(MV_(*decl));
     }
   }
-  return ParamList(begin, MV_(paramDecls));
+  return ParamList(Loc(begin), MV_(paramDecls));
 }
 std::optional<ParameterDeclaration>
 Parser::ParseParameterDeclarationSuffix(DeclSpec &declSpec) {
@@ -723,7 +909,7 @@ Parser::ParseParameterDeclarationSuffix(DeclSpec &declSpec) {
     }else {
       while (Peek(tok::l_paren)) {
         ConsumeAny();
-        switch (mTokCursor->getTokenKind()) {
+        switch (CurKind()) {
         case tok::identifier:
           return true;
         case tok::l_square:
@@ -739,12 +925,12 @@ Parser::ParseParameterDeclarationSuffix(DeclSpec &declSpec) {
   if (peekIsDeclarator()) {
     auto dec = ParseDeclarator();
     if (dec) {
-      return ParameterDeclaration(begin, MV_(declSpec), MV_(*dec));
+      return ParameterDeclaration(Loc(begin), MV_(declSpec), MV_(*dec));
     }
   }else {
     auto absDec = ParseAbstractDeclarator();
     if (absDec) {
-      return ParameterDeclaration(begin, MV_(declSpec), MV_(*absDec));
+      return ParameterDeclaration(Loc(begin), MV_(declSpec), MV_(*absDec));
     }
   }
   return std::nullopt;
@@ -765,11 +951,11 @@ std::optional<ParameterDeclaration> Parser::ParseParameterDeclaration() {
   auto begin = mTokCursor;
   auto specs = ParseDeclarationSpecifiers();
   if (specs.isEmpty()) {
-    DiagReport(Diag, begin->getSMLoc(), diag::err_parse_expect_storage_class_or_type_specifier_or_qualifier);
+    DiagReport(Diag, DiagLoc(begin), diag::err_parse_expect_storage_class_or_type_specifier_or_qualifier);
   }
   /// abstract-declarator{opt}
   if (Peek(tok::comma) || Peek(tok::r_paren)) {
-    return ParameterDeclaration(begin, MV_(specs), std::nullopt);
+    return ParameterDeclaration(Loc(begin), MV_(specs), std::nullopt);
   }
 
   return ParseParameterDeclarationSuffix(specs);
@@ -783,27 +969,27 @@ std::optional<ParameterDeclaration> Parser::ParseParameterDeclaration() {
 Pointer Parser::ParsePointer() {
   auto begin = mTokCursor;
   Expect(tok::star);
-  std::vector<TypeQualifier> typeQualifier;
+  ASTVector<TypeQualifier> typeQualifier;
   while (Peek(tok::kw_const) || Peek(tok::kw_restrict) ||
          Peek(tok::kw_volatile)) {
-    switch (mTokCursor->getTokenKind()) {
+    switch (CurKind()) {
     case tok::kw_const:
-      typeQualifier.push_back(TypeQualifier(mTokCursor, TypeQualifier::Const));
+      typeQualifier.push_back(TypeQualifier(Loc(mTokCursor), TypeQualifier::Const));
       break;
     case tok::kw_restrict:
       typeQualifier.push_back(
-          TypeQualifier(mTokCursor, TypeQualifier::Restrict));
+          TypeQualifier(Loc(mTokCursor), TypeQualifier::Restrict));
       break;
     case tok::kw_volatile:
       typeQualifier.push_back(
-          TypeQualifier(mTokCursor, TypeQualifier::Volatile));
+          TypeQualifier(Loc(mTokCursor), TypeQualifier::Volatile));
       break;
     default:
       break;
     }
     ConsumeAny();
   }
-  return Pointer(begin, MV_(typeQualifier));
+  return Pointer(Loc(begin), MV_(typeQualifier));
 }
 
 /**
@@ -812,16 +998,16 @@ Pointer Parser::ParsePointer() {
    pointer{opt} direct-abstract-declarator
  */
 std::optional<AbstractDeclarator> Parser::ParseAbstractDeclarator() {
-  std::vector<Pointer> pointers;
+  ASTVector<Pointer> pointers;
   auto begin = mTokCursor;
   while (Peek(tok::star)) {
     auto result = ParsePointer();
     pointers.push_back(std::move(result));
   }
   if (!pointers.empty() && !IsFirstInDirectAbstractDeclarator()) {
-    return AbstractDeclarator(begin, MV_(pointers));
+    return AbstractDeclarator(Loc(begin), MV_(pointers));
   }
-  return AbstractDeclarator(begin, MV_(pointers), ParseDirectAbstractDec());
+  return AbstractDeclarator(Loc(begin), MV_(pointers), ParseDirectAbstractDec());
 }
 
 /**
@@ -838,7 +1024,7 @@ Parser::ParseDirectAbstractDeclaratorSuffix() {
   std::optional<DirectAbstractDeclarator> directAbstractDec{std::nullopt};
   auto begin = mTokCursor;
   while (Peek(tok::l_paren) || Peek(tok::l_square)) {
-    switch (mTokCursor->getTokenKind()) {
+    switch (CurKind()) {
     case tok::l_paren: {
       ConsumeAny();
       /// direct-abstract-declarator{opt} ( parameter-type-list{opt} )
@@ -846,7 +1032,7 @@ Parser::ParseDirectAbstractDeclaratorSuffix() {
         auto parameterTypeList = ParseParameterTypeList();
         if (parameterTypeList) {
           directAbstractDec = DirectAbstractDeclaratorParamTypeList(
-              begin, MV_(directAbstractDec), MV_(*parameterTypeList));
+              Loc(begin), MV_(directAbstractDec), MV_(*parameterTypeList));
         }
       }
       /// abstract-declarator first set
@@ -855,12 +1041,12 @@ Parser::ParseDirectAbstractDeclaratorSuffix() {
         auto abstractDeclarator = ParseAbstractDeclarator();
         if (abstractDeclarator) {
           directAbstractDec = DirectAbstractDeclaratorParentheses(
-              begin, MV_(*abstractDeclarator));
+              Loc(begin), MV_(*abstractDeclarator));
         }
       } else {
         /// direct-abstract-declarator{opt} (  )
         directAbstractDec = DirectAbstractDeclaratorParamTypeList(
-            begin, MV_(directAbstractDec), std::nullopt);
+            Loc(begin), MV_(directAbstractDec), std::nullopt);
       }
       Expect(tok::r_paren);
       break;
@@ -871,7 +1057,7 @@ Parser::ParseDirectAbstractDeclaratorSuffix() {
       if (Peek(tok::star)) {
         ConsumeAny();
         directAbstractDec =
-            DirectAbstractDeclaratorAsterisk(begin, MV_(directAbstractDec));
+            DirectAbstractDeclaratorAsterisk(Loc(begin), MV_(directAbstractDec));
         Expect(tok::r_square);
         break;
       }
@@ -879,23 +1065,23 @@ Parser::ParseDirectAbstractDeclaratorSuffix() {
       /// direct-abstract-declarator{opt} [ static type-qualifier-list{opt} assignment-expression ]
       if (Peek(tok::kw_static)) {
         ConsumeAny();
-        std::vector<TypeQualifier> typeQualifiers;
+        ASTVector<TypeQualifier> typeQualifiers;
         while (Peek(tok::kw_const) || Peek(tok::kw_volatile) ||
                Peek(tok::kw_restrict)) {
-          switch (mTokCursor->getTokenKind()) {
+          switch (CurKind()) {
           case tok::kw_const: {
             typeQualifiers.push_back(
-                TypeQualifier(mTokCursor, TypeQualifier::Const));
+                TypeQualifier(Loc(mTokCursor), TypeQualifier::Const));
             break;
           }
           case tok::kw_volatile: {
             typeQualifiers.push_back(
-                TypeQualifier(mTokCursor, TypeQualifier::Volatile));
+                TypeQualifier(Loc(mTokCursor), TypeQualifier::Volatile));
             break;
           }
           case tok::kw_restrict: {
             typeQualifiers.push_back(
-                TypeQualifier(mTokCursor, TypeQualifier::Restrict));
+                TypeQualifier(Loc(mTokCursor), TypeQualifier::Restrict));
             break;
           }
           default:
@@ -906,30 +1092,30 @@ Parser::ParseDirectAbstractDeclaratorSuffix() {
         auto assignExpr = ParseAssignExpr();
         if (assignExpr) {
           directAbstractDec = DirectAbstractDeclaratorAssignExpr(
-              begin, MV_(directAbstractDec), MV_(typeQualifiers),
+              Loc(begin), MV_(directAbstractDec), MV_(typeQualifiers),
               MV_(*assignExpr), true);
         }
         Expect(tok::r_square);
         break;
       }
 
-      std::vector<TypeQualifier> typeQualifiers;
+      ASTVector<TypeQualifier> typeQualifiers;
       while (Peek(tok::kw_const) || Peek(tok::kw_volatile) ||
              Peek(tok::kw_restrict)) {
-        switch (mTokCursor->getTokenKind()) {
+        switch (CurKind()) {
         case tok::kw_const: {
           typeQualifiers.push_back(
-              TypeQualifier(mTokCursor, TypeQualifier::Const));
+              TypeQualifier(Loc(mTokCursor), TypeQualifier::Const));
           break;
         }
         case tok::kw_volatile: {
           typeQualifiers.push_back(
-              TypeQualifier(mTokCursor, TypeQualifier::Volatile));
+              TypeQualifier(Loc(mTokCursor), TypeQualifier::Volatile));
           break;
         }
         case tok::kw_restrict: {
           typeQualifiers.push_back(
-              TypeQualifier(mTokCursor, TypeQualifier::Restrict));
+              TypeQualifier(Loc(mTokCursor), TypeQualifier::Restrict));
           break;
         }
         default:
@@ -942,7 +1128,7 @@ Parser::ParseDirectAbstractDeclaratorSuffix() {
         auto assignExpr = ParseAssignExpr();
         if (assignExpr) {
           directAbstractDec = DirectAbstractDeclaratorAssignExpr(
-              begin, MV_(directAbstractDec), MV_(typeQualifiers),
+              Loc(begin), MV_(directAbstractDec), MV_(typeQualifiers),
               MV_(*assignExpr), true);
         }
         Expect(tok::r_square);
@@ -951,12 +1137,12 @@ Parser::ParseDirectAbstractDeclaratorSuffix() {
           auto assignment = ParseAssignExpr();
           if (assignment) {
             directAbstractDec = DirectAbstractDeclaratorAssignExpr(
-                begin, MV_(directAbstractDec), MV_(typeQualifiers),
+                Loc(begin), MV_(directAbstractDec), MV_(typeQualifiers),
                 MV_(*assignment), false);
           }
         } else {
           directAbstractDec = DirectAbstractDeclaratorAssignExpr(
-              begin, MV_(directAbstractDec), MV_(typeQualifiers), std::nullopt,
+              Loc(begin), MV_(directAbstractDec), MV_(typeQualifiers), std::nullopt,
               false);
         }
         Expect(tok::r_square);
@@ -1008,10 +1194,10 @@ std::optional<DirectAbstractDeclarator> Parser::ParseDirectAbstractDec() {
 std::optional<EnumSpecifier> Parser::ParseEnumSpecifier() {
   auto begin = mTokCursor;
   Expect(tok::kw_enum);
-  std::vector<EnumSpecifier::Enumerator> enumerators;
+  ASTVector<EnumSpecifier::Enumerator> enumerators;
   std::string_view tagName;
   if (Peek(tok::identifier)) {
-    tagName = mTokCursor->getRepresentation();
+    tagName = Spelling(mTokCursor);
     ConsumeAny();
     if (Peek(tok::l_brace)) {
       goto enumerator_list;
@@ -1020,7 +1206,7 @@ std::optional<EnumSpecifier> Parser::ParseEnumSpecifier() {
   enumerator_list:
     ConsumeAny();
     if (Peek(tok::r_brace)) {
-      DiagReport(Diag, mTokCursor->getSMLoc(), diag::err_parse_expect_n, "identifier before '}' token");
+      DiagReport(Diag, DiagLoc(mTokCursor), diag::err_parse_expect_n, "identifier before '}' token");
     }
     enumerators.push_back(*ParseEnumerator());
     while (Peek(tok::comma)) {
@@ -1031,16 +1217,16 @@ std::optional<EnumSpecifier> Parser::ParseEnumSpecifier() {
     }
     Expect(tok::r_brace);
   }else {
-    DiagReport(Diag, mTokCursor->getSMLoc(), diag::err_parse_expect_n, "identifier or { after enum");
+    DiagReport(Diag, DiagLoc(mTokCursor), diag::err_parse_expect_n, "identifier or { after enum");
   }
-  return EnumSpecifier(begin, tagName, MV_(enumerators));
+  return EnumSpecifier(Loc(begin), tagName, MV_(enumerators));
 }
 
 std::optional<EnumSpecifier::Enumerator> Parser::ParseEnumerator() {
   auto begin = mTokCursor;
-  std::string_view enumValueName = mTokCursor->getRepresentation();
+  std::string_view enumValueName = Spelling(mTokCursor);
   if (mScope.checkIsTypedefInCurrentScope(enumValueName)) {
-    DiagReport(Diag, mTokCursor->getSMLoc(), diag::err_parse_expect_n,
+    DiagReport(Diag, DiagLoc(mTokCursor), diag::err_parse_expect_n,
                "identifier, but get a typedef type");
   }
   mScope.addToScope(enumValueName);
@@ -1048,16 +1234,16 @@ std::optional<EnumSpecifier::Enumerator> Parser::ParseEnumerator() {
   if (Peek(tok::equal)) {
     ConsumeAny();
     auto constant = ParseConditionalExpr();
-    return EnumSpecifier::Enumerator{begin, enumValueName, MV_(constant)};
+    return EnumSpecifier::Enumerator{Loc(begin), enumValueName, MV_(constant)};
   }else {
-    return EnumSpecifier::Enumerator{begin, enumValueName};
+    return EnumSpecifier::Enumerator{Loc(begin), enumValueName};
   }
 }
 
 std::optional<BlockStmt> Parser::ParseBlockStmt() {
   auto begin = mTokCursor;
   Expect(tok::l_brace);
-  std::vector<BlockItem> items;
+  ASTVector<BlockItem> items;
   mScope.pushScope();
   while (IsFirstInBlockItem()) {
     auto result = ParseBlockItem();
@@ -1069,7 +1255,7 @@ std::optional<BlockStmt> Parser::ParseBlockStmt() {
   }
   mScope.popScope();
   Expect(tok::r_brace);
-  return BlockStmt(begin, MV_(items));
+  return BlockStmt(Loc(begin), MV_(items));
 }
 
 std::optional<BlockItem> Parser::ParseBlockItem() {
@@ -1094,10 +1280,18 @@ std::optional<BlockItem> Parser::ParseBlockItem() {
  */
 std::optional<Initializer> Parser::ParseInitializer() {
   auto begin = mTokCursor;
+  if (Peek(tok::embed_data)) {
+    ConsumeAny();
+    /// the bytes are in the buffer of the file manager, which outlives the
+    /// syntax tree, they aren't copied into the context
+    auto bytes = begin->getRepresentation();
+    return Initializer(Loc(begin),
+                       EmbedData(Loc(begin), {bytes.data(), bytes.size()}));
+  }
   if (!Peek(tok::l_brace)) {
     auto assignment = ParseAssignExpr();
     if (assignment) {
-      return Initializer(begin, MV_(*assignment));
+      return Initializer(Loc(begin), MV_(*assignment));
     }
   } else {
     Expect(tok::l_brace);
@@ -1107,7 +1301,7 @@ std::optional<Initializer> Parser::ParseInitializer() {
     }
     Expect(tok::r_brace);
     if (initializerList) {
-      return Initializer(begin, MV_(*initializerList));
+      return Initializer(Loc(begin), MV_(*initializerList));
     }
   }
   return std::nullopt;
@@ -1129,7 +1323,7 @@ designator:
  */
 std::optional<InitializerList> Parser::ParseInitializerList() {
   auto begin = mTokCursor;
-  std::vector<InitializerList::InitializerPair> initializerPairs;
+  ASTVector<InitializerList::InitializerPair> initializerPairs;
   bool first = true;
   do {
     if (first) {
@@ -1137,6 +1331,12 @@ std::optional<InitializerList> Parser::ParseInitializerList() {
     } else {
       Expect(tok::comma);
     }
+    if (auto constants = ParseConstantArray()) {
+      SourceLocation loc = constants->getBeginLoc();
+      initializerPairs.push_back(
+          {std::nullopt, Initializer(loc, MV_(*constants))});
+      continue;
+    }
     InitializerList::Designation designation;
     while (Peek(tok::l_square) || Peek(tok::period)) {
       if (Peek(tok::l_square)) {
@@ -1148,7 +1348,7 @@ std::optional<InitializerList> Parser::ParseInitializerList() {
         Expect(tok::r_square);
       } else if (Peek(tok::period)) {
         ConsumeAny();
-        designation.emplace_back(mTokCursor->getRepresentation());
+        designation.emplace_back(Spelling(mTokCursor));
         Expect(tok::identifier);
       }
     }
@@ -1160,8 +1360,97 @@ std::optional<InitializerList> Parser::ParseInitializerList() {
     auto initializer = ParseInitializer();
     if (initializer)
       initializerPairs.push_back({MV_(designation), MV_(*initializer)});
-  } while (Peek(tok::comma));
-  return InitializerList{begin, MV_(initializerPairs)};
+  } while (Peek(tok::comma) && !PeekN(1, tok::r_brace));
+  return InitializerList{Loc(begin), MV_(initializerPairs)};
+}
+
+/**
+ * a run of at least MinConstantRun initializers of an initializer list which
+ * are each a numeric or character constant, negated or not, of one type,
+ * as a generated table has. The run ends before the comma or the } after its
+ * last constant, nullopt leaves the cursor where it was.
+ */
+std::optional<ConstantArray> Parser::ParseConstantArray() {
+  /// the index of the token value of the constant at `tok` and the token
+  /// after it, 0 when there is no constant followed by a comma or a }
+  auto constantAt = [this](TokIter tok) -> std::pair<size_t, TokIter> {
+    if (tok < mTokEnd && tok->getTokenKind() == tok::minus) {
+      ++tok;
+    }
+    if (tok + 1 >= mTokEnd || (tok->getTokenKind() != tok::numeric_constant &&
+                               tok->getTokenKind() != tok::char_constant)) {
+      return {0, tok};
+    }
+    size_t index = tok->getValue().index();
+    auto next = (tok + 1)->getTokenKind();
+    if (std::holds_alternative<std::string>(tok->getValue()) ||
+        (next != tok::comma && next != tok::r_brace)) {
+      return {0, tok};
+    }
+    return {index, tok + 1};
+  };
+
+  size_t kind = 0, count = 0;
+  TokIter end = mTokCursor;
+  for (TokIter tok = mTokCursor;;) {
+    auto [index, next] = constantAt(tok);
+    if (!index || (kind && index != kind)) {
+      break;
+    }
+    kind = index;
+    ++count;
+    end = next;
+    if (next->getTokenKind() != tok::comma) {
+      break;
+    }
+    tok = next + 1;
+  }
+  if (count < MinConstantRun) {
+    return std::nullopt;
+  }
+
+  auto fill = [&](auto zero) -> ConstantArray::Variant {
+    using T = decltype(zero);
+    auto *values =
+        static_cast<T *>(mContext->Allocate(count * sizeof(T), alignof(T)));
+    TokIter tok = mTokCursor;
+    for (size_t i = 0; i < count; ++i, tok += 2) {
+      bool negate = tok->getTokenKind() == tok::minus;
+      if (negate) {
+        ++tok;
+      }
+      T value = std::get<T>(tok->getValue());
+      values[i] = negate ? static_cast<T>(-value) : value;
+    }
+    return std::span<const T>(values, count);
+  };
+  /// the alternatives of Token::ValueType after std::monostate
+  ConstantArray::Variant values;
+  switch (kind) {
+  case 1:
+    values = fill(int32_t{});
+    break;
+  case 2:
+    values = fill(uint32_t{});
+    break;
+  case 3:
+    values = fill(int64_t{});
+    break;
+  case 4:
+    values = fill(uint64_t{});
+    break;
+  case 5:
+    values = fill(float{});
+    break;
+  case 6:
+    values = fill(double{});
+    break;
+  default:
+    LCC_UNREACHABLE;
+  }
+  auto begin = mTokCursor;
+  mTokCursor = end;
+  return ConstantArray(Loc(begin), values);
 }
 
 std::optional<Stmt> Parser::ParseStmt() {
@@ -1195,19 +1484,13 @@ std::optional<Stmt> Parser::ParseStmt() {
   } else {
     /// identifier : stmt
     auto begin = mTokCursor;
-    if (Peek(tok::identifier)) {
+    if (Peek(tok::identifier) && PeekN(1, tok::colon)) {
       ConsumeAny();
-      if (Peek(tok::colon)) {
-        ConsumeAny();
-        return Stmt(LabelStmt(begin, begin->getRepresentation()));
-      }else {
-        mTokCursor = begin;
-        return ParseExprStmt();
-      }
-    }else {
-      /// expr{opt};
-      return ParseExprStmt();
+      ConsumeAny();
+      return Stmt(LabelStmt(Loc(begin), Spelling(begin)));
     }
+    /// expr{opt};
+    return ParseExprStmt();
   }
 }
 
@@ -1224,11 +1507,11 @@ std::optional<Stmt> Parser::ParseIfStmt() {
     ConsumeAny();
     auto elseStmt = ParseStmt();
     if (expr && thenStmt && elseStmt) {
-      return Stmt{IfStmt(begin, MV_(*expr), MV_(*thenStmt), MV_(*elseStmt))};
+      return Stmt{IfStmt(Loc(begin), MV_(*expr), MV_(*thenStmt), MV_(*elseStmt))};
     }
   } else {
     if (expr && thenStmt) {
-      return Stmt{IfStmt(begin, MV_(*expr), MV_(*thenStmt))};
+      return Stmt{IfStmt(Loc(begin), MV_(*expr), MV_(*thenStmt))};
     }
   }
   return std::nullopt;
@@ -1243,7 +1526,7 @@ std::optional<Stmt> Parser::ParseWhileStmt() {
   Expect(tok::r_paren);
   auto stmt = ParseStmt();
   if (expr && stmt) {
-    return Stmt{WhileStmt(begin, MV_(*expr), MV_(*stmt))};
+    return Stmt{WhileStmt(Loc(begin), MV_(*expr), MV_(*stmt))};
   }
   return std::nullopt;
 }
@@ -1259,7 +1542,7 @@ std::optional<Stmt> Parser::ParseDoWhileStmt() {
   Expect(tok::r_paren);
   Expect(tok::semi);
   if (stmt && expr) {
-    return Stmt{DoWhileStmt(begin, MV_(*stmt), MV_(*expr))};
+    return Stmt{DoWhileStmt(Loc(begin), MV_(*stmt), MV_(*expr))};
   }
   return std::nullopt;
 }
@@ -1296,7 +1579,7 @@ std::optional<Stmt> Parser::ParseForStmt() {
 
   auto stmt = ParseStmt();
   if (std::holds_alternative<Declaration>(*blockItem)) {
-    return Stmt(ForStmt(begin, MV_(*stmt),
+    return Stmt(ForStmt(Loc(begin), MV_(*stmt),
                         MV_(std::get<Declaration>(*blockItem)),
                         MV_(controlExpr), MV_(postExpr)));
   } else if (std::holds_alternative<box<ExprStmt>>(
@@ -1307,7 +1590,7 @@ std::optional<Stmt> Parser::ParseForStmt() {
       expr = MV_(*exprStmtBox->moveOptionalExpression());
     }
     return Stmt(
-        ForStmt(begin, MV_(*stmt), MV_(expr), MV_(controlExpr), MV_(postExpr)));
+        ForStmt(Loc(begin), MV_(*stmt), MV_(expr), MV_(controlExpr), MV_(postExpr)));
   }
 
   return std::nullopt;
@@ -1318,7 +1601,7 @@ std::optional<Stmt> Parser::ParseBreakStmt() {
   auto begin = mTokCursor;
   Expect(tok::kw_break);
   Expect(tok::semi);
-  return Stmt{BreakStmt(begin)};
+  return Stmt{BreakStmt(Loc(begin))};
 }
 
 /// continue;
@@ -1326,7 +1609,7 @@ std::optional<Stmt> Parser::ParseContinueStmt() {
   auto begin = mTokCursor;
   Expect(tok::kw_continue);
   Expect(tok::semi);
-  return Stmt{ContinueStmt(begin)};
+  return Stmt{ContinueStmt(Loc(begin))};
 }
 
 /// return expr{opt};
@@ -1335,13 +1618,13 @@ std::optional<Stmt> Parser::ParseReturnStmt() {
   Expect(tok::kw_return);
   if (Peek(tok::semi)) {
     ConsumeAny();
-    return Stmt{ReturnStmt(begin)};
+    return Stmt{ReturnStmt(Loc(begin))};
   }
   auto expr = ParseExpr();
   Expect(tok::semi);
   if (!expr)
     return std::nullopt;
-  return Stmt{ReturnStmt(begin, MV_(*expr))};
+  return Stmt{ReturnStmt(Loc(begin), MV_(*expr))};
 }
 
 /// expr;
@@ -1349,14 +1632,14 @@ std::optional<Stmt> Parser::ParseExprStmt() {
   auto begin = mTokCursor;
   if (Peek(tok::semi)) {
     ConsumeAny();
-    return Stmt(ExprStmt(begin));
+    return Stmt(ExprStmt(Loc(begin)));
   }
   auto expr = ParseExpr();
   Expect(tok::semi);
   if (!expr)
     return std::nullopt;
 
-  return Stmt(ExprStmt(begin, MV_(*expr)));
+  return Stmt(ExprStmt(Loc(begin), MV_(*expr)));
 }
 
 /// switch ( expression ) statement
@@ -1367,10 +1650,10 @@ std::optional<Stmt> Parser::ParseSwitchStmt() {
   auto expr = ParseExpr();
   Expect(tok::r_paren);
   auto stmt = ParseStmt();
-  if (expr || stmt) {
+  if (!expr || !stmt) {
     return std::nullopt;
   }
-  return Stmt(SwitchStmt(begin, MV_(*expr), MV_(*stmt)));
+  return Stmt(SwitchStmt(Loc(begin), MV_(*expr), MV_(*stmt)));
 }
 
 /// case constantExpr: stmt
@@ -1380,10 +1663,10 @@ std::optional<Stmt> Parser::ParseCaseStmt() {
   auto expr = ParseConditionalExpr();
   Expect(tok::colon);
   auto stmt = ParseStmt();
-  if (expr || stmt)
+  if (!expr || !stmt)
     return std::nullopt;
 
-  return Stmt(CaseStmt(begin, MV_(*expr), MV_(*stmt)));
+  return Stmt(CaseStmt(Loc(begin), MV_(*expr), MV_(*stmt)));
 }
 
 /// default: stmt
@@ -1395,17 +1678,17 @@ std::optional<Stmt> Parser::ParseDefaultStmt() {
   if (!stmt)
     return std::nullopt;
 
-  return Stmt(DefaultStmt(begin, MV_(*stmt)));
+  return Stmt(DefaultStmt(Loc(begin), MV_(*stmt)));
 }
 
 /// goto identifier;
 std::optional<Stmt> Parser::ParseGotoStmt() {
   auto begin = mTokCursor;
   Expect(tok::kw_goto);
-  auto name = mTokCursor->getRepresentation();
+  auto name = Spelling(mTokCursor);
   Expect(tok::identifier);
   Expect(tok::semi);
-  return Stmt(GotoStmt(begin, name));
+  return Stmt(GotoStmt(Loc(begin), name));
 }
 
 /**
@@ -1414,7 +1697,7 @@ std::optional<Stmt> Parser::ParseGotoStmt() {
     expression , assignment-expression
  */
 std::optional<Expr> Parser::ParseExpr() {
-  std::vector<AssignExpr> assignExprs;
+  ASTVector<AssignExpr> assignExprs;
   auto begin = mTokCursor;
 
   bool first = true;
@@ -1430,7 +1713,7 @@ std::optional<Expr> Parser::ParseExpr() {
     }
   } while (Peek(tok::comma));
 
-  return Expr(begin, MV_(assignExprs));
+  return Expr(Loc(begin), MV_(assignExprs));
 }
 
 /**
@@ -1454,8 +1737,8 @@ std::optional<AssignExpr> Parser::ParseAssignExpr() {
   if (!firstCondExpr) {
     return std::nullopt;
   }
-  std::vector<std::pair<AssignExpr::AssignOp, CondExpr>> list;
-  while (IsAssignOp(mTokCursor->getTokenKind())) {
+  ASTVector<std::pair<AssignExpr::AssignOp, CondExpr>> list;
+  while (IsAssignOp(CurKind())) {
     auto token = mTokCursor;
     ConsumeAny();
     auto assignOp = [token]() -> AssignExpr::AssignOp {
@@ -1490,7 +1773,7 @@ std::optional<AssignExpr> Parser::ParseAssignExpr() {
     if (condExpr)
       list.push_back({assignOp, MV_(*condExpr)});
   }
-  return AssignExpr(begin, MV_(*firstCondExpr), MV_(list));
+  return AssignExpr(Loc(begin), MV_(*firstCondExpr), MV_(list));
 }
 
 /**
@@ -1500,7 +1783,7 @@ std::optional<AssignExpr> Parser::ParseAssignExpr() {
  */
 std::optional<CondExpr> Parser::ParseConditionalExpr() {
   auto begin = mTokCursor;
-  auto logOrExpr = ParseLogOrExpr();
+  auto logOrExpr = ParseBinaryExpr(0);
   if (!logOrExpr)
     return std::nullopt;
 
@@ -1510,310 +1793,82 @@ std::optional<CondExpr> Parser::ParseConditionalExpr() {
     Expect(tok::colon);
     auto condExpr = ParseConditionalExpr();
     if (logOrExpr && expr && condExpr) {
-      return CondExpr(begin, MV_(*logOrExpr), MV_(*expr), MV_(*condExpr));
-    }
-    return std::nullopt;
-  }
-  return CondExpr(begin, MV_(*logOrExpr));
-}
-
-/**
- * logical-OR-expression:
- *      logical-AND-expression
- *      logical-OR-expression || logical-AND-expression
- */
-std::optional<LogOrExpr> Parser::ParseLogOrExpr() {
-  std::vector<LogAndExpr> logAndExprArr;
-  auto begin = mTokCursor;
-  bool first = true;
-  do {
-    if (first) {
-      first = false;
-    } else {
-      ConsumeAny();
+      return CondExpr(Loc(begin), MV_(*logOrExpr), MV_(*expr), MV_(*condExpr));
     }
-    auto logAndExpr = ParseLogAndExpr();
-    if (logAndExpr)
-      logAndExprArr.push_back(MV_(*logAndExpr));
-  } while (Peek(tok::pipe_pipe));
-
-  if (logAndExprArr.empty()) {
     return std::nullopt;
   }
-
-  return LogOrExpr(begin, MV_(logAndExprArr));
-}
-
-/**
- * logical-AND-expression:
- *      inclusive-OR-expression
- *      logical-AND-expression && inclusive-OR-expression
- */
-std::optional<LogAndExpr> Parser::ParseLogAndExpr() {
-  auto begin = mTokCursor;
-  std::vector<BitOrExpr> bitOrExprArr;
-  bool first = true;
-  do {
-    if (first) {
-      first = false;
-    } else {
-      ConsumeAny();
-    }
-    auto bitOrExpr = ParseBitOrExpr();
-    if (bitOrExpr)
-      bitOrExprArr.push_back(MV_(*bitOrExpr));
-  } while (Peek(tok::amp_amp));
-
-  if (bitOrExprArr.empty()) {
-    return std::nullopt;
-  }
-
-  return LogAndExpr(begin, MV_(bitOrExprArr));
-}
-
-/**
- * inclusive-OR-expression:
- *      exclusive-OR-expression
- *      inclusive-OR-expression | exclusive-OR-expression
- */
-std::optional<BitOrExpr> Parser::ParseBitOrExpr() {
-  auto begin = mTokCursor;
-  std::vector<BitXorExpr> bitXorExprArr;
-  bool first = true;
-  do {
-    if (first) {
-      first = false;
-    } else {
-      ConsumeAny();
-    }
-    auto bitXorExpr = ParseBitXorExpr();
-    if (bitXorExpr) {
-      bitXorExprArr.push_back(MV_(*bitXorExpr));
-    }
-  } while (Peek(tok::pipe));
-
-  if (bitXorExprArr.empty())
-    return std::nullopt;
-
-  return BitOrExpr(begin, MV_(bitXorExprArr));
-}
-
-std::optional<BitXorExpr> Parser::ParseBitXorExpr() {
-  auto begin = mTokCursor;
-  std::vector<BitAndExpr> bitAndExprArr;
-  bool first = true;
-  do {
-    if (first) {
-      first = false;
-    } else {
-      ConsumeAny();
-    }
-    auto bitAndExpr = ParseBitAndExpr();
-    if (bitAndExpr) {
-      bitAndExprArr.push_back(MV_(*bitAndExpr));
-    }
-  } while (Peek(tok::caret));
-
-  if (bitAndExprArr.empty())
-    return std::nullopt;
-
-  return BitXorExpr(begin, MV_(bitAndExprArr));
-}
-
-/**
- * AND-expression:
- *      equality-expression
- *      AND-expression & equality-expression
- */
-std::optional<BitAndExpr> Parser::ParseBitAndExpr() {
-  auto begin = mTokCursor;
-  std::vector<EqualExpr> equalExprArr;
-  bool first = true;
-  do {
-    if (first) {
-      first = false;
-    } else {
-      ConsumeAny();
-    }
-    auto equalExpr = ParseEqualExpr();
-    if (equalExpr) {
-      equalExprArr.push_back(MV_(*equalExpr));
-    }
-  } while (Peek(tok::amp));
-
-  if (equalExprArr.empty()) {
+  return CondExpr(Loc(begin), MV_(*logOrExpr));
+}
+
+static std::optional<BinaryExpr::Op> GetBinaryOp(tok::TokenKind kind) {
+  switch (kind) {
+  case tok::star:
+    return BinaryExpr::Op::Multiply;
+  case tok::slash:
+    return BinaryExpr::Op::Divide;
+  case tok::percent:
+    return BinaryExpr::Op::Modulo;
+  case tok::plus:
+    return BinaryExpr::Op::Plus;
+  case tok::minus:
+    return BinaryExpr::Op::Minus;
+  case tok::less_less:
+    return BinaryExpr::Op::LeftShift;
+  case tok::greater_greater:
+    return BinaryExpr::Op::RightShift;
+  case tok::less:
+    return BinaryExpr::Op::LessThan;
+  case tok::less_equal:
+    return BinaryExpr::Op::LessThanOrEqual;
+  case tok::greater:
+    return BinaryExpr::Op::GreaterThan;
+  case tok::greater_equal:
+    return BinaryExpr::Op::GreaterThanOrEqual;
+  case tok::equal_equal:
+    return BinaryExpr::Op::Equal;
+  case tok::exclaim_equal:
+    return BinaryExpr::Op::NotEqual;
+  case tok::amp:
+    return BinaryExpr::Op::BitAnd;
+  case tok::caret:
+    return BinaryExpr::Op::BitXor;
+  case tok::pipe:
+    return BinaryExpr::Op::BitOr;
+  case tok::amp_amp:
+    return BinaryExpr::Op::LogicalAnd;
+  case tok::pipe_pipe:
+    return BinaryExpr::Op::LogicalOr;
+  default:
     return std::nullopt;
   }
-  return BitAndExpr(begin, MV_(equalExprArr));
 }
 
 /**
- * equality-expression:
- *      relational-expression
- *      equality-expression == relational-expression
- *      equality-expression != relational-expression
+ * logical-OR-expression down to multiplicative-expression, by precedence
+ * climbing: the operators binding at least as tight as `minPrecedence` are
+ * taken here, the right operand of each is parsed one level tighter. An
+ * operand costs a single call instead of one for each level of the grammar.
  */
-std::optional<EqualExpr> Parser::ParseEqualExpr() {
+std::optional<BinaryOperand> Parser::ParseBinaryExpr(unsigned minPrecedence) {
   auto begin = mTokCursor;
-  auto firstRelationalExpr = ParseRelationalExpr();
-  if (!firstRelationalExpr) {
+  auto castExpr = ParseCastExpr();
+  if (!castExpr) {
     return std::nullopt;
   }
-  std::vector<std::pair<EqualExpr::Op, RelationalExpr>> relationalExprs;
-  while (Peek(tok::equal_equal) || Peek(tok::exclaim_equal)) {
-    tok::TokenKind tokenType = mTokCursor->getTokenKind();
-    EqualExpr::Op equalOp;
-    if (tokenType == tok::equal_equal) {
-      equalOp = EqualExpr::Op::Equal;
-    }else {
-      equalOp = EqualExpr::Op::NotEqual;
-    }
-    ConsumeAny();
-    auto relationalExpr = ParseRelationalExpr();
-    if (relationalExpr) {
-      relationalExprs.emplace_back(equalOp, MV_(*relationalExpr));
-    }
-  }
-  return EqualExpr(begin, MV_(*firstRelationalExpr), MV_(relationalExprs));
-}
-
-/**
- * relational-expression:
- *      shift-expression
- *      relational-expression < shift-expression
- *      relational-expression > shift-expression
- *      relational-expression <= shift-expression
- *      relational-expression >= shift-expression
- */
-std::optional<RelationalExpr> Parser::ParseRelationalExpr() {
-  auto begin = mTokCursor;
-  auto firstShiftExpr = ParseShiftExpr();
-  if (!firstShiftExpr)
-    return {std::nullopt};
-
-  std::vector<std::pair<RelationalExpr::Op, ShiftExpr>> relationalExprArr;
-  while (Peek(tok::less) || Peek(tok::less_equal) ||
-         Peek(tok::greater) || Peek(tok::greater_equal)) {
-    tok::TokenKind tokenType = mTokCursor->getTokenKind();
-    auto relationalOp = [tokenType]() -> RelationalExpr::Op {
-      switch (tokenType) {
-      case tok::less:
-        return RelationalExpr::Op::LessThan;
-      case tok::less_equal:
-        return RelationalExpr::Op::LessThanOrEqual;
-      case tok::greater:
-        return RelationalExpr::Op::GreaterThan;
-      case tok::greater_equal:
-        return RelationalExpr::Op::GreaterThanOrEqual;
-      default:
-        LCC_UNREACHABLE;
-      }
-    }();
-    ConsumeAny();
-    auto shiftExpr = ParseShiftExpr();
-    if (shiftExpr) {
-      relationalExprArr.emplace_back(relationalOp, MV_(*shiftExpr));
-    }
-  }
-
-  return RelationalExpr(begin, MV_(*firstShiftExpr), MV_(relationalExprArr));
-}
-
-/**
- * shift-expression:
- *      additive-expression
- *      shift-expression << additive-expression
- *      shift-expression >> additive-expression
- */
-std::optional<ShiftExpr> Parser::ParseShiftExpr() {
-  auto begin = mTokCursor;
-  auto firstAdditiveExpr = ParseAdditiveExpr();
-  if (!firstAdditiveExpr)
-    return {std::nullopt};
-
-  std::vector<std::pair<ShiftExpr::Op, AdditiveExpr>> additiveExprArr;
-  while (Peek(tok::less_less) || Peek(tok::greater_greater)) {
-    tok::TokenKind tokenType = mTokCursor->getTokenKind();
-    ShiftExpr::Op op;
-    if (tokenType == tok::less_less) {
-      op = ShiftExpr::Op::Left;
-    }else {
-      op = ShiftExpr::Op::Right;
-    }
-    ConsumeAny();
-    auto additiveExpr = ParseAdditiveExpr();
-    if (additiveExpr) {
-      additiveExprArr.emplace_back(op, MV_(*additiveExpr));
-    }
-  }
-  return ShiftExpr(begin, MV_(*firstAdditiveExpr), MV_(additiveExprArr));
-}
-
-/**
- * additive-expression:
- * multiplicative-expression
- * additive-expression + multiplicative-expression
- * additive-expression - multiplicative-expression
- */
-std::optional<AdditiveExpr> Parser::ParseAdditiveExpr() {
-  auto begin = mTokCursor;
-  auto firstMultiExpr = ParseMultiExpr();
-  if (!firstMultiExpr)
-    return std::nullopt;
-
-  std::vector<std::pair<AdditiveExpr::Op, MultiExpr>> multiExprArr;
-  while (Peek(tok::plus) || Peek(tok::minus)) {
-    tok::TokenKind tokenType = mTokCursor->getTokenKind();
-    AdditiveExpr::Op op;
-    if (tokenType == tok::plus) {
-      op = AdditiveExpr::Op::Plus;
-    }else {
-      op = AdditiveExpr::Op::Minus;
-    }
-    ConsumeAny();
-    auto multiExpr = ParseMultiExpr();
-    if (multiExpr) {
-      multiExprArr.emplace_back(op, MV_(*multiExpr));
+  BinaryOperand lhs = box<CastExpr>(MV_(*castExpr));
+  while (auto op = GetBinaryOp(CurKind())) {
+    unsigned precedence = BinaryExpr::getPrecedence(*op);
+    if (precedence < minPrecedence) {
+      break;
     }
-  }
-  return AdditiveExpr(begin, MV_(*firstMultiExpr), MV_(multiExprArr));
-}
-
-/**
- * multiplicative-expression:
- *  cast-expression
- *  multiplicative-expression * cast-expression
- *  multiplicative-expression / cast-expression
- *  multiplicative-expression % cast-expression
- */
-std::optional<MultiExpr> Parser::ParseMultiExpr() {
-  auto begin = mTokCursor;
-  auto firstCastExpr = ParseCastExpr();
-  if (!firstCastExpr) {
-    return std::nullopt;
-  }
-  std::vector<std::pair<MultiExpr::Op, CastExpr>> castExprArr;
-  while (Peek(tok::star) || Peek(tok::slash) || Peek(tok::percent)) {
-    tok::TokenKind tokenType = mTokCursor->getTokenKind();
-    auto op = [tokenType]() -> MultiExpr::Op {
-      switch (tokenType) {
-      case tok::star:
-        return MultiExpr::Op::Multiply;
-      case tok::slash:
-        return MultiExpr::Op::Divide;
-      case tok::percent:
-        return MultiExpr::Op::Modulo;
-      default:
-        LCC_UNREACHABLE;
-      }
-    }();
     ConsumeAny();
-    auto castExpr = ParseCastExpr();
-    if (castExpr) {
-      castExprArr.emplace_back(op, MV_(*castExpr));
+    /// past the tightest level no operator is taken, a cast-expression is
+    auto rhs = ParseBinaryExpr(precedence + 1);
+    if (rhs) {
+      lhs = box<BinaryExpr>(BinaryExpr(Loc(begin), *op, MV_(lhs), MV_(*rhs)));
     }
   }
-  return MultiExpr(begin, MV_(*firstCastExpr), MV_(castExprArr));
+  return lhs;
 }
 
 /**
@@ -1823,12 +1878,11 @@ std::optional<MultiExpr> Parser::ParseMultiExpr() {
 std::optional<TypeName> Parser::ParseTypeName() {
   auto begin = mTokCursor;
   auto specs = ParseDeclarationSpecifiers();
-  if (specs.getStorageClassSpecifiers().size() > 0) {
-    DiagReport(Diag, begin->getSMLoc(), diag::err_parse_type_name_appear_storage_class);
+  if (specs.hasStorageClass()) {
+    DiagReport(Diag, DiagLoc(begin), diag::err_parse_type_name_appear_storage_class);
   }
-  if (specs.getTypeSpecs().size() == 0 &&
-      specs.getTypeQualifiers().size() == 0) {
-    DiagReport(Diag, begin->getSMLoc(), diag::err_parse_expect_type_specifier_or_qualifier);
+  if (!specs.hasTypeSpec() && !specs.getQualifiers()) {
+    DiagReport(Diag, DiagLoc(begin), diag::err_parse_expect_type_specifier_or_qualifier);
   }
 
   if (IsFirstInAbstractDeclarator()) {
@@ -1836,9 +1890,9 @@ std::optional<TypeName> Parser::ParseTypeName() {
     if (!abstractDec) {
       return std::nullopt;
     }
-    return TypeName(begin, MV_(specs), MV_(*abstractDec));
+    return TypeName(Loc(begin), MV_(specs), MV_(*abstractDec));
   }
-  return TypeName(begin, MV_(specs));
+  return TypeName(Loc(begin), MV_(specs));
 }
 
 /**
@@ -1851,35 +1905,33 @@ std::optional<TypeName> Parser::ParseTypeName() {
 std::optional<CastExpr> Parser::ParseCastExpr() {
   auto begin = mTokCursor;
   // cast-expression: unary-expression
-  if (!Peek(tok::l_paren)) {
+  if (!Peek(tok::l_paren) || !IsFirstInTypeName(1)) {
     auto unary = ParseUnaryExpr();
     if (!unary) {
       return std::nullopt;
     }
-    return CastExpr(begin, MV_(*unary));
+    return CastExpr(Loc(begin), MV_(*unary));
   }
 
   Expect(tok::l_paren);
-
-  if (!IsFirstInTypeName()) {
-    // cast-expression: unary-expression
-    mTokCursor = begin;
-    auto unary = ParseUnaryExpr();
-    if (!unary) {
+  auto typeName = ParseTypeName();
+  Expect(tok::r_paren);
+  /// ( type-name ) { initializer-list } is a postfix-expression, the
+  /// type-name is not parsed again for it
+  if (Peek(tok::l_brace)) {
+    auto postFix = ParseCompoundLiteral(begin, MV_(typeName));
+    if (!postFix) {
       return std::nullopt;
     }
-    return CastExpr(begin, MV_(*unary));
-  }else {
-    // cast-expression: ( type-name ) cast-expression
-    auto typeName = ParseTypeName();
-    Expect(tok::r_paren);
-    auto cast = ParseCastExpr();
-    if (typeName && cast) {
-      return CastExpr(begin,
-                      CastExpr::TypeNameCast{MV_(*typeName), MV_(*cast)});
-    }
-    return std::nullopt;
+    return CastExpr(Loc(begin), UnaryExpr(MV_(*postFix)));
   }
+  // cast-expression: ( type-name ) cast-expression
+  auto cast = ParseCastExpr();
+  if (typeName && cast) {
+    return CastExpr(Loc(begin),
+                    CastExpr::TypeNameCast{MV_(*typeName), MV_(*cast)});
+  }
+  return std::nullopt;
 }
 
 /**
@@ -1898,21 +1950,27 @@ std::optional<UnaryExpr> Parser::ParseUnaryExpr() {
   TokIter begin = mTokCursor;
   if (Peek(tok::kw_sizeof)) {
     ConsumeAny();
-    if (Peek(tok::l_paren)) {
+    if (Peek(tok::l_paren) && IsFirstInTypeName(1)) {
+      auto typeBegin = mTokCursor;
       ConsumeAny();
       auto type = ParseTypeName();
       Expect(tok::r_paren);
-      if (type) {
-        return UnaryExpr(UnaryExprSizeOf(begin, MV_(*type)));
+      if (Peek(tok::l_brace)) {
+        auto postFix = ParseCompoundLiteral(typeBegin, MV_(type));
+        if (postFix) {
+          return UnaryExpr(UnaryExprSizeOf(Loc(begin), UnaryExpr(MV_(*postFix))));
+        }
+      } else if (type) {
+        return UnaryExpr(UnaryExprSizeOf(Loc(begin), MV_(*type)));
       }
     } else {
       auto unary = ParseUnaryExpr();
       if (unary) {
-        return UnaryExpr(UnaryExprSizeOf(begin, MV_(*unary)));
+        return UnaryExpr(UnaryExprSizeOf(Loc(begin), MV_(*unary)));
       }
     }
-  } else if (IsUnaryOp(mTokCursor->getTokenKind())) {
-    tok::TokenKind tokenType = mTokCursor->getTokenKind();
+  } else if (IsUnaryOp(CurKind())) {
+    tok::TokenKind tokenType = CurKind();
     auto unaryOp = [tokenType]() -> UnaryExprUnaryOperator::Op {
       switch (tokenType) {
       case tok::amp:
@@ -1937,8 +1995,8 @@ std::optional<UnaryExpr> Parser::ParseUnaryExpr() {
     }();
     ConsumeAny();
     auto castExpr = ParseCastExpr();
-    if (!castExpr) {
-      return UnaryExpr(UnaryExprUnaryOperator(begin, unaryOp, MV_(*castExpr)));
+    if (castExpr) {
+      return UnaryExpr(UnaryExprUnaryOperator(Loc(begin), unaryOp, MV_(*castExpr)));
     }
   } else {
     auto postFix = ParsePostFixExpr();
@@ -1964,14 +2022,14 @@ std::optional<UnaryExpr> Parser::ParseUnaryExpr() {
 
 void Parser::ParsePostFixExprSuffix(TokIter beginTokLoc,
                                     PostFixExpr &postFixExpr) {
-  std::cout << "this kind is: " << mTokCursor->getTokenKind() << " " << (mTokCursor->getTokenKind() ==tok::l_paren) << "\n";
-  while (IsPostFixExpr(mTokCursor->getTokenKind())) {
-    auto tokType = mTokCursor->getTokenKind();
+  while (IsPostFixExpr(CurKind())) {
+    auto tokType = CurKind();
     if (tokType == tok::l_paren) {
       ConsumeAny();
-      std::vector<box<AssignExpr>> params;
+      ASTVector<box<AssignExpr>> params;
+      /// f() has no arguments
       bool first = true;
-      do {
+      while (!Peek(tok::r_paren) && (first || Peek(tok::comma))) {
         if (first) {
           first = false;
         } else {
@@ -1981,35 +2039,35 @@ void Parser::ParsePostFixExprSuffix(TokIter beginTokLoc,
         if (assignExpr) {
           params.push_back(MV_(*assignExpr));
         }
-      } while (!Peek(tok::r_paren));
+      }
 
       Expect(tok::r_paren);
       postFixExpr =
-          PostFixExprFuncCall(beginTokLoc, MV_(postFixExpr), MV_(params));
+          PostFixExprFuncCall(Loc(beginTokLoc), MV_(postFixExpr), MV_(params));
     } else if (tokType == tok::l_square) {
       ConsumeAny();
       auto expr = ParseExpr();
       Expect(tok::r_square);
       if (expr) {
         postFixExpr =
-            PostFixExprSubscript(beginTokLoc, MV_(postFixExpr), MV_(*expr));
+            PostFixExprSubscript(Loc(beginTokLoc), MV_(postFixExpr), MV_(*expr));
       }
     } else if (tokType == tok::plus_plus) {
       ConsumeAny();
-      postFixExpr = PostFixExprIncrement(beginTokLoc, MV_(postFixExpr));
+      postFixExpr = PostFixExprIncrement(Loc(beginTokLoc), MV_(postFixExpr));
     } else if (tokType == tok::minus_minus) {
       ConsumeAny();
-      postFixExpr = PostFixExprDecrement(beginTokLoc, MV_(postFixExpr));
+      postFixExpr = PostFixExprDecrement(Loc(beginTokLoc), MV_(postFixExpr));
     } else if (tokType == tok::period) {
       ConsumeAny();
-      auto identifier = mTokCursor->getRepresentation();
+      auto identifier = Spelling(mTokCursor);
       Expect(tok::identifier);
-      postFixExpr = PostFixExprDot(beginTokLoc, MV_(postFixExpr), identifier);
+      postFixExpr = PostFixExprDot(Loc(beginTokLoc), MV_(postFixExpr), identifier);
     } else if (tokType == tok::arrow) {
       ConsumeAny();
-      auto identifier = mTokCursor->getRepresentation();
+      auto identifier = Spelling(mTokCursor);
       Expect(tok::identifier);
-      postFixExpr = PostFixExprArrow(beginTokLoc, MV_(postFixExpr), identifier);
+      postFixExpr = PostFixExprArrow(Loc(beginTokLoc), MV_(postFixExpr), identifier);
     }
   }
 }
@@ -2032,21 +2090,23 @@ std::optional<PostFixExpr> Parser::ParsePostFixExpr() {
 
   TokIter beginTokLoc = mTokCursor;
   if (Peek(tok::identifier)) {
-    auto name = mTokCursor->getRepresentation();
-    primaryExpr = PrimaryExprIdent(beginTokLoc, name);
+    auto name = Spelling(mTokCursor);
+    primaryExpr = PrimaryExprIdent(Loc(beginTokLoc), name);
     ConsumeAny();
   }else if (Peek(tok::char_constant) || Peek(tok::numeric_constant) || Peek(tok::string_literal)) {
     using PrimExprConstantValueType = PrimaryExprConstant::Variant;
     auto value = match(
-        mTokCursor->getValue(), [](auto &&value) -> PrimExprConstantValueType {
+        mTokCursor->getValue(), [this](auto &&value) -> PrimExprConstantValueType {
           using T = std::decay_t<decltype(value)>;
-          if constexpr (std::is_constructible_v<PrimExprConstantValueType, T>) {
+          if constexpr (std::is_same_v<T, std::string>) {
+            return mContext->CopyString(value);
+          } else if constexpr (std::is_constructible_v<PrimExprConstantValueType, T>) {
             return std::forward<decltype(value)>(value);
           } else {
             LCC_UNREACHABLE;
           }
         });
-    primaryExpr = PrimaryExprConstant(beginTokLoc, MV_(value));
+    primaryExpr = PrimaryExprConstant(Loc(beginTokLoc), MV_(value));
     ConsumeAny();
   }else if (Peek(tok::l_paren)) {
     ConsumeAny();
@@ -2054,24 +2114,20 @@ std::optional<PostFixExpr> Parser::ParsePostFixExpr() {
       auto expr = ParseExpr();
       Expect(tok::r_paren);
       if (expr) {
-        primaryExpr = PrimaryExprParentheses(beginTokLoc, MV_(*expr));
+        primaryExpr = PrimaryExprParentheses(Loc(beginTokLoc), MV_(*expr));
       }
     } else {
       auto type = ParseTypeName();
       Expect(tok::r_paren);
-      Expect(tok::l_brace);
-      auto initializer = ParseInitializerList();
-      if (Peek(tok::comma)) {
-        ConsumeAny();
-      }
-      Expect(tok::r_brace);
-      if (type && initializer) {
-        postFixExpr = PostFixExprTypeInitializer(beginTokLoc, MV_(*type),
-                                                 MV_(*initializer));
-      }
+      return ParseCompoundLiteral(beginTokLoc, MV_(type));
     }
   }else {
-    DiagReport(Diag, mTokCursor->getSMLoc(), diag::err_parse_expect_n, "primary expr or ( type-name )");
+    if (Peek(tok::embed_data)) {
+      DiagReport(Diag, DiagLoc(mTokCursor),
+                 diag::err_parse_embed_outside_initializer);
+    } else {
+      DiagReport(Diag, DiagLoc(mTokCursor), diag::err_parse_expect_n, "primary expr or ( type-name )");
+    }
   }
 
   if (primaryExpr) {
@@ -2087,6 +2143,65 @@ std::optional<PostFixExpr> Parser::ParsePostFixExpr() {
   return postFixExpr;
 }
 
+std::optional<PostFixExpr>
+Parser::ParseCompoundLiteral(TokIter beginTokLoc,
+                             std::optional<TypeName> &&typeName) {
+  Expect(tok::l_brace);
+  auto initializer = ParseInitializerList();
+  if (Peek(tok::comma)) {
+    ConsumeAny();
+  }
+  Expect(tok::r_brace);
+  if (!typeName || !initializer) {
+    return std::nullopt;
+  }
+  PostFixExpr postFixExpr = PostFixExprTypeInitializer(
+      Loc(beginTokLoc), MV_(*typeName), MV_(*initializer));
+  ParsePostFixExprSuffix(beginTokLoc, postFixExpr);
+  return postFixExpr;
+}
+
+SourceLocation Parser::Loc(TokIter tok) {
+  /// a node begun at the end of the input, after an error
+  if (tok == mTokens.cend()) {
+    return {};
+  }
+  const llvm::SourceMgr &srcMgr = Diag.getSourceMgr();
+  unsigned id = tok->getFileID();
+  if (!id) {
+    id = srcMgr.FindBufferContainingLoc(tok->getSMLoc());
+  }
+  if (!id) {
+    return {};
+  }
+  if (id != mLocFileID) {
+    mLocFileID = id;
+    mLocFileBase = mLocations.getFileBase(id);
+    mLocBufferStart = srcMgr.getMemoryBuffer(id)->getBufferStart();
+  }
+  return SourceLocation::getFileLoc(mLocFileBase,
+                                    tok->getOffset() - mLocBufferStart);
+}
+
+std::string_view Parser::Spelling(TokIter tok) {
+  /// a name missing at the end of the input, after an error
+  if (tok >= mTokEnd) {
+    return {};
+  }
+  return mContext->CopyString(tok->getRepresentation());
+}
+
+llvm::SMLoc Parser::DiagLoc(TokIter tok) const {
+  if (tok != mTokEnd) {
+    return tok->getSMLoc();
+  }
+  if (tok == mTokens.cbegin()) {
+    return {};
+  }
+  TokIter last = tok - 1;
+  return llvm::SMLoc::getFromPointer(last->getOffset() + last->getLength());
+}
+
 bool Parser::IsAssignOp(tok::TokenKind type) {
   return type == tok::equal || type == tok::plus_equal ||
          type == tok::minus_equal || type == tok::star_equal ||
@@ -2097,23 +2212,32 @@ bool Parser::IsAssignOp(tok::TokenKind type) {
 }
 
 bool Parser::Expect(tok::TokenKind tokenType) {
-  if (mTokCursor->getTokenKind() == tokenType) {
+  if (Peek(tokenType)) {
     ConsumeAny();
     return true;
   }
-  DiagReport(Diag, (mTokCursor-1)->getSMLoc(), diag::err_parse_expect_n_after, tok::getTokenName(tokenType));
+  /// after the token before, the first one has none
+  TokIter after = mTokCursor == mTokens.cbegin() ? mTokCursor : mTokCursor - 1;
+  DiagReport(Diag, DiagLoc(after), diag::err_parse_expect_n_after, tok::getTokenName(tokenType));
   return false;
 }
 
 bool Parser::ConsumeAny() {
-  ++mTokCursor;
+  /// an error at the end of the input consumes nothing
+  if (mTokCursor < mTokEnd) {
+    ++mTokCursor;
+  }
   return true;
 }
+tok::TokenKind Parser::CurKind() const {
+  return mTokCursor < mTokEnd ? mTokCursor->getTokenKind() : tok::eof;
+}
+
 bool Parser::Peek(tok::TokenKind tokenType) {
   if (mTokCursor >= mTokEnd) {
     return false;
   }
-  return mTokCursor->getTokenKind() == tokenType;
+  return CurKind() == tokenType;
 }
 
 bool Parser::PeekN(int n, tok::TokenKind tokenType) {
@@ -2139,50 +2263,170 @@ bool Parser::IsUnaryOp(tok::TokenKind tokenType) {
 bool Parser::IsPostFixExpr(tok::TokenKind tokenType) {
   return (tokenType == tok::l_paren || tokenType == tok::l_square ||
           tokenType == tok::period || tokenType == tok::arrow ||
-          tokenType == tok::plus_plus || tokenType == tok::minus_minus ||
-          tokenType == tok::identifier || tokenType == tok::char_constant ||
-          tokenType == tok::numeric_constant);
+          tokenType == tok::plus_plus || tokenType == tok::minus_minus);
 }
 
 bool Parser::IsCurrentIn(TokenBitSet tokenSet) {
-  return tokenSet[mTokCursor->getTokenKind()];
+  return tokenSet[CurKind()];
+}
+
+size_t Parser::GetAnnotatedKind(unsigned lookahead) const {
+  if (mTokEnd - mTokCursor <= lookahead) {
+    return tok::eof;
+  }
+  TokIter tok = mTokCursor + lookahead;
+  tok::TokenKind kind = tok->getTokenKind();
+  if (kind != tok::identifier) {
+    return kind;
+  }
+  uint32_t &annotation = mAnnotations[tok - mTokens.begin()];
+  uint32_t generation = mScope.getGeneration();
+  if ((annotation >> 1) != generation) {
+    annotation = generation << 1 |
+                 mScope.isTypedefInScope(tok->getRepresentation());
+  }
+  return annotation & 1 ? TypedefName : size_t(tok::identifier);
 }
 
-void Parser::Scope::addTypedef(std::string_view name) {
-  mCurrentScope.back().emplace(name, Symbol{name, true});
+const Parser::Scope::Binding *
+Parser::Scope::lookup(std::string_view name) const {
+  llvm::StringRef key(name.data(), name.size());
+  auto iter = mInnermost.find(key);
+  if (iter != mInnermost.end()) {
+    return &mBindings[iter->second];
+  }
+  if (!mFileScope) {
+    return nullptr;
+  }
+  /// a name has one binding at file scope, visible if it came before
+  iter = mFileScope->mInnermost.find(key);
+  if (iter == mFileScope->mInnermost.end() || iter->second >= mFileScopeSize) {
+    return nullptr;
+  }
+  return &mFileScope->mBindings[iter->second];
 }
 
-bool Parser::Scope::isTypedefInScope(std::string_view name) const {
-  for (auto iter = mCurrentScope.rbegin(); iter != mCurrentScope.rend();
-       iter++) {
-    if (auto result = iter->find(name); result != iter->end()) {
-      return result->second.isTypedef;
+bool Parser::Scope::isTypedefOutside(std::string_view name) const {
+  if (mFileScope) {
+    if (const Binding *binding = mFileScope->lookup(name);
+        binding && binding - mFileScope->mBindings.data() < mFileScopeSize) {
+      return binding->IsTypedef;
     }
   }
-  return false;
+  return mExternal && mExternal->LookupBinding(name).value_or(false);
 }
 
-bool Parser::Scope::checkIsTypedefInCurrentScope(std::string_view name) const {
-  auto iter = mCurrentScope.rbegin();
-  if (auto result = iter->find(name); result != iter->end())
-    return result->second.isTypedef;
-  return false;
+void Parser::Scope::setFileScope(const Scope &fileScope, unsigned size) {
+  assert(mBindings.empty() && "the scope of a body is in use");
+  mFileScope = &fileScope;
+  mFileScopeSize = size;
+  mExternal = fileScope.mExternal;
+  mGeneration = std::max(mGeneration, fileScope.mGeneration) + 1;
 }
 
-void Parser::Scope::addToScope(std::string_view name) {
-  mCurrentScope.back().emplace(name, Symbol{name, false});
+void Parser::Scope::bind(std::string_view name, bool isTypedef) {
+  unsigned depth = mScopeBegins.size();
+  if (!depth && mFileScopeLog) {
+    mFileScopeLog->emplace_back(name, isTypedef);
+  }
+  /// a file scope which goes on from the one it was given, or from the pch
+  /// prefix, that one has the first declaration of the name
+  if (!depth && ((mFileScope && lookup(name)) ||
+                 (mExternal && mExternal->LookupBinding(name)))) {
+    return;
+  }
+  auto [iter, inserted] = mInnermost.try_emplace(
+      llvm::StringRef(name.data(), name.size()), mBindings.size());
+  unsigned shadowed = NoBinding;
+  bool wasTypedef;
+  if (inserted) {
+    wasTypedef = isTypedefOutside(name);
+  } else {
+    /// the first declaration in a scope wins
+    if (mBindings[iter->second].Depth == depth) {
+      return;
+    }
+    shadowed = iter->second;
+    wasTypedef = mBindings[shadowed].IsTypedef;
+    iter->second = mBindings.size();
+  }
+  if (wasTypedef != isTypedef) {
+    ++mGeneration;
+  }
+  mBindings.push_back(Binding{name, shadowed, depth, isTypedef});
+}
+
+bool Parser::Scope::isTypedefInScope(std::string_view name) const {
+  if (const Binding *binding = lookup(name)) {
+    return binding->IsTypedef;
+  }
+  return mExternal && mExternal->LookupBinding(name).value_or(false);
+}
+
+bool Parser::Scope::checkIsTypedefInCurrentScope(std::string_view name) const {
+  const Binding *binding = lookup(name);
+  if (binding && binding->Depth == mScopeBegins.size())
+    return binding->IsTypedef;
+  /// the prefix is part of the file scope
+  if (!binding && mScopeBegins.empty() && mExternal)
+    return mExternal->LookupBinding(name).value_or(false);
+  return false;
 }
 
 void Parser::Scope::pushScope() {
-  mCurrentScope.emplace_back();
+  mScopeBegins.push_back(mBindings.size());
 }
 
 void Parser::Scope::popScope() {
-  mCurrentScope.pop_back();
+  unsigned begin = mScopeBegins.back();
+  mScopeBegins.pop_back();
+  while (mBindings.size() > begin) {
+    const Binding &binding = mBindings.back();
+    llvm::StringRef key(binding.Name.data(), binding.Name.size());
+    bool isTypedef;
+    if (binding.Shadowed == NoBinding) {
+      mInnermost.erase(key);
+      isTypedef = isTypedefOutside(binding.Name);
+    } else {
+      mInnermost[key] = binding.Shadowed;
+      isTypedef = mBindings[binding.Shadowed].IsTypedef;
+    }
+    if (isTypedef != binding.IsTypedef) {
+      ++mGeneration;
+    }
+    mBindings.pop_back();
+  }
+}
+
+std::optional<bool> Parser::Scope::isTypedefAt(std::string_view name,
+                                               unsigned size) const {
+  auto iter = mInnermost.find(llvm::StringRef(name.data(), name.size()));
+  if (iter != mInnermost.end() && iter->second < size) {
+    return mBindings[iter->second].IsTypedef;
+  }
+  return std::nullopt;
 }
 
+void Parser::Scope::truncate(unsigned size) {
+  assert(mScopeBegins.empty() && "only the file scope is truncated");
+  mScopeBegins.push_back(size);
+  popScope();
+}
+
+std::vector<std::pair<std::string_view, bool>>
+Parser::Scope::getFileScopeBindings() const {
+  std::vector<std::pair<std::string_view, bool>> bindings;
+  for (const auto &binding : mBindings) {
+    if (binding.Depth == 0) {
+      bindings.emplace_back(binding.Name, binding.IsTypedef);
+    }
+  }
+  return bindings;
+}
+
+
 void Parser::SkipTo(TokenBitSet recoveryToken, unsigned DiagID) {
-  if (mTokCursor == mTokEnd || recoveryToken[mTokCursor->getTokenKind()]) {
+  if (mTokCursor == mTokEnd || recoveryToken[CurKind()]) {
     return;
   }
   TokIter tok = mTokCursor;
@@ -2192,77 +2436,6 @@ void Parser::SkipTo(TokenBitSet recoveryToken, unsigned DiagID) {
   DiagReport(Diag, tok->getSMLoc(), DiagID);
 }
 
-std::string_view
-Parser::GetDeclaratorName(const Syntax::Declarator &declarator) {
-  return match_with_self(
-      declarator.getDirectDeclarator(),
-      [](auto &&, const box<DirectDeclaratorIdent> &name) -> std::string_view {
-        return name->getIdent();
-      },
-      [](auto &&self, const box<DirectDeclaratorParentheses> &declarator)
-          -> std::string_view {
-        return match(
-            declarator->getDeclarator().getDirectDeclarator(),
-            [&self](auto &&value) -> std::string_view { return self(value); });
-      },
-      [](auto &&self, const box<DirectDeclaratorParamTypeList> &paramTypeList)
-          -> std::string_view {
-        return match(
-            paramTypeList->getDirectDeclarator(),
-            [&self](auto &&value) -> std::string_view { return self(value); });
-      },
-      [](auto &&self, const box<DirectDeclaratorAssignExpr> &assignExpr)
-          -> std::string_view {
-        return match(
-            assignExpr->getDirectDeclarator(),
-            [&self](auto &&value) -> std::string_view { return self(value); });
-      },
-      [](auto &&self,
-         const box<DirectDeclaratorAsterisk> &asterisk) -> std::string_view {
-        return match(
-            asterisk->getDirectDeclarator(),
-            [&self](auto &&value) -> std::string_view { return self(value); });
-      });
-}
-
-const Syntax::DirectDeclaratorParamTypeList *
-Parser::GetFuncDeclarator(const Syntax::Declarator &declarator) {
-  const Syntax::DirectDeclaratorParamTypeList *paramTypeList_ = nullptr;
-  match_with_self(
-      declarator.getDirectDeclarator(),
-      [](auto &&, const box<Syntax::DirectDeclaratorIdent> &name)
-          -> std::string_view { return name->getIdent(); },
-      [](auto &&self,
-         const box<Syntax::DirectDeclaratorParentheses> &declarator)
-          -> std::string_view {
-        return match(
-            declarator->getDeclarator().getDirectDeclarator(),
-            [&self](auto &&value) -> std::string_view { return self(value); });
-      },
-      [&paramTypeList_](
-          auto &&self,
-          const box<Syntax::DirectDeclaratorParamTypeList> &paramTypeList)
-          -> std::string_view {
-        paramTypeList_ = paramTypeList.get();
-        return match(
-            paramTypeList->getDirectDeclarator(),
-            [&self](auto &&value) -> std::string_view { return self(value); });
-      },
-      [](auto &&self, const box<Syntax::DirectDeclaratorAssignExpr> &assignExpr)
-          -> std::string_view {
-        return match(
-            assignExpr->getDirectDeclarator(),
-            [&self](auto &&value) -> std::string_view { return self(value); });
-      },
-      [](auto &&self, const box<Syntax::DirectDeclaratorAsterisk> &asterisk)
-          -> std::string_view {
-        return match(
-            asterisk->getDirectDeclarator(),
-            [&self](auto &&value) -> std::string_view { return self(value); });
-      });
-  return paramTypeList_;
-}
-
 bool Parser::IsFirstInExternalDeclaration() const {
   return IsFirstInDeclaration() || IsFirstInFunctionDefinition();
 }
@@ -2273,66 +2446,17 @@ bool Parser::IsFirstInDeclaration() const {
   return IsFirstInDeclarationSpecifier();
 }
 bool Parser::IsFirstInDeclarationSpecifier() const {
-  switch (mTokCursor->getTokenKind()) {
-  case tok::kw_typedef:
-  case tok::kw_extern:
-  case tok::kw_static:
-  case tok::kw_auto:
-  case tok::kw_register:
-  case tok::kw_void:
-  case tok::kw_char:
-  case tok::kw_short:
-  case tok::kw_int:
-  case tok::kw_long:
-  case tok::kw_float:
-  case tok::kw__Bool:
-  case tok::kw_double:
-  case tok::kw_signed:
-  case tok::kw_unsigned:
-  case tok::kw_enum:
-  case tok::kw_struct:
-  case tok::kw_union:
-  case tok::kw_const:
-  case tok::kw_restrict:
-  case tok::kw_volatile:
-  case tok::kw_inline: return true;
-  case tok::identifier:
-    return mScope.isTypedefInScope(mTokCursor->getRepresentation());
-  default:
-    return false;
-  }
+  return AnnotatedFirstDeclSpec[GetAnnotatedKind()];
 }
 bool Parser::IsFirstInSpecifierQualifier() const {
-  switch (mTokCursor->getTokenKind()) {
-  case tok::kw_void:
-  case tok::kw_char:
-  case tok::kw_short:
-  case tok::kw_int:
-  case tok::kw_long:
-  case tok::kw_float:
-  case tok::kw__Bool:
-  case tok::kw_double:
-  case tok::kw_signed:
-  case tok::kw_unsigned:
-  case tok::kw_enum:
-  case tok::kw_struct:
-  case tok::kw_union:
-  case tok::kw_const:
-  case tok::kw_restrict:
-  case tok::kw_volatile:
-  case tok::kw_inline: return true;
-  case tok::identifier:
-    return mScope.isTypedefInScope(mTokCursor->getRepresentation());
-  default:
-    return false;
-  }
+  return AnnotatedFirstSpecQual[GetAnnotatedKind()];
 }
 bool Parser::IsFirstInDeclarator() const {
   return IsFirstInPointer() || IsFirstInDirectDeclarator();
 }
 bool Parser::IsFirstInDirectDeclarator() const {
-  return mTokCursor->getTokenKind() == tok::identifier ||
-         mTokCursor->getTokenKind() == tok::l_paren;
+  return CurKind() == tok::identifier ||
+         CurKind() == tok::l_paren;
 }
 bool Parser::IsFirstInParameterTypeList() const {
   return IsFirstInParameterList();
@@ -2342,44 +2466,30 @@ bool Parser::IsFirstInAbstractDeclarator() const {
 }
 bool Parser::IsFirstInDirectAbstractDeclarator() const {
   // tok::l_paren, tok::l_square
-  return mTokCursor->getTokenKind() == tok::l_paren ||
-         mTokCursor->getTokenKind() == tok::l_square;
+  return CurKind() == tok::l_paren ||
+         CurKind() == tok::l_square;
 }
 bool Parser::IsFirstInParameterList() const {
   return IsFirstInDeclarationSpecifier();
 }
 bool Parser::IsFirstInPointer() const {
-  return mTokCursor->getTokenKind() == tok::star;
+  return CurKind() == tok::star;
 }
 bool Parser::IsFirstInBlockItem() const {
-  return IsFirstInDeclaration() || IsFirstInStatement();
+  return AnnotatedFirstBlockItem[GetAnnotatedKind()];
 }
 bool Parser::IsFirstInInitializer() const {
-  return IsFirstInAssignmentExpr() || mTokCursor->getTokenKind() == tok::l_brace;
+  return IsFirstInAssignmentExpr() || CurKind() == tok::l_brace ||
+         CurKind() == tok::embed_data;
 }
 bool Parser::IsFirstInInitializerList() const {
   // tok::l_square, tok::period
-  return mTokCursor->getTokenKind() == tok::l_square ||
-         mTokCursor->getTokenKind() == tok::period ||
+  return CurKind() == tok::l_square ||
+         CurKind() == tok::period ||
          IsFirstInInitializer();
 }
 bool Parser::IsFirstInStatement() const {
-  return mTokCursor->getTokenKind() == tok::kw_if ||
-         mTokCursor->getTokenKind() == tok::kw_for ||
-         mTokCursor->getTokenKind() == tok::l_brace ||
-         mTokCursor->getTokenKind() == tok::kw_switch ||
-         mTokCursor->getTokenKind() == tok::kw_continue ||
-         mTokCursor->getTokenKind() == tok::kw_break ||
-         mTokCursor->getTokenKind() == tok::kw_case ||
-         mTokCursor->getTokenKind() == tok::kw_default ||
-         mTokCursor->getTokenKind() == tok::identifier ||
-         mTokCursor->getTokenKind() == tok::kw_do ||
-         mTokCursor->getTokenKind() == tok::kw_while ||
-         mTokCursor->getTokenKind() == tok::kw_return ||
-         mTokCursor->getTokenKind() == tok::kw_goto ||
-         mTokCursor->getTokenKind() == tok::semi ||
-         mTokCursor->getTokenKind() == tok::l_brace ||
-         IsFirstInExpr();
+  return AnnotatedFirstStmt[GetAnnotatedKind()];
 }
 bool Parser::IsFirstInExpr() const {
   return IsFirstInAssignmentExpr();
@@ -2420,33 +2530,23 @@ bool Parser::IsFirstInAdditiveExpr() const {
 bool Parser::IsFirstInMultiExpr() const {
  return IsFirstInCastExpr();
 }
-bool Parser::IsFirstInTypeName() const {
-  return IsFirstInSpecifierQualifier();
+bool Parser::IsFirstInTypeName(unsigned lookahead) const {
+  return AnnotatedFirstSpecQual[GetAnnotatedKind(lookahead)];
 }
 bool Parser::IsFirstInCastExpr() const {
-  return mTokCursor->getTokenKind() == tok::l_paren ||
-  IsFirstInUnaryExpr();
+  return AnnotatedFirstExpr[GetAnnotatedKind()];
 }
 bool Parser::IsFirstInUnaryExpr() const {
-  return IsFirstInPostFixExpr() ||
-         mTokCursor->getTokenKind() == tok::plus_plus ||
-         mTokCursor->getTokenKind() == tok::minus_minus ||
-         mTokCursor->getTokenKind() == tok::amp ||
-         mTokCursor->getTokenKind() == tok::star ||
-         mTokCursor->getTokenKind() == tok::plus ||
-         mTokCursor->getTokenKind() == tok::minus ||
-         mTokCursor->getTokenKind() == tok::tilde ||
-         mTokCursor->getTokenKind() == tok::exclaim ||
-         mTokCursor->getTokenKind() == tok::kw_sizeof;
+  return IsFirstInCastExpr();
 }
 bool Parser::IsFirstInPostFixExpr() const {
-  return mTokCursor->getTokenKind() == tok::l_paren || IsFirstInPrimaryExpr();
+  return IsFirstInPrimaryExpr();
 }
 bool Parser::IsFirstInPrimaryExpr() const {
-  return mTokCursor->getTokenKind() == tok::l_paren ||
-  mTokCursor->getTokenKind() == tok::identifier ||
-  mTokCursor->getTokenKind() == tok::char_constant ||
-  mTokCursor->getTokenKind() == tok::numeric_constant ||
-  mTokCursor->getTokenKind() == tok::string_literal;
+  return CurKind() == tok::l_paren ||
+  CurKind() == tok::identifier ||
+  CurKind() == tok::char_constant ||
+  CurKind() == tok::numeric_constant ||
+  CurKind() == tok::string_literal;
 }
 } // namespace lcc
\ No newline at end of file
@@ -0,0 +1,346 @@
+/***********************************
+ * File:     PPExpression.cc
+ *
+ * Author:   caipeng
+ *
+ * Email:    iiicp@outlook.com
+ *
+ * Date:     2023/6/10
+ *
+ * Sign:     enjoy life
+ ***********************************/
+
+#include "lcc/Preprocessor/Preprocessor.h"
+#include "lcc/Basic/IntegerValue.h"
+#include "llvm/ADT/StringExtras.h"
+
+namespace lcc {
+
+using namespace llvm;
+
+namespace {
+/// C99 6.10.1p4, every value of #if has the type intmax_t or uintmax_t
+using PPValue = IntegerValue;
+
+PPValue ToIntMax(IntegerValue value) {
+  return value.getWidth() == 64 ? value : value.convertTo(64, value.isUnsigned());
+}
+
+class PPExprEvaluator {
+  ArrayRef<PPToken> mTokens;
+  size_t mPos{0};
+  DiagnosticEngine &Diag;
+  const char *mLoc;
+  bool mHasError{false};
+
+public:
+  PPExprEvaluator(ArrayRef<PPToken> tokens, DiagnosticEngine &diag,
+                  const char *loc)
+      : mTokens(tokens), Diag(diag), mLoc(loc) {}
+
+  std::optional<PPValue> Evaluate() {
+    if (mTokens.empty()) {
+      DiagReport(Diag, SMLoc::getFromPointer(mLoc),
+                 diag::err_pp_expected_value_in_expr);
+      return std::nullopt;
+    }
+    PPValue value = ParseConditional(true);
+    if (!mHasError && mPos != mTokens.size()) {
+      Error(diag::err_pp_expr_bad_token);
+    }
+    if (mHasError) {
+      return std::nullopt;
+    }
+    return value;
+  }
+
+private:
+  [[nodiscard]] const char *CurLoc() const {
+    return mPos < mTokens.size() ? mTokens[mPos].Loc : mTokens.back().Loc;
+  }
+
+  [[nodiscard]] bool Peek(tok::TokenKind kind) const {
+    return mPos < mTokens.size() && mTokens[mPos].Kind == kind;
+  }
+
+  PPValue Error(unsigned diagID) {
+    if (!mHasError) {
+      DiagReport(Diag, SMLoc::getFromPointer(CurLoc()), diagID);
+    }
+    mHasError = true;
+    mPos = mTokens.size();
+    return {};
+  }
+
+  /// the precedence of a binary operator, 0 for any other token
+  static int GetPrecedence(tok::TokenKind kind, IntegerValue::BinaryOp &op) {
+    using BinaryOp = IntegerValue::BinaryOp;
+    switch (kind) {
+    case tok::star:
+      op = BinaryOp::Mul;
+      return 10;
+    case tok::slash:
+      op = BinaryOp::Div;
+      return 10;
+    case tok::percent:
+      op = BinaryOp::Rem;
+      return 10;
+    case tok::plus:
+      op = BinaryOp::Add;
+      return 9;
+    case tok::minus:
+      op = BinaryOp::Sub;
+      return 9;
+    case tok::less_less:
+      op = BinaryOp::Shl;
+      return 8;
+    case tok::greater_greater:
+      op = BinaryOp::Shr;
+      return 8;
+    case tok::less:
+      op = BinaryOp::Less;
+      return 7;
+    case tok::greater:
+      op = BinaryOp::Greater;
+      return 7;
+    case tok::less_equal:
+      op = BinaryOp::LessEqual;
+      return 7;
+    case tok::greater_equal:
+      op = BinaryOp::GreaterEqual;
+      return 7;
+    case tok::equal_equal:
+      op = BinaryOp::Equal;
+      return 6;
+    case tok::exclaim_equal:
+      op = BinaryOp::NotEqual;
+      return 6;
+    case tok::amp:
+      op = BinaryOp::BitAnd;
+      return 5;
+    case tok::caret:
+      op = BinaryOp::BitXor;
+      return 4;
+    case tok::pipe:
+      op = BinaryOp::BitOr;
+      return 3;
+    /// && and || short-circuit, they are not an IntegerValue operation
+    case tok::amp_amp:
+      return 2;
+    case tok::pipe_pipe:
+      return 1;
+    default:
+      return 0;
+    }
+  }
+
+  /// conditional-expression:
+  ///   logical-OR-expression
+  ///   logical-OR-expression ? expression : conditional-expression
+  PPValue ParseConditional(bool evaluate) {
+    PPValue cond = ParseBinary(1, evaluate);
+    if (!Peek(tok::question)) {
+      return cond;
+    }
+    ++mPos;
+    PPValue lhs = ParseConditional(evaluate && cond.isTrue());
+    if (!Peek(tok::colon)) {
+      return Error(diag::err_pp_expected_colon);
+    }
+    ++mPos;
+    PPValue rhs = ParseConditional(evaluate && !cond.isTrue());
+    /// C99 6.5.15p5, the usual arithmetic conversions apply to both arms
+    bool isUnsigned = lhs.isUnsigned() || rhs.isUnsigned();
+    return (cond.isTrue() ? lhs : rhs).convertTo(64, isUnsigned);
+  }
+
+  /// precedence climbing over the binary operators
+  PPValue ParseBinary(int minPrecedence, bool evaluate) {
+    PPValue lhs = ParseUnary(evaluate);
+    while (mPos < mTokens.size()) {
+      tok::TokenKind kind = mTokens[mPos].Kind;
+      IntegerValue::BinaryOp op{};
+      int precedence = GetPrecedence(kind, op);
+      if (precedence == 0 || precedence < minPrecedence) {
+        break;
+      }
+      const char *opLoc = mTokens[mPos].Loc;
+      ++mPos;
+      bool evaluateRhs = evaluate;
+      if ((kind == tok::amp_amp && !lhs.isTrue()) ||
+          (kind == tok::pipe_pipe && lhs.isTrue())) {
+        evaluateRhs = false;
+      }
+      PPValue rhs = ParseBinary(precedence + 1, evaluateRhs);
+      if (kind == tok::amp_amp) {
+        lhs = ToIntMax(PPValue::getBool(lhs.isTrue() && rhs.isTrue()));
+      } else if (kind == tok::pipe_pipe) {
+        lhs = ToIntMax(PPValue::getBool(lhs.isTrue() || rhs.isTrue()));
+      } else {
+        lhs = Apply(op, lhs, rhs, evaluate, opLoc);
+      }
+    }
+    return lhs;
+  }
+
+  PPValue Apply(IntegerValue::BinaryOp op, PPValue lhs, PPValue rhs,
+                bool evaluate, const char *opLoc) {
+    PPValue result;
+    auto status = PPValue::Apply(op, lhs, rhs, result);
+    /// an operand which isn't evaluated can't be wrong, `0 && 1 / 0`
+    if (evaluate && !mHasError) {
+      CheckStatus(status, opLoc);
+    }
+    return ToIntMax(result);
+  }
+
+  void CheckStatus(IntegerValue::Status status, const char *loc) {
+    switch (status) {
+    case IntegerValue::Status::Ok:
+      break;
+    case IntegerValue::Status::Overflow:
+      DiagReport(Diag, SMLoc::getFromPointer(loc),
+                 diag::warn_pp_integer_overflow);
+      break;
+    case IntegerValue::Status::ShiftOutOfRange:
+      DiagReport(Diag, SMLoc::getFromPointer(loc),
+                 diag::warn_pp_shift_count_out_of_range);
+      break;
+    case IntegerValue::Status::DivisionByZero:
+      DiagReport(Diag, SMLoc::getFromPointer(loc),
+                 diag::err_pp_division_by_zero);
+      mHasError = true;
+      mPos = mTokens.size();
+      break;
+    }
+  }
+
+  PPValue ParseUnary(bool evaluate) {
+    if (mPos >= mTokens.size()) {
+      return Error(diag::err_pp_expected_value_in_expr);
+    }
+    const PPToken &token = mTokens[mPos++];
+    switch (token.Kind) {
+    case tok::plus:
+      return ParseUnary(evaluate);
+    case tok::minus: {
+      PPValue value = ParseUnary(evaluate), result;
+      auto status = value.Negate(result);
+      if (evaluate && !mHasError) {
+        CheckStatus(status, token.Loc);
+      }
+      return result;
+    }
+    case tok::tilde:
+      return ParseUnary(evaluate).BitNot();
+    case tok::exclaim:
+      return ToIntMax(ParseUnary(evaluate).LogicalNot());
+    case tok::l_paren: {
+      PPValue value = ParseConditional(evaluate);
+      if (!Peek(tok::r_paren)) {
+        return Error(diag::err_pp_expected_rparen);
+      }
+      ++mPos;
+      return value;
+    }
+    case tok::pp_number:
+      return ParseNumber(token);
+    case tok::char_constant:
+      return ToIntMax(ParseCharConstant(token));
+    /// C99 6.10.1p3, identifiers left after macro expansion are replaced by 0
+    case tok::identifier:
+      return ToIntMax(PPValue::getInt(0));
+    default:
+      --mPos;
+      return Error(diag::err_pp_expr_bad_token);
+    }
+  }
+
+  PPValue ParseNumber(const PPToken &token) {
+    auto value = IntegerValue::ParseLiteral(token.Spelling);
+    if (!value) {
+      if (!mHasError) {
+        DiagReport(Diag, SMLoc::getFromPointer(token.Loc),
+                   diag::err_pp_invalid_number, token.Spelling);
+      }
+      mHasError = true;
+      mPos = mTokens.size();
+      return {};
+    }
+    return ToIntMax(*value);
+  }
+
+  /// an int holding a char, which is signed
+  static PPValue ParseCharConstant(const PPToken &token) {
+    std::string_view spelling = token.Spelling;
+    auto toInt = [](unsigned value) {
+      return PPValue::getInt(static_cast<signed char>(value));
+    };
+    if (spelling.empty()) {
+      return PPValue::getInt(0);
+    }
+    if (spelling[0] != '\\' || spelling.size() == 1) {
+      return toInt(static_cast<unsigned char>(spelling[0]));
+    }
+    char escape = spelling[1];
+    switch (escape) {
+    case 'n':
+      return toInt('\n');
+    case 't':
+      return toInt('\t');
+    case 'r':
+      return toInt('\r');
+    case 'a':
+      return toInt('\a');
+    case 'b':
+      return toInt('\b');
+    case 'f':
+      return toInt('\f');
+    case 'v':
+      return toInt('\v');
+    case 'x': {
+      unsigned value = 0;
+      for (char c : spelling.substr(2)) {
+        if (!isHexDigit(c)) {
+          break;
+        }
+        value = value * 16 + hexDigitValue(c);
+      }
+      return toInt(value);
+    }
+    default:
+      break;
+    }
+    if (escape < '0' || escape > '7') {
+      return toInt(static_cast<unsigned char>(escape));
+    }
+    unsigned value = 0;
+    for (char c : spelling.substr(1, 3)) {
+      if (c < '0' || c > '7') {
+        break;
+      }
+      value = value * 8 + (c - '0');
+    }
+    return toInt(value);
+  }
+};
+} // namespace
+
+bool Preprocessor::EvaluateDirectiveExpression(llvm::ArrayRef<PPToken> tokens,
+                                               const char *loc) {
+  PPExprEvaluator evaluator(tokens, Diag, loc);
+  auto value = evaluator.Evaluate();
+  return value && value->isTrue();
+}
+
+std::optional<uint64_t>
+Preprocessor::EvaluateDirectiveValue(llvm::ArrayRef<PPToken> tokens,
+                                     const char *loc) {
+  PPExprEvaluator evaluator(tokens, Diag, loc);
+  auto value = evaluator.Evaluate();
+  if (!value) {
+    return std::nullopt;
+  }
+  return value->getZExtValue();
+}
+} // namespace lcc
@@ -0,0 +1,1485 @@
+/***********************************
+ * File:     Preprocessor.cc
+ *
+ * Author:   caipeng
+ *
+ * Email:    iiicp@outlook.com
+ *
+ * Date:     2023/6/10
+ *
+ * Sign:     enjoy life
+ ***********************************/
+
+#include "lcc/Preprocessor/Preprocessor.h"
+#include "lcc/Basic/Util.h"
+#include "lcc/Serialization/PCH.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/Path.h"
+#include <algorithm>
+#include <functional>
+
+namespace lcc {
+
+using namespace llvm;
+
+/// C99 5.2.4.1 requires 15 nesting levels for #include, keep some margin but
+/// stop a recursive include before it eats the stack
+static constexpr size_t MaxIncludeDepth = 200;
+
+template <typename T>
+static ArrayRef<T> CopyToArena(BumpPtrAllocator &arena, ArrayRef<T> src) {
+  if (src.empty()) {
+    return {};
+  }
+  T *dst = arena.Allocate<T>(src.size());
+  std::uninitialized_copy(src.begin(), src.end(), dst);
+  return {dst, src.size()};
+}
+
+Preprocessor::Preprocessor(llvm::SourceMgr &mgr, DiagnosticEngine &diag,
+                           FileManager &fileMgr)
+    : mSrcMgr(mgr), Diag(diag), mFileMgr(fileMgr) {
+  DefineBuiltinMacro("__FILE__", MacroInfo::BuiltinKind::File);
+  DefineBuiltinMacro("__LINE__", MacroInfo::BuiltinKind::Line);
+  mPredefines = "#define __STDC__ 1\n"
+                "#define __STDC_VERSION__ 199901L\n"
+                "#define __STDC_HOSTED__ 1\n"
+                "#define __lcc__ 1\n"
+                "#define __STDC_EMBED_NOT_FOUND__ 0\n"
+                "#define __STDC_EMBED_FOUND__ 1\n"
+                "#define __STDC_EMBED_EMPTY__ 2\n";
+}
+
+void Preprocessor::AddIncludeDir(std::string_view dir, bool isSystem) {
+  if (isSystem) {
+    mSystemIncludeDirs.emplace_back(dir);
+  } else {
+    mIncludeDirs.emplace_back(dir);
+  }
+}
+
+void Preprocessor::AddMacroDefinition(std::string_view definition) {
+  auto pos = definition.find('=');
+  mPredefines += "#define ";
+  if (pos == std::string_view::npos) {
+    mPredefines += definition;
+    mPredefines += " 1\n";
+  } else {
+    mPredefines += definition.substr(0, pos);
+    mPredefines += ' ';
+    mPredefines += definition.substr(pos + 1);
+    mPredefines += '\n';
+  }
+}
+
+void Preprocessor::AddMacroUndef(std::string_view name) {
+  mPredefines += "#undef ";
+  mPredefines += name;
+  mPredefines += '\n';
+}
+
+void Preprocessor::UsePCH(const PCHReader &pch) {
+  mPCH = &pch;
+  mPCHFileID = mSrcMgr.AddNewSourceBuffer(
+      MemoryBuffer::getMemBuffer(pch.getText(), pch.getFileName(),
+                                 /*RequiresNullTerminator=*/false),
+      SMLoc());
+  /// the prefix is part of the translation unit for -MD
+  for (auto name : pch.getInputFiles()) {
+    if (auto file = mFileMgr.getFile(name)) {
+      AddIncludedFile(*file, false);
+    }
+  }
+}
+
+void Preprocessor::EnterMainFile(Lexer &lexer) {
+  auto file = mFileMgr.getFile(lexer.getBufferName());
+  if (file) {
+    mHeaderInfos[(*file)->getUniqueID()].IsEntered = true;
+    EnterFile(lexer, (*file)->getUniqueID());
+  } else {
+    EnterFile(lexer);
+  }
+  /// the predefines are a file of their own on top of main file, so they are
+  /// executed before the first line of main file
+  mOwnedLexers.push_back(std::make_unique<Lexer>(
+      mSrcMgr, Diag, std::string(mPredefines), "<built-in>"));
+  EnterFile(*mOwnedLexers.back());
+}
+
+std::optional<Token> Preprocessor::Lex() {
+  auto token = LexExpanded();
+  if (!token) {
+    return std::nullopt;
+  }
+  return ToToken(*token);
+}
+
+std::vector<Token> Preprocessor::Preprocess() {
+  std::vector<Token> results;
+  while (auto token = Lex()) {
+    results.push_back(std::move(*token));
+  }
+  results.shrink_to_fit();
+  return results;
+}
+
+void Preprocessor::ScanDependencies() {
+  while (!mFiles.empty()) {
+    FileContext &file = mFiles.back();
+    /// every directive consumes its line, so the lexer is always at the start
+    /// of a line here
+    if (!file.Lex->SkipToNextDirective(true)) {
+      ExitFile();
+      continue;
+    }
+    auto hash = file.Lex->Lex();
+    LCC_ASSERT(hash && hash->getTokenKind() == tok::pp_hash);
+    HandleDirective(ToPPToken(*hash));
+    /// the tokens of #embed aren't wanted
+    mContexts.clear();
+  }
+}
+
+const MacroInfo *Preprocessor::getMacroInfo(std::string_view name) const {
+  auto iter = mIdentifiers.find(name);
+  if (iter == mIdentifiers.end()) {
+    return nullptr;
+  }
+  return iter->second.Macro;
+}
+
+std::vector<const MacroInfo *> Preprocessor::getDefinedMacros() const {
+  std::vector<const MacroInfo *> macros;
+  for (const auto &entry : mIdentifiers) {
+    const MacroInfo *macro = entry.second.Macro;
+    if (macro && macro->getBuiltinKind() == MacroInfo::BuiltinKind::None) {
+      macros.push_back(macro);
+    }
+  }
+  llvm::sort(macros, [](const MacroInfo *lhs, const MacroInfo *rhs) {
+    return lhs->getName()->Name < rhs->getName()->Name;
+  });
+  return macros;
+}
+
+IdentifierInfo *Preprocessor::GetIdentifierInfo(std::string_view name) {
+  auto [iter, inserted] = mIdentifiers.try_emplace(name);
+  IdentifierInfo *ident = &iter->second;
+  if (inserted) {
+    ident->Name = iter->first();
+    /// a name new to this translation unit may be a macro of the prefix
+    if (mPCH) {
+      LoadMacroFromPCH(ident);
+    }
+  }
+  return ident;
+}
+
+void Preprocessor::LoadMacroFromPCH(IdentifierInfo *ident) {
+  auto record = mPCH->LookupMacro(ident->Name);
+  if (!record) {
+    return;
+  }
+  const char *text = mPCH->getText().data();
+  SmallVector<IdentifierInfo *, 8> params;
+  for (auto param : record->Params) {
+    params.push_back(GetIdentifierInfo(param));
+  }
+  /// the identifiers of the body are entered here, which loads the macros
+  /// they name as well. `ident` is in the table already, so a macro referring
+  /// to itself doesn't recurse
+  SmallVector<PPToken, 16> body;
+  for (const auto &token : record->Body) {
+    PPToken result;
+    result.Kind = token.Kind;
+    result.ArgNo = token.ArgNo;
+    result.FileID = mPCHFileID;
+    result.LeadingSpace = token.LeadingSpace;
+    result.Loc = text + token.Loc;
+    if (token.Kind == tok::identifier) {
+      result.Ident = GetIdentifierInfo(token.Spelling);
+      result.Spelling = result.Ident->Name;
+    } else {
+      result.Spelling = token.Spelling;
+    }
+    body.push_back(result);
+  }
+  ident->Macro = new (mArena.Allocate<MacroInfo>())
+      MacroInfo(ident, text + record->DefLoc,
+                CopyToArena<IdentifierInfo *>(mArena, params),
+                CopyToArena<PPToken>(mArena, body), record->FunctionLike,
+                record->Variadic);
+}
+
+PPToken Preprocessor::ToPPToken(const Token &token) {
+  PPToken result;
+  result.Kind = token.getTokenKind();
+  result.Loc = token.getOffset();
+  result.FileID = token.getFileID();
+  result.LeadingSpace = token.hasLeadingSpace();
+  switch (result.Kind) {
+  case tok::identifier: {
+    result.Ident = GetIdentifierInfo(token.getRepresentation());
+    result.Spelling = result.Ident->Name;
+    break;
+  }
+  /// the token starts at the opening quote and ends before the closing one
+  case tok::string_literal:
+  case tok::char_constant: {
+    result.Spelling = std::string_view(result.Loc + 1, token.getLength() - 1);
+    break;
+  }
+  case tok::pp_number: {
+    result.Spelling = std::string_view(result.Loc, token.getLength());
+    break;
+  }
+  case tok::pp_backslash: {
+    result.Spelling = "\\";
+    break;
+  }
+  default: {
+    const char *spelling = tok::getPunctuatorSpelling(result.Kind);
+    result.Spelling = spelling ? spelling : "";
+    break;
+  }
+  }
+  return result;
+}
+
+Token Preprocessor::ToToken(const PPToken &token) {
+  uint32_t length = token.Spelling.size();
+  if (token.Kind == tok::string_literal || token.Kind == tok::char_constant) {
+    length += 1;
+  }
+  /// the bytes of #embed stay in the buffer of the file manager, however big
+  /// the resource is it isn't copied
+  Token::ValueType value;
+  if (token.Kind == tok::embed_data) {
+    value = token.Spelling;
+  } else {
+    value = std::string(token.Spelling);
+  }
+  Token result(token.Kind, token.Loc, length, mSrcMgr, std::move(value));
+  result.setLeadingSpace(token.LeadingSpace);
+  result.setFileID(token.FileID);
+  return result;
+}
+
+std::string Preprocessor::GetFullSpelling(const PPToken &token) const {
+  if (token.Kind == tok::string_literal) {
+    return "\"" + std::string(token.Spelling) + "\"";
+  }
+  if (token.Kind == tok::char_constant) {
+    return "'" + std::string(token.Spelling) + "'";
+  }
+  return std::string(token.Spelling);
+}
+
+void Preprocessor::EnterFile(Lexer &lexer,
+                             std::optional<sys::fs::UniqueID> id,
+                             bool isSystem) {
+  FileContext file;
+  file.Lex = &lexer;
+  file.Dir = sys::path::parent_path(lexer.getBufferName()).str();
+  file.ID = id;
+  file.IsSystem = isSystem;
+  mFiles.push_back(std::move(file));
+  if (mCallbacks) {
+    mCallbacks->FileChanged(lexer.getBufferID(), lexer.getPosition(),
+                            PPCallbacks::EnterFile);
+  }
+}
+
+void Preprocessor::ExitFile() {
+  FileContext &file = mFiles.back();
+  for (const auto &cond : file.Conds) {
+    DiagReport(Diag, SMLoc::getFromPointer(cond.IfLoc),
+               diag::err_pp_unterminated_conditional);
+  }
+  if (file.ID) {
+    if (auto *macro = file.MIOpt.GetControllingMacroAtEndOfFile()) {
+      mHeaderInfos[*file.ID].ControllingMacro = macro;
+    }
+  }
+  mFiles.pop_back();
+  if (mCallbacks && !mFiles.empty()) {
+    const Lexer &lexer = *mFiles.back().Lex;
+    mCallbacks->FileChanged(lexer.getBufferID(), lexer.getPosition(),
+                            PPCallbacks::ExitFile);
+  }
+}
+
+void Preprocessor::DefineBuiltinMacro(std::string_view name,
+                                      MacroInfo::BuiltinKind kind) {
+  IdentifierInfo *ident = GetIdentifierInfo(name);
+  ident->Macro = new (mArena.Allocate<MacroInfo>())
+      MacroInfo(ident, nullptr, {}, {}, false, false, kind);
+}
+
+std::optional<PPToken> Preprocessor::LexRaw() {
+  if (!mPushback.empty()) {
+    PPToken token = mPushback.back();
+    mPushback.pop_back();
+    return token;
+  }
+  while (!mContexts.empty()) {
+    MacroContext &context = mContexts.back();
+    if (context.Pos < context.Tokens.size()) {
+      PPToken token = context.Tokens[context.Pos];
+      if (context.Pos == 0 && context.FirstLeadingSpace) {
+        token.LeadingSpace = *context.FirstLeadingSpace;
+      }
+      context.Pos++;
+      if (context.HS) {
+        token.HS = token.HS ? HideSetUnion(token.HS, context.HS) : context.HS;
+      }
+      return token;
+    }
+    if (context.IsBarrier) {
+      return std::nullopt;
+    }
+    mContexts.pop_back();
+  }
+  return LexFromFile();
+}
+
+std::optional<PPToken> Preprocessor::LexFromFile() {
+  while (!mFiles.empty()) {
+    FileContext &file = mFiles.back();
+    auto token = file.Lex->Lex();
+    if (!token) {
+      ExitFile();
+      continue;
+    }
+    if (token->getTokenKind() == tok::pp_newline) {
+      file.AtLineStart = true;
+      continue;
+    }
+    if (token->getTokenKind() == tok::pp_hash && file.AtLineStart) {
+      HandleDirective(ToPPToken(*token));
+      /// #embed has pushed its tokens
+      if (!mContexts.empty()) {
+        return LexRaw();
+      }
+      continue;
+    }
+    file.AtLineStart = false;
+    file.MIOpt.ReadTokenOrDirective();
+    return ToPPToken(*token);
+  }
+  return std::nullopt;
+}
+
+std::optional<PPToken> Preprocessor::LexExpanded() {
+  while (auto token = LexRaw()) {
+    if (token->Kind != tok::identifier || !token->Ident->Macro) {
+      return token;
+    }
+    MacroInfo *macro = token->Ident->Macro;
+    if (HideSetContains(token->HS, macro)) {
+      return token;
+    }
+    if (mContexts.empty()) {
+      mExpansionLoc = token->Loc;
+      mExpansionStartLoc = token->Loc;
+      mExpansionStartFileID = token->FileID;
+    }
+    if (!EnterMacro(*token, macro)) {
+      return token;
+    }
+  }
+  return std::nullopt;
+}
+
+/// directives
+
+void Preprocessor::HandleDirective(const PPToken &hash) {
+  FileContext &file = mFiles.back();
+  auto name = file.Lex->Lex();
+  /// null directive
+  if (!name || name->getTokenKind() == tok::pp_newline) {
+    file.AtLineStart = true;
+    return;
+  }
+  PPToken directive = ToPPToken(*name);
+  /// the conditional directives tell the include guard detector themselves
+  if (directive.Kind != tok::identifier ||
+      (directive.Spelling != "if" && directive.Spelling != "ifndef" &&
+       directive.Spelling != "elif" && directive.Spelling != "else" &&
+       directive.Spelling != "endif")) {
+    file.MIOpt.ReadTokenOrDirective();
+  }
+  /// # 33 "file.c", line marker written by other preprocessors
+  if (directive.Kind == tok::pp_number) {
+    SkipLine();
+    return;
+  }
+  if (directive.Kind != tok::identifier) {
+    DiagReport(Diag, SMLoc::getFromPointer(directive.Loc),
+               diag::err_pp_invalid_directive);
+    SkipLine();
+    return;
+  }
+  std::string_view spelling = directive.Spelling;
+  if (spelling == "define") {
+    HandleDefine(directive);
+  } else if (spelling == "undef") {
+    HandleUndef(directive);
+  } else if (spelling == "include") {
+    HandleInclude(directive);
+  } else if (spelling == "embed") {
+    HandleEmbed(directive);
+  } else if (spelling == "if") {
+    HandleIf(directive);
+  } else if (spelling == "ifdef") {
+    HandleIfdef(directive, false);
+  } else if (spelling == "ifndef") {
+    HandleIfdef(directive, true);
+  } else if (spelling == "elif") {
+    HandleElse(directive, true);
+  } else if (spelling == "else") {
+    HandleElse(directive, false);
+  } else if (spelling == "endif") {
+    HandleEndif(directive);
+  } else if (spelling == "error") {
+    HandleDiagnosticDirective(directive, true);
+  } else if (spelling == "warning") {
+    HandleDiagnosticDirective(directive, false);
+  } else if (spelling == "pragma") {
+    HandlePragma(directive);
+  } else if (spelling == "line") {
+    SkipLine();
+  } else {
+    DiagReport(Diag, SMLoc::getFromPointer(directive.Loc),
+               diag::err_pp_invalid_directive);
+    SkipLine();
+  }
+}
+
+std::vector<PPToken> Preprocessor::ReadDirectiveLine() {
+  FileContext &file = mFiles.back();
+  std::vector<PPToken> tokens;
+  while (auto token = file.Lex->Lex()) {
+    if (token->getTokenKind() == tok::pp_newline) {
+      break;
+    }
+    tokens.push_back(ToPPToken(*token));
+  }
+  file.AtLineStart = true;
+  return tokens;
+}
+
+void Preprocessor::SkipLine() {
+  FileContext &file = mFiles.back();
+  while (auto token = file.Lex->Lex()) {
+    if (token->getTokenKind() == tok::pp_newline) {
+      break;
+    }
+  }
+  file.AtLineStart = true;
+}
+
+void Preprocessor::HandleDefine(const PPToken &directive) {
+  auto line = ReadDirectiveLine();
+  if (line.empty() || line[0].Kind != tok::identifier ||
+      line[0].Spelling == "defined") {
+    DiagReport(Diag,
+               SMLoc::getFromPointer(line.empty() ? directive.Loc
+                                                  : line[0].Loc),
+               diag::err_pp_expected_macro_name);
+    return;
+  }
+  IdentifierInfo *name = line[0].Ident;
+  size_t i = 1;
+  bool functionLike = false, variadic = false;
+  SmallVector<IdentifierInfo *, 8> params;
+  /// the '(' of a function like macro must follow the name immediately
+  if (i < line.size() && line[i].Kind == tok::l_paren &&
+      !line[i].LeadingSpace) {
+    functionLike = true;
+    ++i;
+    if (i < line.size() && line[i].Kind == tok::r_paren) {
+      ++i;
+    } else {
+      while (true) {
+        if (i >= line.size()) {
+          DiagReport(Diag, SMLoc::getFromPointer(line.back().Loc),
+                     diag::err_pp_expected_rparen_in_macro_params);
+          return;
+        }
+        if (line[i].Kind == tok::ellipsis) {
+          variadic = true;
+          params.push_back(GetIdentifierInfo("__VA_ARGS__"));
+          if (++i >= line.size() || line[i].Kind != tok::r_paren) {
+            DiagReport(Diag, SMLoc::getFromPointer(line[i - 1].Loc),
+                       diag::err_pp_expected_rparen_in_macro_params);
+            return;
+          }
+          ++i;
+          break;
+        }
+        if (line[i].Kind != tok::identifier) {
+          DiagReport(Diag, SMLoc::getFromPointer(line[i].Loc),
+                     diag::err_pp_invalid_macro_param);
+          return;
+        }
+        if (is_contained(params, line[i].Ident)) {
+          DiagReport(Diag, SMLoc::getFromPointer(line[i].Loc),
+                     diag::err_pp_duplicate_macro_param, line[i].Spelling);
+          return;
+        }
+        params.push_back(line[i].Ident);
+        ++i;
+        if (i < line.size() && line[i].Kind == tok::comma) {
+          ++i;
+          continue;
+        }
+        if (i < line.size() && line[i].Kind == tok::r_paren) {
+          ++i;
+          break;
+        }
+        DiagReport(Diag,
+                   SMLoc::getFromPointer(i < line.size() ? line[i].Loc
+                                                         : line[i - 1].Loc),
+                   diag::err_pp_expected_rparen_in_macro_params);
+        return;
+      }
+    }
+  }
+
+  MutableArrayRef<PPToken> body(line.data() + i, line.size() - i);
+  if (!body.empty()) {
+    body.front().LeadingSpace = false;
+  }
+  if (functionLike) {
+    for (auto &token : body) {
+      if (token.Kind != tok::identifier) {
+        continue;
+      }
+      const auto *iter = llvm::find(params, token.Ident);
+      if (iter != params.end()) {
+        token.ArgNo = iter - params.begin() + 1;
+      }
+    }
+    for (size_t j = 0; j < body.size(); ++j) {
+      if (body[j].Kind == tok::pp_hash &&
+          (j + 1 == body.size() || !body[j + 1].ArgNo)) {
+        DiagReport(Diag, SMLoc::getFromPointer(body[j].Loc),
+                   diag::err_pp_stringize_not_param);
+        return;
+      }
+    }
+  }
+  if (!body.empty() && (body.front().Kind == tok::pp_hashhash ||
+                        body.back().Kind == tok::pp_hashhash)) {
+    const PPToken &edge =
+        body.front().Kind == tok::pp_hashhash ? body.front() : body.back();
+    DiagReport(Diag, SMLoc::getFromPointer(edge.Loc),
+               diag::err_pp_hashhash_at_edge);
+    return;
+  }
+
+  auto *macro = new (mArena.Allocate<MacroInfo>())
+      MacroInfo(name, line[0].Loc,
+                CopyToArena<IdentifierInfo *>(mArena, params),
+                CopyToArena<PPToken>(mArena, body), functionLike, variadic);
+  if (name->Macro && !name->Macro->isIdenticalTo(*macro)) {
+    DiagReport(Diag, SMLoc::getFromPointer(line[0].Loc),
+               diag::warn_pp_macro_redefined, name->Name);
+  }
+  name->Macro = macro;
+}
+
+void Preprocessor::HandleUndef(const PPToken &directive) {
+  auto line = ReadDirectiveLine();
+  if (line.empty() || line[0].Kind != tok::identifier) {
+    DiagReport(Diag,
+               SMLoc::getFromPointer(line.empty() ? directive.Loc
+                                                  : line[0].Loc),
+               diag::err_pp_expected_macro_name);
+    return;
+  }
+  if (line.size() > 1) {
+    DiagReport(Diag, SMLoc::getFromPointer(line[1].Loc),
+               diag::warn_pp_extra_tokens, directive.Spelling);
+  }
+  line[0].Ident->Macro = nullptr;
+}
+
+bool Preprocessor::ReadHeaderName(llvm::ArrayRef<PPToken> tokens,
+                                  std::string &fileName, bool &isAngled,
+                                  std::vector<PPToken> &rest) {
+  fileName.clear();
+  isAngled = false;
+  /// the lexer turns "..." and <...> after #include into one string literal
+  if (!tokens.empty() && tokens[0].Kind == tok::string_literal) {
+    isAngled = *tokens[0].Loc == '<';
+    fileName = tokens[0].Spelling;
+    rest.assign(tokens.begin() + 1, tokens.end());
+    return !fileName.empty();
+  }
+  /// #include pp-tokens, C99 6.10.2p4
+  auto expanded = ExpandTokens(tokens);
+  size_t end = 0;
+  if (!expanded.empty() && expanded[0].Kind == tok::string_literal) {
+    fileName = expanded[0].Spelling;
+    end = 1;
+  } else if (!expanded.empty() && expanded[0].Kind == tok::less) {
+    isAngled = true;
+    size_t i = 1;
+    for (; i < expanded.size() && expanded[i].Kind != tok::greater; ++i) {
+      if (i > 1 && expanded[i].LeadingSpace) {
+        fileName += ' ';
+      }
+      fileName += GetFullSpelling(expanded[i]);
+    }
+    if (i == expanded.size()) {
+      fileName.clear();
+    }
+    end = i + 1;
+  }
+  if (fileName.empty()) {
+    return false;
+  }
+  rest.assign(expanded.begin() + end, expanded.end());
+  return true;
+}
+
+void Preprocessor::AddIncludedFile(const FileEntry *file, bool isSystem) {
+  if (mIncludedFileSet.insert(file).second) {
+    mIncludedFiles.push_back({file, isSystem});
+  }
+}
+
+void Preprocessor::HandleInclude(const PPToken &directive) {
+  auto line = ReadDirectiveLine();
+  std::string fileName;
+  bool isAngled = false;
+  std::vector<PPToken> rest;
+  if (!ReadHeaderName(line, fileName, isAngled, rest)) {
+    DiagReport(Diag, SMLoc::getFromPointer(directive.Loc),
+               diag::err_pp_expected_include_filename);
+    return;
+  }
+
+  bool isSystem = false;
+  const FileEntry *file = LookupIncludeFile(fileName, isAngled, isSystem);
+  if (!file) {
+    DiagReport(Diag, SMLoc::getFromPointer(directive.Loc),
+               diag::err_pp_file_not_found, fileName);
+    return;
+  }
+  /// multiple include optimization, the file is neither read nor lexed again
+  HeaderFileInfo &info = mHeaderInfos[file->getUniqueID()];
+  if (info.canSkip()) {
+    ++mNumSkippedIncludes;
+    return;
+  }
+  if (mFiles.size() >= MaxIncludeDepth) {
+    DiagReport(Diag, SMLoc::getFromPointer(directive.Loc),
+               diag::err_pp_include_too_deep);
+    return;
+  }
+  auto buffer = file->getBuffer();
+  if (!buffer) {
+    DiagReport(Diag, SMLoc::getFromPointer(directive.Loc),
+               diag::err_pp_file_not_found, fileName);
+    return;
+  }
+  AddIncludedFile(file, isSystem);
+  info.IsEntered = true;
+  mOwnedLexers.push_back(std::make_unique<Lexer>(mSrcMgr, Diag, **buffer));
+  EnterFile(*mOwnedLexers.back(), file->getUniqueID(), isSystem);
+}
+
+void Preprocessor::HandleEmbed(const PPToken &directive) {
+  auto line = ReadDirectiveLine();
+  std::string fileName;
+  bool isAngled = false;
+  std::vector<PPToken> rest;
+  if (!ReadHeaderName(line, fileName, isAngled, rest)) {
+    DiagReport(Diag, SMLoc::getFromPointer(directive.Loc),
+               diag::err_pp_expected_include_filename);
+    return;
+  }
+  EmbedParams params;
+  if (!ParseEmbedParams(rest, params, true)) {
+    return;
+  }
+  auto bytes = LookupEmbed(fileName, isAngled, params);
+  if (!bytes) {
+    DiagReport(Diag, SMLoc::getFromPointer(directive.Loc),
+               diag::err_pp_file_not_found, fileName);
+    return;
+  }
+
+  if (mContexts.empty()) {
+    mExpansionStartLoc = directive.Loc;
+    mExpansionStartFileID = directive.FileID;
+  }
+  /// the whole resource is one token whatever its size, the parser turns it
+  /// into a single initializer
+  auto &context = mContexts.emplace_back();
+  if (bytes->empty()) {
+    context.Storage = std::move(params.IfEmpty);
+  } else {
+    context.Storage = std::move(params.Prefix);
+    PPToken data;
+    data.Kind = tok::embed_data;
+    data.Loc = directive.Loc;
+    data.FileID = directive.FileID;
+    data.LeadingSpace = true;
+    data.Spelling = *bytes;
+    context.Storage.push_back(data);
+    context.Storage.insert(context.Storage.end(), params.Suffix.begin(),
+                           params.Suffix.end());
+  }
+  context.Tokens = context.Storage;
+}
+
+bool Preprocessor::ParseEmbedParams(llvm::ArrayRef<PPToken> tokens,
+                                    EmbedParams &params, bool report) {
+  size_t i = 0;
+  while (i < tokens.size()) {
+    const PPToken &name = tokens[i];
+    std::string_view spelling = name.Spelling;
+    /// __limit__ is the same as limit
+    if (spelling.size() > 4 && spelling.substr(0, 2) == "__" &&
+        spelling.substr(spelling.size() - 2) == "__") {
+      spelling = spelling.substr(2, spelling.size() - 4);
+    }
+    if (name.Kind != tok::identifier ||
+        (spelling != "limit" && spelling != "prefix" &&
+         spelling != "suffix" && spelling != "if_empty")) {
+      if (report) {
+        DiagReport(Diag, SMLoc::getFromPointer(name.Loc),
+                   diag::err_pp_unknown_embed_param, GetFullSpelling(name));
+      }
+      return false;
+    }
+    /// the argument is a balanced token sequence in parentheses
+    size_t close = i + 1;
+    if (close < tokens.size() && tokens[close].Kind == tok::l_paren) {
+      unsigned depth = 0;
+      for (; close < tokens.size(); ++close) {
+        if (tokens[close].Kind == tok::l_paren) {
+          ++depth;
+        } else if (tokens[close].Kind == tok::r_paren && --depth == 0) {
+          break;
+        }
+      }
+    }
+    if (close >= tokens.size() || tokens[close].Kind != tok::r_paren) {
+      if (report) {
+        DiagReport(Diag, SMLoc::getFromPointer(name.Loc),
+                   diag::err_pp_expected_embed_param_paren, spelling);
+      }
+      return false;
+    }
+    auto argument = tokens.slice(i + 2, close - i - 2);
+    if (spelling == "limit") {
+      mExpansionLoc = name.Loc;
+      auto value = EvaluateDirectiveValue(ExpandTokens(argument), name.Loc);
+      if (!value) {
+        return false;
+      }
+      params.Limit = *value;
+    } else if (spelling == "prefix") {
+      params.Prefix.assign(argument.begin(), argument.end());
+    } else if (spelling == "suffix") {
+      params.Suffix.assign(argument.begin(), argument.end());
+    } else {
+      params.IfEmpty.assign(argument.begin(), argument.end());
+    }
+    i = close + 1;
+  }
+  return true;
+}
+
+std::optional<std::string_view>
+Preprocessor::LookupEmbed(std::string_view fileName, bool isAngled,
+                          const EmbedParams &params) {
+  bool isSystem = false;
+  const FileEntry *file = LookupIncludeFile(fileName, isAngled, isSystem);
+  if (!file) {
+    return std::nullopt;
+  }
+  /// the raw bytes, binary data mustn't lose a BOM or a '\r'
+  auto buffer = file->getRawBuffer();
+  if (!buffer) {
+    return std::nullopt;
+  }
+  AddIncludedFile(file, isSystem);
+  std::string_view bytes((*buffer)->getBufferStart(),
+                         (*buffer)->getBufferSize());
+  if (params.Limit && *params.Limit < bytes.size()) {
+    bytes = bytes.substr(0, *params.Limit);
+  }
+  return bytes;
+}
+
+int Preprocessor::EvaluateHasEmbed(llvm::ArrayRef<PPToken> tokens) {
+  std::string fileName;
+  bool isAngled = false;
+  std::vector<PPToken> rest;
+  EmbedParams params;
+  if (!ReadHeaderName(tokens, fileName, isAngled, rest) ||
+      !ParseEmbedParams(rest, params, false)) {
+    return 0;
+  }
+  auto bytes = LookupEmbed(fileName, isAngled, params);
+  if (!bytes) {
+    return 0;
+  }
+  return bytes->empty() ? 2 : 1;
+}
+
+const FileEntry *Preprocessor::LookupIncludeFile(std::string_view fileName,
+                                                 bool isAngled,
+                                                 bool &isSystem) const {
+  /// a file included by a system header is a system header too
+  isSystem = !mFiles.empty() && mFiles.back().IsSystem;
+  /// the file manager remembers misses too, a search path which doesn't have
+  /// the header costs one stat per process instead of one per #include
+  auto getFile = [this](StringRef path) -> const FileEntry * {
+    auto file = mFileMgr.getFile(path);
+    return file ? *file : nullptr;
+  };
+  if (sys::path::is_absolute(fileName)) {
+    return getFile(fileName);
+  }
+  SmallString<256> path;
+  /// "..." searches the directory of the current file first
+  if (!isAngled && !mFiles.empty()) {
+    path = mFiles.back().Dir;
+    sys::path::append(path, fileName);
+    if (const FileEntry *file = getFile(path)) {
+      return file;
+    }
+  }
+  for (const auto &dir : mIncludeDirs) {
+    path = dir;
+    sys::path::append(path, fileName);
+    if (const FileEntry *file = getFile(path)) {
+      return file;
+    }
+  }
+  for (const auto &dir : mSystemIncludeDirs) {
+    path = dir;
+    sys::path::append(path, fileName);
+    if (const FileEntry *file = getFile(path)) {
+      isSystem = true;
+      return file;
+    }
+  }
+  return nullptr;
+}
+
+void Preprocessor::HandleIf(const PPToken &directive) {
+  auto line = ReadDirectiveLine();
+  FileContext &file = mFiles.back();
+  /// #if !defined X or #if !defined(X) may start an include guard
+  bool isGuard = false;
+  if (file.Conds.empty() && file.MIOpt.isAtStart() && line.size() >= 3 &&
+      line[0].Kind == tok::exclaim && line[1].Kind == tok::identifier &&
+      line[1].Spelling == "defined") {
+    if (line.size() == 3 && line[2].Kind == tok::identifier) {
+      file.MIOpt.EnterGuard(line[2].Ident);
+      isGuard = true;
+    } else if (line.size() == 5 && line[2].Kind == tok::l_paren &&
+               line[3].Kind == tok::identifier &&
+               line[4].Kind == tok::r_paren) {
+      file.MIOpt.EnterGuard(line[3].Ident);
+      isGuard = true;
+    }
+  }
+  if (!isGuard) {
+    file.MIOpt.ReadTokenOrDirective();
+  }
+  bool value = EvaluateCondition(directive, line);
+  mFiles.back().Conds.push_back({directive.Loc, value, false});
+  if (!value) {
+    SkipExcludedBlock();
+  }
+}
+
+void Preprocessor::HandleIfdef(const PPToken &directive, bool isIfndef) {
+  auto line = ReadDirectiveLine();
+  bool value = false;
+  if (line.empty() || line[0].Kind != tok::identifier) {
+    DiagReport(Diag,
+               SMLoc::getFromPointer(line.empty() ? directive.Loc
+                                                  : line[0].Loc),
+               diag::err_pp_expected_macro_name);
+  } else {
+    value = (line[0].Ident->Macro != nullptr) != isIfndef;
+    if (line.size() > 1) {
+      DiagReport(Diag, SMLoc::getFromPointer(line[1].Loc),
+                 diag::warn_pp_extra_tokens, directive.Spelling);
+    }
+  }
+  FileContext &file = mFiles.back();
+  if (isIfndef && file.Conds.empty() && file.MIOpt.isAtStart() &&
+      line.size() == 1 && line[0].Kind == tok::identifier) {
+    file.MIOpt.EnterGuard(line[0].Ident);
+  } else {
+    file.MIOpt.ReadTokenOrDirective();
+  }
+  file.Conds.push_back({directive.Loc, value, false});
+  if (!value) {
+    SkipExcludedBlock();
+  }
+}
+
+void Preprocessor::HandleElse(const PPToken &directive, bool isElif) {
+  auto &conds = mFiles.back().Conds;
+  if (conds.empty()) {
+    DiagReport(Diag, SMLoc::getFromPointer(directive.Loc),
+               diag::err_pp_else_without_if, directive.Spelling);
+    SkipLine();
+    return;
+  }
+  auto &cond = conds.back();
+  if (cond.SeenElse) {
+    DiagReport(Diag, SMLoc::getFromPointer(directive.Loc),
+               diag::err_pp_else_after_else, directive.Spelling);
+  }
+  /// an include guard never has another group
+  if (conds.size() == 1) {
+    mFiles.back().MIOpt.Invalidate();
+  }
+  cond.SeenElse |= !isElif;
+  SkipLine();
+  /// the group before is the one taken, skip the rest of the conditional
+  SkipExcludedBlock();
+}
+
+void Preprocessor::HandleEndif(const PPToken &directive) {
+  auto &conds = mFiles.back().Conds;
+  if (conds.empty()) {
+    DiagReport(Diag, SMLoc::getFromPointer(directive.Loc),
+               diag::err_pp_else_without_if, directive.Spelling);
+    mFiles.back().MIOpt.Invalidate();
+  } else {
+    conds.pop_back();
+    if (conds.empty()) {
+      mFiles.back().MIOpt.ExitTopLevelConditional();
+    }
+  }
+  SkipLine();
+}
+
+void Preprocessor::HandlePragma(const PPToken &directive) {
+  auto line = ReadDirectiveLine();
+  if (line.empty() || line[0].Kind != tok::identifier ||
+      line[0].Spelling != "once") {
+    /// unknown pragmas are ignored, C99 6.10.6p1
+    return;
+  }
+  if (line.size() > 1) {
+    DiagReport(Diag, SMLoc::getFromPointer(line[1].Loc),
+               diag::warn_pp_extra_tokens, "pragma once");
+  }
+  FileContext &file = mFiles.back();
+  if (file.ID) {
+    mHeaderInfos[*file.ID].IsPragmaOnce = true;
+  }
+}
+
+void Preprocessor::HandleDiagnosticDirective(const PPToken &directive,
+                                             bool isError) {
+  auto line = ReadDirectiveLine();
+  std::string message;
+  for (const auto &token : line) {
+    if (!message.empty() && token.LeadingSpace) {
+      message += ' ';
+    }
+    message += GetFullSpelling(token);
+  }
+  if (isError) {
+    DiagReport(Diag, SMLoc::getFromPointer(directive.Loc),
+               diag::err_pp_error_directive, message);
+  } else {
+    DiagReport(Diag, SMLoc::getFromPointer(directive.Loc),
+               diag::warn_pp_warning_directive, message);
+  }
+}
+
+void Preprocessor::SkipExcludedBlock() {
+  FileContext &file = mFiles.back();
+  unsigned depth = 0;
+  bool atLineStart = true;
+  /// only the first two tokens of a directive line are lexed, everything else
+  /// is skipped by the lexer's raw scanner
+  while (file.Lex->SkipToNextDirective(atLineStart)) {
+    auto hash = file.Lex->Lex();
+    LCC_ASSERT(hash && hash->getTokenKind() == tok::pp_hash);
+    auto name = file.Lex->Lex();
+    if (!name) {
+      break;
+    }
+    if (name->getTokenKind() == tok::pp_newline) {
+      atLineStart = true;
+      continue;
+    }
+    atLineStart = false;
+    if (name->getTokenKind() != tok::identifier) {
+      continue;
+    }
+    std::string_view spelling = name->getRepresentation();
+    if (spelling == "if" || spelling == "ifdef" || spelling == "ifndef") {
+      ++depth;
+      continue;
+    }
+    if (spelling == "endif") {
+      if (depth) {
+        --depth;
+        continue;
+      }
+      SkipLine();
+      file.Conds.pop_back();
+      if (file.Conds.empty()) {
+        file.MIOpt.ExitTopLevelConditional();
+      }
+      return;
+    }
+    if (depth || (spelling != "else" && spelling != "elif")) {
+      continue;
+    }
+    PPToken directive = ToPPToken(*name);
+    auto &cond = file.Conds.back();
+    if (file.Conds.size() == 1) {
+      file.MIOpt.Invalidate();
+    }
+    if (cond.SeenElse) {
+      DiagReport(Diag, SMLoc::getFromPointer(directive.Loc),
+                 diag::err_pp_else_after_else, directive.Spelling);
+    }
+    if (spelling == "else") {
+      cond.SeenElse = true;
+      SkipLine();
+      if (!cond.WasTaken) {
+        cond.WasTaken = true;
+        return;
+      }
+    } else if (!cond.WasTaken &&
+               EvaluateCondition(directive, ReadDirectiveLine())) {
+      cond.WasTaken = true;
+      return;
+    } else if (cond.WasTaken) {
+      SkipLine();
+    }
+    atLineStart = true;
+  }
+  /// the end of file, LexFromFile reports the unterminated conditional
+}
+
+bool Preprocessor::EvaluateCondition(const PPToken &directive,
+                                     llvm::ArrayRef<PPToken> line) {
+  /// `defined X` and `defined(X)` are replaced before macro expansion
+  std::vector<PPToken> tokens;
+  tokens.reserve(line.size());
+  for (size_t i = 0; i < line.size(); ++i) {
+    if (line[i].Kind == tok::identifier && line[i].Spelling == "__has_embed") {
+      size_t close = i + 1;
+      if (close < line.size() && line[close].Kind == tok::l_paren) {
+        unsigned depth = 0;
+        for (; close < line.size(); ++close) {
+          if (line[close].Kind == tok::l_paren) {
+            ++depth;
+          } else if (line[close].Kind == tok::r_paren && --depth == 0) {
+            break;
+          }
+        }
+      }
+      if (i + 1 >= line.size() || line[i + 1].Kind != tok::l_paren) {
+        DiagReport(Diag, SMLoc::getFromPointer(line[i].Loc),
+                   diag::err_pp_expected_lparen_after, line[i].Spelling);
+        return false;
+      }
+      if (close >= line.size()) {
+        DiagReport(Diag, SMLoc::getFromPointer(line[i + 1].Loc),
+                   diag::err_pp_expected_rparen);
+        return false;
+      }
+      int result = EvaluateHasEmbed(line.slice(i + 2, close - i - 2));
+      PPToken value = line[i];
+      value.Kind = tok::pp_number;
+      value.Ident = nullptr;
+      value.Spelling = result == 0 ? "0" : result == 1 ? "1" : "2";
+      tokens.push_back(value);
+      i = close;
+      continue;
+    }
+    if (line[i].Kind != tok::identifier || line[i].Spelling != "defined") {
+      tokens.push_back(line[i]);
+      continue;
+    }
+    size_t j = i + 1;
+    bool hasParen = j < line.size() && line[j].Kind == tok::l_paren;
+    if (hasParen) {
+      ++j;
+    }
+    if (j >= line.size() || line[j].Kind != tok::identifier) {
+      DiagReport(Diag, SMLoc::getFromPointer(line[i].Loc),
+                 diag::err_pp_defined_requires_identifier);
+      return false;
+    }
+    bool isDefined = line[j].Ident->Macro != nullptr;
+    if (hasParen) {
+      if (++j >= line.size() || line[j].Kind != tok::r_paren) {
+        DiagReport(Diag, SMLoc::getFromPointer(line[j - 1].Loc),
+                   diag::err_pp_expected_rparen);
+        return false;
+      }
+    }
+    PPToken value = line[i];
+    value.Kind = tok::pp_number;
+    value.Ident = nullptr;
+    value.Spelling = isDefined ? "1" : "0";
+    tokens.push_back(value);
+    i = j;
+  }
+  mExpansionLoc = directive.Loc;
+  auto expanded = ExpandTokens(tokens);
+  return EvaluateDirectiveExpression(expanded, directive.Loc);
+}
+
+/// macro expansion
+
+bool Preprocessor::EnterMacro(const PPToken &name, MacroInfo *macro) {
+  if (macro->getBuiltinKind() != MacroInfo::BuiltinKind::None) {
+    PPToken result = name;
+    result.Ident = nullptr;
+    result.HS = nullptr;
+    if (macro->getBuiltinKind() == MacroInfo::BuiltinKind::File) {
+      std::string fileName;
+      for (char c : mFiles.back().Lex->getBufferName()) {
+        if (c == '\\' || c == '"') {
+          fileName += '\\';
+        }
+        fileName += c;
+      }
+      result.Kind = tok::string_literal;
+      result.Spelling = mSaver.save(fileName);
+    } else {
+      auto line = mSrcMgr.getLineAndColumn(SMLoc::getFromPointer(mExpansionLoc));
+      result.Kind = tok::pp_number;
+      result.Spelling = mSaver.save(std::to_string(line.first));
+    }
+    auto &context = mContexts.emplace_back();
+    context.Storage.push_back(result);
+    context.Tokens = context.Storage;
+    return true;
+  }
+
+  if (!macro->isFunctionLike()) {
+    if (macro->getBody().empty()) {
+      return true;
+    }
+    if (macro->hasPaste()) {
+      auto tokens = SubstituteArgs(macro, {}, HideSetAdd(name.HS, macro));
+      if (tokens.empty()) {
+        return true;
+      }
+      tokens.front().LeadingSpace = name.LeadingSpace;
+      auto &context = mContexts.emplace_back();
+      context.Storage = std::move(tokens);
+      context.Tokens = context.Storage;
+      return true;
+    }
+    auto &context = mContexts.emplace_back();
+    context.Tokens = macro->getBody();
+    context.HS = HideSetAdd(name.HS, macro);
+    context.FirstLeadingSpace = name.LeadingSpace;
+    return true;
+  }
+
+  /// a function like macro name not followed by '(' is a plain identifier
+  auto next = LexRaw();
+  if (!next || next->Kind != tok::l_paren) {
+    if (next) {
+      mPushback.push_back(*next);
+    }
+    return false;
+  }
+
+  unsigned numParams = macro->getNumParams();
+  std::vector<std::vector<PPToken>> args(1);
+  std::optional<PPToken> rparen;
+  unsigned depth = 0;
+  while (auto token = LexRaw()) {
+    if (token->Kind == tok::l_paren) {
+      ++depth;
+    } else if (token->Kind == tok::r_paren) {
+      if (depth == 0) {
+        rparen = token;
+        break;
+      }
+      --depth;
+    } else if (token->Kind == tok::comma && depth == 0 &&
+               !(macro->isVariadic() && args.size() == numParams)) {
+      args.emplace_back();
+      continue;
+    }
+    args.back().push_back(*token);
+  }
+  if (!rparen) {
+    DiagReport(Diag, SMLoc::getFromPointer(name.Loc),
+               diag::err_pp_unterminated_macro_call);
+    return true;
+  }
+  if (numParams == 0 && args.size() == 1 && args[0].empty()) {
+    args.clear();
+  } else if (macro->isVariadic() && args.size() == numParams - 1) {
+    args.emplace_back();
+  }
+  if (args.size() != numParams) {
+    DiagReport(Diag, SMLoc::getFromPointer(name.Loc),
+               diag::err_pp_wrong_number_of_args, name.Spelling, numParams,
+               args.size());
+    return true;
+  }
+
+  const HideSet *hs =
+      HideSetAdd(HideSetIntersect(name.HS, rparen->HS), macro);
+  auto tokens = SubstituteArgs(macro, args, hs);
+  if (tokens.empty()) {
+    return true;
+  }
+  tokens.front().LeadingSpace = name.LeadingSpace;
+  auto &context = mContexts.emplace_back();
+  context.Storage = std::move(tokens);
+  context.Tokens = context.Storage;
+  return true;
+}
+
+std::vector<PPToken>
+Preprocessor::SubstituteArgs(const MacroInfo *macro,
+                             const std::vector<std::vector<PPToken>> &args,
+                             const HideSet *hs) {
+  auto body = macro->getBody();
+  std::vector<std::optional<std::vector<PPToken>>> expandedArgs(args.size());
+  std::vector<PPToken> results;
+  results.reserve(body.size());
+  /// the left operand of a following '##' was an empty argument
+  bool lastIsPlaceMarker = false;
+
+  auto appendArg = [&](llvm::ArrayRef<PPToken> arg, bool leadingSpace) {
+    size_t start = results.size();
+    results.insert(results.end(), arg.begin(), arg.end());
+    if (results.size() > start) {
+      results[start].LeadingSpace = leadingSpace;
+    }
+  };
+
+  for (size_t i = 0; i < body.size(); ++i) {
+    const PPToken &token = body[i];
+    bool nextIsPaste =
+        i + 1 < body.size() && body[i + 1].Kind == tok::pp_hashhash;
+    if (token.Kind == tok::pp_hash && macro->isFunctionLike()) {
+      const PPToken &param = body[++i];
+      results.push_back(Stringize(args[param.ArgNo - 1], token));
+      lastIsPlaceMarker = false;
+      continue;
+    }
+    if (token.Kind == tok::pp_hashhash) {
+      const PPToken &rhs = body[++i];
+      llvm::ArrayRef<PPToken> operand(rhs);
+      /// GNU extension, `, ## __VA_ARGS__` drops the comma when there are no
+      /// variable arguments and pastes nothing otherwise
+      bool isGNUComma = macro->isVariadic() &&
+                        rhs.ArgNo == macro->getNumParams() &&
+                        !lastIsPlaceMarker && !results.empty() &&
+                        results.back().Kind == tok::comma;
+      if (rhs.ArgNo) {
+        operand = args[rhs.ArgNo - 1];
+        if (operand.empty()) {
+          if (isGNUComma) {
+            results.pop_back();
+          }
+          continue;
+        }
+      }
+      if (lastIsPlaceMarker || results.empty() || isGNUComma) {
+        appendArg(operand, rhs.LeadingSpace);
+      } else if (auto pasted = Paste(results.back(), operand.front())) {
+        results.back() = *pasted;
+        appendArg(operand.drop_front(), operand.size() > 1 &&
+                                            operand[1].LeadingSpace);
+      } else {
+        appendArg(operand, false);
+      }
+      lastIsPlaceMarker = false;
+      continue;
+    }
+    if (token.ArgNo) {
+      const auto &arg = args[token.ArgNo - 1];
+      if (nextIsPaste) {
+        lastIsPlaceMarker = arg.empty();
+        appendArg(arg, token.LeadingSpace);
+        continue;
+      }
+      auto &expanded = expandedArgs[token.ArgNo - 1];
+      if (!expanded) {
+        expanded = ExpandTokens(arg);
+      }
+      appendArg(*expanded, token.LeadingSpace);
+      lastIsPlaceMarker = false;
+      continue;
+    }
+    results.push_back(token);
+    lastIsPlaceMarker = false;
+  }
+
+  for (auto &token : results) {
+    token.HS = token.HS ? HideSetUnion(token.HS, hs) : hs;
+  }
+  return results;
+}
+
+std::vector<PPToken> Preprocessor::ExpandTokens(llvm::ArrayRef<PPToken> tokens) {
+  bool needExpand = llvm::any_of(tokens, [](const PPToken &token) {
+    return token.Kind == tok::identifier && token.Ident->Macro &&
+           !HideSetContains(token.HS, token.Ident->Macro);
+  });
+  if (!needExpand) {
+    return {tokens.begin(), tokens.end()};
+  }
+
+  std::vector<PPToken> pushback;
+  std::swap(pushback, mPushback);
+  auto &barrier = mContexts.emplace_back();
+  barrier.Tokens = tokens;
+  barrier.IsBarrier = true;
+  size_t barrierDepth = mContexts.size();
+
+  std::vector<PPToken> results;
+  results.reserve(tokens.size());
+  while (auto token = LexExpanded()) {
+    results.push_back(*token);
+  }
+  LCC_ASSERT(mContexts.size() == barrierDepth && mContexts.back().IsBarrier);
+  mContexts.pop_back();
+  std::swap(pushback, mPushback);
+  return results;
+}
+
+PPToken Preprocessor::Stringize(llvm::ArrayRef<PPToken> arg,
+                                const PPToken &hash) {
+  std::string text;
+  for (size_t i = 0; i < arg.size(); ++i) {
+    if (i != 0 && arg[i].LeadingSpace) {
+      text += ' ';
+    }
+    if (arg[i].Kind == tok::string_literal ||
+        arg[i].Kind == tok::char_constant) {
+      for (char c : GetFullSpelling(arg[i])) {
+        if (c == '"' || c == '\\') {
+          text += '\\';
+        }
+        text += c;
+      }
+    } else {
+      text += arg[i].Spelling;
+    }
+  }
+  PPToken result;
+  result.Kind = tok::string_literal;
+  result.Loc = hash.Loc;
+  result.FileID = hash.FileID;
+  result.LeadingSpace = hash.LeadingSpace;
+  result.Spelling = mSaver.save(text);
+  return result;
+}
+
+std::optional<PPToken> Preprocessor::Paste(const PPToken &lhs,
+                                           const PPToken &rhs) {
+  std::string text = GetFullSpelling(lhs) + GetFullSpelling(rhs);
+  tok::TokenKind kind = Lexer::GetTokenKindOfSpelling(text);
+  if (kind == tok::unknown) {
+    DiagReport(Diag, SMLoc::getFromPointer(lhs.Loc),
+               diag::err_pp_invalid_paste, text);
+    return std::nullopt;
+  }
+  PPToken result;
+  result.Kind = kind;
+  result.Loc = lhs.Loc;
+  result.FileID = lhs.FileID;
+  result.LeadingSpace = lhs.LeadingSpace;
+  if (kind == tok::identifier) {
+    result.Ident = GetIdentifierInfo(text);
+    result.Spelling = result.Ident->Name;
+  } else if (kind == tok::pp_number) {
+    result.Spelling = mSaver.save(text);
+  } else {
+    result.Spelling = tok::getPunctuatorSpelling(kind);
+  }
+  return result;
+}
+
+/// hide set
+
+const HideSet *Preprocessor::GetHideSet(const MacroInfo *macro,
+                                        const HideSet *next) {
+  auto &slot = mHideSets[{macro, next}];
+  if (!slot) {
+    slot = new (mArena.Allocate<HideSet>()) HideSet{macro, next};
+  }
+  return slot;
+}
+
+const HideSet *Preprocessor::HideSetAdd(const HideSet *hs,
+                                        const MacroInfo *macro) {
+  if (!hs || std::less<const MacroInfo *>()(macro, hs->Macro)) {
+    return GetHideSet(macro, hs);
+  }
+  if (hs->Macro == macro) {
+    return hs;
+  }
+  return GetHideSet(hs->Macro, HideSetAdd(hs->Next, macro));
+}
+
+const HideSet *Preprocessor::HideSetUnion(const HideSet *lhs,
+                                          const HideSet *rhs) {
+  if (lhs == rhs || !rhs) {
+    return lhs;
+  }
+  for (; rhs; rhs = rhs->Next) {
+    lhs = HideSetAdd(lhs, rhs->Macro);
+  }
+  return lhs;
+}
+
+const HideSet *Preprocessor::HideSetIntersect(const HideSet *lhs,
+                                              const HideSet *rhs) {
+  if (lhs == rhs) {
+    return lhs;
+  }
+  if (!lhs || !rhs) {
+    return nullptr;
+  }
+  if (lhs->Macro == rhs->Macro) {
+    return GetHideSet(lhs->Macro, HideSetIntersect(lhs->Next, rhs->Next));
+  }
+  if (std::less<const MacroInfo *>()(lhs->Macro, rhs->Macro)) {
+    return HideSetIntersect(lhs->Next, rhs);
+  }
+  return HideSetIntersect(lhs, rhs->Next);
+}
+
+bool Preprocessor::HideSetContains(const HideSet *hs, const MacroInfo *macro) {
+  for (; hs; hs = hs->Next) {
+    if (hs->Macro == macro) {
+      return true;
+    }
+    if (std::less<const MacroInfo *>()(macro, hs->Macro)) {
+      return false;
+    }
+  }
+  return false;
+}
+} // namespace lcc
@@ -0,0 +1,263 @@
+/***********************************
+ * File:     PrintPreprocessed.cc
+ *
+ * Author:   caipeng
+ *
+ * Email:    iiicp@outlook.com
+ *
+ * Date:     2023/6/15
+ *
+ * Sign:     enjoy life
+ ***********************************/
+
+#include "lcc/Preprocessor/Preprocessor.h"
+#include "lcc/Basic/Util.h"
+#include "llvm/ADT/StringExtras.h"
+#include <algorithm>
+
+namespace lcc {
+
+using namespace llvm;
+
+namespace {
+/// Writes the tokens of -E. A token is copied from where its spelling lives,
+/// the output line is kept in step with the source by counting the newlines
+/// between the locations of consecutive tokens, which reads every byte of the
+/// source once whatever the number of tokens. The line markers of #include
+/// are written when the preprocessor enters and leaves the files.
+class PPOutputPrinter : public PPCallbacks {
+private:
+  /// more blank lines than this are replaced by a line marker
+  static constexpr unsigned MaxBlankLines = 8;
+
+  SourceMgr &mSrcMgr;
+  raw_ostream &mOS;
+  /// where the output is
+  unsigned mFileID;
+  unsigned mLine;
+  const char *mLastLoc;
+  bool mAtLineStart{true};
+  /// the files entered since the main file, a file left before the main file
+  /// is the predefines
+  unsigned mIncludeDepth{0};
+  /// what the previous token on the line ends with, to tell whether the next
+  /// one can be written right after it
+  const char *mPrevEnd{nullptr};
+  char mPrevLastChar{0};
+  tok::TokenKind mPrevKind{tok::unknown};
+
+public:
+  /// the output starts at the first line of main file
+  PPOutputPrinter(SourceMgr &mgr, raw_ostream &os, unsigned mainFileID)
+      : mSrcMgr(mgr), mOS(os), mFileID(mainFileID), mLine(1),
+        mLastLoc(mgr.getMemoryBuffer(mainFileID)->getBufferStart()) {
+    WriteLineMarker(0);
+  }
+
+  void FileChanged(unsigned fileID, const char *loc,
+                   FileChangeReason reason) override;
+  /// the next token is presumed to be at `loc` of buffer `fileID`
+  void MoveTo(const char *loc, unsigned fileID);
+  void Print(const PPToken &token);
+  void Finish() {
+    if (!mAtLineStart) {
+      mOS << '\n';
+    }
+  }
+
+private:
+  /// # line "file" flag, flag 1 enters a file and 2 returns to it
+  void WriteLineMarker(unsigned flag);
+  void WriteBytes(std::string_view bytes);
+  bool AvoidPaste(const PPToken &token) const;
+};
+} // namespace
+
+void PPOutputPrinter::FileChanged(unsigned fileID, const char *loc,
+                                  FileChangeReason reason) {
+  unsigned flag = 1;
+  if (reason == ExitFile) {
+    if (mIncludeDepth == 0) {
+      return;
+    }
+    --mIncludeDepth;
+    flag = 2;
+  } else {
+    ++mIncludeDepth;
+  }
+  mFileID = fileID;
+  mLine = mSrcMgr.FindLineNumber(SMLoc::getFromPointer(loc), fileID);
+  mLastLoc = loc;
+  WriteLineMarker(flag);
+}
+
+void PPOutputPrinter::MoveTo(const char *loc, unsigned fileID) {
+  /// a token made up by the preprocessor stays where the output is, so does
+  /// a function like macro name at the end of a file which has been left
+  /// looking for its '('
+  if (!loc || fileID != mFileID) {
+    return;
+  }
+  if (loc <= mLastLoc) {
+    return;
+  }
+  unsigned line = mLine + std::count(mLastLoc, loc, '\n');
+  mLastLoc = loc;
+  if (line == mLine) {
+    return;
+  }
+  if (line - mLine > MaxBlankLines) {
+    mLine = line;
+    WriteLineMarker(0);
+    return;
+  }
+  for (; mLine < line; ++mLine) {
+    mOS << '\n';
+  }
+  mAtLineStart = true;
+}
+
+void PPOutputPrinter::WriteLineMarker(unsigned flag) {
+  if (!mAtLineStart) {
+    mOS << '\n';
+  }
+  mOS << "# " << mLine << " \"";
+  /// spelled as __FILE__ would be
+  for (char c : mSrcMgr.getMemoryBuffer(mFileID)->getBufferIdentifier()) {
+    if (c == '\\' || c == '"') {
+      mOS << '\\';
+    }
+    mOS << c;
+  }
+  mOS << '"';
+  if (flag) {
+    mOS << ' ' << flag;
+  }
+  mOS << '\n';
+  mAtLineStart = true;
+}
+
+void PPOutputPrinter::Print(const PPToken &token) {
+  if (!mAtLineStart &&
+      (token.LeadingSpace || (token.Loc != mPrevEnd && AvoidPaste(token)))) {
+    mOS << ' ';
+  }
+  mAtLineStart = false;
+  mPrevKind = token.Kind;
+  switch (token.Kind) {
+  case tok::string_literal:
+  case tok::char_constant: {
+    char quote = token.Kind == tok::string_literal ? '"' : '\'';
+    mOS << quote << token.Spelling << quote;
+    /// a stringized argument doesn't refer to the source
+    mPrevEnd = token.Spelling.data() == token.Loc + 1
+                   ? token.Loc + token.Spelling.size() + 2
+                   : nullptr;
+    mPrevLastChar = quote;
+    break;
+  }
+  /// #embed, the bytes as the initializer list they stand for
+  case tok::embed_data: {
+    WriteBytes(token.Spelling);
+    mPrevEnd = nullptr;
+    mPrevLastChar = '0';
+    break;
+  }
+  default: {
+    mOS << token.Spelling;
+    /// the result of ## isn't spelled at its location
+    mPrevEnd = token.Loc && token.Spelling.data() == token.Loc
+                   ? token.Loc + token.Spelling.size()
+                   : nullptr;
+    mPrevLastChar = token.Spelling.empty() ? '\0' : token.Spelling.back();
+    break;
+  }
+  }
+}
+
+void PPOutputPrinter::WriteBytes(std::string_view bytes) {
+  char buffer[4096];
+  size_t size = 0;
+  for (size_t i = 0; i < bytes.size(); ++i) {
+    if (size + 4 > sizeof(buffer)) {
+      mOS.write(buffer, size);
+      size = 0;
+    }
+    if (i != 0) {
+      buffer[size++] = ',';
+    }
+    auto byte = static_cast<unsigned char>(bytes[i]);
+    if (byte >= 100) {
+      buffer[size++] = '0' + byte / 100;
+    }
+    if (byte >= 10) {
+      buffer[size++] = '0' + byte / 10 % 10;
+    }
+    buffer[size++] = '0' + byte % 10;
+  }
+  mOS.write(buffer, size);
+}
+
+/// two tokens which weren't next to each other in the source would be read
+/// back as one, e.g. `+` `+` from a macro, or `x` `1`
+bool PPOutputPrinter::AvoidPaste(const PPToken &token) const {
+  char first = '\0';
+  if (token.Kind == tok::string_literal) {
+    first = '"';
+  } else if (token.Kind == tok::char_constant) {
+    first = '\'';
+  } else if (token.Kind == tok::embed_data) {
+    first = '0';
+  } else if (!token.Spelling.empty()) {
+    first = token.Spelling.front();
+  }
+  auto isWord = [](char c) { return isAlnum(c) || c == '_'; };
+  if (isWord(mPrevLastChar)) {
+    if (isWord(first) || first == '"' || first == '\'') {
+      /// L"..." as well
+      return true;
+    }
+    if (mPrevKind != tok::pp_number) {
+      return false;
+    }
+    /// a pp-number goes on with a '.', and with a sign after an exponent:
+    /// 1e +1 but 2+3
+    return first == '.' ||
+           ((first == '+' || first == '-') &&
+            std::string_view("eEpP").find(mPrevLastChar) !=
+                std::string_view::npos);
+  }
+  if (mPrevLastChar == '.') {
+    return first == '.' || isDigit(first);
+  }
+  /// the characters which make a longer punctuator with the one before
+  static constexpr std::pair<char, std::string_view> Follows[] = {
+      {'+', "+="}, {'-', "-=>"}, {'*', "="},   {'/', "/*="}, {'%', "=>:"},
+      {'&', "&="}, {'|', "|="},  {'^', "="},   {'<', "<=:%"}, {'>', ">="},
+      {'=', "="},  {'!', "="},   {'#', "#"},   {':', ">"}};
+  for (const auto &[last, follow] : Follows) {
+    if (last == mPrevLastChar) {
+      return follow.find(first) != std::string_view::npos;
+    }
+  }
+  return false;
+}
+
+void Preprocessor::PrintPreprocessedOutput(raw_ostream &os) {
+  LCC_ASSERT(!mFiles.empty());
+  PPOutputPrinter printer(mSrcMgr, os, mFiles.front().Lex->getBufferID());
+  PPCallbacks *callbacks = mCallbacks;
+  mCallbacks = &printer;
+  while (auto token = LexExpanded()) {
+    /// the tokens of an expansion go on the line of the macro name
+    if (mContexts.empty()) {
+      printer.MoveTo(token->Loc, token->FileID);
+    } else {
+      printer.MoveTo(mExpansionStartLoc, mExpansionStartFileID);
+    }
+    printer.Print(*token);
+  }
+  printer.Finish();
+  mCallbacks = callbacks;
+}
+} // namespace lcc
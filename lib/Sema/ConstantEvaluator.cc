@@ -0,0 +1,349 @@
+/***********************************
+ * File:     ConstantEvaluator.cc
+ *
+ * Author:   caipeng
+ *
+ * Email:    iiicp@outlook.com
+ *
+ * Date:     2023/6/16
+ *
+ * Sign:     enjoy life
+ ***********************************/
+
+#include "lcc/Sema/ConstantEvaluator.h"
+#include "lcc/Basic/Match.h"
+
+namespace lcc {
+
+using BinaryOp = IntegerValue::BinaryOp;
+
+std::optional<IntegerValue>
+ConstantEvaluator::Evaluate(const Syntax::ConstantExpr &expr) {
+  mHasError = false;
+  IntegerValue value = visit(expr, true);
+  if (mHasError) {
+    return std::nullopt;
+  }
+  return value;
+}
+
+std::optional<IntegerValue>
+ConstantEvaluator::Evaluate(const Syntax::AssignExpr &expr) {
+  /// C99 6.6p3, no assignment in a constant expression
+  if (!expr.getOptionalConditionalExpr().empty()) {
+    mHasError = false;
+    NotConstant(expr.getOptionalConditionalExpr().front().second.getBeginLoc());
+    return std::nullopt;
+  }
+  return Evaluate(expr.getConditionalExpr());
+}
+
+IntegerValue ConstantEvaluator::NotConstant(SourceLocation loc) {
+  if (!mHasError) {
+    DiagReport(Diag, loc, diag::err_sema_expr_not_integer_constant);
+  }
+  mHasError = true;
+  return {};
+}
+
+void ConstantEvaluator::CheckStatus(IntegerValue::Status status, SourceLocation loc) {
+  if (mHasError) {
+    return;
+  }
+  switch (status) {
+  case IntegerValue::Status::Ok:
+    break;
+  case IntegerValue::Status::Overflow:
+    DiagReport(Diag, loc, diag::warn_sema_integer_overflow);
+    break;
+  case IntegerValue::Status::ShiftOutOfRange:
+    DiagReport(Diag, loc, diag::warn_sema_shift_count_out_of_range);
+    break;
+  case IntegerValue::Status::DivisionByZero:
+    DiagReport(Diag, loc, diag::err_sema_division_by_zero);
+    mHasError = true;
+    break;
+  }
+}
+
+IntegerValue ConstantEvaluator::Apply(BinaryOp op, IntegerValue lhs,
+                                      IntegerValue rhs, bool evaluate,
+                                      SourceLocation loc) {
+  IntegerValue result;
+  auto status = IntegerValue::Apply(op, lhs, rhs, result);
+  if (evaluate) {
+    CheckStatus(status, loc);
+  }
+  return result;
+}
+
+IntegerValue ConstantEvaluator::visit(const Syntax::CondExpr &expr,
+                                      bool evaluate) {
+  IntegerValue cond = visit(expr.getLogicalOrExpression(), evaluate);
+  if (!expr.getOptionalExpression()) {
+    return cond;
+  }
+  IntegerValue lhs =
+      visit(*expr.getOptionalExpression(), evaluate && cond.isTrue());
+  IntegerValue rhs = visit(*expr.getOptionalConditionalExpression(),
+                           evaluate && !cond.isTrue());
+  /// C99 6.5.15p5, both arms are brought to their common type, the type of
+  /// any other binary operator on them
+  IntegerValue common;
+  IntegerValue::Apply(BinaryOp::BitOr, lhs, rhs, common);
+  return (cond.isTrue() ? lhs : rhs)
+      .promote()
+      .convertTo(common.getWidth(), common.isUnsigned());
+}
+
+IntegerValue ConstantEvaluator::visit(const Syntax::BinaryOperand &expr,
+                                      bool evaluate) {
+  return match(
+      expr,
+      [&](const box<Syntax::CastExpr> &castExpr) {
+        return visit(*castExpr, evaluate);
+      },
+      [&](const box<Syntax::BinaryExpr> &binaryExpr) {
+        return visit(*binaryExpr, evaluate);
+      });
+}
+
+static BinaryOp GetBinaryOp(Syntax::BinaryExpr::Op op) {
+  using Op = Syntax::BinaryExpr::Op;
+  switch (op) {
+  case Op::Multiply:
+    return BinaryOp::Mul;
+  case Op::Divide:
+    return BinaryOp::Div;
+  case Op::Modulo:
+    return BinaryOp::Rem;
+  case Op::Plus:
+    return BinaryOp::Add;
+  case Op::Minus:
+    return BinaryOp::Sub;
+  case Op::LeftShift:
+    return BinaryOp::Shl;
+  case Op::RightShift:
+    return BinaryOp::Shr;
+  case Op::LessThan:
+    return BinaryOp::Less;
+  case Op::LessThanOrEqual:
+    return BinaryOp::LessEqual;
+  case Op::GreaterThan:
+    return BinaryOp::Greater;
+  case Op::GreaterThanOrEqual:
+    return BinaryOp::GreaterEqual;
+  case Op::Equal:
+    return BinaryOp::Equal;
+  case Op::NotEqual:
+    return BinaryOp::NotEqual;
+  case Op::BitAnd:
+    return BinaryOp::BitAnd;
+  case Op::BitXor:
+    return BinaryOp::BitXor;
+  case Op::BitOr:
+    return BinaryOp::BitOr;
+  case Op::LogicalAnd:
+  case Op::LogicalOr:
+    /// short-circuited, not an arithmetic operation
+    break;
+  }
+  LCC_UNREACHABLE;
+}
+
+IntegerValue ConstantEvaluator::visit(const Syntax::BinaryExpr &expr,
+                                      bool evaluate) {
+  IntegerValue lhs = visit(expr.getLhs(), evaluate);
+  switch (expr.getOperator()) {
+  case Syntax::BinaryExpr::Op::LogicalAnd: {
+    bool value = lhs.isTrue();
+    value &= visit(expr.getRhs(), evaluate && value).isTrue();
+    return IntegerValue::getBool(value);
+  }
+  case Syntax::BinaryExpr::Op::LogicalOr: {
+    bool value = lhs.isTrue();
+    value |= visit(expr.getRhs(), evaluate && !value).isTrue();
+    return IntegerValue::getBool(value);
+  }
+  default:
+    return Apply(GetBinaryOp(expr.getOperator()), lhs,
+                 visit(expr.getRhs(), evaluate), evaluate,
+                 Syntax::getBeginLoc(expr.getRhs()));
+  }
+}
+
+IntegerValue ConstantEvaluator::visit(const Syntax::CastExpr &expr,
+                                      bool evaluate) {
+  return match(
+      expr.getVariant(),
+      [&](const Syntax::UnaryExpr &unaryExpr) {
+        return visit(unaryExpr, evaluate);
+      },
+      [&](const Syntax::CastExpr::TypeNameCast &typeNameCast) {
+        IntegerValue value = visit(*typeNameCast.second, evaluate);
+        auto type = GetScalarType(*typeNameCast.first);
+        /// C99 6.6p6, only casts to integer types
+        if (!type || !type->IsInteger) {
+          return NotConstant(typeNameCast.first->getBeginLoc());
+        }
+        if (type->IsBool) {
+          return IntegerValue(value.isTrue(), type->Size * 8, true);
+        }
+        return value.convertTo(type->Size * 8, type->IsUnsigned);
+      });
+}
+
+IntegerValue ConstantEvaluator::visit(const Syntax::UnaryExpr &expr,
+                                      bool evaluate) {
+  return match(
+      expr,
+      [&](const Syntax::PostFixExpr &postFixExpr) {
+        return visit(postFixExpr, evaluate);
+      },
+      [&](const box<Syntax::UnaryExprUnaryOperator> &unaryExpr) {
+        const Syntax::CastExpr *operand = unaryExpr->getCastExpr();
+        /// ++, --, & and * never give an integer constant
+        if (!operand) {
+          return NotConstant(unaryExpr->getBeginLoc());
+        }
+        switch (unaryExpr->getOperator()) {
+        case Syntax::UnaryExprUnaryOperator::Op::Plus:
+          return visit(*operand, evaluate).promote();
+        case Syntax::UnaryExprUnaryOperator::Op::Minus: {
+          IntegerValue result;
+          auto status = visit(*operand, evaluate).Negate(result);
+          if (evaluate) {
+            CheckStatus(status, unaryExpr->getBeginLoc());
+          }
+          return result;
+        }
+        case Syntax::UnaryExprUnaryOperator::Op::BitNot:
+          return visit(*operand, evaluate).BitNot();
+        case Syntax::UnaryExprUnaryOperator::Op::LogicalNot:
+          return visit(*operand, evaluate).LogicalNot();
+        default:
+          return NotConstant(unaryExpr->getBeginLoc());
+        }
+      },
+      [&](const box<Syntax::UnaryExprSizeOf> &sizeOfExpr) {
+        /// the size of an expression needs its type, which is sema's
+        const auto *typeName =
+            std::get_if<Syntax::TypeNameBox>(&sizeOfExpr->getVariant());
+        std::optional<ScalarType> type;
+        if (typeName) {
+          type = GetScalarType(**typeName);
+        }
+        if (!type) {
+          return NotConstant(sizeOfExpr->getBeginLoc());
+        }
+        /// size_t is unsigned long
+        return IntegerValue(type->Size, 64, true);
+      });
+}
+
+IntegerValue ConstantEvaluator::visit(const Syntax::PostFixExpr &expr,
+                                      bool evaluate) {
+  if (const auto *primaryExpr = std::get_if<Syntax::PrimaryExpr>(&expr)) {
+    return visit(*primaryExpr, evaluate);
+  }
+  return match(expr, [&](const auto &postFixExpr) -> IntegerValue {
+    using T = std::decay_t<decltype(postFixExpr)>;
+    if constexpr (std::is_same_v<T, Syntax::PrimaryExpr>) {
+      LCC_UNREACHABLE;
+    } else {
+      return NotConstant(postFixExpr->getBeginLoc());
+    }
+  });
+}
+
+IntegerValue ConstantEvaluator::visit(const Syntax::PrimaryExpr &expr,
+                                      bool evaluate) {
+  return match(
+      expr,
+      [&](const Syntax::PrimaryExprIdent &ident) {
+        std::optional<IntegerValue> value;
+        if (mLookup) {
+          value = mLookup(ident.getIdentifier());
+        }
+        if (!value) {
+          return NotConstant(ident.getBeginLoc());
+        }
+        return *value;
+      },
+      [&](const Syntax::PrimaryExprConstant &constant) {
+        return match(
+            constant.getValue(),
+            [](int32_t value) { return IntegerValue::getInt(value); },
+            [](uint32_t value) { return IntegerValue(value, 32, true); },
+            [](int64_t value) {
+              return IntegerValue(static_cast<uint64_t>(value), 64, false);
+            },
+            [](uint64_t value) { return IntegerValue(value, 64, true); },
+            /// C99 6.6p6, a floating constant only as the operand of a cast,
+            /// which isn't supported, and never a string
+            [&](const auto &) { return NotConstant(constant.getBeginLoc()); });
+      },
+      [&](const Syntax::PrimaryExprParentheses &parentheses) {
+        return visit(parentheses.getExpr(), evaluate);
+      });
+}
+
+IntegerValue ConstantEvaluator::visit(const Syntax::Expr &expr,
+                                      bool evaluate) {
+  const auto &operands = expr.getAssignExpressions();
+  /// C99 6.6p3, no comma operator and no assignment
+  if (operands.size() != 1 ||
+      !operands.front().getOptionalConditionalExpr().empty()) {
+    return NotConstant(expr.getBeginLoc());
+  }
+  return visit(operands.front().getConditionalExpr(), evaluate);
+}
+
+std::optional<ConstantEvaluator::ScalarType>
+ConstantEvaluator::GetScalarType(const Syntax::TypeName &typeName) {
+  if (typeName.getAbstractDeclarator()) {
+    return std::nullopt;
+  }
+  const auto &specs = typeName.getSpecifierQualifiers();
+  unsigned kinds = specs.getPrimTypes(), numLongs = specs.getNumLongs();
+  bool isEnum = false;
+  if (const auto *typeSpec = specs.getTypeSpec()) {
+    if (!std::holds_alternative<box<Syntax::EnumSpecifier>>(
+            typeSpec->getVariant())) {
+      return std::nullopt;
+    }
+    isEnum = true;
+  }
+  using Kind = Syntax::TypeSpec::PrimTypeKind;
+  bool isUnsigned = kinds & Kind::Unsigned;
+  /// an enumerated type is compatible with int here
+  if (isEnum) {
+    return ScalarType{4, true, false, false};
+  }
+  if (kinds & Kind::Void) {
+    return std::nullopt;
+  }
+  if (kinds & Kind::Bool) {
+    return ScalarType{1, true, true, true};
+  }
+  if (kinds & Kind::Float) {
+    return ScalarType{4, false, false, false};
+  }
+  if (kinds & Kind::Double) {
+    return ScalarType{numLongs ? 16u : 8u, false, false, false};
+  }
+  if (kinds & Kind::Char) {
+    return ScalarType{1, true, isUnsigned, false};
+  }
+  if (kinds & Kind::Short) {
+    return ScalarType{2, true, isUnsigned, false};
+  }
+  if (numLongs) {
+    return ScalarType{8, true, isUnsigned, false};
+  }
+  if (kinds & (Kind::Int | Kind::Signed | Kind::Unsigned)) {
+    return ScalarType{4, true, isUnsigned, false};
+  }
+  return std::nullopt;
+}
+} // namespace lcc
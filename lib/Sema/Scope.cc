@@ -10,21 +10,36 @@
  * Sign:     enjoy life
  ***********************************/
 #include "lcc/Sema/Scope.h"
-#include "lcc/Basic/Match.h"
 
 namespace lcc {
 
-const Scope::DeclarationSymbol* Scope::FindDeclSymbol(std::string_view name, size_t envId) {
-  auto curr = envId;
-  while (curr >= 0) {
-    auto &env = scopes_[envId];
-    for (auto &[name_, symbol_] : env.declarationSymbols_)
-      if (name_ == name) {
-        return &symbol_;
-      }
-    curr--;
-  }
-  return nullptr;
+const Scope::DeclarationSymbol *
+Scope::FindDeclSymbol(std::string_view name) const {
+  return declarationSymbols_.Find(name);
+}
+
+const Scope::DeclarationSymbol *
+Scope::FindDeclSymbolInCurrentScope(std::string_view name) const {
+  return declarationSymbols_.FindInCurrentScope(name);
+}
+
+const Scope::DeclarationSymbol *
+Scope::AddDeclSymbol(std::string_view name, DeclarationSymbol symbol) {
+  return declarationSymbols_.Add(name, symbol);
+}
+
+const Scope::TagSymbol *Scope::FindTagSymbol(std::string_view name) const {
+  return tagSymbols_.Find(name);
+}
+
+const Scope::TagSymbol *
+Scope::FindTagSymbolInCurrentScope(std::string_view name) const {
+  return tagSymbols_.FindInCurrentScope(name);
+}
+
+const Scope::TagSymbol *Scope::AddTagSymbol(std::string_view name,
+                                            TagSymbol symbol) {
+  return tagSymbols_.Add(name, symbol);
 }
 
 } // namespace lcc
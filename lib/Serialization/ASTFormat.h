@@ -0,0 +1,68 @@
+/***********************************
+ * File:     ASTFormat.h
+ *
+ * Author:   caipeng
+ *
+ * Email:    iiicp@outlook.com
+ *
+ * Date:     2023/6/18
+ *
+ * Sign:     enjoy life
+ ***********************************/
+
+#ifndef LCC_ASTFORMAT_H
+#define LCC_ASTFORMAT_H
+
+#include <cstdint>
+
+/// the layout shared by ASTWriter and ASTReader, see
+/// lcc/Serialization/ASTFile.h
+namespace lcc::astfile {
+
+/// the last byte is the format version, bump it on every layout change
+inline constexpr char Magic[8] = {'L', 'C', 'C', 'A', 'S', 'T', '\0', 3};
+
+/// the words following the magic
+enum HeaderField : unsigned {
+  /// a file is only valid for the node kinds it was written with
+  NumNodeKinds,
+  NodesOffset,
+  NumNodes,
+  ChildrenOffset,
+  NumChildren,
+  ConstantsOffset,
+  NumConstants,
+  StringsOffset,
+  StringsSize,
+  StringTableOffset,
+  NumStrings,
+  FilesOffset,
+  NumFiles,
+  NumHeaderFields
+};
+
+/// {kind | payload << 16, file, offset, string or constant, first child,
+/// number of children}
+inline constexpr unsigned NodeWords = 6;
+enum NodeField : unsigned {
+  NodeKind,
+  NodeFile,
+  NodeOffset,
+  NodeValue,
+  NodeFirstChild,
+  NodeNumChildren
+};
+inline constexpr uint32_t KindMask = 0xffff;
+inline constexpr unsigned PayloadShift = 16;
+
+/// an absent child, a node without a string or a file
+inline constexpr uint32_t NoNode = ~0u;
+inline constexpr uint32_t NoValue = ~0u;
+
+/// {offset, length}
+inline constexpr unsigned StringWords = 2;
+/// {low word, high word}
+inline constexpr unsigned ConstantWords = 2;
+} // namespace lcc::astfile
+
+#endif // LCC_ASTFORMAT_H
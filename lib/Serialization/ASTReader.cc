@@ -0,0 +1,207 @@
+/***********************************
+ * File:     ASTReader.cc
+ *
+ * Author:   caipeng
+ *
+ * Email:    iiicp@outlook.com
+ *
+ * Date:     2023/6/18
+ *
+ * Sign:     enjoy life
+ ***********************************/
+
+#include "ASTFormat.h"
+#include "lcc/Serialization/ASTFile.h"
+#include "llvm/Support/Endian.h"
+#include <cstring>
+
+namespace lcc {
+
+using namespace llvm;
+
+static uint32_t ReadWord(const char *ptr, unsigned index = 0) {
+  return support::endian::read32le(ptr + index * 4);
+}
+
+static Error MakeError(StringRef fileName, const Twine &message) {
+  return createStringError(inconvertibleErrorCode(),
+                           "%s: %s", fileName.str().c_str(),
+                           message.str().c_str());
+}
+
+Expected<std::unique_ptr<ASTReader>> ASTReader::Load(StringRef path) {
+  /// mapped when the file is big enough, nothing is read until it is touched
+  auto buffer = MemoryBuffer::getFile(path, /*IsText=*/false,
+                                      /*RequiresNullTerminator=*/false);
+  if (!buffer) {
+    return MakeError(path, buffer.getError().message());
+  }
+  return Load(std::move(*buffer));
+}
+
+Expected<std::unique_ptr<ASTReader>>
+ASTReader::Load(std::unique_ptr<MemoryBuffer> buffer) {
+  std::unique_ptr<ASTReader> reader(new ASTReader());
+  reader->mFileName = buffer->getBufferIdentifier().str();
+  reader->mBuffer = std::move(buffer);
+  StringRef path = reader->mFileName;
+  const char *data = reader->mBuffer->getBufferStart();
+  uint64_t size = reader->mBuffer->getBufferSize();
+
+  uint32_t header[astfile::NumHeaderFields];
+  if (size < sizeof(astfile::Magic) + sizeof(header) ||
+      std::memcmp(data, astfile::Magic, sizeof(astfile::Magic)) != 0) {
+    return MakeError(path, "not an AST file of this compiler");
+  }
+  for (unsigned i = 0; i < astfile::NumHeaderFields; ++i) {
+    header[i] = ReadWord(data + sizeof(astfile::Magic), i);
+  }
+  if (header[astfile::NumNodeKinds] !=
+      static_cast<uint32_t>(ASTNodeKind::NUM_KINDS)) {
+    return MakeError(path, "AST file written by another version");
+  }
+  auto inBounds = [size](uint64_t offset, uint64_t length) {
+    return offset + length <= size;
+  };
+  if (!inBounds(header[astfile::NodesOffset],
+                uint64_t(header[astfile::NumNodes]) * astfile::NodeWords * 4) ||
+      !inBounds(header[astfile::ChildrenOffset],
+                uint64_t(header[astfile::NumChildren]) * 4) ||
+      !inBounds(header[astfile::ConstantsOffset],
+                uint64_t(header[astfile::NumConstants]) *
+                    astfile::ConstantWords * 4) ||
+      !inBounds(header[astfile::StringsOffset], header[astfile::StringsSize]) ||
+      !inBounds(header[astfile::StringTableOffset],
+                uint64_t(header[astfile::NumStrings]) * astfile::StringWords *
+                    4) ||
+      !inBounds(header[astfile::FilesOffset],
+                uint64_t(header[astfile::NumFiles]) * 4)) {
+    return MakeError(path, "malformed AST file");
+  }
+  reader->mNodes = data + header[astfile::NodesOffset];
+  reader->mNumNodes = header[astfile::NumNodes];
+  reader->mChildren = data + header[astfile::ChildrenOffset];
+  reader->mNumChildren = header[astfile::NumChildren];
+  reader->mConstants = data + header[astfile::ConstantsOffset];
+  reader->mNumConstants = header[astfile::NumConstants];
+  reader->mStrings = StringRef(data + header[astfile::StringsOffset],
+                               header[astfile::StringsSize]);
+  reader->mStringTable = data + header[astfile::StringTableOffset];
+  reader->mNumStrings = header[astfile::NumStrings];
+  reader->mFiles = data + header[astfile::FilesOffset];
+  reader->mNumFiles = header[astfile::NumFiles];
+  return std::move(reader);
+}
+
+const char *ASTReader::getRecord(uint32_t index) const {
+  return mNodes + uint64_t(index) * astfile::NodeWords * 4;
+}
+
+std::optional<StringRef> ASTReader::getString(uint32_t index) const {
+  if (index >= mNumStrings) {
+    return std::nullopt;
+  }
+  const char *entry = mStringTable + uint64_t(index) * astfile::StringWords * 4;
+  uint32_t offset = ReadWord(entry, 0), length = ReadWord(entry, 1);
+  if (uint64_t(offset) + length > mStrings.size()) {
+    return std::nullopt;
+  }
+  return mStrings.substr(offset, length);
+}
+
+ASTNodeKind ASTRecord::getKind() const {
+  uint32_t kind =
+      ReadWord(mReader->getRecord(mIndex), astfile::NodeKind) &
+      astfile::KindMask;
+  if (kind >= static_cast<uint32_t>(ASTNodeKind::NUM_KINDS)) {
+    return ASTNodeKind::NUM_KINDS;
+  }
+  return static_cast<ASTNodeKind>(kind);
+}
+
+uint32_t ASTRecord::getPayload() const {
+  return ReadWord(mReader->getRecord(mIndex), astfile::NodeKind) >>
+         astfile::PayloadShift;
+}
+
+StringRef ASTRecord::getFileName() const {
+  uint32_t file = ReadWord(mReader->getRecord(mIndex), astfile::NodeFile);
+  if (file >= mReader->mNumFiles) {
+    return {};
+  }
+  return mReader->getString(ReadWord(mReader->mFiles, file)).value_or("");
+}
+
+uint32_t ASTRecord::getOffset() const {
+  return ReadWord(mReader->getRecord(mIndex), astfile::NodeOffset);
+}
+
+std::optional<StringRef> ASTRecord::getString() const {
+  if (getKind() == ASTNodeKind::ConstantArray ||
+      (getKind() == ASTNodeKind::PrimaryExprConstant &&
+       getPayload() != static_cast<uint32_t>(ASTConstantKind::String))) {
+    return std::nullopt;
+  }
+  return mReader->getString(
+      ReadWord(mReader->getRecord(mIndex), astfile::NodeValue));
+}
+
+std::optional<uint64_t> ASTRecord::getConstant() const {
+  if (getKind() != ASTNodeKind::PrimaryExprConstant ||
+      getPayload() == static_cast<uint32_t>(ASTConstantKind::String)) {
+    return std::nullopt;
+  }
+  return ReadConstant(
+      ReadWord(mReader->getRecord(mIndex), astfile::NodeValue));
+}
+
+std::optional<uint32_t> ASTRecord::getNumElements() const {
+  if (getKind() != ASTNodeKind::ConstantArray) {
+    return std::nullopt;
+  }
+  auto size = ReadConstant(
+      ReadWord(mReader->getRecord(mIndex), astfile::NodeValue));
+  if (!size || *size > mReader->mNumConstants) {
+    return std::nullopt;
+  }
+  return *size;
+}
+
+std::optional<uint64_t> ASTRecord::getElement(uint32_t index) const {
+  auto size = getNumElements();
+  if (!size || index >= *size) {
+    return std::nullopt;
+  }
+  return ReadConstant(
+      uint64_t(ReadWord(mReader->getRecord(mIndex), astfile::NodeValue)) + 1 +
+      index);
+}
+
+std::optional<uint64_t> ASTRecord::ReadConstant(uint64_t index) const {
+  if (index >= mReader->mNumConstants) {
+    return std::nullopt;
+  }
+  const char *entry = mReader->mConstants + index * astfile::ConstantWords * 4;
+  return ReadWord(entry, 0) | uint64_t(ReadWord(entry, 1)) << 32;
+}
+
+uint32_t ASTRecord::getNumChildren() const {
+  return ReadWord(mReader->getRecord(mIndex), astfile::NodeNumChildren);
+}
+
+ASTRecord ASTRecord::getChild(uint32_t index) const {
+  const char *record = mReader->getRecord(mIndex);
+  uint64_t slot = uint64_t(ReadWord(record, astfile::NodeFirstChild)) + index;
+  if (index >= ReadWord(record, astfile::NodeNumChildren) ||
+      slot >= mReader->mNumChildren) {
+    return {};
+  }
+  uint32_t child = ReadWord(mReader->mChildren, slot);
+  /// a node is numbered before its children, one which is not would be a
+  /// cycle for a walk of the tree
+  if (child <= mIndex || child >= mReader->mNumNodes) {
+    return {};
+  }
+  return {mReader, child};
+}
+} // namespace lcc
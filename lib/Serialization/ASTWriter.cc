@@ -0,0 +1,923 @@
+/***********************************
+ * File:     ASTWriter.cc
+ *
+ * Author:   caipeng
+ *
+ * Email:    iiicp@outlook.com
+ *
+ * Date:     2023/6/18
+ *
+ * Sign:     enjoy life
+ ***********************************/
+
+#include "ASTFormat.h"
+#include "lcc/Serialization/ASTFile.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Support/MathExtras.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace lcc {
+
+using namespace llvm;
+using namespace Syntax;
+using astfile::NoNode;
+using astfile::NoValue;
+
+const char *getASTNodeKindName(ASTNodeKind kind) {
+  static const char *const names[] = {
+#define AST_NODE(Name) #Name,
+#include "lcc/Serialization/ASTNodeKinds.def"
+  };
+  if (kind >= ASTNodeKind::NUM_KINDS) {
+    return "<invalid>";
+  }
+  return names[static_cast<unsigned>(kind)];
+}
+
+namespace {
+/// a numeric constant in the constants section, an integer as its 64 bit
+/// extension, floating point as its bits
+template <typename T> uint64_t ConstantBits(T number) {
+  if constexpr (std::is_same_v<T, float>) {
+    return FloatToBits(number);
+  } else if constexpr (std::is_same_v<T, double>) {
+    return DoubleToBits(number);
+  } else if constexpr (std::is_integral_v<T>) {
+    return static_cast<uint64_t>(number);
+  } else {
+    return 0;
+  }
+}
+
+/// flattens the tree into the records, a node is numbered before its
+/// children so the root is 0 and a subtree is a run of consecutive nodes
+class RecordBuilder {
+private:
+  struct Record {
+    uint32_t Kind;
+    uint32_t File;
+    uint32_t Offset;
+    uint32_t Value;
+    uint32_t FirstChild;
+    uint32_t NumChildren;
+  };
+
+  const SourceMgr &mSrcMgr;
+  SourceLocationTable mLocations;
+  std::vector<Record> mNodes;
+  std::vector<uint32_t> mChildren;
+  std::vector<uint64_t> mConstants;
+  std::string mStrings;
+  std::vector<std::pair<uint32_t, uint32_t>> mStringTable;
+  StringMap<uint32_t> mStringIndex;
+  /// the file index of each buffer id that was seen
+  DenseMap<unsigned, uint32_t> mFileIndex;
+  std::vector<uint32_t> mFiles;
+  /// the buffer of the last location, nodes next to each other mostly share
+  /// one
+  unsigned mLastBuffer{0};
+  uint32_t mLastBegin{0};
+  uint32_t mLastEnd{0};
+  /// a node still to write, and the slot of its parent's children its id
+  /// goes in
+  struct Task {
+    void (RecordBuilder::*Expand)(const void *node, uint32_t slot,
+                                  uint32_t part);
+    const void *Node;
+    uint32_t Slot;
+    /// the designator of an initializer entry, for ExpandDesignator
+    uint32_t Part;
+  };
+  /// the nodes still to write are kept here rather than on the C stack, a
+  /// tree thousands of levels deep, as a long chain of operators makes, is
+  /// written in constant stack
+  std::vector<Task> mTasks;
+  /// the slot of the root, which has no parent
+  static constexpr uint32_t NoSlot = ~0u;
+
+public:
+  explicit RecordBuilder(const SourceMgr &srcMgr)
+      : mSrcMgr(srcMgr), mLocations(srcMgr) {}
+
+  void Build(const TranslationUnit &unit) {
+    Push(NoSlot, unit);
+    while (!mTasks.empty()) {
+      Task task = mTasks.back();
+      mTasks.pop_back();
+      /// the children are pushed in order and reversed, so they are popped
+      /// and numbered in order
+      size_t first = mTasks.size();
+      (this->*task.Expand)(task.Node, task.Slot, task.Part);
+      std::reverse(mTasks.begin() + first, mTasks.end());
+    }
+  }
+
+  void Emit(raw_ostream &os) const;
+
+private:
+  uint32_t AddString(std::string_view str) {
+    auto [iter, inserted] = mStringIndex.try_emplace(
+        StringRef(str.data(), str.size()), mStringTable.size());
+    if (inserted) {
+      mStringTable.emplace_back(mStrings.size(), str.size());
+      mStrings.append(str.data(), str.size());
+    }
+    return iter->second;
+  }
+
+  /// the file index and offset of a location
+  std::pair<uint32_t, uint32_t> Locate(SourceLocation loc) {
+    uint32_t raw = loc.getRawEncoding();
+    if (!loc.isValid()) {
+      return {NoValue, 0};
+    }
+    if (!(raw >= mLastBegin && raw <= mLastEnd)) {
+      auto [id, offset] = mLocations.getDecomposedLoc(loc);
+      if (!id) {
+        return {NoValue, 0};
+      }
+      mLastBuffer = id;
+      mLastBegin = raw - offset;
+      mLastEnd = mLastBegin + mSrcMgr.getMemoryBuffer(id)->getBufferSize();
+    }
+    auto [iter, inserted] = mFileIndex.try_emplace(mLastBuffer, mFiles.size());
+    if (inserted) {
+      StringRef name =
+          mSrcMgr.getMemoryBuffer(mLastBuffer)->getBufferIdentifier();
+      mFiles.push_back(AddString({name.data(), name.size()}));
+    }
+    return {iter->second, raw - mLastBegin};
+  }
+
+  uint32_t Begin(ASTNodeKind kind, SourceLocation loc, uint32_t payload = 0,
+                 uint32_t value = NoValue) {
+    Record record{static_cast<uint32_t>(kind) |
+                      payload << astfile::PayloadShift,
+                  NoValue, 0, value, 0, 0};
+    std::tie(record.File, record.Offset) = Locate(loc);
+    mNodes.push_back(record);
+    return mNodes.size() - 1;
+  }
+  uint32_t Begin(ASTNodeKind kind, SourceLocation loc, uint32_t payload,
+                 std::string_view str) {
+    return Begin(kind, loc, payload, AddString(str));
+  }
+  /// puts `node` in `slot` of its parent and gives it `numChildren` slots of
+  /// its own, returning the first; a slot stays NoNode for an absent child
+  uint32_t Place(uint32_t slot, uint32_t node, uint32_t numChildren = 0) {
+    if (slot != NoSlot) {
+      mChildren[slot] = node;
+    }
+    uint32_t first = mChildren.size();
+    mNodes[node].FirstChild = first;
+    mNodes[node].NumChildren = numChildren;
+    mChildren.resize(first + numChildren, NoNode);
+    return first;
+  }
+
+  template <typename T>
+  void ExpandNode(const void *node, uint32_t slot, uint32_t) {
+    Expand(*static_cast<const T *>(node), slot);
+  }
+  void ExpandDesignator(const void *entry, uint32_t slot, uint32_t part);
+
+  template <typename T> void Push(uint32_t slot, const T &node) {
+    mTasks.push_back({&RecordBuilder::ExpandNode<T>, &node, slot, 0});
+  }
+  template <typename... Ts>
+  void Push(uint32_t slot, const std::variant<Ts...> &node) {
+    std::visit([this, slot](const auto &alt) { Push(slot, alt); }, node);
+  }
+  template <typename T> void Push(uint32_t slot, const box<T> &node) {
+    Push(slot, *node);
+  }
+  template <typename T>
+  void Push(uint32_t slot, const std::optional<T> &node) {
+    if (node) {
+      Push(slot, *node);
+    }
+  }
+  template <typename T> void Push(uint32_t slot, const T *node) {
+    if (node) {
+      Push(slot, *node);
+    }
+  }
+  /// a list goes in the slots from `first` on
+  template <typename T>
+  void PushAll(uint32_t first, const ASTVector<T> &nodes) {
+    for (const auto &node : nodes) {
+      Push(first++, node);
+    }
+  }
+
+  using AssignOperand = std::pair<AssignExpr::AssignOp, CondExpr>;
+
+  void Expand(const TranslationUnit &node, uint32_t slot);
+  void Expand(const FunctionDefinition &node, uint32_t slot);
+  void Expand(const Declaration &node, uint32_t slot);
+  void Expand(const Declaration::InitDeclarator &node, uint32_t slot);
+  void Expand(const DeclSpec &node, uint32_t slot);
+  void Expand(const TypeSpec &node, uint32_t slot);
+  void Expand(const TypeQualifier &node, uint32_t slot);
+  void Expand(const StructOrUnionSpec &node, uint32_t slot);
+  void Expand(const StructOrUnionSpec::StructDeclaration &node, uint32_t slot);
+  void Expand(const StructOrUnionSpec::StructDeclarator &node, uint32_t slot);
+  void Expand(const EnumSpecifier &node, uint32_t slot);
+  void Expand(const EnumSpecifier::Enumerator &node, uint32_t slot);
+  void Expand(const TypeName &node, uint32_t slot);
+  void Expand(const Declarator &node, uint32_t slot);
+  void Expand(const Pointer &node, uint32_t slot);
+  void Expand(const DirectDeclaratorIdent &node, uint32_t slot);
+  void Expand(const DirectDeclaratorParentheses &node, uint32_t slot);
+  void Expand(const DirectDeclaratorAssignExpr &node, uint32_t slot);
+  void Expand(const DirectDeclaratorAsterisk &node, uint32_t slot);
+  void Expand(const DirectDeclaratorParamTypeList &node, uint32_t slot);
+  void Expand(const AbstractDeclarator &node, uint32_t slot);
+  void Expand(const DirectAbstractDeclaratorParentheses &node, uint32_t slot);
+  void Expand(const DirectAbstractDeclaratorAssignExpr &node, uint32_t slot);
+  void Expand(const DirectAbstractDeclaratorAsterisk &node, uint32_t slot);
+  void Expand(const DirectAbstractDeclaratorParamTypeList &node, uint32_t slot);
+  void Expand(const ParamTypeList &node, uint32_t slot);
+  void Expand(const ParamList &node, uint32_t slot);
+  void Expand(const ParameterDeclaration &node, uint32_t slot);
+  void Expand(const Initializer &node, uint32_t slot);
+  void Expand(const InitializerList &node, uint32_t slot);
+  void Expand(const InitializerList::InitializerPair &node, uint32_t slot);
+  void Expand(const EmbedData &node, uint32_t slot);
+  void Expand(const ConstantArray &node, uint32_t slot);
+
+  void Expand(const BlockStmt &node, uint32_t slot);
+  void Expand(const ReturnStmt &node, uint32_t slot);
+  void Expand(const ExprStmt &node, uint32_t slot);
+  void Expand(const IfStmt &node, uint32_t slot);
+  void Expand(const SwitchStmt &node, uint32_t slot);
+  void Expand(const DefaultStmt &node, uint32_t slot);
+  void Expand(const CaseStmt &node, uint32_t slot);
+  void Expand(const LabelStmt &node, uint32_t slot);
+  void Expand(const GotoStmt &node, uint32_t slot);
+  void Expand(const DoWhileStmt &node, uint32_t slot);
+  void Expand(const WhileStmt &node, uint32_t slot);
+  void Expand(const ForStmt &node, uint32_t slot);
+  void Expand(const BreakStmt &node, uint32_t slot);
+  void Expand(const ContinueStmt &node, uint32_t slot);
+
+  void Expand(const Expr &node, uint32_t slot);
+  void Expand(const AssignExpr &node, uint32_t slot);
+  void Expand(const AssignOperand &node, uint32_t slot);
+  void Expand(const CondExpr &node, uint32_t slot);
+  void Expand(const BinaryExpr &node, uint32_t slot);
+  void Expand(const CastExpr &node, uint32_t slot);
+  void Expand(const UnaryExprUnaryOperator &node, uint32_t slot);
+  void Expand(const UnaryExprSizeOf &node, uint32_t slot);
+  void Expand(const PostFixExprSubscript &node, uint32_t slot);
+  void Expand(const PostFixExprFuncCall &node, uint32_t slot);
+  void Expand(const PostFixExprDot &node, uint32_t slot);
+  void Expand(const PostFixExprArrow &node, uint32_t slot);
+  void Expand(const PostFixExprIncrement &node, uint32_t slot);
+  void Expand(const PostFixExprDecrement &node, uint32_t slot);
+  void Expand(const PostFixExprTypeInitializer &node, uint32_t slot);
+  void Expand(const PrimaryExprIdent &node, uint32_t slot);
+  void Expand(const PrimaryExprConstant &node, uint32_t slot);
+  void Expand(const PrimaryExprParentheses &node, uint32_t slot);
+};
+
+void RecordBuilder::Expand(const TranslationUnit &node, uint32_t slot) {
+  /// the unit has no location of its own
+  const auto &globals = node.getGlobals();
+  uint32_t first = Place(
+      slot, Begin(ASTNodeKind::TranslationUnit, SourceLocation()),
+      globals.size());
+  PushAll(first, globals);
+}
+
+void RecordBuilder::Expand(const FunctionDefinition &node, uint32_t slot) {
+  uint32_t first = Place(
+      slot, Begin(ASTNodeKind::FunctionDefinition, node.getBeginLoc()), 3);
+  Push(first, node.getDeclarationSpecifiers());
+  Push(first + 1, node.getDeclarator());
+  Push(first + 2, node.getCompoundStatement());
+}
+
+void RecordBuilder::Expand(const Declaration &node, uint32_t slot) {
+  const auto &initDeclarators = node.getInitDeclarators();
+  uint32_t first =
+      Place(slot, Begin(ASTNodeKind::Declaration, node.getBeginLoc()),
+            1 + initDeclarators.size());
+  Push(first, node.getDeclarationSpecifiers());
+  PushAll(first + 1, initDeclarators);
+}
+
+void RecordBuilder::Expand(const Declaration::InitDeclarator &node,
+                           uint32_t slot) {
+  uint32_t first =
+      Place(slot, Begin(ASTNodeKind::InitDeclarator, node.beginLoc_), 2);
+  Push(first, node.declarator_);
+  Push(first + 1, node.optionalInitializer_);
+}
+
+void RecordBuilder::Expand(const DeclSpec &node, uint32_t slot) {
+  /// the primitive type specifiers have no location of their own
+  uint32_t numChildren = node.getTypeSpec() != nullptr;
+  for (uint16_t bit = 1; bit <= TypeSpec::Bool; bit <<= 1) {
+    if (node.getPrimTypes() & bit) {
+      numChildren += bit == TypeSpec::Long ? node.getNumLongs() : 1;
+    }
+  }
+  uint32_t first = Place(slot,
+                         Begin(ASTNodeKind::DeclSpec, node.getBeginLoc(),
+                               node.getStorageClasses() |
+                                   node.getQualifiers() << 5 |
+                                   node.isInline() << 8),
+                         numChildren);
+  for (uint16_t bit = 1; bit <= TypeSpec::Bool; bit <<= 1) {
+    if (!(node.getPrimTypes() & bit)) {
+      continue;
+    }
+    unsigned count = bit == TypeSpec::Long ? node.getNumLongs() : 1;
+    while (count--) {
+      Place(first++, Begin(ASTNodeKind::TypeSpec, node.getBeginLoc(), bit));
+    }
+  }
+  Push(first, node.getTypeSpec());
+}
+
+void RecordBuilder::Expand(const TypeSpec &node, uint32_t slot) {
+  const auto &variant = node.getVariant();
+  if (const auto *name = std::get_if<TypeSpec::TypedefName>(&variant)) {
+    Place(slot, Begin(ASTNodeKind::TypeSpec, node.getBeginLoc(), 0,
+                      AddString(*name)));
+    return;
+  }
+  uint32_t first =
+      Place(slot, Begin(ASTNodeKind::TypeSpec, node.getBeginLoc()), 1);
+  if (const auto *tag = std::get_if<box<StructOrUnionSpec>>(&variant)) {
+    Push(first, *tag);
+  } else {
+    Push(first, std::get<box<EnumSpecifier>>(variant));
+  }
+}
+
+void RecordBuilder::Expand(const TypeQualifier &node, uint32_t slot) {
+  Place(slot, Begin(ASTNodeKind::TypeQualifier, node.getBeginLoc(),
+                    node.getQualifier()));
+}
+
+void RecordBuilder::Expand(const StructOrUnionSpec &node, uint32_t slot) {
+  const auto &declarations = node.getStructDeclarations();
+  uint32_t first =
+      Place(slot,
+            Begin(ASTNodeKind::StructOrUnionSpec, node.getBeginLoc(),
+                  node.isUnion(), node.getTag()),
+            declarations.size());
+  PushAll(first, declarations);
+}
+
+void RecordBuilder::Expand(const StructOrUnionSpec::StructDeclaration &node,
+                           uint32_t slot) {
+  uint32_t first =
+      Place(slot, Begin(ASTNodeKind::StructDeclaration, node.beginLoc_),
+            1 + node.structDeclarators_.size());
+  Push(first, node.specifierQualifiers_);
+  PushAll(first + 1, node.structDeclarators_);
+}
+
+void RecordBuilder::Expand(const StructOrUnionSpec::StructDeclarator &node,
+                           uint32_t slot) {
+  uint32_t first =
+      Place(slot, Begin(ASTNodeKind::StructDeclarator, node.beginLoc_), 2);
+  Push(first, node.optionalDeclarator_);
+  Push(first + 1, node.optionalBitfield_);
+}
+
+void RecordBuilder::Expand(const EnumSpecifier &node, uint32_t slot) {
+  const auto &enumerators = node.getEnumerators();
+  uint32_t first = Place(slot,
+                         Begin(ASTNodeKind::EnumSpecifier, node.getBeginLoc(),
+                               0, node.getName()),
+                         enumerators.size());
+  PushAll(first, enumerators);
+}
+
+void RecordBuilder::Expand(const EnumSpecifier::Enumerator &node,
+                           uint32_t slot) {
+  uint32_t first = Place(
+      slot, Begin(ASTNodeKind::Enumerator, node.beginLoc_, 0, node.name_), 1);
+  Push(first, node.optionalConstantExpr_);
+}
+
+void RecordBuilder::Expand(const TypeName &node, uint32_t slot) {
+  uint32_t first =
+      Place(slot, Begin(ASTNodeKind::TypeName, node.getBeginLoc()), 2);
+  Push(first, node.getSpecifierQualifiers());
+  Push(first + 1, node.getAbstractDeclarator());
+}
+
+void RecordBuilder::Expand(const Declarator &node, uint32_t slot) {
+  const auto &pointers = node.getPointers();
+  uint32_t first =
+      Place(slot, Begin(ASTNodeKind::Declarator, node.getBeginLoc()),
+            1 + pointers.size());
+  Push(first, node.getDirectDeclarator());
+  PushAll(first + 1, pointers);
+}
+
+void RecordBuilder::Expand(const Pointer &node, uint32_t slot) {
+  const auto &qualifiers = node.getTypeQualifiers();
+  uint32_t first = Place(
+      slot, Begin(ASTNodeKind::Pointer, node.getBeginLoc()), qualifiers.size());
+  PushAll(first, qualifiers);
+}
+
+void RecordBuilder::Expand(const DirectDeclaratorIdent &node, uint32_t slot) {
+  Place(slot, Begin(ASTNodeKind::DirectDeclaratorIdent, node.getBeginLoc(), 0,
+                    AddString(node.getIdent())));
+}
+
+void RecordBuilder::Expand(const DirectDeclaratorParentheses &node,
+                           uint32_t slot) {
+  uint32_t first = Place(
+      slot,
+      Begin(ASTNodeKind::DirectDeclaratorParentheses, node.getBeginLoc()), 1);
+  Push(first, node.getDeclarator());
+}
+
+void RecordBuilder::Expand(const DirectDeclaratorAssignExpr &node,
+                           uint32_t slot) {
+  const auto &qualifiers = node.getTypeQualifierList();
+  uint32_t first =
+      Place(slot,
+            Begin(ASTNodeKind::DirectDeclaratorAssignExpr, node.getBeginLoc(),
+                  node.hasStatic()),
+            2 + qualifiers.size());
+  Push(first, node.getDirectDeclarator());
+  Push(first + 1, node.getAssignmentExpression());
+  PushAll(first + 2, qualifiers);
+}
+
+void RecordBuilder::Expand(const DirectDeclaratorAsterisk &node,
+                           uint32_t slot) {
+  const auto &qualifiers = node.getTypeQualifierList();
+  uint32_t first = Place(
+      slot, Begin(ASTNodeKind::DirectDeclaratorAsterisk, node.getBeginLoc()),
+      1 + qualifiers.size());
+  Push(first, node.getDirectDeclarator());
+  PushAll(first + 1, qualifiers);
+}
+
+void RecordBuilder::Expand(const DirectDeclaratorParamTypeList &node,
+                           uint32_t slot) {
+  uint32_t first = Place(
+      slot,
+      Begin(ASTNodeKind::DirectDeclaratorParamTypeList, node.getBeginLoc()),
+      2);
+  Push(first, node.getDirectDeclarator());
+  Push(first + 1, node.getParamTypeList());
+}
+
+void RecordBuilder::Expand(const AbstractDeclarator &node, uint32_t slot) {
+  const auto &pointers = node.getPointers();
+  uint32_t first =
+      Place(slot, Begin(ASTNodeKind::AbstractDeclarator, node.getBeginLoc()),
+            1 + pointers.size());
+  Push(first, node.getDirectAbstractDeclarator());
+  PushAll(first + 1, pointers);
+}
+
+void RecordBuilder::Expand(const DirectAbstractDeclaratorParentheses &node,
+                           uint32_t slot) {
+  uint32_t first =
+      Place(slot,
+            Begin(ASTNodeKind::DirectAbstractDeclaratorParentheses,
+                  node.getBeginLoc()),
+            1);
+  Push(first, node.getAbstractDeclarator());
+}
+
+void RecordBuilder::Expand(const DirectAbstractDeclaratorAssignExpr &node,
+                           uint32_t slot) {
+  const auto &qualifiers = node.getTypeQualifiers();
+  uint32_t first =
+      Place(slot,
+            Begin(ASTNodeKind::DirectAbstractDeclaratorAssignExpr,
+                  node.getBeginLoc(), node.hasStatic()),
+            2 + qualifiers.size());
+  Push(first, node.getDirectAbstractDeclarator());
+  Push(first + 1, node.getAssignmentExpression());
+  PushAll(first + 2, qualifiers);
+}
+
+void RecordBuilder::Expand(const DirectAbstractDeclaratorAsterisk &node,
+                           uint32_t slot) {
+  uint32_t first =
+      Place(slot,
+            Begin(ASTNodeKind::DirectAbstractDeclaratorAsterisk,
+                  node.getBeginLoc()),
+            1);
+  Push(first, node.getDirectAbstractDeclarator());
+}
+
+void RecordBuilder::Expand(const DirectAbstractDeclaratorParamTypeList &node,
+                           uint32_t slot) {
+  uint32_t first =
+      Place(slot,
+            Begin(ASTNodeKind::DirectAbstractDeclaratorParamTypeList,
+                  node.getBeginLoc()),
+            2);
+  Push(first, node.getDirectAbstractDeclarator());
+  Push(first + 1, node.getParameterTypeList());
+}
+
+void RecordBuilder::Expand(const ParamTypeList &node, uint32_t slot) {
+  uint32_t first = Place(slot,
+                         Begin(ASTNodeKind::ParamTypeList, node.getBeginLoc(),
+                               node.hasEllipse()),
+                         1);
+  Push(first, node.getParameterList());
+}
+
+void RecordBuilder::Expand(const ParamList &node, uint32_t slot) {
+  const auto &parameters = node.getParameterDeclarations();
+  uint32_t first =
+      Place(slot, Begin(ASTNodeKind::ParamList, node.getBeginLoc()),
+            parameters.size());
+  PushAll(first, parameters);
+}
+
+void RecordBuilder::Expand(const ParameterDeclaration &node, uint32_t slot) {
+  uint32_t first = Place(
+      slot, Begin(ASTNodeKind::ParameterDeclaration, node.getBeginLoc()), 2);
+  Push(first, node.getDeclSpec());
+  Push(first + 1, node.declaratorKind_);
+}
+
+void RecordBuilder::Expand(const Initializer &node, uint32_t slot) {
+  uint32_t first =
+      Place(slot, Begin(ASTNodeKind::Initializer, node.getBeginLoc()), 1);
+  Push(first, node.getVariant());
+}
+
+void RecordBuilder::Expand(const InitializerList &node, uint32_t slot) {
+  const auto &entries = node.getInitializerList();
+  uint32_t first =
+      Place(slot, Begin(ASTNodeKind::InitializerList, node.getBeginLoc()),
+            entries.size());
+  PushAll(first, entries);
+}
+
+void RecordBuilder::Expand(const InitializerList::InitializerPair &node,
+                           uint32_t slot) {
+  const auto &[designation, initializer] = node;
+  uint32_t numDesignators = designation ? designation->size() : 0;
+  uint32_t first = Place(
+      slot, Begin(ASTNodeKind::InitializerEntry, initializer.getBeginLoc()),
+      1 + numDesignators);
+  Push(first, initializer);
+  for (uint32_t i = 0; i < numDesignators; ++i) {
+    mTasks.push_back(
+        {&RecordBuilder::ExpandDesignator, &node, first + 1 + i, i});
+  }
+}
+
+void RecordBuilder::ExpandDesignator(const void *entry, uint32_t slot,
+                                     uint32_t part) {
+  const auto &[designation, initializer] =
+      *static_cast<const InitializerList::InitializerPair *>(entry);
+  const auto &designator = (*designation)[part];
+  if (const auto *index = std::get_if<ConstantExpr>(&designator)) {
+    uint32_t first = Place(
+        slot, Begin(ASTNodeKind::IndexDesignator, index->getBeginLoc()), 1);
+    Push(first, *index);
+  } else {
+    /// a member name keeps no token, it is located at its entry
+    Place(slot,
+          Begin(ASTNodeKind::FieldDesignator, initializer.getBeginLoc(), 0,
+                AddString(std::get<InitializerList::Identifier>(designator))));
+  }
+}
+
+void RecordBuilder::Expand(const EmbedData &node, uint32_t slot) {
+  Place(slot, Begin(ASTNodeKind::EmbedData, node.getBeginLoc(), 0,
+                    AddString(node.getBytes())));
+}
+
+void RecordBuilder::Expand(const BlockStmt &node, uint32_t slot) {
+  const auto &items = node.getBlockItems();
+  uint32_t first = Place(
+      slot, Begin(ASTNodeKind::BlockStmt, node.getBeginLoc()), items.size());
+  PushAll(first, items);
+}
+
+void RecordBuilder::Expand(const ReturnStmt &node, uint32_t slot) {
+  uint32_t first =
+      Place(slot, Begin(ASTNodeKind::ReturnStmt, node.getBeginLoc()), 1);
+  Push(first, node.getExpression());
+}
+
+void RecordBuilder::Expand(const ExprStmt &node, uint32_t slot) {
+  uint32_t first =
+      Place(slot, Begin(ASTNodeKind::ExprStmt, node.getBeginLoc()), 1);
+  Push(first, node.getOptionalExpression());
+}
+
+void RecordBuilder::Expand(const IfStmt &node, uint32_t slot) {
+  uint32_t first =
+      Place(slot, Begin(ASTNodeKind::IfStmt, node.getBeginLoc()), 3);
+  Push(first, node.getExpression());
+  Push(first + 1, node.getThenStmt());
+  Push(first + 2, node.getElseStmt());
+}
+
+void RecordBuilder::Expand(const SwitchStmt &node, uint32_t slot) {
+  uint32_t first =
+      Place(slot, Begin(ASTNodeKind::SwitchStmt, node.getBeginLoc()), 2);
+  Push(first, node.getExpression());
+  Push(first + 1, node.getStatement());
+}
+
+void RecordBuilder::Expand(const DefaultStmt &node, uint32_t slot) {
+  uint32_t first =
+      Place(slot, Begin(ASTNodeKind::DefaultStmt, node.getBeginLoc()), 1);
+  Push(first, node.getStatement());
+}
+
+void RecordBuilder::Expand(const CaseStmt &node, uint32_t slot) {
+  uint32_t first =
+      Place(slot, Begin(ASTNodeKind::CaseStmt, node.getBeginLoc()), 2);
+  Push(first, node.getConstantExpr());
+  Push(first + 1, node.getStatement());
+}
+
+void RecordBuilder::Expand(const LabelStmt &node, uint32_t slot) {
+  Place(slot, Begin(ASTNodeKind::LabelStmt, node.getBeginLoc(), 0,
+                    AddString(node.getIdentifier())));
+}
+
+void RecordBuilder::Expand(const GotoStmt &node, uint32_t slot) {
+  Place(slot, Begin(ASTNodeKind::GotoStmt, node.getBeginLoc(), 0,
+                    AddString(node.getIdentifier())));
+}
+
+void RecordBuilder::Expand(const DoWhileStmt &node, uint32_t slot) {
+  uint32_t first =
+      Place(slot, Begin(ASTNodeKind::DoWhileStmt, node.getBeginLoc()), 2);
+  Push(first, node.getStatement());
+  Push(first + 1, node.getExpression());
+}
+
+void RecordBuilder::Expand(const WhileStmt &node, uint32_t slot) {
+  uint32_t first =
+      Place(slot, Begin(ASTNodeKind::WhileStmt, node.getBeginLoc()), 2);
+  Push(first, node.getExpression());
+  Push(first + 1, node.getStatement());
+}
+
+void RecordBuilder::Expand(const ForStmt &node, uint32_t slot) {
+  uint32_t first =
+      Place(slot, Begin(ASTNodeKind::ForStmt, node.getBeginLoc()), 4);
+  Push(first, node.getInitial());
+  Push(first + 1, node.getControlling());
+  Push(first + 2, node.getPost());
+  Push(first + 3, node.getStatement());
+}
+
+void RecordBuilder::Expand(const BreakStmt &node, uint32_t slot) {
+  Place(slot, Begin(ASTNodeKind::BreakStmt, node.getBeginLoc()));
+}
+
+void RecordBuilder::Expand(const ContinueStmt &node, uint32_t slot) {
+  Place(slot, Begin(ASTNodeKind::ContinueStmt, node.getBeginLoc()));
+}
+
+void RecordBuilder::Expand(const Expr &node, uint32_t slot) {
+  const auto &exprs = node.getAssignExpressions();
+  uint32_t first = Place(
+      slot, Begin(ASTNodeKind::Expr, node.getBeginLoc()), exprs.size());
+  PushAll(first, exprs);
+}
+
+void RecordBuilder::Expand(const AssignExpr &node, uint32_t slot) {
+  const auto &operands = node.getOptionalConditionalExpr();
+  uint32_t first =
+      Place(slot, Begin(ASTNodeKind::AssignExpr, node.getBeginLoc()),
+            1 + operands.size());
+  Push(first, node.getConditionalExpr());
+  PushAll(first + 1, operands);
+}
+
+void RecordBuilder::Expand(const AssignOperand &node, uint32_t slot) {
+  const auto &[op, condExpr] = node;
+  uint32_t first = Place(
+      slot, Begin(ASTNodeKind::AssignOperand, condExpr.getBeginLoc(), op), 1);
+  Push(first, condExpr);
+}
+
+void RecordBuilder::Expand(const CondExpr &node, uint32_t slot) {
+  uint32_t first =
+      Place(slot, Begin(ASTNodeKind::CondExpr, node.getBeginLoc()), 3);
+  Push(first, node.getLogicalOrExpression());
+  Push(first + 1, node.getOptionalExpression());
+  Push(first + 2, node.getOptionalConditionalExpression());
+}
+
+void RecordBuilder::Expand(const BinaryExpr &node, uint32_t slot) {
+  uint32_t first =
+      Place(slot,
+            Begin(ASTNodeKind::BinaryExpr, node.getBeginLoc(),
+                  static_cast<uint32_t>(node.getOperator())),
+            2);
+  Push(first, node.getLhs());
+  Push(first + 1, node.getRhs());
+}
+
+void RecordBuilder::Expand(const CastExpr &node, uint32_t slot) {
+  if (const auto *cast =
+          std::get_if<CastExpr::TypeNameCast>(&node.getVariant())) {
+    uint32_t first =
+        Place(slot, Begin(ASTNodeKind::CastExpr, node.getBeginLoc()), 2);
+    Push(first, cast->first);
+    Push(first + 1, cast->second);
+  } else {
+    uint32_t first =
+        Place(slot, Begin(ASTNodeKind::CastExpr, node.getBeginLoc()), 1);
+    Push(first, std::get<UnaryExpr>(node.getVariant()));
+  }
+}
+
+void RecordBuilder::Expand(const UnaryExprUnaryOperator &node,
+                           uint32_t slot) {
+  uint32_t first =
+      Place(slot,
+            Begin(ASTNodeKind::UnaryExprUnaryOperator, node.getBeginLoc(),
+                  static_cast<uint32_t>(node.getOperator())),
+            1);
+  Push(first, node.getCastExpr());
+}
+
+void RecordBuilder::Expand(const UnaryExprSizeOf &node, uint32_t slot) {
+  uint32_t first =
+      Place(slot, Begin(ASTNodeKind::UnaryExprSizeOf, node.getBeginLoc()), 1);
+  Push(first, node.getVariant());
+}
+
+void RecordBuilder::Expand(const PostFixExprSubscript &node, uint32_t slot) {
+  uint32_t first = Place(
+      slot, Begin(ASTNodeKind::PostFixExprSubscript, node.getBeginLoc()), 2);
+  Push(first, node.getPostFixExpr());
+  Push(first + 1, node.getExpr());
+}
+
+void RecordBuilder::Expand(const PostFixExprFuncCall &node, uint32_t slot) {
+  const auto &arguments = node.getOptionalAssignExpressions();
+  uint32_t first =
+      Place(slot, Begin(ASTNodeKind::PostFixExprFuncCall, node.getBeginLoc()),
+            1 + arguments.size());
+  Push(first, node.getPostFixExpr());
+  PushAll(first + 1, arguments);
+}
+
+void RecordBuilder::Expand(const PostFixExprDot &node, uint32_t slot) {
+  uint32_t first = Place(slot,
+                         Begin(ASTNodeKind::PostFixExprDot, node.getBeginLoc(),
+                               0, node.getIdentifier()),
+                         1);
+  Push(first, node.getPostFixExpr());
+}
+
+void RecordBuilder::Expand(const PostFixExprArrow &node, uint32_t slot) {
+  uint32_t first =
+      Place(slot,
+            Begin(ASTNodeKind::PostFixExprArrow, node.getBeginLoc(), 0,
+                  node.getIdentifier()),
+            1);
+  Push(first, node.getPostFixExpr());
+}
+
+void RecordBuilder::Expand(const PostFixExprIncrement &node, uint32_t slot) {
+  uint32_t first = Place(
+      slot, Begin(ASTNodeKind::PostFixExprIncrement, node.getBeginLoc()), 1);
+  Push(first, node.getPostFixExpr());
+}
+
+void RecordBuilder::Expand(const PostFixExprDecrement &node, uint32_t slot) {
+  uint32_t first = Place(
+      slot, Begin(ASTNodeKind::PostFixExprDecrement, node.getBeginLoc()), 1);
+  Push(first, node.getPostFixExpr());
+}
+
+void RecordBuilder::Expand(const PostFixExprTypeInitializer &node,
+                           uint32_t slot) {
+  uint32_t first = Place(
+      slot,
+      Begin(ASTNodeKind::PostFixExprTypeInitializer, node.getBeginLoc()), 2);
+  Push(first, node.getTypeName());
+  Push(first + 1, node.getInitializerList());
+}
+
+void RecordBuilder::Expand(const PrimaryExprIdent &node, uint32_t slot) {
+  Place(slot, Begin(ASTNodeKind::PrimaryExprIdent, node.getBeginLoc(), 0,
+                    AddString(node.getIdentifier())));
+}
+
+void RecordBuilder::Expand(const PrimaryExprConstant &node, uint32_t slot) {
+  const auto &value = node.getValue();
+  auto kind = static_cast<uint32_t>(value.index());
+  if (const auto *str = std::get_if<std::string_view>(&value)) {
+    Place(slot, Begin(ASTNodeKind::PrimaryExprConstant, node.getBeginLoc(),
+                      kind, AddString(*str)));
+    return;
+  }
+  mConstants.push_back(
+      std::visit([](auto number) { return ConstantBits(number); }, value));
+  Place(slot, Begin(ASTNodeKind::PrimaryExprConstant, node.getBeginLoc(), kind,
+                    mConstants.size() - 1));
+}
+
+void RecordBuilder::Expand(const ConstantArray &node, uint32_t slot) {
+  const auto &values = node.getValues();
+  auto kind = static_cast<uint32_t>(values.index());
+  uint32_t first = mConstants.size();
+  mConstants.push_back(node.size());
+  std::visit(
+      [this](auto numbers) {
+        for (auto number : numbers) {
+          mConstants.push_back(ConstantBits(number));
+        }
+      },
+      values);
+  Place(slot,
+        Begin(ASTNodeKind::ConstantArray, node.getBeginLoc(), kind, first));
+}
+
+void RecordBuilder::Expand(const PrimaryExprParentheses &node,
+                           uint32_t slot) {
+  uint32_t first = Place(
+      slot, Begin(ASTNodeKind::PrimaryExprParentheses, node.getBeginLoc()), 1);
+  Push(first, node.getExpr());
+}
+
+void RecordBuilder::Emit(raw_ostream &os) const {
+  uint32_t header[astfile::NumHeaderFields];
+  header[astfile::NumNodeKinds] =
+      static_cast<uint32_t>(ASTNodeKind::NUM_KINDS);
+  uint32_t offset = sizeof(astfile::Magic) + sizeof(header);
+  auto place = [&offset](size_t size) {
+    uint32_t start = offset;
+    offset = alignTo(offset + size, 4);
+    return start;
+  };
+  header[astfile::NodesOffset] =
+      place(mNodes.size() * astfile::NodeWords * 4);
+  header[astfile::NumNodes] = mNodes.size();
+  header[astfile::ChildrenOffset] = place(mChildren.size() * 4);
+  header[astfile::NumChildren] = mChildren.size();
+  header[astfile::ConstantsOffset] =
+      place(mConstants.size() * astfile::ConstantWords * 4);
+  header[astfile::NumConstants] = mConstants.size();
+  header[astfile::StringsOffset] = place(mStrings.size());
+  header[astfile::StringsSize] = mStrings.size();
+  header[astfile::StringTableOffset] =
+      place(mStringTable.size() * astfile::StringWords * 4);
+  header[astfile::NumStrings] = mStringTable.size();
+  header[astfile::FilesOffset] = place(mFiles.size() * 4);
+  header[astfile::NumFiles] = mFiles.size();
+
+  support::endian::Writer writer(os, support::little);
+  os.write(astfile::Magic, sizeof(astfile::Magic));
+  writer.write(ArrayRef<uint32_t>(header));
+  for (const auto &node : mNodes) {
+    writer.write(node.Kind);
+    writer.write(node.File);
+    writer.write(node.Offset);
+    writer.write(node.Value);
+    writer.write(node.FirstChild);
+    writer.write(node.NumChildren);
+  }
+  writer.write(ArrayRef<uint32_t>(mChildren));
+  for (uint64_t constant : mConstants) {
+    writer.write(uint32_t(constant));
+    writer.write(uint32_t(constant >> 32));
+  }
+  os << mStrings;
+  for (size_t i = mStrings.size(); i % 4 != 0; ++i) {
+    os << '\0';
+  }
+  for (auto [stringOffset, length] : mStringTable) {
+    writer.write(stringOffset);
+    writer.write(length);
+  }
+  writer.write(ArrayRef<uint32_t>(mFiles));
+}
+} // namespace
+
+void ASTWriter::Emit(const TranslationUnit &unit, const SourceMgr &srcMgr,
+                     raw_ostream &os) {
+  RecordBuilder builder(srcMgr);
+  builder.Build(unit);
+  builder.Emit(os);
+}
+} // namespace lcc
@@ -0,0 +1,67 @@
+/***********************************
+ * File:     PCHFormat.h
+ *
+ * Author:   caipeng
+ *
+ * Email:    iiicp@outlook.com
+ *
+ * Date:     2023/6/14
+ *
+ * Sign:     enjoy life
+ ***********************************/
+
+#ifndef LCC_PCHFORMAT_H
+#define LCC_PCHFORMAT_H
+
+#include <cstdint>
+
+/// the layout shared by PCHWriter and PCHReader, see lcc/Serialization/PCH.h
+namespace lcc::pch {
+
+/// the last byte is the format version, bump it on every layout change
+inline constexpr char Magic[8] = {'L', 'C', 'C', 'P', 'C', 'H', '\0', 3};
+
+/// the words following the magic
+enum HeaderField : unsigned {
+  /// a pch is only valid for the token kinds it was written with
+  NumTokenKinds,
+  TextOffset,
+  TextSize,
+  StringsOffset,
+  StringsSize,
+  InputsOffset,
+  NumInputs,
+  MacroRecordsOffset,
+  MacroRecordsSize,
+  MacroTableOffset,
+  NumMacroBuckets,
+  BindingTableOffset,
+  NumBindingBuckets,
+  ASTOffset,
+  ASTSize,
+  NumHeaderFields
+};
+
+/// {name offset, name length, size (2 words), mtime (2 words)}
+inline constexpr unsigned InputFileWords = 6;
+/// {hash, record offset}, an offset of 0 marks an empty bucket
+inline constexpr unsigned MacroBucketWords = 2;
+
+/// a macro record is {name offset, name length, definition offset, flags,
+/// number of params, number of tokens}, then {offset, length} per param and
+/// TokenWords per token of the body
+inline constexpr unsigned MacroRecordWords = 6;
+enum MacroFlags : uint32_t { MacroFunctionLike = 1, MacroVariadic = 2 };
+
+/// {kind | flags, arg no, loc, spelling offset, spelling length}
+inline constexpr unsigned TokenWords = 5;
+inline constexpr uint32_t TokenLeadingSpace = 1u << 16;
+inline constexpr uint32_t TokenKindMask = 0xffff;
+
+/// a file scope binding of the prefix is {hash, name offset, name length,
+/// flags}, the name is in the strings. A bucket without BindingUsed is empty
+inline constexpr unsigned BindingBucketWords = 4;
+enum BindingFlags : uint32_t { BindingUsed = 1, BindingTypedef = 2 };
+} // namespace lcc::pch
+
+#endif // LCC_PCHFORMAT_H
@@ -0,0 +1,224 @@
+/***********************************
+ * File:     PCHReader.cc
+ *
+ * Author:   caipeng
+ *
+ * Email:    iiicp@outlook.com
+ *
+ * Date:     2023/6/14
+ *
+ * Sign:     enjoy life
+ ***********************************/
+
+#include "PCHFormat.h"
+#include "lcc/Serialization/PCH.h"
+#include "llvm/Support/DJB.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/FileSystem.h"
+#include <cstring>
+
+namespace lcc {
+
+using namespace llvm;
+
+static uint32_t ReadWord(const char *ptr, unsigned index = 0) {
+  return support::endian::read32le(ptr + index * 4);
+}
+
+static Error MakeError(StringRef fileName, const Twine &message) {
+  return createStringError(inconvertibleErrorCode(),
+                           "%s: %s", fileName.str().c_str(),
+                           message.str().c_str());
+}
+
+Expected<std::unique_ptr<PCHReader>> PCHReader::Load(StringRef path) {
+  /// mapped when the file is big enough, nothing is read until it is touched
+  auto buffer = MemoryBuffer::getFile(path, /*IsText=*/false,
+                                      /*RequiresNullTerminator=*/false);
+  if (!buffer) {
+    return MakeError(path, buffer.getError().message());
+  }
+  std::unique_ptr<PCHReader> reader(new PCHReader());
+  reader->mFileName = path.str();
+  reader->mBuffer = std::move(*buffer);
+  const char *data = reader->mBuffer->getBufferStart();
+  uint64_t size = reader->mBuffer->getBufferSize();
+
+  uint32_t header[pch::NumHeaderFields];
+  if (size < sizeof(pch::Magic) + sizeof(header) ||
+      std::memcmp(data, pch::Magic, sizeof(pch::Magic)) != 0) {
+    return MakeError(path, "not a precompiled header of this compiler");
+  }
+  for (unsigned i = 0; i < pch::NumHeaderFields; ++i) {
+    header[i] = ReadWord(data + sizeof(pch::Magic), i);
+  }
+  if (header[pch::NumTokenKinds] != tok::NUM_TOKENS) {
+    return MakeError(path, "precompiled header built by another version");
+  }
+  auto inBounds = [size](uint64_t offset, uint64_t length) {
+    return offset + length <= size;
+  };
+  if (!inBounds(header[pch::TextOffset], header[pch::TextSize]) ||
+      !inBounds(header[pch::StringsOffset], header[pch::StringsSize]) ||
+      !inBounds(header[pch::InputsOffset],
+                uint64_t(header[pch::NumInputs]) * pch::InputFileWords * 4) ||
+      !inBounds(header[pch::MacroRecordsOffset],
+                header[pch::MacroRecordsSize]) ||
+      !inBounds(header[pch::MacroTableOffset],
+                uint64_t(header[pch::NumMacroBuckets]) *
+                    pch::MacroBucketWords * 4) ||
+      !inBounds(header[pch::BindingTableOffset],
+                uint64_t(header[pch::NumBindingBuckets]) *
+                    pch::BindingBucketWords * 4) ||
+      !inBounds(header[pch::ASTOffset], header[pch::ASTSize]) ||
+      !isPowerOf2_32(header[pch::NumMacroBuckets]) ||
+      !isPowerOf2_32(header[pch::NumBindingBuckets])) {
+    return MakeError(path, "malformed precompiled header");
+  }
+  reader->mText = StringRef(data + header[pch::TextOffset],
+                            header[pch::TextSize]);
+  reader->mStrings = StringRef(data + header[pch::StringsOffset],
+                               header[pch::StringsSize]);
+  reader->mMacroTable = data + header[pch::MacroTableOffset];
+  reader->mNumMacroBuckets = header[pch::NumMacroBuckets];
+  reader->mBindingTable = data + header[pch::BindingTableOffset];
+  reader->mNumBindingBuckets = header[pch::NumBindingBuckets];
+
+  /// a binding is a plain {offset, length} into the strings, checking them
+  /// all here costs no decoding and leaves LookupBinding nothing to fail on:
+  /// a lost typedef name would silently parse the translation unit another way
+  for (uint32_t i = 0; i < reader->mNumBindingBuckets; ++i) {
+    const char *entry = reader->mBindingTable + i * pch::BindingBucketWords * 4;
+    if ((ReadWord(entry, 3) & pch::BindingUsed) &&
+        uint64_t(ReadWord(entry, 1)) + ReadWord(entry, 2) >
+            reader->mStrings.size()) {
+      return MakeError(path, "malformed precompiled header");
+    }
+  }
+  /// the AST section is a view of the pch, the node records are read when
+  /// they are visited
+  auto ast = ASTReader::Load(MemoryBuffer::getMemBuffer(
+      StringRef(data + header[pch::ASTOffset], header[pch::ASTSize]), path,
+      /*RequiresNullTerminator=*/false));
+  if (!ast) {
+    return ast.takeError();
+  }
+  reader->mAST = std::move(*ast);
+
+  /// read eagerly as well: a stale pch would silently compile the old
+  /// version of the prefix
+  const char *inputs = data + header[pch::InputsOffset];
+  for (uint32_t i = 0; i < header[pch::NumInputs]; ++i) {
+    const char *record = inputs + i * pch::InputFileWords * 4;
+    uint32_t nameOffset = ReadWord(record, 0), nameLength = ReadWord(record, 1);
+    if (uint64_t(nameOffset) + nameLength > reader->mStrings.size()) {
+      return MakeError(path, "malformed precompiled header");
+    }
+    StringRef name = reader->mStrings.substr(nameOffset, nameLength);
+    uint64_t fileSize = ReadWord(record, 2) | uint64_t(ReadWord(record, 3)) << 32;
+    uint64_t modTime = ReadWord(record, 4) | uint64_t(ReadWord(record, 5)) << 32;
+    sys::fs::file_status status;
+    if (sys::fs::status(name, status) || status.getSize() != fileSize ||
+        uint64_t(status.getLastModificationTime().time_since_epoch().count()) !=
+            modTime) {
+      return MakeError(path, "'" + name +
+                                 "' has been modified since the precompiled "
+                                 "header was built");
+    }
+    reader->mInputFiles.emplace_back(name.data(), name.size());
+  }
+  return std::move(reader);
+}
+
+std::optional<PCHMacro> PCHReader::LookupMacro(std::string_view name) const {
+  uint32_t hash = djbHash(StringRef(name.data(), name.size()));
+  uint64_t bufferSize = mBuffer->getBufferSize();
+  const char *data = mBuffer->getBufferStart();
+  uint32_t bucket = hash & (mNumMacroBuckets - 1);
+  for (uint32_t probe = 0; probe < mNumMacroBuckets;
+       ++probe, bucket = (bucket + 1) & (mNumMacroBuckets - 1)) {
+    const char *entry = mMacroTable + bucket * pch::MacroBucketWords * 4;
+    uint32_t offset = ReadWord(entry, 1);
+    if (!offset) {
+      return std::nullopt;
+    }
+    if (ReadWord(entry, 0) != hash) {
+      continue;
+    }
+    if (uint64_t(offset) + pch::MacroRecordWords * 4 > bufferSize) {
+      return std::nullopt;
+    }
+    const char *record = data + offset;
+    uint32_t numParams = ReadWord(record, 4), numTokens = ReadWord(record, 5);
+    if (offset + (pch::MacroRecordWords + uint64_t(numParams) * 2 +
+                  uint64_t(numTokens) * pch::TokenWords) * 4 >
+        bufferSize) {
+      return std::nullopt;
+    }
+    /// every offset below is into the text, a bad one means a corrupt file
+    bool valid = true;
+    auto text = [this, &valid](uint32_t offset, uint32_t length) {
+      if (uint64_t(offset) + length > mText.size()) {
+        valid = false;
+        return std::string_view();
+      }
+      return std::string_view(mText.data() + offset, length);
+    };
+    PCHMacro macro;
+    macro.Name = text(ReadWord(record, 0), ReadWord(record, 1));
+    if (macro.Name != name) {
+      continue;
+    }
+    macro.DefLoc = ReadWord(record, 2);
+    uint32_t flags = ReadWord(record, 3);
+    macro.FunctionLike = flags & pch::MacroFunctionLike;
+    macro.Variadic = flags & pch::MacroVariadic;
+    const char *params = record + pch::MacroRecordWords * 4;
+    for (uint32_t i = 0; i < numParams; ++i) {
+      if (macro.Variadic && i + 1 == numParams) {
+        macro.Params.push_back("__VA_ARGS__");
+      } else {
+        macro.Params.push_back(
+            text(ReadWord(params, i * 2), ReadWord(params, i * 2 + 1)));
+      }
+    }
+    const char *tokens = params + numParams * 2 * 4;
+    for (uint32_t i = 0; i < numTokens; ++i) {
+      const char *token = tokens + i * pch::TokenWords * 4;
+      uint32_t kind = ReadWord(token, 0);
+      PCHMacro::Token result;
+      result.Kind = tok::TokenKind(kind & pch::TokenKindMask);
+      result.LeadingSpace = kind & pch::TokenLeadingSpace;
+      result.ArgNo = ReadWord(token, 1);
+      result.Loc = ReadWord(token, 2);
+      result.Spelling = text(ReadWord(token, 3), ReadWord(token, 4));
+      valid &= result.Kind < tok::NUM_TOKENS && result.Loc < mText.size();
+      macro.Body.push_back(result);
+    }
+    if (!valid || macro.DefLoc >= mText.size()) {
+      return std::nullopt;
+    }
+    return macro;
+  }
+  return std::nullopt;
+}
+
+std::optional<bool> PCHReader::LookupBinding(std::string_view name) const {
+  StringRef key(name.data(), name.size());
+  uint32_t hash = djbHash(key);
+  uint32_t bucket = hash & (mNumBindingBuckets - 1);
+  for (uint32_t probe = 0; probe < mNumBindingBuckets;
+       ++probe, bucket = (bucket + 1) & (mNumBindingBuckets - 1)) {
+    const char *entry = mBindingTable + bucket * pch::BindingBucketWords * 4;
+    uint32_t flags = ReadWord(entry, 3);
+    if (!(flags & pch::BindingUsed)) {
+      return std::nullopt;
+    }
+    if (ReadWord(entry, 0) == hash &&
+        mStrings.substr(ReadWord(entry, 1), ReadWord(entry, 2)) == key) {
+      return bool(flags & pch::BindingTypedef);
+    }
+  }
+  return std::nullopt;
+}
+} // namespace lcc
@@ -0,0 +1,214 @@
+/***********************************
+ * File:     PCHWriter.cc
+ *
+ * Author:   caipeng
+ *
+ * Email:    iiicp@outlook.com
+ *
+ * Date:     2023/6/14
+ *
+ * Sign:     enjoy life
+ ***********************************/
+
+#include "PCHFormat.h"
+#include "lcc/Serialization/PCH.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/DJB.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MathExtras.h"
+
+namespace lcc {
+
+using namespace llvm;
+
+Error PCHWriter::AddInputFile(StringRef path) {
+  sys::fs::file_status status;
+  if (std::error_code ec = sys::fs::status(path, status)) {
+    return createStringError(ec, "cannot stat '%s'", path.str().c_str());
+  }
+  /// the pch may be used from another working directory
+  SmallString<256> realPath;
+  if (std::error_code ec = sys::fs::real_path(path, realPath)) {
+    return createStringError(ec, "cannot resolve '%s'", path.str().c_str());
+  }
+  InputFile file;
+  file.NameOffset = AddString({realPath.data(), realPath.size()});
+  file.NameLength = realPath.size();
+  file.Size = status.getSize();
+  file.ModTime =
+      status.getLastModificationTime().time_since_epoch().count();
+  mInputFiles.push_back(file);
+  return Error::success();
+}
+
+void PCHWriter::AddMacro(const MacroInfo &macro) {
+  MacroEntry entry;
+  entry.RecordOffset = mMacroRecords.size();
+  uint32_t defLoc = mText.size();
+  mText += "#define ";
+  entry.NameOffset = mText.size();
+  entry.NameLength = macro.getName()->Name.size();
+  mText += macro.getName()->Name;
+
+  SmallVector<std::pair<uint32_t, uint32_t>, 8> params;
+  if (macro.isFunctionLike()) {
+    mText += '(';
+    auto names = macro.getParams();
+    for (size_t i = 0; i < names.size(); ++i) {
+      if (i != 0) {
+        mText += ", ";
+      }
+      /// the reader knows the name of the last parameter of a variadic macro
+      std::string_view param = macro.isVariadic() && i + 1 == names.size()
+                                   ? std::string_view("...")
+                                   : names[i]->Name;
+      params.push_back({uint32_t(mText.size()), uint32_t(param.size())});
+      mText += param;
+    }
+    mText += ')';
+  }
+
+  uint32_t flags =
+      (macro.isFunctionLike() ? uint32_t(pch::MacroFunctionLike) : 0u) |
+      (macro.isVariadic() ? uint32_t(pch::MacroVariadic) : 0u);
+  mMacroRecords.insert(mMacroRecords.end(),
+                       {entry.NameOffset, entry.NameLength, defLoc, flags,
+                        uint32_t(params.size()),
+                        uint32_t(macro.getBody().size())});
+  for (auto [offset, length] : params) {
+    mMacroRecords.insert(mMacroRecords.end(), {offset, length});
+  }
+  for (const auto &token : macro.getBody()) {
+    /// the first token is always separated from the name, the others keep
+    /// their spacing, so the line reads like the original definition
+    if (&token == macro.getBody().begin() || token.LeadingSpace) {
+      mText += ' ';
+    }
+    uint32_t loc = mText.size();
+    uint32_t spelling = loc;
+    if (token.Kind == tok::string_literal || token.Kind == tok::char_constant) {
+      char quote = token.Kind == tok::string_literal ? '"' : '\'';
+      mText += quote;
+      spelling = mText.size();
+      mText += token.Spelling;
+      mText += quote;
+    } else {
+      mText += token.Spelling;
+    }
+    uint32_t kind =
+        token.Kind | (token.LeadingSpace ? pch::TokenLeadingSpace : 0);
+    mMacroRecords.insert(mMacroRecords.end(),
+                         {kind, uint32_t(token.ArgNo), loc, spelling,
+                          uint32_t(token.Spelling.size())});
+  }
+  mText += '\n';
+  mMacros.push_back(entry);
+}
+
+void PCHWriter::AddFileScopeBinding(std::string_view name, bool isTypedef) {
+  mBindings.push_back({AddString(name), uint32_t(name.size()), isTypedef});
+}
+
+void PCHWriter::AddAST(const Syntax::TranslationUnit &unit,
+                       const SourceMgr &srcMgr) {
+  mAST.clear();
+  raw_string_ostream os(mAST);
+  ASTWriter::Emit(unit, srcMgr, os);
+}
+
+uint32_t PCHWriter::AddString(std::string_view str) {
+  uint32_t offset = mStrings.size();
+  mStrings += str;
+  return offset;
+}
+
+/// power of two, at most half full
+static uint32_t GetNumBuckets(size_t numEntries) {
+  return NextPowerOf2(numEntries * 2);
+}
+
+void PCHWriter::Emit(raw_ostream &os) const {
+  uint32_t numMacroBuckets = GetNumBuckets(mMacros.size());
+
+  uint32_t header[pch::NumHeaderFields];
+  header[pch::NumTokenKinds] = tok::NUM_TOKENS;
+  uint32_t offset = sizeof(pch::Magic) + sizeof(header);
+  auto place = [&offset](size_t size) {
+    uint32_t start = offset;
+    offset = alignTo(offset + size, 4);
+    return start;
+  };
+  header[pch::TextOffset] = place(mText.size());
+  header[pch::TextSize] = mText.size();
+  header[pch::StringsOffset] = place(mStrings.size());
+  header[pch::StringsSize] = mStrings.size();
+  header[pch::InputsOffset] =
+      place(mInputFiles.size() * pch::InputFileWords * 4);
+  header[pch::NumInputs] = mInputFiles.size();
+  header[pch::MacroRecordsOffset] = place(mMacroRecords.size() * 4);
+  header[pch::MacroRecordsSize] = mMacroRecords.size() * 4;
+  header[pch::MacroTableOffset] =
+      place(numMacroBuckets * pch::MacroBucketWords * 4);
+  header[pch::NumMacroBuckets] = numMacroBuckets;
+  uint32_t numBindingBuckets = GetNumBuckets(mBindings.size());
+  header[pch::BindingTableOffset] =
+      place(numBindingBuckets * pch::BindingBucketWords * 4);
+  header[pch::NumBindingBuckets] = numBindingBuckets;
+  header[pch::ASTOffset] = place(mAST.size());
+  header[pch::ASTSize] = mAST.size();
+
+  std::vector<uint32_t> macroTable(numMacroBuckets * pch::MacroBucketWords);
+  for (const auto &macro : mMacros) {
+    StringRef name(mText.data() + macro.NameOffset, macro.NameLength);
+    uint32_t hash = djbHash(name);
+    uint32_t bucket = hash & (numMacroBuckets - 1);
+    while (macroTable[bucket * pch::MacroBucketWords + 1]) {
+      bucket = (bucket + 1) & (numMacroBuckets - 1);
+    }
+    macroTable[bucket * pch::MacroBucketWords] = hash;
+    macroTable[bucket * pch::MacroBucketWords + 1] =
+        header[pch::MacroRecordsOffset] + macro.RecordOffset * 4;
+  }
+  std::vector<uint32_t> bindingTable(numBindingBuckets *
+                                     pch::BindingBucketWords);
+  for (const auto &binding : mBindings) {
+    StringRef name(mStrings.data() + binding.NameOffset, binding.NameLength);
+    uint32_t hash = djbHash(name);
+    uint32_t bucket = hash & (numBindingBuckets - 1);
+    while (bindingTable[bucket * pch::BindingBucketWords + 3]) {
+      bucket = (bucket + 1) & (numBindingBuckets - 1);
+    }
+    uint32_t *entry = &bindingTable[bucket * pch::BindingBucketWords];
+    entry[0] = hash;
+    entry[1] = binding.NameOffset;
+    entry[2] = binding.NameLength;
+    entry[3] = pch::BindingUsed |
+               (binding.IsTypedef ? uint32_t(pch::BindingTypedef) : 0u);
+  }
+
+  support::endian::Writer writer(os, support::little);
+  auto pad = [&os](size_t size) {
+    for (size_t i = size; i % 4 != 0; ++i) {
+      os << '\0';
+    }
+  };
+  os.write(pch::Magic, sizeof(pch::Magic));
+  writer.write(ArrayRef<uint32_t>(header));
+  os << mText;
+  pad(mText.size());
+  os << mStrings;
+  pad(mStrings.size());
+  for (const auto &file : mInputFiles) {
+    writer.write(file.NameOffset);
+    writer.write(file.NameLength);
+    writer.write(file.Size);
+    writer.write(file.ModTime);
+  }
+  writer.write(ArrayRef<uint32_t>(mMacroRecords));
+  writer.write(ArrayRef<uint32_t>(macroTable));
+  writer.write(ArrayRef<uint32_t>(bindingTable));
+  os << mAST;
+}
+} // namespace lcc
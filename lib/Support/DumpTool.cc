@@ -13,6 +13,7 @@
 #include "lcc/Basic/Match.h"
 #include "lcc/Basic/Util.h"
 #include "lcc/Basic/ValueReset.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/Support/raw_ostream.h"
 namespace lcc::dump {
 
@@ -53,6 +54,11 @@ void dumpTokens(const std::vector<lcc::Token> &tokens) {
   for (auto &tok : tokens) {
 //    llvm::outs() << tok.getLine() << ", " << tok.getColumn() << ", " << tok.getRepresentation() << "\n";
     auto pair = tok.getLineAndColumn();
+    if (tok.getTokenKind() == tok::embed_data) {
+      llvm::outs() << pair.first << ", " << pair.second << ", <embed "
+                   << tok.getRepresentation().size() << " bytes>\n";
+      continue;
+    }
     llvm::outs() << pair.first << ", " << pair.second << ", " << tok.getRepresentation() << "\n";
   }
 }
@@ -100,14 +106,57 @@ void visit(const Syntax::DeclSpec &declarationSpecifiers) {
   Print("DeclSpec");
   llvm::outs() << &declarationSpecifiers << "\n";
   ValueReset v(LeftAlign, LeftAlign+1);
-  for (const auto &storage : declarationSpecifiers.getStorageClassSpecifiers()) {
-    visit(storage);
-  }
-  for (const auto &qualifier : declarationSpecifiers.getTypeQualifiers()) {
-    visit(qualifier);
-  }
-  for (const auto &specifier : declarationSpecifiers.getTypeSpecs()) {
-    visit(specifier);
+  static const char *storageClasses[] = {"Typedef", "Extern", "Static", "Auto",
+                                         "Register"};
+  for (unsigned i = 0; i < std::size(storageClasses); ++i) {
+    if (declarationSpecifiers.hasStorageClass(
+            static_cast<Syntax::DeclSpec::StorageClass>(i))) {
+      Print("StorageClsSpec");
+      llvm::outs() << "\n";
+      ValueReset v(LeftAlign, LeftAlign + 1);
+      Println(storageClasses[i]);
+    }
+  }
+  static const char *qualifiers[] = {"Const", "Restrict", "Volatile"};
+  for (unsigned i = 0; i < std::size(qualifiers); ++i) {
+    if (declarationSpecifiers.hasQualifier(
+            static_cast<Syntax::TypeQualifier::Qualifier>(i))) {
+      Print("TypeQualifier");
+      llvm::outs() << "\n";
+      ValueReset v(LeftAlign, LeftAlign + 1);
+      Println(qualifiers[i]);
+    }
+  }
+  if (declarationSpecifiers.isInline()) {
+    Print("FunctionSpecifier");
+    llvm::outs() << "\n";
+    ValueReset v(LeftAlign, LeftAlign + 1);
+    Println("inline");
+  }
+  /// in the order of TypeSpec::PrimTypeKind
+  static const char *primTypes[] = {"Void",   "Char",   "Short",
+                                    "Int",    "Long",   "Float",
+                                    "Double", "Signed", "Unsigned",
+                                    "Bool"};
+  for (unsigned i = 0; i < std::size(primTypes); ++i) {
+    if (!(declarationSpecifiers.getPrimTypes() & (1u << i))) {
+      continue;
+    }
+    unsigned count = (1u << i) == Syntax::TypeSpec::Long
+                         ? declarationSpecifiers.getNumLongs()
+                         : 1;
+    while (count--) {
+      Print("TypeSpec");
+      llvm::outs() << "\n";
+      ValueReset v(LeftAlign, LeftAlign + 1);
+      Print("PrimTypeKind");
+      llvm::outs() << "\n";
+      ValueReset v1(LeftAlign, LeftAlign + 1);
+      Println(primTypes[i]);
+    }
+  }
+  if (const auto *typeSpec = declarationSpecifiers.getTypeSpec()) {
+    visit(*typeSpec);
   }
 }
 void visit(const Syntax::Declarator &declarator) {
@@ -141,6 +190,18 @@ void visit(const Syntax::Initializer &initializer) {
       [](const Syntax::AssignExpr &assignExpr) { visit(assignExpr); },
       [](const box<Syntax::InitializerList> &initializerList) {
         visit(*initializerList);
+      },
+      [](const Syntax::EmbedData &embedData) {
+        ValueReset v(LeftAlign, LeftAlign + 1);
+        Print("EmbedData");
+        llvm::outs() << &embedData << " " << embedData.getBytes().size()
+                     << " bytes\n";
+      },
+      [](const Syntax::ConstantArray &constantArray) {
+        ValueReset v(LeftAlign, LeftAlign + 1);
+        Print("ConstantArray");
+        llvm::outs() << &constantArray << " " << constantArray.size()
+                     << " constants\n";
       });
 }
 
@@ -166,28 +227,6 @@ void visit(const Syntax::InitializerList &initializerList) {
   }
 }
 
-void visit(const Syntax::StorageClsSpec &storageClassSpecifier) {
-  Print("StorageClsSpec");
-  llvm::outs() << &storageClassSpecifier << "\n";
-  ValueReset v(LeftAlign, LeftAlign+1);
-  switch (storageClassSpecifier.getSpecifier()) {
-  case Syntax::StorageClsSpec::Typedef:
-    Println("Typedef");
-    break;
-  case Syntax::StorageClsSpec::Extern:
-    Println("Extern");
-    break;
-  case Syntax::StorageClsSpec::Static:
-    Println("Static");
-    break;
-  case Syntax::StorageClsSpec::Auto:
-    Println("Auto");
-    break;
-  case Syntax::StorageClsSpec::Register:
-    Println("Register");
-    break;
-  }
-}
 void visit(const Syntax::TypeQualifier &typeQualifier) {
   Print("TypeQualifier");
   llvm::outs() << &typeQualifier << "\n";
@@ -210,53 +249,6 @@ void visit(const Syntax::TypeSpec &typeSpecifier) {
   ValueReset v(LeftAlign, LeftAlign+1);
   match(
       typeSpecifier.getVariant(),
-      [](const Syntax::TypeSpec::PrimTypeKind &primitiveTypeSpecifier) {
-        Print("PrimTypeKind");
-        llvm::outs() << &primitiveTypeSpecifier << "\n";
-        ValueReset v(LeftAlign, LeftAlign + 1);
-        switch (primitiveTypeSpecifier) {
-        case Syntax::TypeSpec::Void: {
-          Println("Void");
-          break;
-        }
-        case Syntax::TypeSpec::Char: {
-          Println("Char");
-          break;
-        }
-        case Syntax::TypeSpec::Bool: {
-          Println("Bool");
-          break;
-        }
-        case Syntax::TypeSpec::Short: {
-          Println("Short");
-          break;
-        }
-        case Syntax::TypeSpec::Int: {
-          Println("Int");
-          break;
-        }
-        case Syntax::TypeSpec::Long: {
-          Println("Long");
-          break;
-        }
-        case Syntax::TypeSpec::Float: {
-          Println("Float");
-          break;
-        }
-        case Syntax::TypeSpec::Double: {
-          Println("Double");
-          break;
-        }
-        case Syntax::TypeSpec::Unsigned: {
-          Println("Unsigned");
-          break;
-        }
-        case Syntax::TypeSpec::Signed: {
-          Println("Signed");
-          break;
-        }
-        }
-      },
       [](const box<Syntax::StructOrUnionSpec> &structOrUnionSpecifier) {
         Print("StructOrUnionSpec");
         llvm::outs() << &structOrUnionSpecifier << " "
@@ -297,12 +289,6 @@ void visit(const Syntax::TypeSpec &typeSpecifier) {
         Println(stringView);
       });
 }
-void visit(const Syntax::FunctionSpecifier &functionSpecifier) {
-  Print("FunctionSpecifier");
-  llvm::outs() << &functionSpecifier << "\n";
-  ValueReset v(LeftAlign, LeftAlign+1);
-  Println("inline");
-}
 
 void visit(const Syntax::Pointer &pointer) {
   Print("Pointer");
@@ -659,7 +645,7 @@ void visit(const Syntax::ConstantExpr &constantExpr) {
   Print("CondExpr");
   llvm::outs() << &constantExpr << "\n";
   ValueReset v(LeftAlign, LeftAlign+1);
-  visit(constantExpr.getLogicalOrExpression());
+  dump::visit(constantExpr.getLogicalOrExpression(), 0);
   if (constantExpr.getOptionalExpression()) {
     visit(*constantExpr.getOptionalExpression());
   }
@@ -667,151 +653,80 @@ void visit(const Syntax::ConstantExpr &constantExpr) {
     visit(*constantExpr.getOptionalConditionalExpression());
   }
 }
-void visit(const Syntax::LogOrExpr &logOrExpr) {
-  Print("LogOrExpr");
-  llvm::outs() << &logOrExpr << "\n";
-  ValueReset v(LeftAlign, LeftAlign+1);
-  for (const auto &logAndExpr : logOrExpr.getLogAndExprs()) {
-    visit(logAndExpr);
-  }
-}
-void visit(const Syntax::LogAndExpr &logAndExpr) {
-  Print("LogAndExpr");
-  llvm::outs() << &logAndExpr << "\n";
-  ValueReset v(LeftAlign, LeftAlign+1);
-  for (const auto &bitOrExpr : logAndExpr.getBitOrExprs()) {
-    visit(bitOrExpr);
-  }
-}
-void visit(const Syntax::BitOrExpr &bitOrExpr) {
-  Print("BitOrExpr");
-  llvm::outs() << &bitOrExpr << "\n";
-  ValueReset v(LeftAlign, LeftAlign+1);
-  for (const auto &bitXorExpr : bitOrExpr.getBitXorExprs()) {
-    visit(bitXorExpr);
-  }
-}
-void visit(const Syntax::BitXorExpr &bitXorExpr) {
-  Print("BitXorExpr");
-  llvm::outs() << &bitXorExpr << "\n";
-  ValueReset v(LeftAlign, LeftAlign+1);
-  for (const auto &bitAndExpr : bitXorExpr.getBitAndExprs()) {
-    visit(bitAndExpr);
-  }
-}
-void visit(const Syntax::BitAndExpr &bitAndExpr) {
-  Print("BitAndExpr");
-  llvm::outs() << &bitAndExpr << "\n";
-  ValueReset v(LeftAlign, LeftAlign+1);
-  for (const auto &equalExpr : bitAndExpr.getEqualExpr()) {
-    visit(equalExpr);
-  }
-}
-void visit(const Syntax::EqualExpr &equalExpr) {
-  Print("EqualExpr");
-  llvm::outs() << &equalExpr << "\n";
-  ValueReset v(LeftAlign, LeftAlign+1);
-  visit(equalExpr.getRelationalExpr());
-  for (const auto &relationExpr: equalExpr.getOptionalRelationalExpr()) {
-    switch (relationExpr.first) {
-    case Syntax::EqualExpr::Equal: {
-      Println("==");
-      break;
-    }
-    case Syntax::EqualExpr::NotEqual: {
-      Println("!=");
-      break;
-    }
-    }
-    visit(relationExpr.second);
-  }
-}
-void visit(const Syntax::RelationalExpr &relationalExpr) {
-  Print("RelationalExpr");
-  llvm::outs() << &relationalExpr << "\n";
-  ValueReset v(LeftAlign, LeftAlign+1);
-  visit(relationalExpr.getShiftExpr());
-  for (const auto &shiftExpr: relationalExpr.getOptionalShiftExpressions()) {
-    switch (shiftExpr.first) {
-    case Syntax::RelationalExpr::LessThan: {
-      Println("<");
-      break;
-    }
-    case Syntax::RelationalExpr::LessThanOrEqual: {
-      Println("<=");
-      break;
-    }
-    case Syntax::RelationalExpr::GreaterThan: {
-      Println(">");
-      break;
-    }
-    case Syntax::RelationalExpr::GreaterThanOrEqual: {
-      Println(">=");
-      break;
-    }
-    }
-    visit(shiftExpr.second);
-  }
-}
-void visit(const Syntax::ShiftExpr &shiftExpr) {
-  Print("ShiftExpr");
-  llvm::outs() << &shiftExpr << "\n";
-  ValueReset v(LeftAlign, LeftAlign+1);
-  visit(shiftExpr.getAdditiveExpr());
-  for (const auto &additiveExpr: shiftExpr.getOptAdditiveExps()) {
-    switch (additiveExpr.first) {
-    case Syntax::ShiftExpr::Left: {
-      Println("<<");
-      break;
-    }
-    case Syntax::ShiftExpr::Right: {
-      Println(">>");
-      break;
-    }
-    }
-    visit(additiveExpr.second);
-  }
+static constexpr std::string_view BinaryLevelNames[] = {
+    "LogOrExpr",  "LogAndExpr",     "BitOrExpr", "BitXorExpr",   "BitAndExpr",
+    "EqualExpr",  "RelationalExpr", "ShiftExpr", "AdditiveExpr", "MultiExpr"};
+
+static std::string_view getSpelling(Syntax::BinaryExpr::Op op) {
+  switch (op) {
+  case Syntax::BinaryExpr::Op::Multiply:
+    return "*";
+  case Syntax::BinaryExpr::Op::Divide:
+    return "/";
+  case Syntax::BinaryExpr::Op::Modulo:
+    return "%";
+  case Syntax::BinaryExpr::Op::Plus:
+    return "+";
+  case Syntax::BinaryExpr::Op::Minus:
+    return "-";
+  case Syntax::BinaryExpr::Op::LeftShift:
+    return "<<";
+  case Syntax::BinaryExpr::Op::RightShift:
+    return ">>";
+  case Syntax::BinaryExpr::Op::LessThan:
+    return "<";
+  case Syntax::BinaryExpr::Op::LessThanOrEqual:
+    return "<=";
+  case Syntax::BinaryExpr::Op::GreaterThan:
+    return ">";
+  case Syntax::BinaryExpr::Op::GreaterThanOrEqual:
+    return ">=";
+  case Syntax::BinaryExpr::Op::Equal:
+    return "==";
+  case Syntax::BinaryExpr::Op::NotEqual:
+    return "!=";
+  case Syntax::BinaryExpr::Op::BitAnd:
+    return "&";
+  case Syntax::BinaryExpr::Op::BitXor:
+    return "^";
+  case Syntax::BinaryExpr::Op::BitOr:
+    return "|";
+  case Syntax::BinaryExpr::Op::LogicalAnd:
+    return "&&";
+  case Syntax::BinaryExpr::Op::LogicalOr:
+    return "||";
+  }
+  LCC_UNREACHABLE;
 }
-void visit(const Syntax::AdditiveExpr &additiveExpr) {
-  Print("AdditiveExpr");
-  llvm::outs() << &additiveExpr << "\n";
-  ValueReset v(LeftAlign, LeftAlign+1);
-  visit(additiveExpr.getMultiExpr());
-  for (const auto &multiExpr: additiveExpr.getOptionalMultiExps()) {
-    switch (multiExpr.first) {
-    case Syntax::AdditiveExpr::Minus: {
-      Println("-");
-      break;
-    }
-    case Syntax::AdditiveExpr::Plus: {
-      Println("+");
+
+void visit(const Syntax::BinaryOperand &operand, unsigned precedence) {
+  if (precedence == Syntax::BinaryExpr::NumPrecedences) {
+    visit(*std::get<box<Syntax::CastExpr>>(operand));
+    return;
+  }
+  Print(BinaryLevelNames[precedence]);
+  llvm::outs() << &operand << "\n";
+  ValueReset v(LeftAlign, LeftAlign+1);
+  /// the operators of this level are the left spine of the tree, collected
+  /// from the last one back to the first operand
+  llvm::SmallVector<const Syntax::BinaryExpr *, 4> spine;
+  const Syntax::BinaryOperand *first = &operand;
+  while (auto *binaryExpr = std::get_if<box<Syntax::BinaryExpr>>(first)) {
+    if ((*binaryExpr)->getPrecedence() != precedence) {
       break;
     }
-    }
-    visit(multiExpr.second);
+    spine.push_back(binaryExpr->get());
+    first = &(*binaryExpr)->getLhs();
   }
-}
-void visit(const Syntax::MultiExpr &multiExpr) {
-  Print("MultiExpr");
-  llvm::outs() << &multiExpr << "\n";
-  ValueReset v(LeftAlign, LeftAlign+1);
-  visit(multiExpr.getCastExpr());
-  for (const auto &castExpr: multiExpr.getOptionalCastExps()) {
-    switch (castExpr.first) {
-    case Syntax::MultiExpr::Multiply: {
-      Println("*");
-      break;
-    }
-    case Syntax::MultiExpr::Divide: {
-      Println("/");
-      break;
-    }
-    case Syntax::MultiExpr::Modulo: {
-      Println("%");
-      break;
-    }
+  dump::visit(*first, precedence + 1);
+  /// the levels from logical-OR to AND list their operands only
+  bool printOperator = precedence >=
+      Syntax::BinaryExpr::getPrecedence(Syntax::BinaryExpr::Op::Equal);
+  for (auto iter = spine.rbegin(); iter != spine.rend(); ++iter) {
+    if (printOperator) {
+      Println(getSpelling((*iter)->getOperator()));
     }
-    visit(castExpr.second);
+    dump::visit((*iter)->getRhs(), precedence + 1);
   }
 }
 void visit(const Syntax::CastExpr &castExpr) {
@@ -822,7 +737,7 @@ void visit(const Syntax::CastExpr &castExpr) {
       castExpr.getVariant(),
       [](const Syntax::UnaryExpr &unaryExpr) { visit(unaryExpr); },
       [](const Syntax::CastExpr::TypeNameCast &pair) {
-        visit(pair.first);
+        visit(*pair.first);
         visit(*pair.second);
       });
 }
@@ -972,7 +887,7 @@ void visit(const Syntax::PrimaryExpr &primaryExpr) {
         match(constant.getValue(), [](auto &&value) {
           ValueReset v(LeftAlign, LeftAlign + 1);
           using T = std::decay_t<decltype(value)>;
-          if constexpr (std::is_same_v<T, std::string>) {
+          if constexpr (std::is_same_v<T, std::string_view>) {
             Println(value);
           } else {
             Println(std::to_string(value));
@@ -0,0 +1,211 @@
+/***********************************
+ * File:     TestSupport.h
+ *
+ * Author:   caipeng
+ *
+ * Email:    iiicp@outlook.com
+ *
+ * Date:     2023/6/18
+ *
+ * Sign:     enjoy life
+ ***********************************/
+
+#ifndef LCC_TESTSUPPORT_H
+#define LCC_TESTSUPPORT_H
+
+#if __has_include("catch2/catch_all.hpp")
+#include "catch2/catch_all.hpp"
+#else
+#include "catch2/catch.hpp"
+#endif
+
+#include "lcc/AST/AST.h"
+#include "lcc/AST/ASTVisitor.h"
+#include "lcc/Basic/Diagnostic.h"
+#include "lcc/Basic/FileManager.h"
+#include "lcc/Lexer/Lexer.h"
+#include "lcc/Parser/Parser.h"
+#include "lcc/Preprocessor/Preprocessor.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/raw_ostream.h"
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace lcc::test {
+
+/// a source parsed as the parser sees it, without the preprocessor, with the
+/// diagnostics kept in Messages
+class ParsedSource {
+public:
+  std::string Messages;
+  llvm::raw_string_ostream OS{Messages};
+  llvm::SourceMgr Mgr;
+  DiagnosticEngine Diag{Mgr, OS};
+  /// owns the source buffer the diagnostics and source locations point into
+  std::optional<Lexer> Lex;
+  /// the nodes keep source locations and their own copies of the names, the
+  /// tokens are dropped after the parse as the driver does
+  std::optional<Syntax::TranslationUnit> Unit;
+
+  /// the function bodies are left for later and parsed on up to
+  /// `bodyThreads` threads when it isn't 0, see Parser::UseDelayedBodies
+  explicit ParsedSource(std::string source, unsigned bodyThreads = 0) {
+    Lex.emplace(Mgr, Diag, std::move(source));
+    auto tokens = Lex->toCTokens(Lex->tokenize());
+    Parser parser(tokens, Diag);
+    if (bodyThreads) {
+      parser.UseDelayedBodies(bodyThreads);
+    }
+    Unit.emplace(parser.ParseTranslationUnit());
+    OS.flush();
+  }
+  ParsedSource(const ParsedSource &) = delete;
+  ParsedSource &operator=(const ParsedSource &) = delete;
+
+  [[nodiscard]] unsigned numErrors() { return Diag.numErrors(); }
+};
+
+/// the node classes of a walk with the names and operators in them, the
+/// children of a node in parentheses after it
+class ShapeRecorder : public Syntax::ASTVisitor<ShapeRecorder> {
+public:
+  std::string Shape;
+
+#define AST_NODE(Name)                                                         \
+  bool Visit##Name(const Syntax::Name &node) {                                 \
+    Shape += #Name;                                                            \
+    Detail(node);                                                              \
+    Shape += '(';                                                              \
+    return true;                                                               \
+  }                                                                            \
+  void PostVisit##Name(const Syntax::Name &) { Shape += ')'; }
+#include "lcc/AST/ASTNodes.def"
+
+private:
+  void Detail(const Syntax::PrimaryExprIdent &node) {
+    Shape += ' ';
+    Shape += node.getIdentifier();
+  }
+  void Detail(const Syntax::DirectDeclaratorIdent &node) {
+    Shape += ' ';
+    Shape += node.getIdent();
+  }
+  void Detail(const Syntax::TypeSpec &node) {
+    if (const auto *name =
+            std::get_if<Syntax::TypeSpec::TypedefName>(&node.getVariant())) {
+      Shape += ' ';
+      Shape += *name;
+    }
+  }
+  void Detail(const Syntax::BinaryExpr &node) {
+    Shape += ' ';
+    Shape += std::to_string(static_cast<int>(node.getOperator()));
+  }
+  template <typename T> void Detail(const T &) {}
+};
+
+/// the shape of `node` and everything below it
+template <typename T> std::string Shape(const T &node) {
+  ShapeRecorder recorder;
+  recorder.Traverse(node);
+  return std::move(recorder.Shape);
+}
+
+/// a directory in the temporary directory for the files of a test, removed
+/// with the object
+class TempDir {
+public:
+  llvm::SmallString<128> Path;
+
+  TempDir() {
+    REQUIRE(!llvm::sys::fs::createUniqueDirectory("lcc-test", Path));
+  }
+  ~TempDir() { llvm::sys::fs::remove_directories(Path); }
+  TempDir(const TempDir &) = delete;
+  TempDir &operator=(const TempDir &) = delete;
+
+  /// the path of `name` in the directory
+  [[nodiscard]] std::string getPath(llvm::StringRef name) const {
+    llvm::SmallString<128> path(Path);
+    llvm::sys::path::append(path, name);
+    return std::string(path.str());
+  }
+  /// writes `content` to `name` in the directory and returns its path
+  std::string Write(llvm::StringRef name, llvm::StringRef content) {
+    std::string path = getPath(name);
+    std::error_code ec;
+    llvm::raw_fd_ostream os(path, ec);
+    REQUIRE(!ec);
+    os << content;
+    return path;
+  }
+};
+
+/// a source run through the preprocessor the way the driver does it. The
+/// main file is named `path`, so "..." includes are found beside it. Set up
+/// PP before calling one of the actions, each of which may be called once
+class PreprocessedSource {
+public:
+  std::string Messages;
+  llvm::raw_string_ostream OS{Messages};
+  llvm::SourceMgr Mgr;
+  DiagnosticEngine Diag{Mgr, OS};
+  /// may be shared by several sources, like the translation units of a run
+  FileManager &Files;
+  std::optional<Lexer> Lex;
+  std::optional<Preprocessor> PP;
+
+  PreprocessedSource(std::string source, FileManager &files,
+                     std::string_view path = "<stdin>")
+      : Files(files) {
+    Lex.emplace(Mgr, Diag, std::move(source), path);
+    PP.emplace(Mgr, Diag, Files);
+  }
+  PreprocessedSource(const PreprocessedSource &) = delete;
+  PreprocessedSource &operator=(const PreprocessedSource &) = delete;
+
+  /// the pp tokens after macro expansion
+  std::vector<Token> Preprocess() {
+    PP->EnterMainFile(*Lex);
+    auto tokens = PP->Preprocess();
+    OS.flush();
+    return tokens;
+  }
+  /// the tokens of Preprocess spelled one after the other, separated by a
+  /// space
+  std::string Spell() {
+    std::string result;
+    for (const auto &token : Preprocess()) {
+      if (!result.empty()) {
+        result += ' ';
+      }
+      result += token.getRepresentation();
+    }
+    return result;
+  }
+  /// -E
+  std::string PrintPreprocessed() {
+    std::string result;
+    llvm::raw_string_ostream os(result);
+    PP->EnterMainFile(*Lex);
+    PP->PrintPreprocessedOutput(os);
+    os.flush();
+    OS.flush();
+    return result;
+  }
+  /// -M, the included files are in PP->getIncludedFiles()
+  void ScanDependencies() {
+    PP->EnterMainFile(*Lex);
+    PP->ScanDependencies();
+    OS.flush();
+  }
+
+  [[nodiscard]] unsigned numErrors() { return Diag.numErrors(); }
+};
+} // namespace lcc::test
+
+#endif // LCC_TESTSUPPORT_H
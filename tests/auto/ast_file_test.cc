@@ -0,0 +1,138 @@
+/***********************************
+ * File:     ast_file_test.cc
+ *
+ * Author:   caipeng
+ *
+ * Email:    iiicp@outlook.com
+ *
+ * Date:     2023/6/18
+ *
+ * Sign:     enjoy life
+ ***********************************/
+
+#include "TestSupport.h"
+#include "lcc/Serialization/ASTFile.h"
+#include "llvm/ADT/bit.h"
+#include "llvm/Support/FileSystem.h"
+
+using namespace lcc;
+
+namespace {
+/// an AST file in the temporary directory, removed with the object
+class TempASTFile {
+public:
+  llvm::SmallString<128> Path;
+
+  TempASTFile() {
+    REQUIRE(!llvm::sys::fs::createTemporaryFile("lcc-test", "ast", Path));
+  }
+  ~TempASTFile() { llvm::sys::fs::remove(Path); }
+  TempASTFile(const TempASTFile &) = delete;
+  TempASTFile &operator=(const TempASTFile &) = delete;
+
+  std::unique_ptr<ASTReader> Write(test::ParsedSource &source) {
+    {
+      std::error_code ec;
+      llvm::raw_fd_ostream os(Path, ec);
+      REQUIRE(!ec);
+      ASTWriter::Emit(*source.Unit, source.Mgr, os);
+    }
+    auto reader = ASTReader::Load(Path);
+    REQUIRE(static_cast<bool>(reader));
+    return std::move(*reader);
+  }
+};
+} // namespace
+
+TEST_CASE("a chain of operators thousands deep is written and read back",
+          "[ASTFile]") {
+  std::string source = "int f(void) { return 1";
+  for (int i = 1; i < 20000; ++i) {
+    source += "+1";
+  }
+  source += "; }";
+  test::ParsedSource parsed(source);
+  REQUIRE(parsed.numErrors() == 0);
+
+  TempASTFile file;
+  auto reader = file.Write(parsed);
+  unsigned binaries = 0, constants = 0;
+  bool childrenAfter = true;
+  for (uint32_t i = 0; i < reader->getNumNodes(); ++i) {
+    ASTRecord record(reader.get(), i);
+    binaries += record.getKind() == ASTNodeKind::BinaryExpr;
+    constants += record.getKind() == ASTNodeKind::PrimaryExprConstant;
+    /// numbered before its children
+    for (uint32_t child = 0; child < record.getNumChildren(); ++child) {
+      if (auto childRecord = record.getChild(child)) {
+        childrenAfter &= childRecord.getIndex() > i;
+      }
+    }
+  }
+  CHECK(childrenAfter);
+  CHECK(binaries == 19999);
+  CHECK(constants == 20000);
+
+  /// the outermost + is numbered first, its left operand is the chain of
+  /// the others
+  uint32_t outermost = 0;
+  while (ASTRecord(reader.get(), outermost).getKind() !=
+         ASTNodeKind::BinaryExpr) {
+    ++outermost;
+  }
+  unsigned depth = 0;
+  for (ASTRecord binary(reader.get(), outermost);
+       binary && binary.getKind() == ASTNodeKind::BinaryExpr;
+       binary = binary.getChild(0)) {
+    ++depth;
+  }
+  CHECK(depth == 19999);
+}
+
+TEST_CASE("a ConstantArray keeps its elements in the AST file", "[ASTFile]") {
+  std::string source = "unsigned a[] = {";
+  for (int i = 0; i < 15; ++i) {
+    source += std::to_string(i * 1000) + "u, ";
+  }
+  source += "-1u};\ndouble b[] = {";
+  for (int i = 0; i < 16; ++i) {
+    source += "-" + std::to_string(i) + ".5, ";
+  }
+  source += "};\nint c[] = {1, 2};\n";
+  test::ParsedSource parsed(source);
+  REQUIRE(parsed.numErrors() == 0);
+
+  TempASTFile file;
+  auto reader = file.Write(parsed);
+  std::vector<ASTRecord> arrays;
+  unsigned constants = 0;
+  for (uint32_t i = 0; i < reader->getNumNodes(); ++i) {
+    ASTRecord record(reader.get(), i);
+    if (record.getKind() == ASTNodeKind::ConstantArray) {
+      arrays.push_back(record);
+    }
+    constants += record.getKind() == ASTNodeKind::PrimaryExprConstant;
+  }
+  /// c is too short to be packed
+  CHECK(constants == 2);
+  REQUIRE(arrays.size() == 2);
+
+  CHECK(arrays[0].getPayload() ==
+        static_cast<uint32_t>(ASTConstantKind::UInt32));
+  REQUIRE(arrays[0].getNumElements() == 16u);
+  CHECK(arrays[0].getElement(0) == 0u);
+  CHECK(arrays[0].getElement(14) == 14000u);
+  CHECK(arrays[0].getElement(15) == 0xffffffffu);
+  CHECK(!arrays[0].getElement(16));
+  /// not an array
+  CHECK(!ASTRecord(reader.get(), 0).getNumElements());
+
+  CHECK(arrays[1].getPayload() ==
+        static_cast<uint32_t>(ASTConstantKind::Double));
+  REQUIRE(arrays[1].getNumElements() == 16u);
+  for (uint32_t i = 0; i < 16; ++i) {
+    auto element = arrays[1].getElement(i);
+    REQUIRE(element);
+    CHECK(llvm::bit_cast<double>(*element) == -(i + 0.5));
+  }
+}
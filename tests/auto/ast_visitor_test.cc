@@ -0,0 +1,159 @@
+/***********************************
+ * File:     ast_visitor_test.cc
+ *
+ * Author:   caipeng
+ *
+ * Email:    iiicp@outlook.com
+ *
+ * Date:     2023/6/18
+ *
+ * Sign:     enjoy life
+ ***********************************/
+
+#include "TestSupport.h"
+#include "lcc/AST/ASTVisitor.h"
+#include <string>
+#include <vector>
+
+using namespace lcc;
+
+namespace {
+/// the statements, declarations and leaves of a walk as they are entered,
+/// "/X" when a node X is left
+class OrderRecorder : public Syntax::ASTVisitor<OrderRecorder> {
+public:
+  std::vector<std::string> Order;
+  /// leaves out what is below an if statement
+  bool SkipIf{false};
+  /// the name of the identifier the walk ends at, empty for none
+  std::string_view StopAt;
+
+  bool VisitFunctionDefinition(const Syntax::FunctionDefinition &) {
+    Order.emplace_back("function");
+    return true;
+  }
+  void PostVisitFunctionDefinition(const Syntax::FunctionDefinition &) {
+    Order.emplace_back("/function");
+  }
+  bool VisitDeclaration(const Syntax::Declaration &) {
+    Order.emplace_back("declaration");
+    return true;
+  }
+  void PostVisitDeclaration(const Syntax::Declaration &) {
+    Order.emplace_back("/declaration");
+  }
+  bool VisitBlockStmt(const Syntax::BlockStmt &) {
+    Order.emplace_back("block");
+    return true;
+  }
+  void PostVisitBlockStmt(const Syntax::BlockStmt &) {
+    Order.emplace_back("/block");
+  }
+  bool VisitIfStmt(const Syntax::IfStmt &) {
+    Order.emplace_back("if");
+    return !SkipIf;
+  }
+  bool VisitReturnStmt(const Syntax::ReturnStmt &) {
+    Order.emplace_back("return");
+    return true;
+  }
+  bool VisitBinaryExpr(const Syntax::BinaryExpr &) {
+    Order.emplace_back("binary");
+    return true;
+  }
+  void PostVisitBinaryExpr(const Syntax::BinaryExpr &) {
+    Order.emplace_back("/binary");
+  }
+  bool VisitDirectDeclaratorIdent(const Syntax::DirectDeclaratorIdent &node) {
+    Order.emplace_back("decl " + std::string(node.getIdent()));
+    return true;
+  }
+  bool VisitPrimaryExprIdent(const Syntax::PrimaryExprIdent &node) {
+    Order.emplace_back(std::string(node.getIdentifier()));
+    if (node.getIdentifier() == StopAt) {
+      Stop();
+    }
+    return true;
+  }
+  bool VisitPrimaryExprConstant(const Syntax::PrimaryExprConstant &) {
+    Order.emplace_back("constant");
+    return true;
+  }
+};
+
+constexpr const char *Source = "int g = 1;\n"
+                               "int f(int a) {\n"
+                               "  if (a < g)\n"
+                               "    return a + 2;\n"
+                               "  int b = a * g;\n"
+                               "  return b;\n"
+                               "}\n"
+                               "int h;\n";
+} // namespace
+
+TEST_CASE("the walk is in source order, post-order hooks after the children",
+          "[ASTVisitor]") {
+  test::ParsedSource source(Source);
+  REQUIRE(source.numErrors() == 0);
+  OrderRecorder recorder;
+  recorder.Traverse(*source.Unit);
+  std::vector<std::string> expected{
+      "declaration", "decl g", "constant", "/declaration",
+      "function", "decl f", "decl a",
+      "block",
+      "if", "binary", "a", "g", "/binary",
+      "return", "binary", "a", "constant", "/binary",
+      "declaration", "decl b", "binary", "a", "g", "/binary", "/declaration",
+      "return", "b",
+      "/block", "/function",
+      "declaration", "decl h", "/declaration"};
+  CHECK(recorder.Order == expected);
+}
+
+TEST_CASE("a Visit hook which returns false leaves the children out",
+          "[ASTVisitor]") {
+  test::ParsedSource source(Source);
+  REQUIRE(source.numErrors() == 0);
+  OrderRecorder recorder;
+  recorder.SkipIf = true;
+  recorder.Traverse(*source.Unit);
+  std::vector<std::string> expected{
+      "declaration", "decl g", "constant", "/declaration",
+      "function", "decl f", "decl a",
+      "block",
+      "if",
+      "declaration", "decl b", "binary", "a", "g", "/binary", "/declaration",
+      "return", "b",
+      "/block", "/function",
+      "declaration", "decl h", "/declaration"};
+  CHECK(recorder.Order == expected);
+}
+
+TEST_CASE("Stop ends the walk after the current hook", "[ASTVisitor]") {
+  test::ParsedSource source(Source);
+  REQUIRE(source.numErrors() == 0);
+  OrderRecorder recorder;
+  recorder.StopAt = "g";
+  recorder.Traverse(*source.Unit);
+  std::vector<std::string> expected{
+      "declaration", "decl g", "constant", "/declaration",
+      "function", "decl f", "decl a",
+      "block", "if", "binary", "a", "g"};
+  CHECK(recorder.Order == expected);
+  CHECK(recorder.isStopped());
+
+  /// a new walk starts over
+  recorder.Order.clear();
+  recorder.StopAt = {};
+  recorder.Traverse(*source.Unit);
+  CHECK(recorder.Order.size() == 32);
+}
+
+TEST_CASE("a walk of a subtree", "[ASTVisitor]") {
+  test::ParsedSource source(Source);
+  REQUIRE(source.numErrors() == 0);
+  OrderRecorder recorder;
+  recorder.Traverse(source.Unit->getGlobals()[2]);
+  std::vector<std::string> expected{"declaration", "decl h", "/declaration"};
+  CHECK(recorder.Order == expected);
+}
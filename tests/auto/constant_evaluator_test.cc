@@ -0,0 +1,196 @@
+/***********************************
+ * File:     constant_evaluator_test.cc
+ *
+ * Author:   caipeng
+ *
+ * Email:    iiicp@outlook.com
+ *
+ * Date:     2023/6/18
+ *
+ * Sign:     enjoy life
+ ***********************************/
+
+#include "TestSupport.h"
+#include "lcc/AST/ASTVisitor.h"
+#include "lcc/Sema/ConstantEvaluator.h"
+#include "llvm/ADT/StringMap.h"
+#include <functional>
+#include <vector>
+
+using namespace lcc;
+
+namespace {
+/// the values of the enumerators, case labels and array bounds of a source in
+/// source order, an enumerator is visible to the expressions after it
+class ConstantCollector : public Syntax::ASTVisitor<ConstantCollector> {
+  llvm::StringMap<IntegerValue> mEnumerators;
+  /// the evaluator keeps a function_ref, the callable must outlive it
+  std::function<std::optional<IntegerValue>(std::string_view)> mLookup;
+  ConstantEvaluator mEvaluator;
+
+  std::optional<IntegerValue> Lookup(std::string_view name) const {
+    std::optional<IntegerValue> value;
+    auto iter = mEnumerators.find(llvm::StringRef(name.data(), name.size()));
+    if (iter != mEnumerators.end()) {
+      value = iter->second;
+    }
+    return value;
+  }
+
+public:
+  std::vector<std::optional<IntegerValue>> Values;
+
+  explicit ConstantCollector(DiagnosticEngine &diag)
+      : mLookup([this](std::string_view name) { return Lookup(name); }),
+        mEvaluator(diag, mLookup) {}
+
+  bool VisitEnumSpecifier(const Syntax::EnumSpecifier &node) {
+    /// C99 6.7.2.2p3, one more than the enumerator before, the first is 0
+    IntegerValue next = IntegerValue::getInt(0);
+    for (const auto &enumerator : node.getEnumerators()) {
+      std::optional<IntegerValue> value = next;
+      if (enumerator.optionalConstantExpr_) {
+        value = mEvaluator.Evaluate(*enumerator.optionalConstantExpr_);
+      }
+      Values.push_back(value);
+      if (value) {
+        mEnumerators.insert({llvm::StringRef(enumerator.name_.data(),
+                                             enumerator.name_.size()),
+                             *value});
+        IntegerValue::Apply(IntegerValue::BinaryOp::Add, *value,
+                            IntegerValue::getInt(1), next);
+      }
+    }
+    return false;
+  }
+  bool VisitCaseStmt(const Syntax::CaseStmt &node) {
+    Values.push_back(mEvaluator.Evaluate(node.getConstantExpr()));
+    return true;
+  }
+  bool VisitDirectDeclaratorAssignExpr(
+      const Syntax::DirectDeclaratorAssignExpr &node) {
+    if (const auto *bound = node.getAssignmentExpression()) {
+      Values.push_back(mEvaluator.Evaluate(*bound));
+    }
+    return true;
+  }
+};
+
+struct Evaluated {
+  test::ParsedSource Source;
+  std::vector<std::optional<IntegerValue>> Values;
+
+  explicit Evaluated(std::string source) : Source(std::move(source)) {
+    REQUIRE(Source.numErrors() == 0);
+    ConstantCollector collector(Source.Diag);
+    collector.Traverse(*Source.Unit);
+    Source.OS.flush();
+    Values = std::move(collector.Values);
+  }
+};
+
+bool Is(const std::optional<IntegerValue> &value, int64_t expected,
+        unsigned width, bool isUnsigned) {
+  return value && value->getSExtValue() == expected &&
+         value->getWidth() == width && value->isUnsigned() == isUnsigned;
+}
+} // namespace
+
+TEST_CASE("enumerators take the type and value of their expression",
+          "[ConstantEvaluator]") {
+  /// the enumerators of tests/c/pp_07.c
+  Evaluated result("enum Limits {\n"
+                   "  Min = -2147483647 - 1,\n"
+                   "  Narrow = (unsigned char)300,\n"
+                   "  Size = sizeof(long) * 2,\n"
+                   "  Wide = (long)1 << 40 >> 38,\n"
+                   "  Mixed = -1 < 0u,\n"
+                   "  Chosen = 1 ? -1 : 0u\n"
+                   "};\n");
+  REQUIRE(result.Values.size() == 6);
+  CHECK(Is(result.Values[0], -2147483648, 32, false));
+  CHECK(Is(result.Values[1], 44, 8, true));
+  CHECK(Is(result.Values[2], 16, 64, true));
+  CHECK(Is(result.Values[3], 4, 64, false));
+  CHECK(Is(result.Values[4], 0, 32, false));
+  CHECK(result.Values[5]->getZExtValue() == 0xffffffff);
+  CHECK(result.Values[5]->isUnsigned());
+  CHECK(result.Source.Messages.empty());
+}
+
+TEST_CASE("an enumerator without a value follows the one before",
+          "[ConstantEvaluator]") {
+  Evaluated result("enum { A, B = 5, C, D = C * 2, E };");
+  REQUIRE(result.Values.size() == 5);
+  CHECK(Is(result.Values[0], 0, 32, false));
+  CHECK(Is(result.Values[1], 5, 32, false));
+  CHECK(Is(result.Values[2], 6, 32, false));
+  CHECK(Is(result.Values[3], 12, 32, false));
+  CHECK(Is(result.Values[4], 13, 32, false));
+}
+
+TEST_CASE("case labels and array bounds", "[ConstantEvaluator]") {
+  Evaluated result("enum { Narrow = 44, Wide = 4 };\n"
+                   "int buffer[sizeof(int) + 1];\n"
+                   "int classify(int value) {\n"
+                   "  switch (value) {\n"
+                   "  case Narrow:\n"
+                   "    return 1;\n"
+                   "  case Wide * 2:\n"
+                   "    return 2;\n"
+                   "  case 'a' + 1:\n"
+                   "    return 3;\n"
+                   "  }\n"
+                   "  return 0;\n"
+                   "}\n");
+  REQUIRE(result.Values.size() == 6);
+  CHECK(Is(result.Values[2], 5, 64, true));
+  CHECK(Is(result.Values[3], 44, 32, false));
+  CHECK(Is(result.Values[4], 8, 32, false));
+  CHECK(Is(result.Values[5], 'b', 32, false));
+}
+
+TEST_CASE("operands which are not evaluated can't fail",
+          "[ConstantEvaluator]") {
+  Evaluated result("enum {\n"
+                   "  And = 0 && 1 / 0,\n"
+                   "  Or = 1 || 1 / 0,\n"
+                   "  Cond = 1 ? 2 : 1 / 0,\n"
+                   "  Shift = 0 ? 1 << 40 : 3\n"
+                   "};\n");
+  REQUIRE(result.Values.size() == 4);
+  CHECK(Is(result.Values[0], 0, 32, false));
+  CHECK(Is(result.Values[1], 1, 32, false));
+  CHECK(Is(result.Values[2], 2, 32, false));
+  CHECK(Is(result.Values[3], 3, 32, false));
+  CHECK(result.Source.Messages.empty());
+}
+
+TEST_CASE("overflow is a warning with the wrapped value",
+          "[ConstantEvaluator]") {
+  Evaluated result("enum { Big = 2147483647 + 1, Far = 1 << 33 };");
+  REQUIRE(result.Values.size() == 2);
+  CHECK(Is(result.Values[0], -2147483648, 32, false));
+  CHECK(result.Values[1].has_value());
+  CHECK(result.Source.Diag.numErrors() == 0);
+  CHECK(result.Source.Messages.find("overflow") != std::string::npos);
+}
+
+TEST_CASE("expressions which are not integer constants",
+          "[ConstantEvaluator]") {
+  Evaluated result("int f(void);\n"
+                   "enum {\n"
+                   "  Zero = 1 / 0,\n"
+                   "  Call = f(),\n"
+                   "  Unknown = missing + 1,\n"
+                   "  Floating = (float)1,\n"
+                   "  Pointer = sizeof(int *),\n"
+                   "  Comma = (1, 2),\n"
+                   "  After = Zero\n"
+                   "};\n");
+  REQUIRE(result.Values.size() == 7);
+  for (const auto &value : result.Values) {
+    CHECK(!value.has_value());
+  }
+  CHECK(result.Source.Diag.numErrors() == 7);
+}
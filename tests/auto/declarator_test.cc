@@ -0,0 +1,120 @@
+/***********************************
+ * File:     declarator_test.cc
+ *
+ * Author:   caipeng
+ *
+ * Email:    iiicp@outlook.com
+ *
+ * Date:     2023/6/18
+ *
+ * Sign:     enjoy life
+ ***********************************/
+
+#include "TestSupport.h"
+
+using namespace lcc;
+using namespace lcc::Syntax;
+using Derivation = Declarator::Derivation;
+
+namespace {
+/// the declarator of a source which is one declaration of one name
+class DeclaratorOf {
+public:
+  test::ParsedSource Parsed;
+
+  explicit DeclaratorOf(std::string source) : Parsed(std::move(source)) {}
+
+  const Declarator &get() {
+    REQUIRE(Parsed.numErrors() == 0);
+    const auto &globals = Parsed.Unit->getGlobals();
+    REQUIRE(globals.size() == 1);
+    const auto &initDeclarators =
+        std::get<Declaration>(globals[0]).getInitDeclarators();
+    REQUIRE(initDeclarators.size() == 1);
+    return *initDeclarators[0].declarator_;
+  }
+};
+
+std::vector<Derivation> Derivations(const Declarator &declarator) {
+  std::vector<Derivation> derivations;
+  for (unsigned i = 0; i < declarator.getNumDerivations(); ++i) {
+    derivations.push_back(declarator.getDerivation(i));
+  }
+  return derivations;
+}
+
+/// the name the parameter list directly follows, empty when it follows
+/// parentheses
+std::string_view FollowedName(const DirectDeclaratorParamTypeList &function) {
+  const auto *ident =
+      std::get_if<box<DirectDeclaratorIdent>>(&function.getDirectDeclarator());
+  return ident ? (*ident)->getIdent() : std::string_view();
+}
+} // namespace
+
+TEST_CASE("a declarator's derivations are read from the name outwards",
+          "[Declarator]") {
+  using D = Derivation;
+  auto derivations = [](const char *source) {
+    CAPTURE(source);
+    DeclaratorOf declarator(source);
+    return Derivations(declarator.get());
+  };
+  CHECK(derivations("int a;").empty());
+  CHECK(derivations("int *a[3];") == std::vector<D>{D::Array, D::Pointer});
+  CHECK(derivations("int (*a)[3];") == std::vector<D>{D::Pointer, D::Array});
+  CHECK(derivations("int **a;") == std::vector<D>{D::Pointer, D::Pointer});
+  /// suffixes apply to the innermost declarator first
+  CHECK(derivations("int a[2][3];") == std::vector<D>{D::Array, D::Array});
+  CHECK(derivations("int (*(*x)[4])(void);") ==
+        std::vector<D>{D::Pointer, D::Array, D::Pointer, D::Function});
+  CHECK(derivations("int ((a));").empty());
+  CHECK(derivations("int *(*(f)(int))[2];") ==
+        std::vector<D>{D::Function, D::Pointer, D::Array, D::Pointer});
+}
+
+TEST_CASE("a declarator knows its name and the parameters which belong to it",
+          "[Declarator]") {
+  {
+    /// a function returning a pointer to a function
+    DeclaratorOf of("int (*f(int))(char);");
+    const Declarator &declarator = of.get();
+    CHECK(declarator.getName() == "f");
+    CHECK(declarator.isFunction());
+    CHECK(Derivations(declarator) ==
+          std::vector<Derivation>{Derivation::Function, Derivation::Pointer,
+                                  Derivation::Function});
+    REQUIRE(declarator.getFuncDeclarator());
+    /// f(int), not (*f(int))(char)
+    CHECK(FollowedName(*declarator.getFuncDeclarator()) == "f");
+  }
+  {
+    /// a pointer to a function is not a function, but still has the
+    /// function declarator
+    DeclaratorOf of("int (*fp)(int);");
+    const Declarator &declarator = of.get();
+    CHECK(declarator.getName() == "fp");
+    CHECK(!declarator.isFunction());
+    CHECK(Derivations(declarator) ==
+          std::vector<Derivation>{Derivation::Pointer, Derivation::Function});
+    REQUIRE(declarator.getFuncDeclarator());
+    CHECK(FollowedName(*declarator.getFuncDeclarator()).empty());
+  }
+  {
+    DeclaratorOf of("int *p[4];");
+    CHECK(of.get().getName() == "p");
+    CHECK(!of.get().getFuncDeclarator());
+  }
+}
+
+TEST_CASE("derivations past the maximum are counted", "[Declarator]") {
+  std::string source = "int ";
+  const unsigned count = Declarator::MaxDerivations + 3;
+  source += std::string(count, '*');
+  source += "p;";
+  DeclaratorOf of(source);
+  const Declarator &declarator = of.get();
+  CHECK(declarator.getNumDerivations() == count);
+  CHECK(declarator.getDerivation(Declarator::MaxDerivations - 1) ==
+        Derivation::Pointer);
+}
@@ -0,0 +1,147 @@
+/***********************************
+ * File:     incremental_parser_test.cc
+ *
+ * Author:   caipeng
+ *
+ * Email:    iiicp@outlook.com
+ *
+ * Date:     2023/6/18
+ *
+ * Sign:     enjoy life
+ ***********************************/
+
+#include "TestSupport.h"
+#include "lcc/Parser/IncrementalParser.h"
+#include <string>
+#include <vector>
+
+using namespace lcc;
+
+namespace {
+/// the diagnostics of a parse kept in a string
+struct Session {
+  std::string Messages;
+  llvm::raw_string_ostream OS{Messages};
+  llvm::SourceMgr Mgr;
+  DiagnosticEngine Diag{Mgr, OS};
+};
+
+std::vector<std::string> Shapes(const IncrementalParser &parser) {
+  std::vector<std::string> shapes;
+  for (size_t i = 0; i < parser.getNumDecls(); ++i) {
+    shapes.push_back(test::Shape(parser.getDecl(i)));
+  }
+  return shapes;
+}
+
+/// the declarations of `parser` after its edits are those the parser gives
+/// for its text in one piece
+void CheckAgainstFullParse(const IncrementalParser &parser) {
+  test::ParsedSource full{std::string(parser.getText())};
+  std::vector<std::string> shapes;
+  for (const auto &decl : full.Unit->getGlobals()) {
+    shapes.push_back(test::Shape(decl));
+  }
+  CHECK(Shapes(parser) == shapes);
+}
+} // namespace
+
+TEST_CASE("a typedef which becomes a variable changes the parse after it",
+          "[IncrementalParser]") {
+  Session session;
+  IncrementalParser parser(session.Diag, "typedef int T;\n"
+                                         "int f(void) {\n"
+                                         "  T * x;\n"
+                                         "  return 0;\n"
+                                         "}\n");
+  REQUIRE(parser.getNumDecls() == 2);
+  /// a declaration of x as a pointer to T
+  CHECK(Shapes(parser)[1].find("BinaryExpr") == std::string::npos);
+
+  REQUIRE(parser.Edit(0, std::string_view("typedef ").size(), ""));
+  CHECK(parser.getText().rfind("int T;", 0) == 0);
+  CheckAgainstFullParse(parser);
+  /// now T times x
+  CHECK(Shapes(parser)[1].find("BinaryExpr") != std::string::npos);
+
+  REQUIRE(parser.Edit(0, 0, "typedef "));
+  CheckAgainstFullParse(parser);
+  CHECK(Shapes(parser)[1].find("BinaryExpr") == std::string::npos);
+}
+
+TEST_CASE("an unclosed comment swallows the declarations after it",
+          "[IncrementalParser]") {
+  Session session;
+  IncrementalParser parser(session.Diag, "int a;\nint b;\nint c;\n");
+  REQUIRE(parser.getNumDecls() == 3);
+
+  size_t b = parser.getText().find("int b");
+  REQUIRE(parser.Edit(b, 0, "/* "));
+  CheckAgainstFullParse(parser);
+  CHECK(parser.getNumDecls() < 3);
+
+  size_t c = parser.getText().find("int c");
+  REQUIRE(parser.Edit(c, 0, "*/ "));
+  CheckAgainstFullParse(parser);
+  CHECK(parser.getNumDecls() == 2);
+}
+
+TEST_CASE("an unclosed brace and closing it again", "[IncrementalParser]") {
+  Session session;
+  IncrementalParser parser(session.Diag, "int f(void) {\n"
+                                         "  return 1;\n"
+                                         "}\n"
+                                         "int g;\n");
+  REQUIRE(parser.getNumDecls() == 2);
+  std::vector<std::string> before = Shapes(parser);
+
+  size_t brace = parser.getText().find('}');
+  REQUIRE(parser.Edit(brace, 1, ""));
+  CheckAgainstFullParse(parser);
+
+  REQUIRE(parser.Edit(brace, 0, "}"));
+  CheckAgainstFullParse(parser);
+  CHECK(Shapes(parser) == before);
+}
+
+TEST_CASE("edits at the beginning and at the end of the text",
+          "[IncrementalParser]") {
+  Session session;
+  IncrementalParser parser(session.Diag, "int a;\nint f(void) { return a; }\n");
+  REQUIRE(parser.getNumDecls() == 2);
+
+  REQUIRE(parser.Edit(0, 0, "int z;\n"));
+  CheckAgainstFullParse(parser);
+  CHECK(parser.getNumDecls() == 3);
+
+  REQUIRE(parser.Edit(parser.getText().size(), 0, "int w = 1;\n"));
+  CheckAgainstFullParse(parser);
+  CHECK(parser.getNumDecls() == 4);
+
+  /// the last declaration replaced, up to the end of the text
+  size_t w = parser.getText().find("int w");
+  REQUIRE(parser.Edit(w, parser.getText().size() - w, "long w;"));
+  CheckAgainstFullParse(parser);
+
+  REQUIRE(parser.Edit(0, std::string_view("int z;\n").size(), ""));
+  CheckAgainstFullParse(parser);
+  CHECK(parser.getNumDecls() == 3);
+}
+
+TEST_CASE("an edit out of the text changes nothing", "[IncrementalParser]") {
+  Session session;
+  IncrementalParser parser(session.Diag, "int a;\nint b;\n");
+  std::string text = parser.getText();
+  std::vector<std::string> shapes = Shapes(parser);
+
+  CHECK_FALSE(parser.Edit(text.size() + 1, 0, "int c;"));
+  CHECK_FALSE(parser.Edit(text.size() - 1, 2, ""));
+  CHECK_FALSE(parser.Edit(0, text.size() + 1, ""));
+  CHECK(parser.getText() == text);
+  CHECK(Shapes(parser) == shapes);
+
+  /// the whole text is in range
+  CHECK(parser.Edit(0, text.size(), "int c;\n"));
+  CheckAgainstFullParse(parser);
+  CHECK(parser.getNumDecls() == 1);
+}
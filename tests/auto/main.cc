@@ -10,7 +10,12 @@
  * Sign:     enjoy life
  ***********************************/
 
+#if __has_include("catch2/catch_session.hpp")
 #include "catch2/catch_session.hpp"
+#else
+#define CATCH_CONFIG_RUNNER
+#include "catch2/catch.hpp"
+#endif
 int main( int argc, char* argv[] ) {
   // your setup ...
 
@@ -10,7 +10,7 @@
  * Sign:     enjoy life
  ***********************************/
 
-#include "catch2/catch_all.hpp"
+#include "TestSupport.h"
 SCENARIO("111") {
   GIVEN("a thing") {
     int a = 3;
@@ -36,3 +36,188 @@ SCENARIO("111") {
     }
   }
 }
+
+TEST_CASE("a unary operator applies to its cast-expression", "[Parser]") {
+  for (const char *source :
+       {"int x = -1 + 2;", "int x = !0 || ~0;",
+        "int f(int *p) { return *p + -*p; }"}) {
+    CAPTURE(source);
+    lcc::test::ParsedSource parsed(source);
+    CHECK(parsed.numErrors() == 0);
+  }
+}
+
+TEST_CASE("switch statements and case labels are kept", "[Parser]") {
+  using namespace lcc::Syntax;
+  using lcc::box;
+  lcc::test::ParsedSource parsed(
+      "int f(int a) { switch (a) case 1: return 2; return 0; }");
+  REQUIRE(parsed.numErrors() == 0);
+  const auto &globals = parsed.Unit->getGlobals();
+  REQUIRE(globals.size() == 1);
+  const auto &items = std::get<FunctionDefinition>(globals[0])
+                          .getCompoundStatement()
+                          .getBlockItems();
+  REQUIRE(items.size() == 2);
+  const auto &stmt = std::get<Stmt>(items[0]);
+  REQUIRE(std::holds_alternative<box<SwitchStmt>>(stmt));
+  CHECK(std::holds_alternative<box<CaseStmt>>(
+      std::get<box<SwitchStmt>>(stmt)->getStatement()));
+}
+
+TEST_CASE("a call may have no arguments", "[Parser]") {
+  lcc::test::ParsedSource parsed("int g(void);\n"
+                                 "int h(int, int);\n"
+                                 "int f(void) { return g() + h(1, g()); }\n");
+  CHECK(parsed.numErrors() == 0);
+}
+
+TEST_CASE("an input cut short is an error, not a read past the tokens",
+          "[Parser]") {
+  for (const char *source :
+       {"int x = 1", "int x = 1 +", "int x = -", "int x = a.", "int x = a->",
+        "int x = a = ", "int", "enum {", "struct S { int a :",
+        "int f(void) { goto", "int f(void) { return 1"}) {
+    CAPTURE(source);
+    lcc::test::ParsedSource parsed(source);
+    CHECK(parsed.numErrors() > 0);
+  }
+}
+
+TEST_CASE("delayed function bodies parse as they do in place", "[Parser]") {
+  /// every body depends on which names are typedefs where it is
+  const char *source = "typedef int T;\n"
+                       "int g;\n"
+                       "int f(int T) { return T * g; }\n"
+                       "int h(void) { T * p; return sizeof(T) * 2; }\n"
+                       "int k(void) { int U = 1; return U * g; }\n"
+                       "int l(void) { U * g; return 0; }\n"
+                       "typedef long U;\n"
+                       "int m(void) { U * q; { int T; T * g; } T * r; }\n"
+                       "int n(int U) { typedef char V; V * s; U * g; }\n"
+                       "struct V { int V; };\n"
+                       "int o(struct V *V) { return V->V * (T)1; }\n"
+                       "int p(void) { { typedef int g; g * x; } g * 2; }\n";
+  lcc::test::ParsedSource inPlace(source);
+  REQUIRE(inPlace.numErrors() == 0);
+  std::vector<std::string> expected;
+  for (const auto &decl : inPlace.Unit->getGlobals()) {
+    expected.push_back(lcc::test::Shape(decl));
+  }
+  REQUIRE(expected.size() == 12);
+  /// U isn't a typedef yet in l, it is in m
+  CHECK(expected[5].find("TypeSpec U") == std::string::npos);
+  CHECK(expected[7].find("TypeSpec U") != std::string::npos);
+
+  for (unsigned threads : {1u, 4u}) {
+    CAPTURE(threads);
+    lcc::test::ParsedSource delayed(source, threads);
+    CHECK(delayed.numErrors() == 0);
+    std::vector<std::string> shapes;
+    for (const auto &decl : delayed.Unit->getGlobals()) {
+      shapes.push_back(lcc::test::Shape(decl));
+    }
+    CHECK(shapes == expected);
+  }
+}
+
+namespace {
+/// the initializers of `int a[] = {list};`, "<n>" for an expression and
+/// "[<alternative> x <size>]" for a ConstantArray
+std::string InitializerKinds(const std::string &list) {
+  using namespace lcc::Syntax;
+  lcc::test::ParsedSource parsed("int a[] = {" + list + "};");
+  CHECK(parsed.numErrors() == 0);
+  const auto &globals = parsed.Unit->getGlobals();
+  REQUIRE(globals.size() == 1);
+  const auto &initializer = std::get<Declaration>(globals[0])
+                                .getInitDeclarators()[0]
+                                .optionalInitializer_;
+  REQUIRE(initializer);
+  std::string kinds;
+  size_t expressions = 0;
+  auto flush = [&] {
+    if (expressions) {
+      kinds += "<" + std::to_string(expressions) + ">";
+      expressions = 0;
+    }
+  };
+  for (const auto &[designation, element] :
+       std::get<lcc::box<InitializerList>>(initializer->getVariant())
+           ->getInitializerList()) {
+    if (const auto *constants =
+            std::get_if<ConstantArray>(&element.getVariant())) {
+      flush();
+      kinds += "[" + std::to_string(constants->getValues().index()) + " x " +
+               std::to_string(constants->size()) + "]";
+    } else {
+      ++expressions;
+    }
+  }
+  flush();
+  return kinds;
+}
+
+/// `count` constants from `first`, each with `suffix`
+std::string Constants(int first, int count, const char *suffix = "") {
+  std::string list;
+  for (int i = first; i < first + count; ++i) {
+    list += std::to_string(i) + suffix + ", ";
+  }
+  return list;
+}
+} // namespace
+
+TEST_CASE("a run of 16 constants in an initializer list is one node",
+          "[Parser]") {
+  /// the alternatives are int32_t, uint32_t, int64_t, uint64_t, float, double
+  CHECK(InitializerKinds(Constants(0, 15)) == "<15>");
+  CHECK(InitializerKinds(Constants(0, 16)) == "[0 x 16]");
+  CHECK(InitializerKinds(Constants(0, 40)) == "[0 x 40]");
+  /// a trailing comma before the } is not a constant
+  CHECK(InitializerKinds(Constants(0, 16) + "16,") == "[0 x 17]");
+  CHECK(InitializerKinds(Constants(0, 16) + "16") == "[0 x 17]");
+
+  /// a constant of another type ends the run, the next run starts there
+  CHECK(InitializerKinds(Constants(0, 16) + Constants(0, 16, "u")) ==
+        "[0 x 16][1 x 16]");
+  CHECK(InitializerKinds(Constants(0, 16) + Constants(0, 3, ".0")) ==
+        "[0 x 16]<3>");
+  CHECK(InitializerKinds("x, " + Constants(0, 16) + "x + 1, " +
+                         Constants(0, 15)) == "<1>[0 x 16]<16>");
+  /// a constant which isn't a whole initializer stays an expression
+  CHECK(InitializerKinds(Constants(0, 8) + "8 + 1, " + Constants(0, 8)) ==
+        "<17>");
+}
+
+TEST_CASE("a negated constant joins the run with the type's wraparound",
+          "[Parser]") {
+  using namespace lcc::Syntax;
+  lcc::test::ParsedSource parsed(
+      "int a[] = {" + Constants(0, 14, "u") +
+      "-1u, -0x80000000};\n"
+      "int b[] = {" +
+      Constants(0, 14) + "-1, -2147483647};\n");
+  REQUIRE(parsed.numErrors() == 0);
+  auto values = [&](size_t global) {
+    const auto &initializer = std::get<Declaration>(
+                                  parsed.Unit->getGlobals()[global])
+                                  .getInitDeclarators()[0]
+                                  .optionalInitializer_;
+    const auto &list =
+        std::get<lcc::box<InitializerList>>(initializer->getVariant())
+            ->getInitializerList();
+    REQUIRE(list.size() == 1);
+    return std::get<ConstantArray>(list[0].second.getVariant()).getValues();
+  };
+  auto unsignedValues = std::get<std::span<const uint32_t>>(values(0));
+  REQUIRE(unsignedValues.size() == 16);
+  CHECK(unsignedValues[13] == 13);
+  CHECK(unsignedValues[14] == 0xffffffffu);
+  /// 0x80000000 is an unsigned int, its negation is itself
+  CHECK(unsignedValues[15] == 0x80000000u);
+  auto signedValues = std::get<std::span<const int32_t>>(values(1));
+  REQUIRE(signedValues.size() == 16);
+  CHECK(signedValues[14] == -1);
+  CHECK(signedValues[15] == -2147483647);
+}
@@ -0,0 +1,147 @@
+/***********************************
+ * File:     pch_test.cc
+ *
+ * Author:   caipeng
+ *
+ * Email:    iiicp@outlook.com
+ *
+ * Date:     2023/6/18
+ *
+ * Sign:     enjoy life
+ ***********************************/
+
+#include "TestSupport.h"
+#include "lcc/Serialization/PCH.h"
+
+using namespace lcc;
+
+namespace {
+const char *Prefix = "#ifndef PREFIX_H\n"
+                     "#define PREFIX_H\n"
+                     "typedef unsigned long size_type;\n"
+                     "typedef struct Point { int x, y; } Point;\n"
+                     "int origin;\n"
+                     "int distance(Point *p);\n"
+                     "#define MAX(a, b) ((a) > (b) ? (a) : (b))\n"
+                     "#define NAME \"prefix\"\n"
+                     "#endif\n";
+
+/// what -emit-pch writes for `header`
+void EmitPCH(const std::string &header, const std::string &output,
+             FileManager &files) {
+  auto buffer = files.getFile(header);
+  REQUIRE(buffer);
+  test::PreprocessedSource source(
+      std::string((*buffer)->getBuffer().get()->getBuffer()), files, header);
+  auto tokens = source.Lex->toCTokens(source.Preprocess());
+  Parser parser(tokens, source.Diag);
+  auto unit = parser.ParseTranslationUnit();
+  REQUIRE(source.numErrors() == 0);
+
+  PCHWriter writer;
+  REQUIRE(!writer.AddInputFile(header));
+  for (const auto *macro : source.PP->getDefinedMacros()) {
+    writer.AddMacro(*macro);
+  }
+  for (auto [name, isTypedef] : parser.GetFileScopeBindings()) {
+    writer.AddFileScopeBinding(name, isTypedef);
+  }
+  writer.AddAST(unit, source.Mgr);
+  std::error_code ec;
+  llvm::raw_fd_ostream os(output, ec);
+  REQUIRE(!ec);
+  writer.Emit(os);
+}
+
+/// what -include-pch compiles of `source`, the number of errors
+unsigned ParseWithPCH(std::string source, const PCHReader &pch,
+                      FileManager &files) {
+  test::PreprocessedSource tu(std::move(source), files);
+  tu.PP->UsePCH(pch);
+  auto tokens = tu.Lex->toCTokens(tu.Preprocess());
+  Parser parser(tokens, tu.Diag);
+  parser.UsePCH(pch);
+  parser.ParseTranslationUnit();
+  return tu.numErrors();
+}
+} // namespace
+
+TEST_CASE("a pch keeps the macros, file scope names and declarations of the "
+          "prefix",
+          "[PCH]") {
+  test::TempDir dir;
+  FileManager files;
+  std::string header = dir.Write("prefix.h", Prefix);
+  std::string output = dir.getPath("prefix.pch");
+  EmitPCH(header, output, files);
+
+  auto pch = PCHReader::Load(output);
+  REQUIRE(static_cast<bool>(pch));
+  const PCHReader &reader = **pch;
+
+  auto max = reader.LookupMacro("MAX");
+  REQUIRE(max);
+  CHECK(max->FunctionLike);
+  CHECK(max->Params.size() == 2);
+  CHECK(reader.LookupMacro("PREFIX_H"));
+  CHECK(!reader.LookupMacro("size_type"));
+
+  CHECK(reader.LookupBinding("size_type") == std::optional<bool>(true));
+  CHECK(reader.LookupBinding("Point") == std::optional<bool>(true));
+  CHECK(reader.LookupBinding("origin") == std::optional<bool>(false));
+  CHECK(reader.LookupBinding("distance") == std::optional<bool>(false));
+  CHECK(!reader.LookupBinding("MAX"));
+
+  /// the four declarations of the prefix, without parsing it again
+  ASTRecord root = reader.getAST().getRoot();
+  REQUIRE(root);
+  CHECK(root.getKind() == ASTNodeKind::TranslationUnit);
+  CHECK(root.getNumChildren() == 4);
+}
+
+TEST_CASE("a translation unit starts after the pch prefix", "[PCH]") {
+  test::TempDir dir;
+  FileManager files;
+  std::string output = dir.getPath("prefix.pch");
+  EmitPCH(dir.Write("prefix.h", Prefix), output, files);
+  auto pch = PCHReader::Load(output);
+  REQUIRE(static_cast<bool>(pch));
+
+  /// the typedef names of the prefix decide how these parse
+  CHECK(ParseWithPCH("int f(Point *p) {\n"
+                     "  size_type n = MAX(p->x, p->y);\n"
+                     "  const char *name = NAME;\n"
+                     "  return (size_type)n + distance(p) + origin;\n"
+                     "}\n",
+                     **pch, files) == 0);
+  /// a block scope name shadows a typedef name of the prefix
+  CHECK(ParseWithPCH("int f(void) { int size_type = 1; return size_type * 2; }",
+                     **pch, files) == 0);
+  CHECK(ParseWithPCH("int f(void) { size_typo n = 1; return n; }", **pch,
+                     files) > 0);
+}
+
+TEST_CASE("a pch which is stale or cut short is rejected", "[PCH]") {
+  test::TempDir dir;
+  FileManager files;
+  std::string header = dir.Write("prefix.h", Prefix);
+  std::string output = dir.getPath("prefix.pch");
+  EmitPCH(header, output, files);
+
+  SECTION("cut short") {
+    auto content = llvm::MemoryBuffer::getFile(output);
+    REQUIRE(content);
+    dir.Write("prefix.pch", (*content)->getBuffer().drop_back(8));
+    auto pch = PCHReader::Load(output);
+    REQUIRE(!pch);
+    CHECK(llvm::toString(pch.takeError()).find("malformed") !=
+          std::string::npos);
+  }
+  SECTION("stale") {
+    dir.Write("prefix.h", std::string(Prefix) + "typedef int more;\n");
+    auto pch = PCHReader::Load(output);
+    REQUIRE(!pch);
+    CHECK(llvm::toString(pch.takeError()).find("has been modified") !=
+          std::string::npos);
+  }
+}
@@ -0,0 +1,381 @@
+/***********************************
+ * File:     preprocessor_test.cc
+ *
+ * Author:   caipeng
+ *
+ * Email:    iiicp@outlook.com
+ *
+ * Date:     2023/6/18
+ *
+ * Sign:     enjoy life
+ ***********************************/
+
+#include "TestSupport.h"
+
+using namespace lcc;
+
+namespace {
+/// the tokens of `source` after preprocessing, spelled and separated by a
+/// space, with no error reported
+std::string Expand(std::string source) {
+  FileManager files;
+  test::PreprocessedSource pp(std::move(source), files);
+  std::string result = pp.Spell();
+  CAPTURE(pp.Messages);
+  CHECK(pp.numErrors() == 0);
+  return result;
+}
+
+/// whether `condition` holds in an #if, with no error reported
+bool If(const std::string &condition) {
+  return Expand("#if " + condition + "\nyes\n#else\nno\n#endif\n") == "yes";
+}
+} // namespace
+
+TEST_CASE("a macro is not expanded again in its own expansion",
+          "[Preprocessor]") {
+  CHECK(Expand("#define x x + 1\nx") == "x + 1");
+  CHECK(Expand("#define a b\n#define b a\na b") == "a b");
+  /// the f of the expansion is hidden, also from the ( after it
+  CHECK(Expand("#define f(x) x f\nf(1)(2)") == "1 f ( 2 )");
+  CHECK(Expand("#define f(x) g(x)\n#define g(x) f(x)\nf(1)") == "f ( 1 )");
+  /// an argument is expanded before it is substituted
+  CHECK(Expand("#define id(x) x\n#define one 1\nid(id(one))") == "1");
+  CHECK(Expand("#define f(x) x\nf") == "f");
+}
+
+TEST_CASE("# and ## work with empty arguments", "[Preprocessor]") {
+  /// a string literal is spelled without its quotes
+  CHECK(Expand("#define str(x) #x\nstr( a  +\n b )") == "a + b");
+  CHECK(Expand("#define str(x) #x\n[str()]") == "[  ]");
+  CHECK(Expand("#define str(x) #x\nstr(\"a\\n\")") == "\\\"a\\\\n\\\"");
+  CHECK(Expand("#define cat(a, b) a ## b\ncat(x, y) cat(1, 2)") == "xy 12");
+  CHECK(Expand("#define cat(a, b) a ## b\n[cat(, y)]") == "[ y ]");
+  CHECK(Expand("#define cat(a, b) a ## b\n[cat(x, )]") == "[ x ]");
+  CHECK(Expand("#define cat(a, b) a ## b\n[cat(,)]") == "[ ]");
+  /// the operands of ## are not expanded first
+  CHECK(Expand("#define one 1\n#define cat(a, b) a ## b\ncat(one, 2)") ==
+        "one2");
+  CHECK(Expand("#define cat(a, b) a ## b\ncat(+, =) cat(<<, =)") == "+= <<=");
+}
+
+TEST_CASE("__VA_ARGS__ takes the variable arguments", "[Preprocessor]") {
+  CHECK(Expand("#define F(fmt, ...) f(fmt, __VA_ARGS__)\nF(a, 1, (2, 3))") ==
+        "f ( a , 1 , ( 2 , 3 ) )");
+  CHECK(Expand("#define F(...) [__VA_ARGS__]\nF() F(1) F(1, 2)") ==
+        "[ ] [ 1 ] [ 1 , 2 ]");
+  CHECK(Expand("#define S(...) #__VA_ARGS__\nS(a, b)") == "a, b");
+}
+
+TEST_CASE("#if evaluates C integer arithmetic", "[Preprocessor]") {
+  CHECK(If("(1 + 2) * 3 == 9 && -1 < 0"));
+  CHECK(If("10 / 3 == 3 && 10 % 3 == 1 && (1 << 4) == 16 && ~0 == -1"));
+  CHECK(If("0x10 == 16 && 010 == 8 && 'a' == 97"));
+  /// -1 becomes unsigned once the other operand is
+  CHECK(If("-1 > 0u"));
+  CHECK(!If("-1 > 0"));
+  CHECK(If("defined(FOO) == 0 && !defined FOO"));
+  CHECK(If("undefined_name == 0"));
+  CHECK(If("(2 || 0) == 1 && (1 ? 2 : 3) == 2"));
+}
+
+TEST_CASE("#if does not evaluate the operands it short-circuits",
+          "[Preprocessor]") {
+  CHECK(!If("0 && 1 / 0"));
+  CHECK(If("1 || 1 / 0"));
+  CHECK(If("1 ? 1 : 1 % 0"));
+  CHECK(If("0 ? 1 / 0 : 1"));
+
+  FileManager files;
+  test::PreprocessedSource pp("#if 1 / 0\n#endif\n", files);
+  pp.Preprocess();
+  CHECK(pp.numErrors() > 0);
+}
+
+TEST_CASE("an include guard or #pragma once skips the header the second "
+          "time",
+          "[Preprocessor]") {
+  test::TempDir dir;
+  dir.Write("guard.h", "#ifndef GUARD_H\n#define GUARD_H\nguarded\n#endif\n");
+  dir.Write("once.h", "#pragma once\nonce\n");
+  dir.Write("plain.h", "plain\n");
+  FileManager files;
+  test::PreprocessedSource pp("#include \"guard.h\"\n"
+                              "#include \"once.h\"\n"
+                              "#include \"plain.h\"\n"
+                              "#include \"guard.h\"\n"
+                              "#include \"once.h\"\n"
+                              "#include \"plain.h\"\n",
+                              files, dir.getPath("main.c"));
+  CHECK(pp.Spell() == "guarded once plain plain");
+  CHECK(pp.numErrors() == 0);
+  CHECK(pp.PP->getNumSkippedIncludes() == 2);
+
+  /// the guard only counts while its macro is defined
+  test::PreprocessedSource again("#include \"guard.h\"\n"
+                                 "#undef GUARD_H\n"
+                                 "#include \"guard.h\"\n",
+                                 files, dir.getPath("again.c"));
+  CHECK(again.Spell() == "guarded guarded");
+  CHECK(again.PP->getNumSkippedIncludes() == 0);
+}
+
+TEST_CASE("an inactive group is skipped whatever it holds", "[Preprocessor]") {
+  CHECK(Expand("#if 0\n"
+               "don't care about ' or \" here\n"
+               "#if 1\n"
+               "#error not reached\n"
+               "#endif\n"
+               "#else\n"
+               "live\n"
+               "#endif\n") == "live");
+  CHECK(Expand("#if 0\n"
+               "/* a comment\n"
+               "#endif\n"
+               "*/\n"
+               "#elif 1\n"
+               "second\n"
+               "#else\n"
+               "third\n"
+               "#endif\n") == "second");
+  CHECK(Expand("#ifdef NOT_DEFINED\n"
+               "char *s = \"#endif\";\n"
+               "junk \\\n"
+               "#endif\n"
+               "# /* comment */ else\n"
+               "x\n"
+               "#  endif\n") == "x");
+  /// a splice inside a literal doesn't end it, the "/*" is still in it
+  CHECK(Expand("#if 0\n"
+               "char *s = \"abc\\\n"
+               "/* not a comment\";\n"
+               "#else\n"
+               "int live;\n"
+               "#endif\n") == "int live ;");
+  CHECK(Expand("#define ONE 1\n"
+               "#if ONE - 1\n"
+               "a\n"
+               "#elif ONE\n"
+               "b\n"
+               "#elif 1 / 0\n"
+               "c\n"
+               "#endif\n") == "b");
+}
+
+TEST_CASE("-M lists every header the translation unit includes",
+          "[Preprocessor]") {
+  test::TempDir dir;
+  REQUIRE(!llvm::sys::fs::create_directory(dir.getPath("sys")));
+  dir.Write("a.h", "#include \"b.h\"\n#include <s.h>\n");
+  dir.Write("b.h", "#pragma once\nint b;\n");
+  dir.Write("c.h", "int c;\n");
+  dir.Write("sys/s.h", "#include <c.h>\nint s;\n");
+  FileManager files;
+  test::PreprocessedSource pp("#include \"a.h\"\n"
+                              "#if 0\n"
+                              "#include \"missing.h\"\n"
+                              "#endif\n"
+                              "#define C \"c.h\"\n"
+                              "#include C\n"
+                              "#include \"a.h\"\n",
+                              files, dir.getPath("main.c"));
+  pp.PP->AddIncludeDir(dir.getPath("sys"), /*isSystem=*/true);
+  pp.PP->AddIncludeDir(dir.getPath(""), /*isSystem=*/false);
+  pp.ScanDependencies();
+  CAPTURE(pp.Messages);
+  CHECK(pp.numErrors() == 0);
+
+  std::vector<std::pair<std::string, bool>> included;
+  for (const auto &file : pp.PP->getIncludedFiles()) {
+    included.emplace_back(
+        llvm::sys::path::filename(file.File->getName()).str(), file.IsSystem);
+  }
+  /// in the order they were first entered, c.h is a system header because a
+  /// system header included it first
+  CHECK(included == std::vector<std::pair<std::string, bool>>{
+                        {"a.h", false},
+                        {"b.h", false},
+                        {"s.h", true},
+                        {"c.h", true}});
+}
+
+TEST_CASE("#embed turns a resource into one token with its parameters",
+          "[Preprocessor]") {
+  test::TempDir dir;
+  dir.Write("data.bin", "abc");
+  dir.Write("empty.bin", "");
+  FileManager files;
+  auto embed = [&](const std::string &line) {
+    test::PreprocessedSource pp("{\n" + line + "\n}", files,
+                                dir.getPath("main.c"));
+    std::string result;
+    for (const auto &token : pp.Preprocess()) {
+      if (!result.empty()) {
+        result += ' ';
+      }
+      if (token.getTokenKind() == tok::embed_data) {
+        result += "<" + token.getRepresentation().str() + ">";
+      } else {
+        result += token.getRepresentation();
+      }
+    }
+    CAPTURE(pp.Messages);
+    CHECK(pp.numErrors() == 0);
+    return result;
+  };
+  CHECK(embed("#embed \"data.bin\"") == "{ <abc> }");
+  CHECK(embed("#embed \"data.bin\" limit(2)") == "{ <ab> }");
+  CHECK(embed("#embed \"data.bin\" __limit__(1 + 1)") == "{ <ab> }");
+  CHECK(embed("#embed \"data.bin\" prefix(0,) suffix(, 9)") ==
+        "{ 0 , <abc> , 9 }");
+  CHECK(embed("#embed \"data.bin\" if_empty(none)") == "{ <abc> }");
+  CHECK(embed("#embed \"empty.bin\" prefix(0,) if_empty(none)") ==
+        "{ none }");
+  CHECK(embed("#embed \"data.bin\" limit(0) if_empty(none)") == "{ none }");
+
+  /// __STDC_EMBED_NOT_FOUND__, __STDC_EMBED_FOUND__, __STDC_EMBED_EMPTY__
+  test::PreprocessedSource has("__has_embed(\"data.bin\")\n"
+                               "#if __has_embed(\"data.bin\") == 1 && "
+                               "__has_embed(\"empty.bin\") == 2 && "
+                               "__has_embed(\"missing.bin\") == 0 && "
+                               "__has_embed(\"data.bin\" limit(0)) == 2 && "
+                               "__has_embed(\"data.bin\" unknown(1)) == 0\n"
+                               "ok\n"
+                               "#endif\n",
+                               files, dir.getPath("has.c"));
+  CHECK(has.Spell().find("ok") != std::string::npos);
+  CHECK(has.numErrors() == 0);
+}
+
+TEST_CASE("an included file is normalized, an embedded one is not",
+          "[Preprocessor]") {
+  test::TempDir dir;
+  dir.Write("crlf.h", "\xef\xbb\xbfint a;\r\nint\rb;\r\n");
+  FileManager files;
+  auto file = files.getFile(dir.getPath("crlf.h"));
+  REQUIRE(file);
+  auto raw = (*file)->getRawBuffer();
+  REQUIRE(raw);
+  CHECK((*raw)->getBuffer() == "\xef\xbb\xbfint a;\r\nint\rb;\r\n");
+  auto buffer = (*file)->getBuffer();
+  REQUIRE(buffer);
+  CHECK((*buffer)->getBuffer() == "int a;\nint\rb;\n");
+
+  test::PreprocessedSource pp("#include \"crlf.h\"\n"
+                              "#embed \"crlf.h\" limit(5)\n",
+                              files, dir.getPath("main.c"));
+  auto tokens = pp.Preprocess();
+  CHECK(pp.numErrors() == 0);
+  REQUIRE(tokens.size() == 7);
+  CHECK(tokens.back().getTokenKind() == tok::embed_data);
+  CHECK(tokens.back().getRepresentation() == "\xef\xbb\xbfin");
+}
+
+TEST_CASE("-E writes line markers where the file or line changes",
+          "[Preprocessor]") {
+  test::TempDir dir;
+  std::string header = dir.Write("a.h", "int a;\n");
+  std::string main = dir.getPath("main.c");
+  FileManager files;
+  test::PreprocessedSource pp("#define N 1\n"
+                              "#include \"a.h\"\n"
+                              "int x = N;\n"
+                              "\n\n\n\n\n\n\n\n\n\n"
+                              "int y;\n",
+                              files, main);
+  std::string output = pp.PrintPreprocessed();
+  CHECK(pp.numErrors() == 0);
+  CHECK(output == "# 1 \"" + main + "\"\n"
+                  "# 1 \"" + header + "\" 1\n"
+                  "int a;\n"
+                  "# 3 \"" + main + "\" 2\n"
+                  "int x = 1;\n"
+                  "# 14 \"" + main + "\"\n"
+                  "int y;\n");
+}
+
+TEST_CASE("-E returns from a header before entering the next one",
+          "[Preprocessor]") {
+  test::TempDir dir;
+  std::string t = dir.Write("t.h", "int t;\n");
+  std::string b = dir.Write("b.h", "int b;\n");
+  /// b.h is the last line, a.h is entered from main.c, not from b.h
+  std::string m = dir.Write("m.h", "int m;\n#include \"b.h\"\n");
+  std::string a = dir.Write("a.h", "int a;\n");
+  std::string main = dir.getPath("main.c");
+  FileManager files;
+  test::PreprocessedSource pp("#include \"t.h\"\n"
+                              "#include \"t.h\"\n"
+                              "#include \"m.h\"\n"
+                              "#include \"a.h\"\n"
+                              "int x;\n",
+                              files, main);
+  std::string output = pp.PrintPreprocessed();
+  CHECK(pp.numErrors() == 0);
+  CHECK(output == "# 1 \"" + main + "\"\n"
+                  "# 1 \"" + t + "\" 1\n"
+                  "int t;\n"
+                  "# 2 \"" + main + "\" 2\n"
+                  "# 1 \"" + t + "\" 1\n"
+                  "int t;\n"
+                  "# 3 \"" + main + "\" 2\n"
+                  "# 1 \"" + m + "\" 1\n"
+                  "int m;\n"
+                  "# 1 \"" + b + "\" 1\n"
+                  "int b;\n"
+                  "# 3 \"" + m + "\" 2\n"
+                  "# 4 \"" + main + "\" 2\n"
+                  "# 1 \"" + a + "\" 1\n"
+                  "int a;\n"
+                  "# 5 \"" + main + "\" 2\n"
+                  "int x;\n");
+}
+
+TEST_CASE("-E enters a header whose first token comes from a nested include",
+          "[Preprocessor]") {
+  test::TempDir dir;
+  std::string b = dir.Write("b.h", "int b;\n");
+  std::string n = dir.Write("n.h", "#define N 1\n#include \"b.h\"\nint n;\n");
+  std::string e = dir.Write("e.h", "#define E\n");
+  std::string main = dir.getPath("main.c");
+  FileManager files;
+  test::PreprocessedSource pp("#include \"n.h\"\n"
+                              "#include \"e.h\"\n"
+                              "int m = N;\n",
+                              files, main);
+  std::string output = pp.PrintPreprocessed();
+  CHECK(pp.numErrors() == 0);
+  CHECK(output == "# 1 \"" + main + "\"\n"
+                  "# 1 \"" + n + "\" 1\n"
+                  "# 1 \"" + b + "\" 1\n"
+                  "int b;\n"
+                  "# 3 \"" + n + "\" 2\n"
+                  "int n;\n"
+                  "# 2 \"" + main + "\" 2\n"
+                  "# 1 \"" + e + "\" 1\n"
+                  "# 3 \"" + main + "\" 2\n"
+                  "int m = 1;\n");
+}
+
+TEST_CASE("-E only spaces tokens which would be read back as one",
+          "[Preprocessor]") {
+  auto print = [](const std::string &source) {
+    FileManager files;
+    test::PreprocessedSource pp("#define f(a) a+(3,4)\n"
+                                "#define g(x) x\n"
+                                "#define e(x) x ## e\n"
+                                "#define cat(a, b) a ## b\n" +
+                                    source + "\n",
+                                files);
+    std::string output = pp.PrintPreprocessed();
+    CHECK(pp.numErrors() == 0);
+    /// the last line, without the line markers and blank lines before it
+    output.pop_back();
+    return output.substr(output.rfind('\n') + 1);
+  };
+  CHECK(print("f(2) g(1)+g(2) g(1.)-1 a+b 1e+1") ==
+        "2+(3,4) 1+2 1.-1 a+b 1e+1");
+  /// a pp-number ending in an exponent takes the sign in
+  CHECK(print("e(1)+1 e(0x1)-g(1)") == "1e +1 0x1e -1");
+  CHECK(print("cat(+,+)+ g(+)+ g(-)- g(<)<= g(x)1") == "++ + + + - - < <= x 1");
+}
@@ -0,0 +1,116 @@
+/***********************************
+ * File:     scope_test.cc
+ *
+ * Author:   caipeng
+ *
+ * Email:    iiicp@outlook.com
+ *
+ * Date:     2023/6/18
+ *
+ * Sign:     enjoy life
+ ***********************************/
+
+#include "TestSupport.h"
+#include "lcc/Sema/Scope.h"
+#include <memory>
+
+using namespace lcc;
+
+namespace {
+SemaSyntax::Declaration MakeDeclaration() {
+  return SemaSyntax::Declaration(
+      std::make_shared<Type>(), SemaSyntax::Linkage::None,
+      SemaSyntax::Lifetime::Automatic, SemaSyntax::Declaration::Definition);
+}
+
+/// the declaration `symbol` holds, null for anything else
+const SemaSyntax::Declaration *
+GetDeclaration(const Scope::DeclarationSymbol *symbol) {
+  if (!symbol) {
+    return nullptr;
+  }
+  auto *const *decl = std::get_if<SemaSyntax::Declaration *>(symbol);
+  return decl ? *decl : nullptr;
+}
+} // namespace
+
+TEST_CASE("a struct tag and a variable of the same name are apart",
+          "[Scope]") {
+  Scope scope;
+  Type structType;
+  auto decl = MakeDeclaration();
+
+  /// struct point {...}; struct point point;
+  CHECK(scope.AddTagSymbol("point", &structType) == nullptr);
+  CHECK(scope.AddDeclSymbol("point", &decl) == nullptr);
+
+  REQUIRE(scope.FindTagSymbol("point") != nullptr);
+  CHECK(*scope.FindTagSymbol("point") == &structType);
+  CHECK(GetDeclaration(scope.FindDeclSymbol("point")) == &decl);
+
+  /// a name only declared as a tag isn't an ordinary identifier, and back
+  CHECK(scope.AddTagSymbol("node", &structType) == nullptr);
+  CHECK(scope.FindDeclSymbol("node") == nullptr);
+  CHECK(scope.AddDeclSymbol("count", &decl) == nullptr);
+  CHECK(scope.FindTagSymbol("count") == nullptr);
+}
+
+TEST_CASE("a redeclaration in the same scope keeps the first", "[Scope]") {
+  Scope scope;
+  auto first = MakeDeclaration(), second = MakeDeclaration();
+  CHECK(scope.AddDeclSymbol("x", &first) == nullptr);
+  CHECK(GetDeclaration(scope.AddDeclSymbol("x", &second)) == &first);
+  CHECK(GetDeclaration(scope.FindDeclSymbol("x")) == &first);
+}
+
+TEST_CASE("an inner scope shadows until it is left", "[Scope]") {
+  Scope scope;
+  auto outer = MakeDeclaration(), inner = MakeDeclaration(),
+       local = MakeDeclaration();
+  Type outerTag, innerTag;
+  REQUIRE(scope.AddDeclSymbol("x", &outer) == nullptr);
+  REQUIRE(scope.AddTagSymbol("s", &outerTag) == nullptr);
+  CHECK(scope.getCurrentEnvId() == 0);
+  {
+    auto exit = scope.EnterScope();
+    CHECK(scope.getCurrentEnvId() == 1);
+    /// visible from the enclosing scope, but not declared in this one
+    CHECK(GetDeclaration(scope.FindDeclSymbol("x")) == &outer);
+    CHECK(scope.FindDeclSymbolInCurrentScope("x") == nullptr);
+
+    CHECK(scope.AddDeclSymbol("x", &inner) == nullptr);
+    CHECK(scope.AddTagSymbol("s", &innerTag) == nullptr);
+    CHECK(scope.AddDeclSymbol("y", &local) == nullptr);
+    CHECK(GetDeclaration(scope.FindDeclSymbol("x")) == &inner);
+    CHECK(GetDeclaration(scope.FindDeclSymbolInCurrentScope("x")) == &inner);
+    CHECK(*scope.FindTagSymbol("s") == &innerTag);
+    {
+      auto nested = scope.EnterScope();
+      CHECK(scope.getCurrentEnvId() == 2);
+      CHECK(GetDeclaration(scope.FindDeclSymbol("x")) == &inner);
+      CHECK(GetDeclaration(scope.FindDeclSymbol("y")) == &local);
+    }
+    CHECK(GetDeclaration(scope.FindDeclSymbol("y")) == &local);
+  }
+  CHECK(scope.getCurrentEnvId() == 0);
+  CHECK(GetDeclaration(scope.FindDeclSymbol("x")) == &outer);
+  CHECK(GetDeclaration(scope.FindDeclSymbolInCurrentScope("x")) == &outer);
+  CHECK(*scope.FindTagSymbol("s") == &outerTag);
+  CHECK(scope.FindDeclSymbol("y") == nullptr);
+}
+
+TEST_CASE("an undeclared name is not found at any depth", "[Scope]") {
+  Scope scope;
+  CHECK(scope.FindDeclSymbol("missing") == nullptr);
+  CHECK(scope.FindTagSymbol("missing") == nullptr);
+
+  auto decl = MakeDeclaration();
+  REQUIRE(scope.AddDeclSymbol("present", &decl) == nullptr);
+  auto first = scope.EnterScope();
+  auto second = scope.EnterScope();
+  CHECK(scope.FindDeclSymbol("missing") == nullptr);
+  CHECK(scope.FindDeclSymbolInCurrentScope("missing") == nullptr);
+  CHECK(scope.FindTagSymbol("missing") == nullptr);
+  CHECK(scope.FindTagSymbolInCurrentScope("missing") == nullptr);
+  CHECK(GetDeclaration(scope.FindDeclSymbol("present")) == &decl);
+}
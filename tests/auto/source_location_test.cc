@@ -0,0 +1,72 @@
+/***********************************
+ * File:     source_location_test.cc
+ *
+ * Author:   caipeng
+ *
+ * Email:    iiicp@outlook.com
+ *
+ * Date:     2023/6/18
+ *
+ * Sign:     enjoy life
+ ***********************************/
+
+#include "TestSupport.h"
+#include "lcc/Basic/SourceLocation.h"
+#include "llvm/Support/MemoryBuffer.h"
+
+using namespace lcc;
+
+namespace {
+unsigned AddBuffer(llvm::SourceMgr &mgr, llvm::StringRef text) {
+  return mgr.AddNewSourceBuffer(llvm::MemoryBuffer::getMemBufferCopy(text),
+                                llvm::SMLoc());
+}
+} // namespace
+
+TEST_CASE("a location is the base of its buffer plus the offset in it",
+          "[SourceLocation]") {
+  llvm::SourceMgr mgr;
+  SourceLocationTable table(mgr);
+  unsigned first = AddBuffer(mgr, "abc");
+  unsigned second = AddBuffer(mgr, "");
+  unsigned third = AddBuffer(mgr, "hello");
+
+  CHECK(table.getFileBase(first) == 1);
+  CHECK(table.getFileBase(second) == 5);
+  CHECK(table.getFileBase(third) == 6);
+  CHECK(table.getFileBase(0) == 0);
+  CHECK(table.getFileBase(third + 1) == 0);
+
+  for (unsigned id : {first, second, third}) {
+    uint64_t size = mgr.getMemoryBuffer(id)->getBufferSize();
+    /// the end of a buffer is a location in it too
+    for (uint64_t offset = 0; offset <= size; ++offset) {
+      auto loc = SourceLocation::getFileLoc(table.getFileBase(id), offset);
+      CHECK(table.getDecomposedLoc(loc) ==
+            std::pair<unsigned, uint32_t>(id, offset));
+    }
+  }
+  auto loc = SourceLocation::getFileLoc(table.getFileBase(third), 1);
+  CHECK(table.getSMLoc(loc).getPointer() ==
+        mgr.getMemoryBuffer(third)->getBufferStart() + 1);
+
+  CHECK(table.getDecomposedLoc(SourceLocation()) ==
+        std::pair<unsigned, uint32_t>(0, 0));
+  CHECK(table.getDecomposedLoc(SourceLocation::getFromRawEncoding(12)) ==
+        std::pair<unsigned, uint32_t>(0, 0));
+}
+
+TEST_CASE("the table takes in the buffers added after a lookup",
+          "[SourceLocation]") {
+  llvm::SourceMgr mgr;
+  SourceLocationTable table(mgr);
+  unsigned first = AddBuffer(mgr, "int a;");
+  CHECK(table.getFileBase(first) == 1);
+  auto late = SourceLocation::getFromRawEncoding(10);
+  CHECK(table.getDecomposedLoc(late).first == 0);
+
+  unsigned second = AddBuffer(mgr, "int b;");
+  CHECK(table.getDecomposedLoc(late) ==
+        std::pair<unsigned, uint32_t>(second, 2));
+  CHECK(table.getFileBase(second) == 8);
+}
@@ -0,0 +1,26 @@
+/// a run of 16 or more constants of one type is kept as one ConstantArray
+static const unsigned short crc[] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50a5, 0x60c6, 0x70e7,
+    0x8108, 0x9129, 0xa14a, 0xb16b, 0xc18c, 0xd1ad, 0xe1ce, 0xf1ef,
+};
+
+/// negated and character constants join the run, a double ends it
+static const int mixed[] = {
+    -1, -2, -3, -4, 'a', 'b', 'c', 'd', 9, 10, 11, 12, 13, 14, 15, 16,
+    0.5, 17,
+};
+
+/// a short list keeps its expressions
+int small[] = {1, 2, 3};
+
+struct Table {
+  int rows[2][16];
+};
+struct Table table = {
+    {
+        {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,},
+        {[0] = 1, 2, 3},
+    },
+};
+
+int main(void) { return crc[1] + mixed[0] + small[0] + table.rows[0][1]; }
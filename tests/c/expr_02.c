@@ -0,0 +1,25 @@
+struct Point {
+  int x;
+  int y;
+};
+
+int testSizeofExpr(int a) {
+  return sizeof(a) + sizeof (a) * 2 + sizeof(int);
+}
+
+int testCompoundLiteral() {
+  int a = (int){3};
+  return a + ((struct Point){1, 2}).y + sizeof (struct Point){0, 0};
+}
+
+int testParentheses(int a) {
+  return ((((a)))) + (int)(a) + (int)((a));
+}
+
+int testLabel(int a) {
+again:
+  a = a - 1;
+  if (a)
+    goto again;
+  return a;
+}
@@ -0,0 +1,12 @@
+#ifndef PCH_01_H
+#define PCH_01_H
+#include "pp_01.h"
+typedef unsigned long size_type;
+typedef struct Point { int x, y; } Point;
+typedef int (*callback)(Point *);
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+#define STR(x) #x
+#define NAME "pch"
+#define TEMP 1
+#undef TEMP
+#endif
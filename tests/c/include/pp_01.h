@@ -0,0 +1,2 @@
+#define PP_HEADER_VALUE 42
+typedef int pp_int;
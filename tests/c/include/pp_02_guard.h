@@ -0,0 +1,4 @@
+#ifndef PP_02_GUARD_H
+#define PP_02_GUARD_H
+typedef int guard_int;
+#endif // PP_02_GUARD_H
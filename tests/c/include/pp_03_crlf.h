@@ -0,0 +1,6 @@
+﻿#ifndef PP_03_CRLF_H
+#define PP_03_CRLF_H
+/* saved with a BOM and windows line ends */
+#define CRLF_VALUE 3
+typedef int crlf_int;
+#endif
@@ -0,0 +1,5 @@
+char *s = "ab" "c\x41g"
+  "d\0e" "\101\1012";
+char *empty = "" "";
+char c = '\n';
+int main(void) { return s[0] + c; }
@@ -0,0 +1,47 @@
+#include "include/pp_01.h"
+
+#define ZERO 0
+#define ADD(a, b) ((a) + (b))
+#define STR(x) #x
+#define XSTR(x) STR(x)
+#define CAT(a, b) a ## b
+#define DECL(type, name) type CAT(var_, name)
+#define LOG(fmt, ...) printf(fmt, ## __VA_ARGS__)
+#define AA BB
+#define BB AA
+#define f(a) a*g
+#define g(a) f(a)
+
+#if defined(PP_HEADER_VALUE) && PP_HEADER_VALUE > 40
+int header_value = PP_HEADER_VALUE;
+#elif 1
+int header_value = -1;
+#else
+#error "unreachable"
+#endif
+
+#ifdef NOT_DEFINED
+int not_defined;
+#  if 1
+int nested;
+#  endif
+#else
+int defined_else;
+#endif
+
+#undef ZERO
+#ifndef ZERO
+int zero_undefined = ADD(ADD(1, 2), 3);
+#endif
+
+int printf(const char *, ...);
+
+int main() {
+  DECL(pp_int, count) = 10;
+  const char *s = XSTR(ADD(1, "a\n"));
+  int AA = 0;
+  int line = __LINE__;
+  LOG("no args");
+  LOG("%d", var_count);
+  return f(2)(9) + CAT(1, 0);
+}
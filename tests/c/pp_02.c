@@ -0,0 +1,10 @@
+#include "include/pp_02_guard.h"
+#include "include/pp_02_once.h"
+#include "include/pp_02_guard.h"
+#include "include/../include/pp_02_once.h"
+
+int main() {
+  guard_int a = 1;
+  once_int b = 2;
+  return a + b;
+}
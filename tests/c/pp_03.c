@@ -0,0 +1,7 @@
+#include "include/pp_03_crlf.h"
+#include "include/../include/pp_03_crlf.h"
+
+int main() {
+  crlf_int a = CRLF_VALUE;
+  return a - 3;
+}
@@ -0,0 +1,33 @@
+#if 0
+this isn't valid C, it's "skipped" /* even
+#error inside comment
+*/ text
+  #  if 1
+#error nested
+  # else
+#error nested else
+#endif
+"string with #endif"
+// comment \
+#error spliced comment
+x \
+#error spliced
+#define X 1 /* multi
+#endif fake
+*/
+#elif 1
+int a_ok = 1;
+#else
+#error else taken
+#endif
+#ifdef NOPE
+#include "does_not_exist.h"
+#elif defined(__lcc__)
+int b_ok = 2;
+#endif
+   /* c */ # ifndef __STDC__
+#error ifndef
+#else
+int c_ok = 3;
+#endif
+int main() { return a_ok + b_ok + c_ok; }
@@ -0,0 +1,13 @@
+#if !__has_embed("include/pp_05_data.txt")
+#error the resource is missing
+#endif
+
+const unsigned char data[] = {
+#embed "include/pp_05_data.txt" suffix(, 0)
+};
+
+const unsigned char first[] = {
+#embed "include/pp_05_data.txt" limit(1)
+};
+
+int main() { return 0; }
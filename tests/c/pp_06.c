@@ -0,0 +1,13 @@
+// lcc -emit-pch include/pch_01.h -o pch_01.pch
+// lcc -include-pch pch_01.pch -c pp_06.c
+
+#if !defined(PCH_01_H) || defined(TEMP)
+#error the macros of the prefix are wrong
+#endif
+
+int distance(Point *p, callback cb) {
+  size_type n = MAX(p->x, p->y);
+  const char *name = NAME;
+  const char *arg = STR(n);
+  return (size_type)n + cb(p);
+}
@@ -0,0 +1,38 @@
+/// #if arithmetic is done in intmax_t and uintmax_t
+#if -1 < 0u
+#error -1 converts to uintmax_t
+#endif
+#if (-1 >> 63) != -1 || (1 ? -1 : 0u) < 0
+#error shift and conditional
+#endif
+#if 18446744073709551615 != -1 || 0x7fffffffffffffff + 0u + 1 != 0x8000000000000000
+#error large constants
+#endif
+#if '\377' >= 0 || '\x41' != 65 || '\101' != 'A'
+#error character constants
+#endif
+#if 0 && (1 / 0)
+#error short-circuit
+#endif
+
+/// enumerators, case labels and array bounds are integer constant expressions
+enum Limits {
+  Min = -2147483647 - 1,
+  Narrow = (unsigned char)300,
+  Size = sizeof(long) * 2,
+  Wide = (long)1 << 40 >> 38,
+  Mixed = -1 < 0u,
+  Chosen = 1 ? -1 : 0u
+};
+
+int buffer[Size + 1];
+
+int classify(int value) {
+  switch (value) {
+  case Narrow:
+    return 1;
+  case Wide * 2:
+    return 2;
+  }
+  return 0;
+}
@@ -0,0 +1,100 @@
+/***********************************
+ * File:     bench_match.cc
+ *
+ * Author:   caipeng
+ *
+ * Email:    iiicp@outlook.com
+ *
+ * Date:     2023/6/18
+ *
+ * Sign:     enjoy life
+ ***********************************/
+#include "lcc/Basic/Match.h"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+/// time of lcc::visit against std::visit and the compare chain lcc::visit
+/// used before, on a variant as wide as Syntax::Stmt and on a small one
+
+/// the old visit_imp for more than 9 alternatives
+template <size_t i, typename Callable, typename Variant>
+decltype(auto) chain_visit(Callable &&callable, Variant &&variant) {
+  if (variant.index() == i) {
+    return std::forward<Callable>(callable)(
+        std::get<i>(std::forward<Variant>(variant)));
+  }
+  if constexpr (i > 0) {
+    return chain_visit<i - 1>(std::forward<Callable>(callable),
+                              std::forward<Variant>(variant));
+  } else {
+    LCC_UNREACHABLE;
+  }
+}
+
+template <int n> struct Alt {
+  int value;
+};
+
+template <typename Indices> struct Wide;
+template <size_t... is> struct Wide<std::index_sequence<is...>> {
+  using type = std::variant<Alt<is>...>;
+};
+
+template <typename Variant> static std::vector<Variant> MakeInput() {
+  constexpr size_t size = std::variant_size_v<Variant>;
+  std::vector<Variant> input;
+  std::mt19937 random(42);
+  std::vector<Variant> alternatives;
+  [&]<size_t... is>(std::index_sequence<is...>) {
+    (alternatives.emplace_back(std::in_place_index<is>, int(is)), ...);
+  }(std::make_index_sequence<size>());
+  for (unsigned i = 0; i < (1u << 20); ++i) {
+    input.push_back(alternatives[random() % size]);
+  }
+  return input;
+}
+
+template <typename Variant, typename Visit>
+static void Run(const char *name, const std::vector<Variant> &input,
+                Visit visit) {
+  auto start = std::chrono::steady_clock::now();
+  long sum = 0;
+  for (unsigned round = 0; round < 50; ++round) {
+    for (const auto &variant : input) {
+      sum += visit(variant);
+    }
+  }
+  auto end = std::chrono::steady_clock::now();
+  double ns = std::chrono::duration<double, std::nano>(end - start).count() /
+              (50.0 * input.size());
+  std::printf("%-28s %6.2f ns/visit  (%ld)\n", name, ns, sum);
+}
+
+template <size_t size> static void Bench() {
+  using Variant = typename Wide<std::make_index_sequence<size>>::type;
+  auto input = MakeInput<Variant>();
+  /// each alternative does something different, as the visitors of the
+  /// tree do
+  auto matcher = [](const auto &alt) { return alt.value * 3 + 1; };
+  std::printf("%zu alternatives\n", size);
+  Run("  std::visit", input,
+      [&](const Variant &v) { return std::visit(matcher, v); });
+  Run("  compare chain (old)", input, [&](const Variant &v) {
+    return chain_visit<size - 1>(matcher, v);
+  });
+  Run("  lcc::visit_switch", input,
+      [&](const Variant &v) { return lcc::visit_switch(matcher, v); });
+  Run("  lcc::visit_table", input,
+      [&](const Variant &v) { return lcc::visit_table(matcher, v); });
+  Run("  lcc::visit", input,
+      [&](const Variant &v) { return lcc::visit(matcher, v); });
+}
+
+int main() {
+  Bench<3>();
+  Bench<14>();
+  Bench<16>();
+  return 0;
+}
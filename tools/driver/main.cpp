@@ -1,9 +1,13 @@
 #include "lcc/Basic/Diagnostic.h"
+#include "lcc/Basic/FileManager.h"
 #include "lcc/Basic/Version.h"
 #include "lcc/CodeGen/CodeGen.h"
 #include "lcc/Lexer/Lexer.h"
 #include "lcc/Parser/Parser.h"
+#include "lcc/Preprocessor/Preprocessor.h"
 #include "lcc/Sema/Sema.h"
+#include "lcc/Serialization/ASTFile.h"
+#include "lcc/Serialization/PCH.h"
 #include "lcc/Support/DumpTool.h"
 #include "llvm/Bitcode/BitcodeWriterPass.h"
 #include "llvm/IR/IRPrintingPasses.h"
@@ -15,9 +19,11 @@
 #include "llvm/Support/SMLoc.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/WithColor.h"
 #include "llvm/Transforms/IPO/PassManagerBuilder.h"
+#include <atomic>
 #include <filesystem>
 #include <llvm/Support/FileSystem.h>
 #include <optional>
@@ -42,6 +48,47 @@ static llvm::cl::opt<bool>
 static llvm::cl::opt<bool>
     PreprocessOnly("E", llvm::cl::desc("Only run the preprocessor"));
 
+static llvm::cl::list<std::string>
+    IncludeDirs("I", llvm::cl::desc("Add directory to include search path"),
+                llvm::cl::value_desc("dir"), llvm::cl::Prefix);
+
+static llvm::cl::list<std::string> SystemIncludeDirs(
+    "isystem",
+    llvm::cl::desc("Add directory to the system include search path"),
+    llvm::cl::value_desc("dir"));
+
+static llvm::cl::list<std::string>
+    MacroDefines("D", llvm::cl::desc("Define <macro> to <value> (or 1)"),
+                 llvm::cl::value_desc("macro>=<value"), llvm::cl::Prefix);
+
+static llvm::cl::list<std::string>
+    MacroUndefs("U", llvm::cl::desc("Undefine macro <macro>"),
+                llvm::cl::value_desc("macro"), llvm::cl::Prefix);
+
+static llvm::cl::opt<bool> DepsOnly(
+    "M", llvm::cl::desc("Only scan the dependencies and write them as a make "
+                        "rule, instead of compiling"));
+
+static llvm::cl::opt<bool>
+    UserDepsOnly("MM", llvm::cl::desc("Like -M but omit system headers"));
+
+static llvm::cl::opt<bool> DepsAndCompile(
+    "MD", llvm::cl::desc("Write a make rule of the dependencies to a .d file "
+                         "while compiling"));
+
+static llvm::cl::opt<std::string>
+    DepFileName("MF", llvm::cl::desc("Write the dependencies to <file>"),
+                llvm::cl::value_desc("file"));
+
+static llvm::cl::opt<bool> EmitPCH(
+    "emit-pch",
+    llvm::cl::desc("Build a precompiled header of each header input"));
+
+static llvm::cl::opt<std::string> IncludePCH(
+    "include-pch",
+    llvm::cl::desc("Include the precompiled header <file> before the source"),
+    llvm::cl::value_desc("file"));
+
 static llvm::cl::opt<bool>
     EmitLLVM("emit-llvm",
              llvm::cl::desc(
@@ -52,10 +99,33 @@ static llvm::cl::opt<bool>
                llvm::cl::desc("Emit Tokens files for source inputs"));
 static llvm::cl::opt<bool>
     EmitAst("emit-ast", llvm::cl::desc("Emit AST files for source inputs"));
+static llvm::cl::opt<bool> EmitAstFile(
+    "emit-ast-file",
+    llvm::cl::desc("Write the syntax tree of each source input to a binary "
+                   ".ast file beside it"));
+static llvm::cl::opt<bool> PrintAstFile(
+    "print-ast-file",
+    llvm::cl::desc("Print the syntax tree of each .ast input"));
+
+static llvm::cl::opt<bool> AstHugePages(
+    "ast-huge-pages",
+    llvm::cl::desc("Allocate the syntax tree from huge pages where supported"));
+static llvm::cl::opt<bool>
+    PrintAstStats("print-ast-stats",
+                  llvm::cl::desc("Print the memory used by the syntax tree"));
+
+static llvm::cl::opt<unsigned> ParseJobs(
+    "parse-jobs",
+    llvm::cl::desc("Parse the function bodies of a file on up to <N> threads"),
+    llvm::cl::value_desc("N"), llvm::cl::init(0));
 
 static llvm::cl::opt<bool> TimeOpt("time",
                                    llvm::cl::desc("Time individual commands"));
 
+static llvm::cl::opt<unsigned>
+    Jobs("j", llvm::cl::desc("Compile up to <N> input files in parallel"),
+         llvm::cl::value_desc("N"), llvm::cl::init(1), llvm::cl::Prefix);
+
 void printVersion(llvm::raw_ostream &OS) {
   OS << Head << " " << lcc::getLccVersion() << "\n";
   OS.flush();
@@ -64,20 +134,225 @@ void printVersion(llvm::raw_ostream &OS) {
 
 enum class Action { Preprocess, Compile, AssemblyOutput, Link };
 
-bool compileCFile(Action action, std::filesystem::path sourceFile) {
+/// the buffer of `path`, read into memory once through `fileMgr` and shared
+/// with the other translation units, null once the error is reported
+static const llvm::MemoryBuffer *readInputFile(const std::string &path,
+                                               lcc::FileManager &fileMgr) {
+  auto file = fileMgr.getFile(path);
+  llvm::ErrorOr<const llvm::MemoryBuffer *> FileOrErr =
+      file ? (*file)->getBuffer() : file.getError();
+  if (std::error_code BufferError = FileOrErr.getError()) {
+    llvm::WithColor::error(llvm::errs(), "lcc")
+        << "Error reading " << path << ": " << BufferError.message() << "\n";
+    return nullptr;
+  }
+  return *FileOrErr;
+}
+
+static void setupPreprocessor(lcc::Preprocessor &preprocessor) {
+  for (const auto &dir : IncludeDirs) {
+    preprocessor.AddIncludeDir(dir);
+  }
+  for (const auto &dir : SystemIncludeDirs) {
+    preprocessor.AddIncludeDir(dir, /*isSystem=*/true);
+  }
+  for (const auto &define : MacroDefines) {
+    preprocessor.AddMacroDefinition(define);
+  }
+  for (const auto &undef : MacroUndefs) {
+    preprocessor.AddMacroUndef(undef);
+  }
+}
+
+/// `target: source header...` in the format of gcc -M
+static std::string makeDependencyRule(const std::string &target,
+                                      const std::string &sourceFile,
+                                      const lcc::Preprocessor &preprocessor,
+                                      bool skipSystemHeaders) {
+  std::string rule;
+  auto append = [&rule, column = size_t(0)](llvm::StringRef path) mutable {
+    if (!rule.empty()) {
+      if (column + path.size() + 1 > 76) {
+        rule += " \\\n";
+        column = 0;
+      }
+      rule += ' ';
+      ++column;
+    }
+    for (char c : path) {
+      if (c == ' ' || c == '#') {
+        rule += '\\';
+      } else if (c == '$') {
+        rule += '$';
+      }
+      rule += c;
+    }
+    column += path.size();
+  };
+  append(target + ":");
+  append(sourceFile);
+  for (const auto &file : preprocessor.getIncludedFiles()) {
+    if (!skipSystemHeaders || !file.IsSystem) {
+      append(file.File->getName());
+    }
+  }
+  rule += '\n';
+  return rule;
+}
+
+static bool writeDependencyFile(const std::string &path,
+                                llvm::StringRef content) {
+  std::error_code ec;
+  llvm::raw_fd_ostream os(path, ec, llvm::sys::fs::OpenFlags::OF_Text);
+  if (ec) {
+    llvm::WithColor::error(llvm::errs(), "lcc")
+        << "failed to open dependency file " << path << ": " << ec.message()
+        << "\n";
+    return false;
+  }
+  os << content;
+  return true;
+}
+
+/// -M and -MM, the rule of `sourceFile` is put into `rule`
+bool scanCFileDependencies(std::filesystem::path sourceFile,
+                           lcc::FileManager &fileMgr,
+                           const lcc::PCHReader *pch, std::string &rule) {
+  const llvm::MemoryBuffer *buffer =
+      readInputFile(sourceFile.string(), fileMgr);
+  if (!buffer) {
+    return false;
+  }
+  llvm::SourceMgr mgr;
+  lcc::DiagnosticEngine diag(mgr, llvm::errs());
+  lcc::Lexer lexer(mgr, diag, *buffer);
+  lcc::Preprocessor preprocessor(mgr, diag, fileMgr);
+  setupPreprocessor(preprocessor);
+  if (pch) {
+    preprocessor.UsePCH(*pch);
+  }
+  preprocessor.EnterMainFile(lexer);
+  preprocessor.ScanDependencies();
+  if (diag.numErrors())
+    return false;
+  auto target = sourceFile.filename().replace_extension("o");
+  rule = makeDependencyRule(target.string(), sourceFile.string(),
+                            preprocessor, UserDepsOnly);
+  return true;
+}
+
+/// -E, the preprocessed `sourceFile` is appended to `os`
+bool preprocessCFile(std::filesystem::path sourceFile,
+                     lcc::FileManager &fileMgr, const lcc::PCHReader *pch,
+                     llvm::raw_ostream &os) {
+  const llvm::MemoryBuffer *buffer =
+      readInputFile(sourceFile.string(), fileMgr);
+  if (!buffer) {
+    return false;
+  }
+  llvm::SourceMgr mgr;
+  lcc::DiagnosticEngine diag(mgr, llvm::errs());
+  lcc::Lexer lexer(mgr, diag, *buffer);
+  lcc::Preprocessor preprocessor(mgr, diag, fileMgr);
+  setupPreprocessor(preprocessor);
+  if (pch) {
+    preprocessor.UsePCH(*pch);
+  }
+  preprocessor.EnterMainFile(lexer);
+  preprocessor.PrintPreprocessedOutput(os);
+  return !diag.numErrors();
+}
+
+/// -emit-ast-file
+static bool emitASTFile(const lcc::Syntax::TranslationUnit &translationUnit,
+                        const llvm::SourceMgr &mgr,
+                        const std::string &outputFile) {
+  std::error_code ec;
+  llvm::raw_fd_ostream os(outputFile, ec, llvm::sys::fs::OpenFlags::OF_None);
+  if (ec) {
+    llvm::WithColor::error(llvm::errs(), "lcc")
+        << "failed to open output file " << outputFile << ": "
+        << ec.message() << "\n";
+    return false;
+  }
+  lcc::ASTWriter::Emit(translationUnit, mgr, os);
+  return true;
+}
+
+static void printASTRecord(lcc::ASTRecord record, unsigned depth) {
+  llvm::outs().indent(depth * 2);
+  if (!record) {
+    llvm::outs() << "<null>\n";
+    return;
+  }
+  llvm::outs() << lcc::getASTNodeKindName(record.getKind());
+  if (!record.getFileName().empty()) {
+    llvm::outs() << " <" << record.getFileName() << ":" << record.getOffset()
+                 << ">";
+  }
+  if (record.getPayload()) {
+    llvm::outs() << " " << record.getPayload();
+  }
+  if (auto str = record.getString()) {
+    llvm::outs() << " '" << *str << "'";
+  }
+  if (auto constant = record.getConstant()) {
+    switch (static_cast<lcc::ASTConstantKind>(record.getPayload())) {
+    case lcc::ASTConstantKind::Int32:
+    case lcc::ASTConstantKind::Int64:
+      llvm::outs() << " " << static_cast<int64_t>(*constant);
+      break;
+    case lcc::ASTConstantKind::Float:
+      llvm::outs() << " " << llvm::BitsToFloat(*constant);
+      break;
+    case lcc::ASTConstantKind::Double:
+      llvm::outs() << " " << llvm::BitsToDouble(*constant);
+      break;
+    default:
+      llvm::outs() << " " << *constant;
+      break;
+    }
+  }
+  if (auto size = record.getNumElements()) {
+    llvm::outs() << " " << *size << " elements";
+  }
+  llvm::outs() << "\n";
+  for (uint32_t i = 0; i < record.getNumChildren(); ++i) {
+    printASTRecord(record.getChild(i), depth + 1);
+  }
+}
+
+/// -print-ast-file, the .ast inputs are printed and left out of the
+/// compilation
+static int printASTFiles() {
+  int result = 0;
+  for (const auto &file : InputFiles) {
+    if (std::filesystem::path(file).extension() != ".ast") {
+      continue;
+    }
+    auto reader = lcc::ASTReader::Load(file);
+    if (!reader) {
+      llvm::WithColor::error(llvm::errs(), "lcc")
+          << llvm::toString(reader.takeError()) << "\n";
+      result = -1;
+      continue;
+    }
+    printASTRecord((*reader)->getRoot(), 0);
+  }
+  return result;
+}
+
+bool compileCFile(Action action, std::filesystem::path sourceFile,
+                  lcc::FileManager &fileMgr, const lcc::PCHReader *pch) {
   std::optional<llvm::TimerGroup> timer;
   if (TimeOpt) {
     timer.emplace("Compilation", "Time it took for the whole compilation of " +
                                      sourceFile.string());
   }
 
-  /// file read to memory
-  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> FileOrErr =
-      llvm::MemoryBuffer::getFile(sourceFile.string());
-  if (std::error_code BufferError = FileOrErr.getError()) {
-    llvm::WithColor::error(llvm::errs(), "lcc")
-        << "Error reading " << sourceFile.string() << ": "
-        << BufferError.message() << "\n";
+  const llvm::MemoryBuffer *buffer =
+      readInputFile(sourceFile.string(), fileMgr);
+  if (!buffer) {
     return false;
   }
 
@@ -91,9 +366,14 @@ bool compileCFile(Action action, std::filesystem::path sourceFile) {
   }
   llvm::SourceMgr mgr;
   lcc::DiagnosticEngine diag(mgr, llvm::errs());
-  std::string sourceCode((*FileOrErr)->getBuffer());
-  lcc::Lexer lexer(mgr, diag, std::move(sourceCode), (*FileOrErr)->getBufferIdentifier());
-  auto ppTokens = lexer.tokenize();
+  lcc::Lexer lexer(mgr, diag, *buffer);
+  lcc::Preprocessor preprocessor(mgr, diag, fileMgr);
+  setupPreprocessor(preprocessor);
+  if (pch) {
+    preprocessor.UsePCH(*pch);
+  }
+  preprocessor.EnterMainFile(lexer);
+  auto ppTokens = preprocessor.Preprocess();
   if (diag.numErrors())
     return false;
   auto tokens = lexer.toCTokens(std::move(ppTokens));
@@ -114,11 +394,33 @@ bool compileCFile(Action action, std::filesystem::path sourceFile) {
     parserTimeRegion.emplace(*parserTimer);
   }
   lcc::Parser parser(tokens, diag);
+  if (pch) {
+    /// the parse goes on from the end of the prefix
+    parser.UsePCH(*pch);
+  }
+  if (AstHugePages) {
+    parser.UseHugePageArena();
+  }
+  if (ParseJobs) {
+    parser.UseDelayedBodies(ParseJobs);
+  }
   auto translationUnit = parser.ParseTranslationUnit();
+  if (PrintAstStats) {
+    translationUnit.getContext().PrintStats(llvm::errs());
+  }
   if (EmitAst) {
     lcc::dump::dumpAst(translationUnit);
   }
+  if (EmitAstFile && !diag.numErrors() &&
+      !emitASTFile(translationUnit, mgr,
+                   std::filesystem::path(sourceFile).replace_extension("ast")
+                       .string())) {
+    return false;
+  }
   parserTimeRegion.reset();
+  /// the tree keeps source locations and its own copies of the names, the
+  /// tokens are not needed by sema and codegen
+  std::vector<lcc::Token>().swap(tokens);
   /// parser end
 
   /// semantics begin
@@ -177,6 +479,18 @@ bool compileCFile(Action action, std::filesystem::path sourceFile) {
     outputFile = path.string();
   }
 
+  if (DepsAndCompile) {
+    std::string depFile = DepFileName;
+    if (depFile.empty()) {
+      depFile = std::filesystem::path(outputFile).replace_extension("d");
+    }
+    auto rule = makeDependencyRule(outputFile, sourceFile.string(),
+                                   preprocessor, false);
+    if (!writeDependencyFile(depFile, rule)) {
+      return false;
+    }
+  }
+
   std::error_code ec;
   llvm::raw_fd_ostream os(outputFile, ec, llvm::sys::fs::OpenFlags::OF_None);
   if (ec) {
@@ -220,19 +534,216 @@ bool compileCFile(Action action, std::filesystem::path sourceFile) {
   return true;
 }
 
+/// -include-pch, loaded once for all the input files. Returns false on error,
+/// `pch` is left empty when there is no -include-pch
+static bool loadPCH(std::unique_ptr<lcc::PCHReader> &pch) {
+  if (IncludePCH.empty()) {
+    return true;
+  }
+  auto reader = lcc::PCHReader::Load(IncludePCH);
+  if (!reader) {
+    llvm::WithColor::error(llvm::errs(), "lcc")
+        << llvm::toString(reader.takeError()) << "\n";
+    return false;
+  }
+  pch = std::move(*reader);
+  return true;
+}
+
+/// -emit-pch, the macros defined at the end of the header, the names it
+/// declares at file scope and its syntax tree are written to `outputFile`
+bool emitPCHOfHeader(const std::string &header, const std::string &outputFile,
+                     lcc::FileManager &fileMgr) {
+  const llvm::MemoryBuffer *buffer = readInputFile(header, fileMgr);
+  if (!buffer) {
+    return false;
+  }
+  llvm::SourceMgr mgr;
+  lcc::DiagnosticEngine diag(mgr, llvm::errs());
+  lcc::Lexer lexer(mgr, diag, *buffer);
+  lcc::Preprocessor preprocessor(mgr, diag, fileMgr);
+  setupPreprocessor(preprocessor);
+  preprocessor.EnterMainFile(lexer);
+  auto tokens = lexer.toCTokens(preprocessor.Preprocess());
+  if (diag.numErrors())
+    return false;
+  lcc::Parser parser(tokens, diag);
+  auto translationUnit = parser.ParseTranslationUnit();
+  if (diag.numErrors())
+    return false;
+
+  lcc::PCHWriter writer;
+  llvm::Error err = writer.AddInputFile(header);
+  for (const auto &file : preprocessor.getIncludedFiles()) {
+    if (err) {
+      break;
+    }
+    err = writer.AddInputFile(file.File->getName());
+  }
+  if (err) {
+    llvm::WithColor::error(llvm::errs(), "lcc")
+        << llvm::toString(std::move(err)) << "\n";
+    return false;
+  }
+  for (const auto *macro : preprocessor.getDefinedMacros()) {
+    writer.AddMacro(*macro);
+  }
+  for (auto [name, isTypedef] : parser.GetFileScopeBindings()) {
+    writer.AddFileScopeBinding(name, isTypedef);
+  }
+  writer.AddAST(translationUnit, mgr);
+
+  std::error_code ec;
+  llvm::raw_fd_ostream os(outputFile, ec, llvm::sys::fs::OpenFlags::OF_None);
+  if (ec) {
+    llvm::WithColor::error(llvm::errs(), "lcc")
+        << "failed to open output file " << outputFile << ": "
+        << ec.message() << "\n";
+    return false;
+  }
+  writer.Emit(os);
+  return true;
+}
+
+int emitPCHOfAllFiles() {
+  if (!IncludePCH.empty()) {
+    llvm::errs() << "cannot build a precompiled header on top of another one";
+    return -1;
+  }
+  lcc::FileManager fileMgr;
+  std::vector<std::string> headers;
+  for (const auto &F : InputFiles) {
+    if (std::filesystem::path(F).extension() == ".h") {
+      headers.push_back(F);
+    }
+  }
+  if (!OutputFileName.empty() && headers.size() > 1) {
+    llvm::errs() << "cannot specify -o with multiple precompiled headers";
+    return -1;
+  }
+  for (const auto &header : headers) {
+    std::string outputFile =
+        !OutputFileName.empty() ? std::string(OutputFileName) : header + ".pch";
+    if (!emitPCHOfHeader(header, outputFile, fileMgr)) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
 int doActionOnAllFiles(Action action) {
+  std::unique_ptr<lcc::PCHReader> pch;
+  if (!loadPCH(pch)) {
+    return -1;
+  }
+  /// headers are read once for all the input files
+  lcc::FileManager fileMgr;
+  std::vector<std::filesystem::path> sources;
   for (const auto &F : InputFiles) {
     auto path = std::filesystem::path(F);
-    auto extension = path.extension();
-    if (extension == ".c") {
-      bool res = compileCFile(action, path);
+    if (path.extension() == ".c") {
+      sources.push_back(path);
+    }
+  }
+
+  /// the dumps go to stdout and would interleave
+  if (Jobs <= 1 || sources.size() <= 1 || EmitTokens || EmitAst) {
+    for (const auto &path : sources) {
+      bool res = compileCFile(action, path, fileMgr, pch.get());
       if (!res)
         return -1;
     }
+    return 0;
+  }
+
+  std::atomic<bool> failed{false};
+  llvm::ThreadPool pool(llvm::hardware_concurrency(Jobs));
+  for (const auto &path : sources) {
+    pool.async([&, path] {
+      if (!compileCFile(action, path, fileMgr, pch.get())) {
+        failed = true;
+      }
+    });
+  }
+  pool.wait();
+  return failed ? -1 : 0;
+}
+
+/// -E, the inputs are written one after the other to -o or stdout
+int preprocessAllFiles() {
+  std::unique_ptr<lcc::PCHReader> pch;
+  if (!loadPCH(pch)) {
+    return -1;
+  }
+  lcc::FileManager fileMgr;
+  std::error_code ec;
+  std::string outputFile =
+      OutputFileName.empty() ? std::string("-") : OutputFileName;
+  llvm::raw_fd_ostream os(outputFile, ec, llvm::sys::fs::OpenFlags::OF_None);
+  if (ec) {
+    llvm::WithColor::error(llvm::errs(), "lcc")
+        << "failed to open output file " << OutputFileName << ": "
+        << ec.message() << "\n";
+    return -1;
+  }
+  /// the output is often piped to another process, write it in large chunks
+  os.SetBufferSize(1 << 20);
+  for (const auto &F : InputFiles) {
+    auto path = std::filesystem::path(F);
+    if (path.extension() != ".c") {
+      continue;
+    }
+    if (!preprocessCFile(path, fileMgr, pch.get(), os)) {
+      return -1;
+    }
   }
   return 0;
 }
 
+/// -M and -MM, the inputs are scanned in parallel but the rules are written in
+/// the order of the inputs
+int scanDependenciesOfAllFiles() {
+  std::unique_ptr<lcc::PCHReader> pch;
+  if (!loadPCH(pch)) {
+    return -1;
+  }
+  lcc::FileManager fileMgr;
+  std::vector<std::filesystem::path> sources;
+  for (const auto &F : InputFiles) {
+    auto path = std::filesystem::path(F);
+    if (path.extension() == ".c") {
+      sources.push_back(path);
+    }
+  }
+  std::vector<std::string> rules(sources.size());
+  std::atomic<bool> failed{false};
+  {
+    llvm::ThreadPool pool(llvm::hardware_concurrency(Jobs));
+    for (size_t i = 0; i < sources.size(); ++i) {
+      pool.async([&, i] {
+        if (!scanCFileDependencies(sources[i], fileMgr, pch.get(), rules[i])) {
+          failed = true;
+        }
+      });
+    }
+    pool.wait();
+  }
+  if (failed) {
+    return -1;
+  }
+
+  std::string content;
+  for (const auto &rule : rules) {
+    content += rule;
+  }
+  std::string depFile = !DepFileName.empty() ? DepFileName : OutputFileName;
+  if (depFile.empty()) {
+    llvm::outs() << content;
+    return 0;
+  }
+  return writeDependencyFile(depFile, content) ? 0 : -1;
+}
+
 int main(int argc, char *argv[]) {
   llvm::InitLLVM X(argc, argv);
   llvm::cl::SetVersionPrinter(&printVersion);
@@ -249,6 +760,19 @@ int main(int argc, char *argv[]) {
     return -1;
   }
 
+  /// -M and -MM imply -E, nothing is compiled
+  if (DepsOnly || UserDepsOnly) {
+    return scanDependenciesOfAllFiles();
+  }
+
+  if (EmitPCH) {
+    return emitPCHOfAllFiles();
+  }
+
+  if (PrintAstFile) {
+    return printASTFiles();
+  }
+
   if (CompileOnly) {
     if (AssemblyOnly) {
       llvm::errs()
@@ -273,7 +797,7 @@ int main(int argc, char *argv[]) {
   }
 
   if (PreprocessOnly) {
-    return doActionOnAllFiles(Action::Preprocess);
+    return preprocessAllFiles();
   }
 
   return doActionOnAllFiles(Action::Compile);